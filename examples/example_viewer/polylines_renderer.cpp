@@ -18,15 +18,25 @@ PolylinesRenderer::PolylinesRenderer(const QString& name, QObject* parent) :
   angle_(0) {
 }
 
+// Each arc segment is drawn with two vertices.
+static const double kArcLength = 75 * M_PI / 180;
+static const double kArcStep = 2 * M_PI / 180;
+static const int kMaxVertices = 2 * static_cast<int>(kArcLength / kArcStep);
+
 void PolylinesRenderer::InitializeGL() {
   StockResources stock(GetResources());
 
-  geom_ = GetResources()->MakeGeometry();
+  geom_ = GetResources()->MakeStreamingGeometry();
   material_ = stock.NewMaterial(StockResources::kPerVertexColorNoLighting);
 
   // Draw fat thick lines.
   material_->SetLineWidth(10.0f);
 
+  // The geometry is rewritten every frame, so allocate room for the largest
+  // frame up front.
+  geom_->Initialize(GL_LINE_STRIP, kMaxVertices,
+      { sv::VertexAttribute::kVertices, sv::VertexAttribute::kDiffuse });
+
   draw_node_ = GetScene()->MakeDrawNode(GetBaseNode(), geom_, material_);
 
   UpdateGeometry();
@@ -37,46 +47,54 @@ void PolylinesRenderer::RenderBegin() {
 }
 
 void PolylinesRenderer::UpdateGeometry() {
-  gdata_.gl_mode = GL_LINE_STRIP;
-  gdata_.vertices.clear();
-  gdata_.diffuse.clear();
-
   const double radius = 6.0;
   const double elapsed = start_time_.restart() / 1000.;
   const double speed = 1.0;
   angle_ += elapsed * speed;
-  const double arc_length = 75 * M_PI / 180;
-  const double step = 2 * M_PI / 180;
-  const int num_steps = arc_length / step;
+  const int num_steps = kArcLength / kArcStep;
+
+  // Write the vertex data directly into the geometry's buffer. The pointers
+  // are only valid until Commit() is called.
+  geom_->BeginWrite();
+  GLfloat* vertices = geom_->Data(sv::VertexAttribute::kVertices);
+  GLfloat* diffuse = geom_->Data(sv::VertexAttribute::kDiffuse);
+  sv::AxisAlignedBox bounding_box;
 
   for (int step_num = 0; step_num < num_steps; ++step_num) {
-    const double theta0 = angle_ + step * step_num;
-    const double theta1 = theta0 + step;
+    const double theta0 = angle_ + kArcStep * step_num;
+    const double theta1 = theta0 + kArcStep;
     const double cos0 = cos(theta0);
     const double sin0 = sin(theta0);
     const double cos1 = cos(theta1);
     const double sin1 = sin(theta1);
-    const double x0 = radius * cos0;
-    const double y0 = radius * sin0;
-    const double x1 = radius * cos1;
-    const double y1 = radius * sin1;
-    gdata_.vertices.emplace_back(x0, y0, -0.05);
-    gdata_.vertices.emplace_back(x1, y1, -0.05);
+    const QVector3D v0(radius * cos0, radius * sin0, -0.05);
+    const QVector3D v1(radius * cos1, radius * sin1, -0.05);
+    *vertices++ = v0.x();
+    *vertices++ = v0.y();
+    *vertices++ = v0.z();
+    *vertices++ = v1.x();
+    *vertices++ = v1.y();
+    *vertices++ = v1.z();
+    bounding_box.IncludePoint(v0);
+    bounding_box.IncludePoint(v1);
 
     // Since we chose the material kPerVertexColorNoLighting, specify the color
     // in the per-vertex geometry data.
     //
     // If we used a different material, then color would be specified some
     // other way.
-    const float r0 = cos0 * 0.5 + 0.5;
-    const float g0 = sin0 * 0.5 + 0.5;
-    const float r1 = cos1 * 0.5 + 0.5;
-    const float g1 = sin1 * 0.5 + 0.5;
-    gdata_.diffuse.emplace_back(r0, g0, 0, 1);
-    gdata_.diffuse.emplace_back(r1, g1, 0, 1);
+    const GLfloat colors[8] = {
+      static_cast<GLfloat>(cos0 * 0.5 + 0.5),
+      static_cast<GLfloat>(sin0 * 0.5 + 0.5), 0, 1,
+      static_cast<GLfloat>(cos1 * 0.5 + 0.5),
+      static_cast<GLfloat>(sin1 * 0.5 + 0.5), 0, 1
+    };
+    for (GLfloat color : colors) {
+      *diffuse++ = color;
+    }
   }
 
-  geom_->Load(gdata_);
+  geom_->Commit(2 * num_steps, bounding_box);
 }
 
 }  // namespace vis_examples
@@ -25,14 +25,13 @@ class PolylinesRenderer : public sv::Renderer {
     void UpdateGeometry();
 
     sv::MaterialResource::Ptr material_;
-    sv::GeometryResource::Ptr geom_;
+    sv::StreamingGeometryResource::Ptr geom_;
     sv::DrawNode* draw_node_;
 
     QTime start_time_;
     double angle_;
 
     std::unique_ptr<sv::ParamWidget> widget_;
-    sv::GeometryData gdata_;
 };
 
 }  // namespace vis_examples
@@ -2,8 +2,6 @@
 
 #include <cmath>
 
-#include <QOpenGLTexture>
-
 #include <sceneview/scene_node.hpp>
 #include <sceneview/stock_resources.hpp>
 
@@ -15,6 +13,7 @@ using sv::Renderer;
 using sv::ResourceManager;
 using sv::Scene;
 using sv::StockResources;
+using sv::StreamingTextureResource;
 using sv::SceneNode;
 
 namespace vis_examples {
@@ -64,9 +63,16 @@ void TextureRenderer::MakeTexture() {
   const float tx0 = elapsed;
   const float ty0 = elapsed;
 
-  QImage image(tex_width_, tex_height_, QImage::Format_RGB888);
+  if (!texture_) {
+    texture_ = GetResources()->MakeStreamingTexture();
+    texture_->Initialize(tex_width_, tex_height_,
+        StreamingTextureResource::PixelFormat::kRGB8, true);
+    material_->AddTexture(sv::kTexture0, texture_->Texture());
+    pixels_.resize(tex_width_ * tex_height_ * 3);
+  }
+
   for (int y = 0; y < tex_height_; ++y) {
-    uchar* row = image.scanLine(y);
+    uint8_t* row = &pixels_[y * tex_width_ * 3];
     for (int x = 0; x < tex_width_; ++x) {
       const float tx = static_cast<float>(x) / tex_width_;
       const float ty = static_cast<float>(y) / tex_height_;
@@ -78,12 +84,7 @@ void TextureRenderer::MakeTexture() {
       row[x * 3 + 2] = blue;
     }
   }
-  texture_.reset(new QOpenGLTexture(image));
-  texture_->setMinificationFilter(QOpenGLTexture::LinearMipMapLinear);
-  texture_->setMagnificationFilter(QOpenGLTexture::Linear);
-  texture_->setWrapMode(QOpenGLTexture::ClampToEdge);
-
-  material_->AddTexture(sv::kTexture0, texture_);
+  texture_->Upload(pixels_.data());
 }
 
 }  // namespace vis_examples
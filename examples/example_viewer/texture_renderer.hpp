@@ -1,12 +1,13 @@
 #ifndef SCENEVIEW_EXAMPLES_TEXTURE_RENDERER_HPP__
 #define SCENEVIEW_EXAMPLES_TEXTURE_RENDERER_HPP__
 
+#include <cstdint>
+#include <vector>
+
 #include <QTime>
 
 #include <sceneview/sceneview.hpp>
 
-class QOpenGLTexture;
-
 namespace vis_examples {
 
 /**
@@ -29,7 +30,8 @@ class TextureRenderer : public sv::Renderer {
 
     const int tex_width_ = 400;
     const int tex_height_ = 400;
-    std::shared_ptr<QOpenGLTexture> texture_;
+    sv::StreamingTextureResource::Ptr texture_;
+    std::vector<uint8_t> pixels_;
 
     sv::MaterialResource::Ptr material_;
     sv::GeometryResource::Ptr geom_;
@@ -0,0 +1,221 @@
+// Copyright [2015] Albert Huang
+
+#include "sceneview/internal_gl.hpp"
+
+#include "sceneview/anchor_set.hpp"
+
+#include <algorithm>
+#include <map>
+
+#include <QOpenGLTexture>
+
+#if 0
+#define dbg(fmt, ...) printf(fmt, __VA_ARGS__)
+#else
+#define dbg(...)
+#endif
+
+namespace sv {
+
+// Each row of the texture holds the poses of this many anchors, as three
+// texels each.
+static const int kAnchorsPerRow = 256;
+static const int kTexelsPerAnchor = 3;
+static const int kTextureWidth = kAnchorsPerRow * kTexelsPerAnchor;
+
+AnchorSet::Ptr AnchorSet::Create() {
+  return Ptr(new AnchorSet());
+}
+
+AnchorSet::AnchorSet() :
+  texture_height_(0),
+  texture_(new QOpenGLTexture(QOpenGLTexture::Target2D)) {}
+
+AnchorSet::~AnchorSet() {}
+
+int AnchorSet::AddAnchor(const QMatrix4x4& transform) {
+  const int anchor = transforms_.size();
+  transforms_.push_back(transform);
+  const int rows = anchor / kAnchorsPerRow + 1;
+  texels_.resize(4 * kTextureWidth * rows, 0);
+  SetTransform(anchor, transform);
+  return anchor;
+}
+
+void AnchorSet::SetTransform(int anchor, const QMatrix4x4& transform) {
+  transforms_[anchor] = transform;
+  float* texels = &texels_[4 * kTexelsPerAnchor * anchor];
+  for (int row = 0; row < 3; ++row) {
+    const QVector4D values = transform.row(row);
+    texels[4 * row] = values.x();
+    texels[4 * row + 1] = values.y();
+    texels[4 * row + 2] = values.z();
+    texels[4 * row + 3] = values.w();
+  }
+  dirty_anchors_.push_back(anchor);
+}
+
+void AnchorSet::ApplyTo(const MaterialResource::Ptr& material) {
+  material->AddTexture("anchor_transforms", texture_);
+  materials_.push_back(material);
+  UpdateMaterials();
+}
+
+// Writes the poses of anchors [first, end) to the bound texture. Whole rows
+// are written with a single call, and partial rows with one call each.
+static void WriteAnchors(const std::vector<float>& texels, int first,
+    int end) {
+  while (first < end) {
+    const int row = first / kAnchorsPerRow;
+    const int column = first % kAnchorsPerRow;
+    int num_rows = 1;
+    int num_anchors = std::min(end - first, kAnchorsPerRow - column);
+    if (column == 0 && end - first >= kAnchorsPerRow) {
+      num_rows = (end - first) / kAnchorsPerRow;
+      num_anchors = kAnchorsPerRow;
+    }
+    glTexSubImage2D(GL_TEXTURE_2D, 0, column * kTexelsPerAnchor, row,
+        num_anchors * kTexelsPerAnchor, num_rows, GL_RGBA, GL_FLOAT,
+        &texels[4 * kTexelsPerAnchor * first]);
+    first += num_rows * num_anchors;
+  }
+}
+
+void AnchorSet::Update() {
+  if (dirty_anchors_.empty()) {
+    return;
+  }
+
+  const int rows = texels_.size() / (4 * kTextureWidth);
+  bool write_all = false;
+  if (rows > texture_height_) {
+    // Grow the texture by doubling, and write it all.
+    texture_height_ = std::max(rows, 2 * texture_height_);
+    if (texture_->isStorageAllocated()) {
+      texture_->destroy();
+    }
+    texture_->setSize(kTextureWidth, texture_height_);
+    texture_->setFormat(QOpenGLTexture::RGBA32F);
+    texture_->allocateStorage();
+    texture_->setMinificationFilter(QOpenGLTexture::Nearest);
+    texture_->setMagnificationFilter(QOpenGLTexture::Nearest);
+    texture_->setWrapMode(QOpenGLTexture::ClampToEdge);
+    write_all = true;
+    UpdateMaterials();
+  }
+
+  texture_->bind();
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+  if (write_all) {
+    WriteAnchors(texels_, 0, rows * kAnchorsPerRow);
+  } else {
+    // Write each run of consecutive changed anchors.
+    std::sort(dirty_anchors_.begin(), dirty_anchors_.end());
+    dirty_anchors_.erase(
+        std::unique(dirty_anchors_.begin(), dirty_anchors_.end()),
+        dirty_anchors_.end());
+    size_t run_first = 0;
+    for (size_t ind = 1; ind <= dirty_anchors_.size(); ++ind) {
+      if (ind == dirty_anchors_.size() ||
+          dirty_anchors_[ind] != dirty_anchors_[ind - 1] + 1) {
+        WriteAnchors(texels_, dirty_anchors_[run_first],
+            dirty_anchors_[ind - 1] + 1);
+        dbg("Wrote anchors %d to %d\n", dirty_anchors_[run_first],
+            dirty_anchors_[ind - 1]);
+        run_first = ind;
+      }
+    }
+  }
+  texture_->release();
+  dirty_anchors_.clear();
+
+  for (auto iter = drawables_.begin(); iter != drawables_.end();) {
+    std::shared_ptr<AnchoredDrawable> drawable = iter->lock();
+    if (!drawable) {
+      iter = drawables_.erase(iter);
+      continue;
+    }
+    drawable->UpdateBoundingBox();
+    ++iter;
+  }
+}
+
+void AnchorSet::AddDrawable(
+    const std::shared_ptr<AnchoredDrawable>& drawable) {
+  drawables_.push_back(drawable);
+}
+
+void AnchorSet::UpdateMaterials() {
+  for (auto iter = materials_.begin(); iter != materials_.end();) {
+    MaterialResource::Ptr material = iter->lock();
+    if (!material) {
+      iter = materials_.erase(iter);
+      continue;
+    }
+    material->SetParam("anchor_texture_size",
+        static_cast<float>(kTextureWidth),
+        static_cast<float>(std::max(texture_height_, 1)));
+    ++iter;
+  }
+}
+
+AnchoredDrawable::Ptr AnchoredDrawable::Create(
+    const GeometryResource::Ptr& geometry,
+    const MaterialResource::Ptr& material, const AnchorSet::Ptr& anchors,
+    const GeometryDataView& data) {
+  Ptr result(new AnchoredDrawable(geometry, material, anchors, data));
+  anchors->AddDrawable(result);
+  return result;
+}
+
+AnchoredDrawable::Ptr AnchoredDrawable::Create(
+    const GeometryResource::Ptr& geometry,
+    const MaterialResource::Ptr& material, const AnchorSet::Ptr& anchors,
+    const GeometryData& data) {
+  GeometryDataView view;
+  view.vertices = StridedSpan(
+      reinterpret_cast<const float*>(data.vertices.data()),
+      data.vertices.size());
+  view.anchors = StridedSpan(data.anchors.data(), data.anchors.size());
+  return Create(geometry, material, anchors, view);
+}
+
+AnchoredDrawable::AnchoredDrawable(const GeometryResource::Ptr& geometry,
+    const MaterialResource::Ptr& material, const AnchorSet::Ptr& anchors,
+    const GeometryDataView& data) :
+  Drawable(geometry, material),
+  anchors_(anchors) {
+  const int vertex_stride = data.vertices.stride ?
+    data.vertices.stride : 3 * sizeof(float);
+  const int anchor_stride = data.anchors.stride ?
+    data.anchors.stride : sizeof(float);
+  const char* vertex = reinterpret_cast<const char*>(data.vertices.data);
+  const char* anchor = reinterpret_cast<const char*>(data.anchors.data);
+  std::map<int, AxisAlignedBox> boxes;
+  for (int ind = 0; ind < data.anchors.count; ++ind) {
+    const float* xyz = reinterpret_cast<const float*>(vertex);
+    const int anchor_ind =
+      static_cast<int>(*reinterpret_cast<const float*>(anchor) + 0.5f);
+    boxes[anchor_ind].IncludePoint(QVector3D(xyz[0], xyz[1], xyz[2]));
+    vertex += vertex_stride;
+    anchor += anchor_stride;
+  }
+  anchor_boxes_.assign(boxes.begin(), boxes.end());
+  UpdateBoundingBox();
+}
+
+void AnchoredDrawable::UpdateBoundingBox() {
+  AxisAlignedBox box;
+  for (const auto& item : anchor_boxes_) {
+    if (item.first < anchors_->NumAnchors()) {
+      box.IncludeBox(
+          item.second.Transformed(anchors_->Transform(item.first)));
+    }
+  }
+  if (box != box_) {
+    box_ = box;
+    BoundingBoxChanged();
+  }
+}
+
+}  // namespace sv
@@ -0,0 +1,190 @@
+// Copyright [2015] Albert Huang
+
+#ifndef SCENEVIEW_ANCHOR_SET_HPP__
+#define SCENEVIEW_ANCHOR_SET_HPP__
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <QMatrix4x4>
+
+#include <sceneview/axis_aligned_box.hpp>
+#include <sceneview/drawable.hpp>
+#include <sceneview/geometry_resource.hpp>
+#include <sceneview/material_resource.hpp>
+
+class QOpenGLTexture;
+
+namespace sv {
+
+class AnchoredDrawable;
+
+/**
+ * Poses of a set of anchors, such as the keyframes of a SLAM map, stored in
+ * graphics memory for geometry whose vertices are relative to them.
+ *
+ * Each vertex of anchored geometry has an anchor index, in the
+ * GeometryData::anchors attribute, and its position and normal are relative
+ * to the pose of that anchor. The vertex shader of an anchored material
+ * (e.g., StockResources::kAnchoredPerVertexColorNoLighting) reads the pose
+ * from a float texture and transforms the vertex by it. Scans from any
+ * number of keyframes can therefore be merged into a few large geometries,
+ * and still move with their keyframes.
+ *
+ * When poses change, such as after a loop closure, Update() writes only the
+ * changed poses to the texture. No geometry is uploaded again, and no scene
+ * node is moved, so correcting thousands of poses costs about as much as
+ * writing thousands of matrices.
+ *
+ * Poses should be rigid transforms, since normals are rotated by the same
+ * matrix as positions.
+ *
+ * @code
+ * AnchorSet::Ptr anchors = AnchorSet::Create();
+ * for (const Keyframe& keyframe : keyframes) {
+ *   anchors->AddAnchor(keyframe.pose);
+ * }
+ *
+ * StockResources stock(resources);
+ * MaterialResource::Ptr material =
+ *   stock.NewMaterial(StockResources::kAnchoredPerVertexColorNoLighting);
+ * anchors->ApplyTo(material);
+ *
+ * // gdata.vertices are relative to the keyframe in gdata.anchors.
+ * GeometryResource::Ptr geometry = resources->MakeGeometry();
+ * geometry->Load(gdata);
+ * DrawNode* draw_node = scene->MakeDrawNode(scene->Root());
+ * draw_node->Add(AnchoredDrawable::Create(geometry, material, anchors,
+ *     gdata));
+ *
+ * // After a loop closure:
+ * for (const Keyframe& keyframe : corrected) {
+ *   anchors->SetTransform(keyframe.id, keyframe.pose);
+ * }
+ *
+ * // In Renderer::RenderBegin(), or elsewhere with the OpenGL context
+ * // current, once per frame:
+ * anchors->Update();
+ * @endcode
+ *
+ * @ingroup sv_resources
+ * @headerfile sceneview/anchor_set.hpp
+ */
+class AnchorSet {
+  public:
+    typedef std::shared_ptr<AnchorSet> Ptr;
+
+    static Ptr Create();
+
+    ~AnchorSet();
+
+    /**
+     * Adds an anchor.
+     *
+     * @return the index of the anchor.
+     */
+    int AddAnchor(const QMatrix4x4& transform);
+
+    /**
+     * Sets the pose of an anchor.
+     */
+    void SetTransform(int anchor, const QMatrix4x4& transform);
+
+    const QMatrix4x4& Transform(int anchor) const {
+      return transforms_[anchor];
+    }
+
+    int NumAnchors() const { return transforms_.size(); }
+
+    /**
+     * Sets the texture and parameters that an anchored shader needs on a
+     * material. The material is kept up to date as the set grows.
+     */
+    void ApplyTo(const MaterialResource::Ptr& material);
+
+    /**
+     * Writes changed poses to graphics memory, and updates the bounding
+     * boxes of the anchored drawables.
+     *
+     * Must be called with the OpenGL context current, typically once per
+     * frame before drawing.
+     */
+    void Update();
+
+  private:
+    friend class AnchoredDrawable;
+
+    AnchorSet();
+
+    void AddDrawable(const std::shared_ptr<AnchoredDrawable>& drawable);
+
+    void UpdateMaterials();
+
+    std::vector<QMatrix4x4> transforms_;
+
+    // The first three rows of each transform, laid out as in the texture.
+    std::vector<float> texels_;
+    int texture_height_;
+    std::shared_ptr<QOpenGLTexture> texture_;
+
+    // Anchors that changed since the last update, possibly repeated.
+    std::vector<int> dirty_anchors_;
+
+    std::vector<std::weak_ptr<MaterialResource>> materials_;
+    std::vector<std::weak_ptr<AnchoredDrawable>> drawables_;
+};
+
+/**
+ * Draws anchored geometry.
+ *
+ * The bounding box of the geometry is computed from the boxes of the
+ * vertices of each anchor, transformed by the poses of the anchors, and is
+ * updated by AnchorSet::Update() when the poses change.
+ *
+ * @ingroup sv_scenegraph
+ * @headerfile sceneview/anchor_set.hpp
+ */
+class AnchoredDrawable : public Drawable {
+  public:
+    typedef std::shared_ptr<AnchoredDrawable> Ptr;
+
+    /**
+     * Creates a drawable for anchored geometry.
+     *
+     * @param geometry the geometry, loaded with anchor indices.
+     * @param material an anchored material, set up by AnchorSet::ApplyTo().
+     * @param anchors the anchors that the vertices are relative to.
+     * @param data the data loaded into @p geometry, used to compute the
+     *        bounding box of the vertices of each anchor.
+     */
+    static Ptr Create(const GeometryResource::Ptr& geometry,
+        const MaterialResource::Ptr& material, const AnchorSet::Ptr& anchors,
+        const GeometryDataView& data);
+
+    static Ptr Create(const GeometryResource::Ptr& geometry,
+        const MaterialResource::Ptr& material, const AnchorSet::Ptr& anchors,
+        const GeometryData& data);
+
+    const AxisAlignedBox& BoundingBox() override { return box_; }
+
+  private:
+    friend class AnchorSet;
+
+    AnchoredDrawable(const GeometryResource::Ptr& geometry,
+        const MaterialResource::Ptr& material, const AnchorSet::Ptr& anchors,
+        const GeometryDataView& data);
+
+    void UpdateBoundingBox();
+
+    AnchorSet::Ptr anchors_;
+
+    // Bounding box of the vertices of each anchor, relative to the anchor.
+    std::vector<std::pair<int, AxisAlignedBox>> anchor_boxes_;
+
+    AxisAlignedBox box_;
+};
+
+}  // namespace sv
+
+#endif  // SCENEVIEW_ANCHOR_SET_HPP__
@@ -3,18 +3,42 @@
 #include "sceneview/asset_importer.hpp"
 
 #include "sceneview/importer_assimp.hpp"
+#include "sceneview/importer_gltf.hpp"
 #include "sceneview/importer_rwx.hpp"
 
 namespace sv {
 
 Scene::Ptr AssetImporter::ImportFile(ResourceManager::Ptr resources,
     const QString& fname, const QString& resource_name) {
-  Scene::Ptr assimp_scene = ImportAssimpFile(resources, fname, resource_name);
-  if (assimp_scene) {
-    return assimp_scene;
+  ImportedAsset::Ptr asset = ReadFile(fname);
+  if (!asset) {
+    return Scene::Ptr();
   }
-  Scene::Ptr rwx_scene = ImportRwxFile(resources, fname, resource_name);
-  return rwx_scene;
+  Scene::Ptr scene = resources->MakeScene(resource_name);
+  ImportedAssetBuilder builder(resources, scene, scene->Root(), asset);
+  builder.Build(-1);
+  return scene;
+}
+
+ImportedAsset::Ptr AssetImporter::ReadFile(const QString& fname) {
+  ImportedAsset::Ptr asset = std::make_shared<ImportedAsset>();
+  try {
+    if (ReadGltfFile(fname, asset.get())) {
+      return asset;
+    }
+  } catch (const GltfUnsupportedError& ex) {
+    // Assimp reads some glTF features that ReadGltfFile() doesn't.
+    qDebug("%s, falling back to Assimp\n", ex.what());
+  }
+  *asset = ImportedAsset();
+  if (ReadAssimpFile(fname, asset.get())) {
+    return asset;
+  }
+  *asset = ImportedAsset();
+  if (ReadRwxFile(fname, asset.get())) {
+    return asset;
+  }
+  return ImportedAsset::Ptr();
 }
 
 }  // namespace sv
@@ -5,6 +5,7 @@
 
 #include <QString>
 
+#include <sceneview/imported_asset.hpp>
 #include <sceneview/scene.hpp>
 #include <sceneview/resource_manager.hpp>
 
@@ -25,6 +26,9 @@ class AssetImporter {
      * ":/assets/model.obj")
      *
      * The following file formats are supported:
+     * - glTF 2.0 (.gltf and .glb) files, read natively without copying
+     *   vertex data where possible. See ReadGltfFile(). Files that use
+     *   glTF features it doesn't support are read with Assimp instead.
      * - All file formats supported by Assimp.
      * - Renderware (.RWX) files.
      *
@@ -37,6 +41,18 @@ class AssetImporter {
     static Scene::Ptr ImportFile(ResourceManager::Ptr resources,
         const QString& fname,
         const QString& resource_name = ResourceManager::kAutoName);
+
+    /**
+     * Reads assets from a file into system memory, without creating any
+     * resources.
+     *
+     * This doesn't need an OpenGL context, so it can be called from a
+     * worker thread. The same file formats as ImportFile() are supported.
+     * Use ImportedAssetBuilder to add the asset to a scene.
+     *
+     * @return the asset, or an empty pointer if the file couldn't be read.
+     */
+    static ImportedAsset::Ptr ReadFile(const QString& fname);
 };
 
 
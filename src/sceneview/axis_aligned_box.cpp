@@ -3,13 +3,202 @@
 #include "sceneview/axis_aligned_box.hpp"
 
 #include <algorithm>
+#include <cmath>
 #include <limits>
+#include <vector>
+
+#if defined(__SSE__)
+#include <xmmintrin.h>
+#endif
 
 #include <QMatrix4x4>
 #include <QString>
 
+#include "sceneview/thread_pool.hpp"
+
 namespace sv {
 
+// Arrays with at least this many points are split across threads.
+static const int kParallelMinPoints = 1 << 20;
+
+// Computes the min/max of a range of points. Written so that NaN coordinates
+// are ignored, matching IncludePoint().
+static void MinMaxStrided(const char* data, int num_points, int stride,
+    float* min, float* max) {
+  for (int point_ind = 0; point_ind < num_points; ++point_ind) {
+    const float* point = reinterpret_cast<const float*>(
+        data + static_cast<size_t>(point_ind) * stride);
+    for (int axis = 0; axis < 3; ++axis) {
+      min[axis] = point[axis] < min[axis] ? point[axis] : min[axis];
+      max[axis] = point[axis] > max[axis] ? point[axis] : max[axis];
+    }
+  }
+}
+
+static void MinMaxPacked(const float* xyz, int num_points,
+    float* min, float* max) {
+  int point_ind = 0;
+#if defined(__SSE__)
+  // Load four points (12 floats) at a time as three registers. The
+  // registers hold (x y z x), (y z x y) and (z x y z) respectively, so each
+  // lane always holds the same axis.
+  __m128 min_a = _mm_setr_ps(min[0], min[1], min[2], min[0]);
+  __m128 min_b = _mm_setr_ps(min[1], min[2], min[0], min[1]);
+  __m128 min_c = _mm_setr_ps(min[2], min[0], min[1], min[2]);
+  __m128 max_a = _mm_setr_ps(max[0], max[1], max[2], max[0]);
+  __m128 max_b = _mm_setr_ps(max[1], max[2], max[0], max[1]);
+  __m128 max_c = _mm_setr_ps(max[2], max[0], max[1], max[2]);
+  for (; point_ind + 4 <= num_points; point_ind += 4) {
+    const float* block = xyz + point_ind * 3;
+    const __m128 a = _mm_loadu_ps(block);
+    const __m128 b = _mm_loadu_ps(block + 4);
+    const __m128 c = _mm_loadu_ps(block + 8);
+    // minps/maxps return the second operand if either is NaN, so passing
+    // the accumulator second skips NaNs.
+    min_a = _mm_min_ps(a, min_a);
+    min_b = _mm_min_ps(b, min_b);
+    min_c = _mm_min_ps(c, min_c);
+    max_a = _mm_max_ps(a, max_a);
+    max_b = _mm_max_ps(b, max_b);
+    max_c = _mm_max_ps(c, max_c);
+  }
+  float lanes[6][4];
+  _mm_storeu_ps(lanes[0], min_a);
+  _mm_storeu_ps(lanes[1], min_b);
+  _mm_storeu_ps(lanes[2], min_c);
+  _mm_storeu_ps(lanes[3], max_a);
+  _mm_storeu_ps(lanes[4], max_b);
+  _mm_storeu_ps(lanes[5], max_c);
+  // Which register and lane hold each axis.
+  const int kAxisLanes[3][4][2] = {
+    { { 0, 0 }, { 0, 3 }, { 1, 2 }, { 2, 1 } },
+    { { 0, 1 }, { 1, 0 }, { 1, 3 }, { 2, 2 } },
+    { { 0, 2 }, { 1, 1 }, { 2, 0 }, { 2, 3 } }
+  };
+  for (int axis = 0; axis < 3; ++axis) {
+    for (int lane = 0; lane < 4; ++lane) {
+      const int reg = kAxisLanes[axis][lane][0];
+      const int ind = kAxisLanes[axis][lane][1];
+      min[axis] = std::min(min[axis], lanes[reg][ind]);
+      max[axis] = std::max(max[axis], lanes[reg + 3][ind]);
+    }
+  }
+#endif
+  // Remaining points
+  MinMaxStrided(reinterpret_cast<const char*>(xyz + point_ind * 3),
+      num_points - point_ind, 3 * sizeof(float), min, max);
+}
+
+static void MinMax(const float* xyz, int num_points, int stride,
+    float* min, float* max) {
+  if (stride == 3 * sizeof(float)) {
+    MinMaxPacked(xyz, num_points, min, max);
+  } else {
+    MinMaxStrided(reinterpret_cast<const char*>(xyz), num_points, stride,
+        min, max);
+  }
+}
+
+AxisAlignedBox AxisAlignedBox::FromPoints(const float* xyz, int num_points,
+    int stride) {
+  if (stride == 0) {
+    stride = 3 * sizeof(float);
+  }
+
+  const float kMax = std::numeric_limits<float>::max();
+  const float kLowest = std::numeric_limits<float>::lowest();
+  float min[3] = { kMax, kMax, kMax };
+  float max[3] = { kLowest, kLowest, kLowest };
+
+  ThreadPool* pool = ThreadPool::Default();
+  const int num_chunks = num_points >= kParallelMinPoints ?
+    pool->NumThreads() + 1 : 1;
+  const int chunk_size = (num_points + num_chunks - 1) / num_chunks;
+  const char* data = reinterpret_cast<const char*>(xyz);
+
+  // ParallelFor() runs chunks on the calling thread too, so this doesn't
+  // deadlock when called from a task on the same pool.
+  struct MinMaxResult {
+    float min[3];
+    float max[3];
+  };
+  std::vector<MinMaxResult> chunk_results(num_chunks, MinMaxResult {
+      { kMax, kMax, kMax }, { kLowest, kLowest, kLowest } });
+  pool->ParallelFor(num_chunks, [&](int chunk) {
+    const int first = chunk * chunk_size;
+    const int count = std::min(chunk_size, num_points - first);
+    if (count <= 0) {
+      return;
+    }
+    const float* chunk_xyz = reinterpret_cast<const float*>(
+        data + static_cast<size_t>(first) * stride);
+    MinMax(chunk_xyz, count, stride, chunk_results[chunk].min,
+        chunk_results[chunk].max);
+  });
+
+  for (const MinMaxResult& chunk_result : chunk_results) {
+    for (int axis = 0; axis < 3; ++axis) {
+      min[axis] = std::min(min[axis], chunk_result.min[axis]);
+      max[axis] = std::max(max[axis], chunk_result.max[axis]);
+    }
+  }
+  return AxisAlignedBox(QVector3D(min[0], min[1], min[2]),
+      QVector3D(max[0], max[1], max[2]));
+}
+
+// Transforms a box using its center and extent. Only valid for affine
+// transforms. @p m is a column-major 4x4 matrix.
+static void TransformAffine(const float* m, const QVector3D& box_min,
+    const QVector3D& box_max, QVector3D* result_min, QVector3D* result_max) {
+  const float center[3] = {
+    (box_min.x() + box_max.x()) * 0.5f,
+    (box_min.y() + box_max.y()) * 0.5f,
+    (box_min.z() + box_max.z()) * 0.5f
+  };
+  const float extent[3] = {
+    (box_max.x() - box_min.x()) * 0.5f,
+    (box_max.y() - box_min.y()) * 0.5f,
+    (box_max.z() - box_min.z()) * 0.5f
+  };
+  float new_center[3];
+  float new_extent[3];
+  for (int row = 0; row < 3; ++row) {
+    new_center[row] = m[12 + row];
+    new_extent[row] = 0;
+    for (int col = 0; col < 3; ++col) {
+      const float m_rc = m[col * 4 + row];
+      new_center[row] += m_rc * center[col];
+      new_extent[row] += std::fabs(m_rc) * extent[col];
+    }
+  }
+  *result_min = QVector3D(new_center[0] - new_extent[0],
+      new_center[1] - new_extent[1], new_center[2] - new_extent[2]);
+  *result_max = QVector3D(new_center[0] + new_extent[0],
+      new_center[1] + new_extent[1], new_center[2] + new_extent[2]);
+}
+
+static bool IsAffine(const float* m) {
+  return m[3] == 0 && m[7] == 0 && m[11] == 0 && m[15] == 1;
+}
+
+void AxisAlignedBox::TransformBatch(const AxisAlignedBox* boxes,
+    const QMatrix4x4* transforms, int num_boxes, AxisAlignedBox* result) {
+  for (int box_ind = 0; box_ind < num_boxes; ++box_ind) {
+    const AxisAlignedBox& box = boxes[box_ind];
+    const float* m = transforms[box_ind].constData();
+    if (!box.Valid()) {
+      result[box_ind] = AxisAlignedBox();
+    } else if (IsAffine(m)) {
+      AxisAlignedBox transformed;
+      TransformAffine(m, box.min_, box.max_, &transformed.min_,
+          &transformed.max_);
+      result[box_ind] = transformed;
+    } else {
+      result[box_ind] = box.Transformed(transforms[box_ind]);
+    }
+  }
+}
+
 AxisAlignedBox::AxisAlignedBox() :
   min_(std::numeric_limits<double>::max(),
        std::numeric_limits<double>::max(),
@@ -50,6 +239,17 @@ bool AxisAlignedBox::Valid() const {
 }
 
 AxisAlignedBox AxisAlignedBox::Transformed(const QMatrix4x4& transform) const {
+  if (!Valid()) {
+    return AxisAlignedBox();
+  }
+  AxisAlignedBox result;
+  const float* m = transform.constData();
+  if (IsAffine(m)) {
+    TransformAffine(m, min_, max_, &result.min_, &result.max_);
+    return result;
+  }
+
+  // Projective transform. Transform each corner.
   const double x0 = min_.x();
   const double y0 = min_.y();
   const double z0 = min_.z();
@@ -58,7 +258,6 @@ AxisAlignedBox AxisAlignedBox::Transformed(const QMatrix4x4& transform) const {
   const double y1 = max_.y();
   const double z1 = max_.z();
 
-  AxisAlignedBox result;
   result.IncludePoint(transform * min_);
   result.IncludePoint(transform * max_);
   result.IncludePoint(transform * QVector3D(x0, y1, z0));
@@ -5,6 +5,8 @@
 
 #include <QVector3D>
 
+class QMatrix4x4;
+
 namespace sv {
 
 /**
@@ -29,6 +31,42 @@ class AxisAlignedBox {
      */
     AxisAlignedBox(const QVector3D& min, const QVector3D& max);
 
+    /**
+     * Computes the bounding box of an array of points.
+     *
+     * This is much faster than calling IncludePoint() for each point. The
+     * minimum and maximum are computed with SIMD instructions where
+     * available, and large arrays are split across the ThreadPool::Default()
+     * threads and the calling thread. It can be called from tasks running
+     * on that pool.
+     *
+     * @param xyz pointer to the x coordinate of the first point. Each point
+     *        is three consecutive floats.
+     * @param num_points number of points.
+     * @param stride number of bytes between the start of consecutive points.
+     *        Zero means the points are tightly packed.
+     *
+     * NaN coordinates are ignored. If there are no points, then the box is
+     * invalid.
+     */
+    static AxisAlignedBox FromPoints(const float* xyz, int num_points,
+        int stride = 0);
+
+    /**
+     * Transforms each of @p num_boxes boxes by the corresponding transform.
+     *
+     * Equivalent to calling Transformed() on each box, but avoids most of the
+     * per-box overhead. Useful when many boxes move at once.
+     *
+     * @param boxes the boxes to transform.
+     * @param transforms one transform per box.
+     * @param num_boxes the number of boxes.
+     * @param result output array of @p num_boxes boxes. May be the same as
+     *        @p boxes.
+     */
+    static void TransformBatch(const AxisAlignedBox* boxes,
+        const QMatrix4x4* transforms, int num_boxes, AxisAlignedBox* result);
+
     /**
      * Manually set the box extents.
      */
@@ -62,6 +100,11 @@ class AxisAlignedBox {
 
     /**
      * Transforms and axis-aligns the corners of this box.
+     *
+     * For affine transforms, this uses the center/extent formulation (Arvo,
+     * "Transforming Axis-Aligned Bounding Boxes", Graphics Gems), which is
+     * equivalent to transforming all eight corners but much cheaper.
+     * Transforming an invalid box results in an invalid box.
      */
     AxisAlignedBox Transformed(const QMatrix4x4& transform) const;
 
@@ -2,7 +2,15 @@
 
 #include <gtest/gtest.h>
 
+#include <cmath>
+#include <future>
+#include <limits>
+#include <vector>
+
+#include <QMatrix4x4>
+
 #include "sceneview/axis_aligned_box.hpp"
+#include "sceneview/thread_pool.hpp"
 
 using sv::AxisAlignedBox;
 
@@ -89,3 +97,140 @@ TEST(AxisAlignedBox, Intersection) {
   EXPECT_EQ(box55.Min(), box5.Min());
   EXPECT_EQ(box55.Max(), box5.Max());
 }
+
+static void ExpectNear(const QVector3D& expected, const QVector3D& actual) {
+  const float kTolerance = 1e-4;
+  EXPECT_NEAR(expected.x(), actual.x(), kTolerance);
+  EXPECT_NEAR(expected.y(), actual.y(), kTolerance);
+  EXPECT_NEAR(expected.z(), actual.z(), kTolerance);
+}
+
+TEST(AxisAlignedBox, FromPoints) {
+  // Sizes that do and don't fill whole SIMD blocks.
+  for (int num_points = 0; num_points < 40; ++num_points) {
+    std::vector<float> packed;
+    std::vector<float> strided;
+    AxisAlignedBox expected;
+    for (int point_ind = 0; point_ind < num_points; ++point_ind) {
+      const QVector3D point(std::sin(point_ind * 1.3) * point_ind,
+          std::cos(point_ind * 0.7) * 5, point_ind * 2 - 30);
+      expected.IncludePoint(point);
+      for (int axis = 0; axis < 3; ++axis) {
+        packed.push_back(point[axis]);
+        strided.push_back(point[axis]);
+      }
+      // Padding
+      strided.push_back(1e6);
+      strided.push_back(-1e6);
+    }
+
+    const AxisAlignedBox box_packed =
+      AxisAlignedBox::FromPoints(packed.data(), num_points);
+    const AxisAlignedBox box_strided = AxisAlignedBox::FromPoints(
+        strided.data(), num_points, 5 * sizeof(float));
+    EXPECT_EQ(num_points > 0, box_packed.Valid());
+    EXPECT_EQ(num_points > 0, box_strided.Valid());
+    if (num_points > 0) {
+      EXPECT_EQ(expected.Min(), box_packed.Min());
+      EXPECT_EQ(expected.Max(), box_packed.Max());
+      EXPECT_EQ(expected.Min(), box_strided.Min());
+      EXPECT_EQ(expected.Max(), box_strided.Max());
+    }
+  }
+}
+
+TEST(AxisAlignedBox, FromPointsNaN) {
+  const float kNaN = std::numeric_limits<float>::quiet_NaN();
+  std::vector<float> points;
+  for (int point_ind = 0; point_ind < 9; ++point_ind) {
+    points.push_back(point_ind);
+    points.push_back(point_ind == 4 ? kNaN : -point_ind);
+    points.push_back(point_ind == 0 ? kNaN : 1);
+  }
+  const AxisAlignedBox box = AxisAlignedBox::FromPoints(points.data(), 9);
+  EXPECT_EQ(QVector3D(0, -8, 1), box.Min());
+  EXPECT_EQ(QVector3D(8, 0, 1), box.Max());
+}
+
+TEST(AxisAlignedBox, FromPointsInPoolTasks) {
+  // Large enough to be split across threads, computed from every worker at
+  // once, so that no worker is free to run another task.
+  const int kNumPoints = 1 << 21;
+  std::vector<float> points(3 * kNumPoints);
+  for (int point_ind = 0; point_ind < kNumPoints; ++point_ind) {
+    points[3 * point_ind] = point_ind;
+    points[3 * point_ind + 1] = -point_ind;
+    points[3 * point_ind + 2] = point_ind % 7;
+  }
+  sv::ThreadPool* pool = sv::ThreadPool::Default();
+  std::vector<std::future<AxisAlignedBox>> boxes;
+  for (int task = 0; task < pool->NumThreads() + 1; ++task) {
+    boxes.push_back(pool->Submit([&points]() {
+      return AxisAlignedBox::FromPoints(points.data(), kNumPoints);
+    }));
+  }
+  for (std::future<AxisAlignedBox>& box : boxes) {
+    const AxisAlignedBox result = box.get();
+    EXPECT_EQ(QVector3D(0, 1 - kNumPoints, 0), result.Min());
+    EXPECT_EQ(QVector3D(kNumPoints - 1, 0, 6), result.Max());
+  }
+}
+
+// Transforms the eight corners of a box.
+static AxisAlignedBox TransformCorners(const AxisAlignedBox& box,
+    const QMatrix4x4& transform) {
+  AxisAlignedBox result;
+  for (int corner = 0; corner < 8; ++corner) {
+    const QVector3D point(corner & 1 ? box.Max().x() : box.Min().x(),
+        corner & 2 ? box.Max().y() : box.Min().y(),
+        corner & 4 ? box.Max().z() : box.Min().z());
+    result.IncludePoint(transform.map(point));
+  }
+  return result;
+}
+
+TEST(AxisAlignedBox, Transformed) {
+  const AxisAlignedBox box(QVector3D(-1, 2, 3), QVector3D(4, 5, 9));
+  for (int angle = 0; angle < 360; angle += 15) {
+    QMatrix4x4 transform;
+    transform.translate(3, -2, 7);
+    transform.rotate(angle, 1, 2, 3);
+    transform.scale(2, 1, 0.5);
+
+    const AxisAlignedBox expected = TransformCorners(box, transform);
+    const AxisAlignedBox transformed = box.Transformed(transform);
+    ExpectNear(expected.Min(), transformed.Min());
+    ExpectNear(expected.Max(), transformed.Max());
+  }
+
+  // Invalid boxes stay invalid.
+  QMatrix4x4 transform;
+  transform.translate(1, 2, 3);
+  EXPECT_FALSE(AxisAlignedBox().Transformed(transform).Valid());
+}
+
+TEST(AxisAlignedBox, TransformBatch) {
+  std::vector<AxisAlignedBox> boxes;
+  std::vector<QMatrix4x4> transforms;
+  for (int box_ind = 0; box_ind < 20; ++box_ind) {
+    boxes.push_back(AxisAlignedBox(QVector3D(box_ind, 0, -box_ind),
+          QVector3D(box_ind + 1, box_ind * 2, 1)));
+    QMatrix4x4 transform;
+    transform.rotate(box_ind * 17, 0, 0, 1);
+    transform.translate(box_ind, 1, 2);
+    transforms.push_back(transform);
+  }
+  boxes.push_back(AxisAlignedBox());
+  transforms.push_back(QMatrix4x4());
+
+  std::vector<AxisAlignedBox> result(boxes.size());
+  AxisAlignedBox::TransformBatch(boxes.data(), transforms.data(),
+      boxes.size(), result.data());
+  for (size_t box_ind = 0; box_ind + 1 < boxes.size(); ++box_ind) {
+    const AxisAlignedBox expected =
+      TransformCorners(boxes[box_ind], transforms[box_ind]);
+    ExpectNear(expected.Min(), result[box_ind].Min());
+    ExpectNear(expected.Max(), result[box_ind].Max());
+  }
+  EXPECT_FALSE(result.back().Valid());
+}
@@ -0,0 +1,183 @@
+// Copyright [2015] Albert Huang
+
+#include "sceneview/camera_image.hpp"
+
+#include <stdexcept>
+
+#include <QOpenGLTexture>
+
+namespace sv {
+
+namespace {
+
+typedef StreamingTextureResource::PixelFormat PixelFormat;
+
+bool IsBayer(CameraImage::Encoding encoding) {
+  return encoding == CameraImage::Encoding::kBayerRGGB8 ||
+    encoding == CameraImage::Encoding::kBayerBGGR8 ||
+    encoding == CameraImage::Encoding::kBayerGRBG8 ||
+    encoding == CameraImage::Encoding::kBayerGBRG8;
+}
+
+}  // namespace
+
+CameraImage::Ptr CameraImage::Create(const ResourceManager::Ptr& resources) {
+  return Ptr(new CameraImage(resources));
+}
+
+CameraImage::CameraImage(const ResourceManager::Ptr& resources) :
+  resources_(resources),
+  width_(0),
+  height_(0),
+  encoding_(Encoding::kRGB8),
+  planes_() {}
+
+void CameraImage::Initialize(int width, int height, Encoding encoding) {
+  if (width <= 0 || height <= 0) {
+    throw std::invalid_argument("Invalid image size");
+  }
+  const bool subsampled = encoding == Encoding::kNV12 ||
+    encoding == Encoding::kYUYV || IsBayer(encoding);
+  if (subsampled && (width % 2 || height % 2)) {
+    throw std::invalid_argument("Image size must be even");
+  }
+
+  width_ = width;
+  height_ = height;
+  encoding_ = encoding;
+  planes_.clear();
+
+  // Texels that are decoded together (a Bayer block, a YUYV pair, or
+  // depths across an edge) must not be blended by the texture sampler, so
+  // the shaders read them with nearest filtering and interpolate
+  // themselves.
+  bool nearest = true;
+  auto add_plane = [this](int plane_width, int plane_height,
+      PixelFormat format) {
+    StreamingTextureResource::Ptr plane = resources_->MakeStreamingTexture();
+    plane->Initialize(plane_width, plane_height, format);
+    planes_.push_back(plane);
+  };
+  switch (encoding) {
+    case Encoding::kRGB8:
+      add_plane(width, height, PixelFormat::kRGB8);
+      nearest = false;
+      break;
+    case Encoding::kBGRA8:
+      add_plane(width, height, PixelFormat::kBGRA8);
+      nearest = false;
+      break;
+    case Encoding::kMono8:
+      add_plane(width, height, PixelFormat::kR8);
+      nearest = false;
+      break;
+    case Encoding::kNV12:
+      add_plane(width, height, PixelFormat::kR8);
+      add_plane(width / 2, height / 2, PixelFormat::kRG8);
+      nearest = false;
+      break;
+    case Encoding::kYUYV:
+      add_plane(width / 2, height, PixelFormat::kRGBA8);
+      break;
+    case Encoding::kBayerRGGB8:
+    case Encoding::kBayerBGGR8:
+    case Encoding::kBayerGRBG8:
+    case Encoding::kBayerGBRG8:
+      add_plane(width, height, PixelFormat::kR8);
+      break;
+    case Encoding::kDepth16:
+      add_plane(width, height, PixelFormat::kR16);
+      break;
+  }
+  if (nearest) {
+    for (const StreamingTextureResource::Ptr& plane : planes_) {
+      plane->Texture()->setMinificationFilter(QOpenGLTexture::Nearest);
+      plane->Texture()->setMagnificationFilter(QOpenGLTexture::Nearest);
+    }
+  }
+}
+
+void CameraImage::Upload(const void* data, int stride) {
+  if (encoding_ != Encoding::kNV12) {
+    UploadPlanes({ data }, { stride });
+    return;
+  }
+  if (stride == 0) {
+    stride = width_;
+  }
+  const uint8_t* y_plane = static_cast<const uint8_t*>(data);
+  UploadPlanes({ y_plane, y_plane + static_cast<size_t>(stride) * height_ },
+      { stride, stride });
+}
+
+void CameraImage::UploadPlanes(const std::vector<const void*>& planes,
+    const std::vector<int>& strides) {
+  if (planes_.empty()) {
+    throw std::runtime_error("CameraImage not initialized");
+  }
+  if (planes.size() != planes_.size() || strides.size() != planes_.size()) {
+    throw std::invalid_argument("Wrong number of image planes");
+  }
+  for (size_t plane = 0; plane < planes_.size(); ++plane) {
+    planes_[plane]->Upload(planes[plane], strides[plane]);
+  }
+}
+
+StockResources::StockShaderId CameraImage::StockShader() const {
+  switch (encoding_) {
+    case Encoding::kRGB8:
+    case Encoding::kBGRA8:
+      return StockResources::kTextureUniformColorNoLighting;
+    case Encoding::kMono8:
+      return StockResources::kMonoImageNoLighting;
+    case Encoding::kNV12:
+      return StockResources::kNV12ImageNoLighting;
+    case Encoding::kYUYV:
+      return StockResources::kYUYVImageNoLighting;
+    case Encoding::kBayerRGGB8:
+    case Encoding::kBayerBGGR8:
+    case Encoding::kBayerGRBG8:
+    case Encoding::kBayerGBRG8:
+      return StockResources::kBayerImageNoLighting;
+    case Encoding::kDepth16:
+      return StockResources::kDepthImageNoLighting;
+  }
+  throw std::invalid_argument("Invalid image encoding");
+}
+
+void CameraImage::ApplyTo(const MaterialResource::Ptr& material) {
+  if (planes_.empty()) {
+    throw std::runtime_error("CameraImage not initialized");
+  }
+  if (StockShader() == StockResources::kTextureUniformColorNoLighting) {
+    material->AddTexture(kTexture0, planes_[0]->Texture());
+    return;
+  }
+
+  material->AddTexture("image_plane0", planes_[0]->Texture());
+  if (planes_.size() > 1) {
+    material->AddTexture("image_plane1", planes_[1]->Texture());
+  }
+  material->SetParam("image_size", static_cast<float>(width_),
+      static_cast<float>(height_));
+
+  // Position of the red pixel in each 2x2 block of the mosaic.
+  switch (encoding_) {
+    case Encoding::kBayerRGGB8:
+      material->SetParam("bayer_first_red", 0.0f, 0.0f);
+      break;
+    case Encoding::kBayerBGGR8:
+      material->SetParam("bayer_first_red", 1.0f, 1.0f);
+      break;
+    case Encoding::kBayerGRBG8:
+      material->SetParam("bayer_first_red", 1.0f, 0.0f);
+      break;
+    case Encoding::kBayerGBRG8:
+      material->SetParam("bayer_first_red", 0.0f, 1.0f);
+      break;
+    default:
+      break;
+  }
+}
+
+}  // namespace sv
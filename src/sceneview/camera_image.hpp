@@ -0,0 +1,161 @@
+// Copyright [2015] Albert Huang
+
+#ifndef SCENEVIEW_CAMERA_IMAGE_HPP__
+#define SCENEVIEW_CAMERA_IMAGE_HPP__
+
+#include <memory>
+#include <vector>
+
+#include <sceneview/material_resource.hpp>
+#include <sceneview/resource_manager.hpp>
+#include <sceneview/stock_resources.hpp>
+#include <sceneview/streaming_texture_resource.hpp>
+
+namespace sv {
+
+/**
+ * A live camera image, uploaded in the encoding that the camera delivers it
+ * in and converted to RGB on the GPU.
+ *
+ * Each plane of the image is a StreamingTextureResource, so an upload costs
+ * about as much as copying the raw image. The stock shader returned by
+ * StockShader() decodes the image when it's drawn: YUV images are
+ * converted to RGB, Bayer images are demosaiced, and depth images are
+ * colored by a colormap.
+ *
+ * @code
+ * // With the OpenGL context current:
+ * CameraImage::Ptr image = CameraImage::Create(resources);
+ * image->Initialize(1920, 1080, CameraImage::Encoding::kNV12);
+ *
+ * StockResources stock(resources);
+ * MaterialResource::Ptr material =
+ *     stock.NewMaterial(image->StockShader());
+ * image->ApplyTo(material);
+ * scene->MakeDrawNode(parent, quad, material);
+ *
+ * // For each frame:
+ * image->Upload(frame.data, frame.stride);
+ * @endcode
+ *
+ * The first row of the image is at texture coordinate v = 0.
+ *
+ * @ingroup sv_resources
+ * @headerfile sceneview/camera_image.hpp
+ */
+class CameraImage {
+  public:
+    typedef std::shared_ptr<CameraImage> Ptr;
+
+    /**
+     * Layout of the image data passed to Upload().
+     */
+    enum class Encoding {
+      /// 8-bit RGB.
+      kRGB8,
+      /// 8-bit BGRA, as delivered by many Windows and macOS drivers.
+      kBGRA8,
+      /// 8-bit grayscale.
+      kMono8,
+      /// A full resolution 8-bit Y plane, followed by a half resolution
+      /// plane of interleaved 8-bit U and V.
+      kNV12,
+      /// Packed 4:2:2 YUV, with two pixels stored as Y0 U Y1 V.
+      kYUYV,
+      /// 8-bit Bayer mosaic. The name gives the colors of the top left 2x2
+      /// block, row by row.
+      kBayerRGGB8,
+      kBayerBGGR8,
+      kBayerGRBG8,
+      kBayerGBRG8,
+      /// 16-bit unsigned depth, with 0 marking invalid pixels.
+      kDepth16,
+    };
+
+    static Ptr Create(const ResourceManager::Ptr& resources);
+
+    /**
+     * Allocates graphics memory for images of the specified size and
+     * encoding.
+     *
+     * Must be called with a current OpenGL context, before any call to
+     * Upload(). Materials that the image was applied to must be applied to
+     * again.
+     *
+     * @throw std::invalid_argument if the size is not positive, or not even
+     * for encodings with subsampled chroma or a Bayer mosaic.
+     */
+    void Initialize(int width, int height, Encoding encoding);
+
+    /**
+     * Replaces the image.
+     *
+     * Must be called with a current OpenGL context. For kNV12, the UV
+     * plane must follow the Y plane, with the same stride. Use
+     * UploadPlanes() if it doesn't.
+     *
+     * @param stride the number of bytes between the starts of consecutive
+     *        rows, or 0 if the rows are tightly packed.
+     */
+    void Upload(const void* data, int stride = 0);
+
+    /**
+     * Replaces an image whose planes are stored separately.
+     *
+     * @param planes the first byte of each plane.
+     * @param strides the row stride of each plane, in bytes, or 0 if the
+     *        rows are tightly packed.
+     *
+     * @throw std::invalid_argument if the number of planes or strides
+     * isn't NumPlanes().
+     */
+    void UploadPlanes(const std::vector<const void*>& planes,
+        const std::vector<int>& strides);
+
+    /**
+     * Retrieve the stock shader that draws images with this encoding.
+     */
+    StockResources::StockShaderId StockShader() const;
+
+    /**
+     * Sets the textures and parameters that the stock shader needs on a
+     * material.
+     *
+     * Depth images are mapped to colors as with
+     * StockResources::kDepthImageNoLighting, and the colormap texture must
+     * be added to the material separately.
+     */
+    void ApplyTo(const MaterialResource::Ptr& material);
+
+    int Width() const { return width_; }
+
+    int Height() const { return height_; }
+
+    Encoding GetEncoding() const { return encoding_; }
+
+    /**
+     * Returns the number of planes of the image: two for kNV12, and one
+     * otherwise.
+     */
+    int NumPlanes() const { return planes_.size(); }
+
+    /**
+     * Retrieve the texture that holds a plane of the image.
+     */
+    const StreamingTextureResource::Ptr& Plane(int plane) const {
+      return planes_[plane];
+    }
+
+  private:
+    explicit CameraImage(const ResourceManager::Ptr& resources);
+
+    ResourceManager::Ptr resources_;
+    int width_;
+    int height_;
+    Encoding encoding_;
+    std::vector<StreamingTextureResource::Ptr> planes_;
+};
+
+}  // namespace sv
+
+#endif  // SCENEVIEW_CAMERA_IMAGE_HPP__
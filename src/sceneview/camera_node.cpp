@@ -37,7 +37,7 @@ void CameraNode::CopyFrom(const CameraNode& other) {
 
   look_ = other.look_;
   up_ = other.up_;
-  SceneNode::SetTranslation(other.Translation());
+  SceneNode::SetPreciseTranslation(other.PreciseTranslation());
   SceneNode::SetRotation(other.Rotation());
 }
 
@@ -150,9 +150,15 @@ static QMatrix3x3 RotFromQuat(const QQuaternion& quat) {
 }
 
 void CameraNode::LookAt(const QVector3D& eye, const QVector3D& look_at,
+    const QVector3D& up) {
+  LookAt(Vector3d(eye), Vector3d(look_at), up);
+}
+
+void CameraNode::LookAt(const Vector3d& eye, const Vector3d& look_at,
     const QVector3D& up_denorm) {
-  look_at_ = look_at;
-  const QVector3D look_denorm = look_at - eye;
+  // The eye and look at point are close together, so their difference is
+  // accurate in single precision even when they aren't.
+  const QVector3D look_denorm = (look_at - eye).ToVector3D();
   if (look_denorm.length() < 1e-9) {
     throw std::invalid_argument("eye and look_at are too close!");
   }
@@ -165,7 +171,8 @@ void CameraNode::LookAt(const QVector3D& eye, const QVector3D& look_at,
   const float rot_data[] = { right.x(), up.x(), -look.x(),
                        right.y(), up.y(), -look.y(),
                        right.z(), up.z(), -look.z() };
-  SetTranslation(eye);
+  look_at_ = look_at;
+  SetPreciseTranslation(eye);
   SetRotation(QuatFromRot(QMatrix3x3(rot_data)));
 
   if (proj_type_ == kOrthographic) {
@@ -178,7 +185,7 @@ QVector3D CameraNode::GetLookDir() const {
 }
 
 QVector3D CameraNode::GetLookAt() const {
-  return look_at_;
+  return look_at_.ToVector3D();
 }
 
 QVector3D CameraNode::GetUpDir() const {
@@ -213,6 +220,10 @@ QMatrix4x4 CameraNode::GetViewMatrix() {
   return WorldTransform().inverted();
 }
 
+QMatrix4x4 CameraNode::GetRelativeViewMatrix() {
+  return RelativeTransform(WorldOrigin()).inverted();
+}
+
 QMatrix4x4 CameraNode::GetViewProjectionMatrix() {
   return projection_matrix_ * GetViewMatrix();
 }
@@ -238,7 +249,8 @@ void CameraNode::ComputeProjectionMatrix() {
   switch (proj_type_) {
     case ProjectionType::kOrthographic:
       {
-        const double dist_to_look_at = (Translation() - look_at_).length();
+        const double dist_to_look_at =
+          (PreciseTranslation() - look_at_).ToVector3D().length();
         const double bottom = dist_to_look_at * tan(vfov / 2);
         const double right = bottom * aspect;
         projection_matrix_(0, 0) = 1 / right;
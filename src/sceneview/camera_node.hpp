@@ -90,6 +90,16 @@ class CameraNode : public SceneNode {
     void LookAt(const QVector3D& eye, const QVector3D& look_at,
         const QVector3D& up);
 
+    /**
+     * Rotate and translate the camera to look at the specified point, with
+     * the eye and look at point in double precision.
+     *
+     * Use this for cameras far from the world origin, where a QVector3D
+     * can't position the camera to within a pixel.
+     */
+    void LookAt(const Vector3d& eye, const Vector3d& look_at,
+        const QVector3D& up);
+
     /**
      * Retrieve the vertical field of view, in degrees.
      */
@@ -115,6 +125,11 @@ class CameraNode : public SceneNode {
      */
     QVector3D GetLookAt() const;
 
+    /**
+     * Retrieve the look at point in double precision.
+     */
+    const Vector3d& GetPreciseLookAt() const { return look_at_; }
+
     /**
      * Retrieve the camera's up vector.
      */
@@ -141,6 +156,20 @@ class CameraNode : public SceneNode {
      */
     QMatrix4x4 GetViewMatrix();
 
+    /**
+     * Retrieve the view matrix of the camera as if it were at the world
+     * origin, i.e., with only its rotation.
+     *
+     * Combined with SceneNode::RelativeTransform() of WorldOrigin(), this
+     * gives model-view matrices that are accurate far from the world
+     * origin:
+     * @code
+     * camera->GetRelativeViewMatrix() *
+     *     node->RelativeTransform(camera->WorldOrigin());
+     * @endcode
+     */
+    QMatrix4x4 GetRelativeViewMatrix();
+
     /**
      * Gets the combined projection and view matrix.
      *
@@ -168,7 +197,7 @@ class CameraNode : public SceneNode {
 
     QVector3D look_;
     QVector3D up_;
-    QVector3D look_at_;
+    Vector3d look_at_;
 
     int viewport_width_ = 0;
     int viewport_height_ = 0;
@@ -0,0 +1,330 @@
+// Copyright [2015] Albert Huang
+
+#include "sceneview/internal_gl.hpp"
+
+#include "sceneview/chunked_mesh_resource.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <tuple>
+#include <vector>
+
+#include "sceneview/view_frustum.hpp"
+
+#if 0
+#define dbg(fmt, ...) printf(fmt, __VA_ARGS__)
+#else
+#define dbg(...)
+#endif
+
+namespace sv {
+
+bool ChunkedMeshResource::BlockCoord::operator<(
+    const BlockCoord& other) const {
+  return std::tie(x, y, z) < std::tie(other.x, other.y, other.z);
+}
+
+ChunkedMeshResource::ChunkedMeshResource(const QString& name) :
+  GeometryResource(name, true),
+  index_capacity_(0),
+  batch_depth_(0),
+  bounds_stale_(false),
+  bounds_changed_(false),
+  num_visible_blocks_(0) {}
+
+ChunkedMeshResource::~ChunkedMeshResource() {}
+
+void ChunkedMeshResource::Initialize(GLenum gl_mode,
+    const std::vector<VertexAttribute>& attributes,
+    int vertex_capacity, int index_capacity) {
+  if (gl_mode != GL_POINTS && gl_mode != GL_LINES &&
+      gl_mode != GL_TRIANGLES) {
+    throw std::invalid_argument("Unsupported primitive type for a chunked "
+        "mesh");
+  }
+  if (std::find(attributes.begin(), attributes.end(),
+        VertexAttribute::kVertices) == attributes.end()) {
+    throw std::invalid_argument("Chunked mesh must have vertices");
+  }
+
+  for (int attr_ind = 0; attr_ind < kNumVertexAttributes; ++attr_ind) {
+    present_[attr_ind] = false;
+    counts_[attr_ind] = 0;
+  }
+  for (VertexAttribute attribute : attributes) {
+    present_[static_cast<int>(attribute)] = true;
+  }
+
+  gl_mode_ = gl_mode;
+  num_indices_ = 0;
+  index_type_ = GL_UNSIGNED_INT;
+  primitive_restart_ = false;
+  blocks_.clear();
+  draw_ranges_.clear();
+  num_visible_blocks_ = 0;
+
+  vertex_capacity = std::max(vertex_capacity, 1);
+  vbo_.setUsagePattern(QOpenGLBuffer::DynamicDraw);
+  AllocateVBO(vertex_capacity, false);
+  vbo_.release();
+  vertex_allocator_ = RangeAllocator(vertex_capacity);
+
+  index_capacity_ = 0;
+  if (index_buffer_.isCreated()) {
+    index_buffer_.destroy();
+  }
+  index_allocator_ = RangeAllocator();
+  GrowIndexPool(std::max(index_capacity, 1));
+
+  bounding_box_ = AxisAlignedBox();
+  bounds_stale_ = false;
+  bounds_changed_ = false;
+  NotifyBoundingBoxChanged();
+}
+
+void ChunkedMeshResource::UpsertBlock(const BlockCoord& coord,
+    const GeometryDataView& data) {
+  if (!created_vbo_) {
+    throw std::logic_error("Initialize() must be called before UpsertBlock()");
+  }
+
+  // Check inputs
+  const StridedSpan* spans[kNumVertexAttributes];
+  GetSpans(data, spans);
+  const int num_vertices = data.vertices.count;
+  CheckSpans(spans, num_vertices,
+      "Block data doesn't match the mesh attributes");
+  if (num_vertices == 0 || data.num_indices <= 0 || !data.indices) {
+    throw std::invalid_argument("Blocks must have vertices and indices");
+  }
+  for (int index_ind = 0; index_ind < data.num_indices; ++index_ind) {
+    if (data.indices[index_ind] >= static_cast<uint32_t>(num_vertices)) {
+      throw std::invalid_argument("Vertex index out of range");
+    }
+  }
+
+  auto iter = blocks_.find(coord);
+  if (iter != blocks_.end()) {
+    FreeBlock(iter->second);
+  } else {
+    iter = blocks_.insert(std::make_pair(coord, Block())).first;
+  }
+  Block& block = iter->second;
+
+  // Allocate room in the pools, growing them if needed.
+  block.num_vertices = num_vertices;
+  block.first_vertex = vertex_allocator_.Allocate(num_vertices);
+  if (block.first_vertex < 0) {
+    GrowVertexPool(num_vertices);
+    block.first_vertex = vertex_allocator_.Allocate(num_vertices);
+  }
+  block.num_indices = data.num_indices;
+  block.first_index = index_allocator_.Allocate(data.num_indices);
+  if (block.first_index < 0) {
+    GrowIndexPool(data.num_indices);
+    block.first_index = index_allocator_.Allocate(data.num_indices);
+  }
+
+  vbo_.bind();
+  for (int attr_ind = 0; attr_ind < kNumVertexAttributes; ++attr_ind) {
+    if (present_[attr_ind]) {
+      WriteSpan(static_cast<VertexAttribute>(attr_ind), block.first_vertex,
+          *spans[attr_ind]);
+    }
+  }
+  vbo_.release();
+  UpdateVertexCounts();
+
+  // Indices refer to the whole vertex pool.
+  indices_.resize(data.num_indices);
+  for (int index_ind = 0; index_ind < data.num_indices; ++index_ind) {
+    indices_[index_ind] = data.indices[index_ind] + block.first_vertex;
+  }
+  index_buffer_.bind();
+  BufferSubData(&index_buffer_,
+      static_cast<qint64>(block.first_index) * sizeof(uint32_t),
+      indices_.data(),
+      static_cast<qint64>(data.num_indices) * sizeof(uint32_t));
+  index_buffer_.release();
+  num_indices_ = index_capacity_;
+
+  block.box = AxisAlignedBox::FromPoints(data.vertices.data, num_vertices,
+      data.vertices.stride);
+  if (block.box.Valid()) {
+    AxisAlignedBox box = bounding_box_;
+    box.IncludeBox(block.box);
+    if (!bounding_box_.Valid() || box.Min() != bounding_box_.Min() ||
+        box.Max() != bounding_box_.Max()) {
+      bounding_box_ = box;
+      bounds_changed_ = true;
+    }
+  }
+  UpdateBoundingBox();
+  dbg("%s: block (%d, %d, %d) has %d vertices, %d indices\n",
+      name_.toStdString().c_str(), coord.x, coord.y, coord.z, num_vertices,
+      data.num_indices);
+}
+
+void ChunkedMeshResource::RemoveBlock(const BlockCoord& coord) {
+  auto iter = blocks_.find(coord);
+  if (iter == blocks_.end()) {
+    return;
+  }
+  FreeBlock(iter->second);
+  blocks_.erase(iter);
+  UpdateVertexCounts();
+  if (blocks_.empty()) {
+    num_indices_ = 0;
+  }
+  UpdateBoundingBox();
+}
+
+bool ChunkedMeshResource::HasBlock(const BlockCoord& coord) const {
+  return blocks_.count(coord) > 0;
+}
+
+void ChunkedMeshResource::Clear() {
+  blocks_.clear();
+  vertex_allocator_.Clear();
+  index_allocator_.Clear();
+  UpdateVertexCounts();
+  draw_ranges_.clear();
+  num_visible_blocks_ = 0;
+  num_indices_ = 0;
+  bounds_stale_ = true;
+  UpdateBoundingBox();
+}
+
+void ChunkedMeshResource::BeginBatch() {
+  ++batch_depth_;
+}
+
+void ChunkedMeshResource::EndBatch() {
+  if (batch_depth_ == 0) {
+    throw std::logic_error("EndBatch() called without BeginBatch()");
+  }
+  --batch_depth_;
+  UpdateBoundingBox();
+}
+
+void ChunkedMeshResource::DrawRange(int range, int* first, int* count) const {
+  *first = draw_ranges_[range].first;
+  *count = draw_ranges_[range].second;
+}
+
+void ChunkedMeshResource::PrepareDrawRanges(
+    const QMatrix4x4& model_view_projection) {
+  const ViewFrustum frustum(model_view_projection);
+  draw_ranges_.clear();
+  for (const auto& item : blocks_) {
+    const Block& block = item.second;
+    if (block.box.Valid() && frustum.Intersects(block.box)) {
+      draw_ranges_.push_back(
+          std::make_pair(block.first_index, block.num_indices));
+    }
+  }
+  num_visible_blocks_ = draw_ranges_.size();
+
+  // Merge ranges that are adjacent in the index buffer.
+  std::sort(draw_ranges_.begin(), draw_ranges_.end());
+  int num_merged = 0;
+  for (const std::pair<int, int>& range : draw_ranges_) {
+    if (num_merged > 0) {
+      std::pair<int, int>& last = draw_ranges_[num_merged - 1];
+      if (last.first + last.second == range.first) {
+        last.second += range.second;
+        continue;
+      }
+    }
+    draw_ranges_[num_merged++] = range;
+  }
+  draw_ranges_.resize(num_merged);
+}
+
+void ChunkedMeshResource::FreeBlock(const Block& block) {
+  vertex_allocator_.Free(block.first_vertex, block.num_vertices);
+  index_allocator_.Free(block.first_index, block.num_indices);
+
+  // Only blocks on the boundary of the bounding box can shrink it.
+  if (block.box.Valid()) {
+    const QVector3D& bmin = bounding_box_.Min();
+    const QVector3D& bmax = bounding_box_.Max();
+    for (int axis = 0; axis < 3; ++axis) {
+      if (block.box.Min()[axis] <= bmin[axis] ||
+          block.box.Max()[axis] >= bmax[axis]) {
+        bounds_stale_ = true;
+        break;
+      }
+    }
+  }
+}
+
+void ChunkedMeshResource::UpdateVertexCounts() {
+  // Vertices past the end of the last block are unused, and don't need to
+  // be copied when the pool grows.
+  const int num_vertices = vertex_allocator_.End();
+  for (int attr_ind = 0; attr_ind < kNumVertexAttributes; ++attr_ind) {
+    counts_[attr_ind] = present_[attr_ind] ? num_vertices : 0;
+  }
+}
+
+void ChunkedMeshResource::GrowVertexPool(int min_capacity) {
+  const int capacity = GrowCapacity(capacity_,
+      static_cast<qint64>(capacity_) + min_capacity);
+  AllocateVBO(capacity, true);
+  vbo_.release();
+  vertex_allocator_.Grow(capacity);
+  dbg("%s: vertex pool grew to %d\n", name_.toStdString().c_str(), capacity);
+}
+
+void ChunkedMeshResource::GrowIndexPool(int min_capacity) {
+  const int capacity = GrowCapacity(index_capacity_,
+      static_cast<qint64>(index_capacity_) + min_capacity);
+  QOpenGLBuffer new_buffer(QOpenGLBuffer::IndexBuffer);
+  new_buffer.setUsagePattern(QOpenGLBuffer::DynamicDraw);
+  new_buffer.create();
+  new_buffer.bind();
+  BufferData(&new_buffer,
+      BufferSize(static_cast<qint64>(capacity) * sizeof(uint32_t)));
+  if (index_allocator_.NumAllocated()) {
+    CopyBufferSubData(&index_buffer_, 0, &new_buffer, 0,
+        static_cast<qint64>(index_allocator_.End()) * sizeof(uint32_t));
+  }
+  new_buffer.release();
+
+  if (index_buffer_.isCreated()) {
+    index_buffer_.destroy();
+  }
+  index_buffer_ = new_buffer;
+  index_capacity_ = capacity;
+  index_allocator_.Grow(capacity);
+  if (num_indices_) {
+    num_indices_ = index_capacity_;
+  }
+  dbg("%s: index pool grew to %d\n", name_.toStdString().c_str(), capacity);
+}
+
+void ChunkedMeshResource::UpdateBoundingBox() {
+  if (batch_depth_ > 0) {
+    return;
+  }
+  if (bounds_stale_) {
+    AxisAlignedBox box;
+    for (const auto& item : blocks_) {
+      if (item.second.box.Valid()) {
+        box.IncludeBox(item.second.box);
+      }
+    }
+    bounds_changed_ = bounds_changed_ || box.Valid() != bounding_box_.Valid()
+      || (box.Valid() && (box.Min() != bounding_box_.Min() ||
+                          box.Max() != bounding_box_.Max()));
+    bounding_box_ = box;
+    bounds_stale_ = false;
+  }
+  if (bounds_changed_) {
+    bounds_changed_ = false;
+    NotifyBoundingBoxChanged();
+  }
+}
+
+}  // namespace sv
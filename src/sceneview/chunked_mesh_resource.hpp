@@ -0,0 +1,210 @@
+// Copyright [2015] Albert Huang
+
+#ifndef SCENEVIEW_CHUNKED_MESH_RESOURCE_HPP__
+#define SCENEVIEW_CHUNKED_MESH_RESOURCE_HPP__
+
+#include <map>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <sceneview/axis_aligned_box.hpp>
+#include <sceneview/geometry_resource.hpp>
+#include <sceneview/range_allocator.hpp>
+
+namespace sv {
+
+/**
+ * Mesh made of independently replaceable blocks, such as the output of an
+ * incremental surface reconstruction.
+ *
+ * Each block is identified by an integer block coordinate, and can be
+ * inserted, replaced or removed without touching the other blocks. All
+ * blocks share one vertex buffer and one index buffer, managed as pools by
+ * RangeAllocator. When a pool runs out of room its capacity is doubled, and
+ * the existing contents are copied within graphics memory.
+ *
+ * @code
+ * mesh->Initialize(GL_TRIANGLES,
+ *     { VertexAttribute::kVertices, VertexAttribute::kNormals });
+ * scene->MakeDrawNode(scene->Root(), mesh, material);
+ *
+ * // For each batch of updated blocks:
+ * mesh->BeginBatch();
+ * for (const MeshBlock& block : updated_blocks) {
+ *   GeometryDataView view;
+ *   view.vertices = StridedSpan(block.vertices.data(), block.num_vertices);
+ *   view.normals = StridedSpan(block.normals.data(), block.num_vertices);
+ *   view.indices = block.indices.data();
+ *   view.num_indices = block.indices.size();
+ *   mesh->UpsertBlock({ block.x, block.y, block.z }, view);
+ * }
+ * mesh->EndBatch();
+ * @endcode
+ *
+ * The cost of updating a block depends only on the size of the block, and
+ * not on the number of blocks. When drawn, blocks outside the view frustum
+ * are skipped, and visible blocks that are adjacent in the index buffer are
+ * drawn with a single glDrawElements() call.
+ *
+ * Blocks are the unit of update, so Load(), LoadAndKeep(), Reserve(),
+ * Update(), SetLods() and GenerateLods() aren't supported, and throw
+ * std::logic_error.
+ *
+ * ChunkedMeshResource objects cannot be directly instantiated. Instead, use
+ * ResourceManager.
+ *
+ * @ingroup sv_resources
+ * @headerfile sceneview/chunked_mesh_resource.hpp
+ */
+class ChunkedMeshResource : public GeometryResource {
+  public:
+    typedef std::shared_ptr<ChunkedMeshResource> Ptr;
+
+    /**
+     * Integer coordinate of a block.
+     */
+    struct BlockCoord {
+      int x;
+      int y;
+      int z;
+
+      bool operator<(const BlockCoord& other) const;
+    };
+
+    ~ChunkedMeshResource();
+
+    /**
+     * Discards any existing blocks, and allocates the vertex and index
+     * pools.
+     *
+     * Must be called with a current OpenGL context, before any call to
+     * UpsertBlock().
+     *
+     * @param gl_mode the primitive type. Must be GL_POINTS, GL_LINES or
+     *        GL_TRIANGLES, so that adjacent blocks can be drawn together.
+     * @param attributes the vertex attributes that blocks provide.
+     *        VertexAttribute::kVertices must be included.
+     * @param vertex_capacity the initial size of the vertex pool.
+     * @param index_capacity the initial size of the index pool.
+     *
+     * @throw std::invalid_argument if the primitive type isn't supported, or
+     * the attributes don't include vertices.
+     */
+    void Initialize(GLenum gl_mode,
+        const std::vector<VertexAttribute>& attributes,
+        int vertex_capacity = 65536, int index_capacity = 196608);
+
+    /**
+     * Inserts a block, or replaces it if it already exists.
+     *
+     * Each attribute passed to Initialize() must have a span with as many
+     * values as @p data.vertices. Spans of other attributes must be empty.
+     * Indices are required, and refer to the vertices of the block.
+     * @p data.gl_mode is ignored.
+     *
+     * @throw std::invalid_argument if the spans don't match the attributes
+     * passed to Initialize(), there are no indices, or an index refers to a
+     * vertex that doesn't exist.
+     */
+    void UpsertBlock(const BlockCoord& coord, const GeometryDataView& data);
+
+    /**
+     * Removes a block. Does nothing if the block doesn't exist.
+     */
+    void RemoveBlock(const BlockCoord& coord);
+
+    /**
+     * Returns true if a block exists.
+     */
+    bool HasBlock(const BlockCoord& coord) const;
+
+    /**
+     * Removes all blocks, but keeps the pools.
+     */
+    void Clear();
+
+    /**
+     * Starts a batch of changes.
+     *
+     * Until the matching EndBatch(), the bounding box isn't recomputed and
+     * listeners aren't notified of changes to it. Batches may be nested.
+     */
+    void BeginBatch();
+
+    /**
+     * Ends a batch of changes started with BeginBatch().
+     */
+    void EndBatch();
+
+    /**
+     * Retrieve the number of blocks.
+     */
+    int NumBlocks() const { return blocks_.size(); }
+
+    /**
+     * Retrieve the number of blocks that were inside the view frustum the
+     * last time the mesh was drawn.
+     */
+    int NumVisibleBlocks() const { return num_visible_blocks_; }
+
+    int NumDrawRanges() const override { return draw_ranges_.size(); }
+
+    void DrawRange(int range, int* first, int* count) const override;
+
+    void PrepareDrawRanges(const QMatrix4x4& model_view_projection) override;
+
+  private:
+    friend class ResourceManager;
+
+    struct Block {
+      int first_vertex;
+      int num_vertices;
+      int first_index;
+      int num_indices;
+      AxisAlignedBox box;
+    };
+
+    explicit ChunkedMeshResource(const QString& name);
+
+    void FreeBlock(const Block& block);
+
+    // Sets the attribute counts to the end of the last block in the vertex
+    // pool.
+    void UpdateVertexCounts();
+
+    void GrowVertexPool(int min_capacity);
+
+    void GrowIndexPool(int min_capacity);
+
+    // Recomputes the bounding box if needed, and notifies listeners if it
+    // changed.
+    void UpdateBoundingBox();
+
+    std::map<BlockCoord, Block> blocks_;
+
+    RangeAllocator vertex_allocator_;
+    RangeAllocator index_allocator_;
+    int index_capacity_;
+
+    int batch_depth_;
+
+    // The bounding box may be too large, and must be recomputed from the
+    // blocks.
+    bool bounds_stale_;
+
+    // The bounding box changed, and listeners haven't been notified.
+    bool bounds_changed_;
+
+    // Ranges of the index buffer to draw, as (first index, number of
+    // indices).
+    std::vector<std::pair<int, int>> draw_ranges_;
+    int num_visible_blocks_;
+
+    // Reused to offset the indices of each block.
+    std::vector<uint32_t> indices_;
+};
+
+}  // namespace sv
+
+#endif  // SCENEVIEW_CHUNKED_MESH_RESOURCE_HPP__
@@ -0,0 +1,79 @@
+// Copyright [2015] Albert Huang
+
+#include "sceneview/clip_volume.hpp"
+
+#include <stdexcept>
+
+namespace sv {
+
+ClipVolume::ClipVolume() :
+  has_section_box_(false) {}
+
+void ClipVolume::SetPlanes(const std::vector<Plane>& planes) {
+  const int num_box_planes = has_section_box_ ? 6 : 0;
+  if (planes.size() + num_box_planes > kMaxPlanes) {
+    throw std::invalid_argument("Too many clip planes");
+  }
+  user_planes_ = planes;
+  UpdatePlanes();
+}
+
+void ClipVolume::SetSectionBox(const QMatrix4x4& transform,
+    const QVector3D& size) {
+  if (user_planes_.size() + 6 > kMaxPlanes) {
+    throw std::invalid_argument("Too many clip planes");
+  }
+  const QVector3D center = transform.column(3).toVector3D();
+  for (int axis = 0; axis < 3; ++axis) {
+    const QVector3D column = transform.column(axis).toVector3D();
+    const QVector3D normal = column.normalized();
+    const float half_size = size[axis] * column.length() / 2;
+    const float offset = QVector3D::dotProduct(normal, center);
+    box_planes_[2 * axis] = Plane(normal, half_size - offset);
+    box_planes_[2 * axis + 1] = Plane(-normal, half_size + offset);
+  }
+  has_section_box_ = true;
+  UpdatePlanes();
+}
+
+void ClipVolume::ClearSectionBox() {
+  has_section_box_ = false;
+  UpdatePlanes();
+}
+
+bool ClipVolume::Contains(const QVector3D& point) const {
+  for (const Plane& plane : planes_) {
+    if (plane.SignedDistance(point) < 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool ClipVolume::Excludes(const AxisAlignedBox& box) const {
+  if (!box.Valid()) {
+    return false;
+  }
+  const QVector3D& bmin = box.Min();
+  const QVector3D& bmax = box.Max();
+  for (const Plane& plane : planes_) {
+    // The corner of the box farthest along the normal.
+    const QVector3D& normal = plane.Normal();
+    const QVector3D corner(normal.x() > 0 ? bmax.x() : bmin.x(),
+        normal.y() > 0 ? bmax.y() : bmin.y(),
+        normal.z() > 0 ? bmax.z() : bmin.z());
+    if (plane.SignedDistance(corner) < 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void ClipVolume::UpdatePlanes() {
+  planes_ = user_planes_;
+  if (has_section_box_) {
+    planes_.insert(planes_.end(), box_planes_, box_planes_ + 6);
+  }
+}
+
+}  // namespace sv
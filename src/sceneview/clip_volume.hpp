@@ -0,0 +1,115 @@
+// Copyright [2015] Albert Huang
+
+#ifndef SCENEVIEW_CLIP_VOLUME_HPP__
+#define SCENEVIEW_CLIP_VOLUME_HPP__
+
+#include <vector>
+
+#include <QMatrix4x4>
+#include <QVector3D>
+
+#include <sceneview/axis_aligned_box.hpp>
+#include <sceneview/plane.hpp>
+
+namespace sv {
+
+/**
+ * A region of world space outside of which geometry is clipped away, made
+ * of user clip planes and an optional oriented section box.
+ *
+ * Each DrawGroup has a clip volume. DrawContext passes its planes to the
+ * stock shaders, which clip each primitive against them, and skips draw
+ * nodes whose world bounding box is entirely outside the volume, so that
+ * sectioning a large model also reduces the work done to draw it.
+ *
+ * @code
+ * // Hide everything above 2.5 m, e.g., the ceilings of a building.
+ * scene->GetDefaultDrawGroup()->GetClipVolume().SetPlanes({
+ *     Plane(0, 0, -1, 2.5) });
+ * @endcode
+ *
+ * @headerfile sceneview/clip_volume.hpp
+ */
+class ClipVolume {
+  public:
+    /**
+     * Largest number of planes, including the six planes of the section
+     * box. OpenGL implementations may support fewer, in which case the
+     * last planes are ignored when drawing.
+     */
+    static constexpr int kMaxPlanes = 8;
+
+    /**
+     * Constructs a volume that contains all of space.
+     */
+    ClipVolume();
+
+    /**
+     * Sets the user clip planes. Geometry is kept where the signed distance
+     * to every plane is non-negative.
+     *
+     * @throw std::invalid_argument if there would be more than kMaxPlanes
+     * planes.
+     */
+    void SetPlanes(const std::vector<Plane>& planes);
+
+    const std::vector<Plane>& UserPlanes() const { return user_planes_; }
+
+    /**
+     * Sets the section box, outside of which geometry is clipped.
+     *
+     * @param transform the pose of the center of the box. Should be rigid.
+     * @param size the size of the box along each of its axes.
+     *
+     * @throw std::invalid_argument if there would be more than kMaxPlanes
+     * planes.
+     */
+    void SetSectionBox(const QMatrix4x4& transform, const QVector3D& size);
+
+    /**
+     * Removes the section box.
+     */
+    void ClearSectionBox();
+
+    bool HasSectionBox() const { return has_section_box_; }
+
+    /**
+     * Retrieve all of the planes: the user planes, followed by the planes
+     * of the section box.
+     */
+    const std::vector<Plane>& Planes() const { return planes_; }
+
+    /**
+     * Returns true if nothing is clipped.
+     */
+    bool Empty() const { return planes_.empty(); }
+
+    /**
+     * Returns true if the point is inside the volume.
+     */
+    bool Contains(const QVector3D& point) const;
+
+    /**
+     * Returns true if the box is entirely outside the volume, so that
+     * anything in it is clipped away.
+     *
+     * The test is conservative: some boxes that are outside the volume near
+     * its edges are reported as not excluded. Invalid boxes are never
+     * excluded.
+     */
+    bool Excludes(const AxisAlignedBox& box) const;
+
+  private:
+    void UpdatePlanes();
+
+    std::vector<Plane> user_planes_;
+
+    bool has_section_box_;
+    Plane box_planes_[6];
+
+    std::vector<Plane> planes_;
+};
+
+}  // namespace sv
+
+#endif  // SCENEVIEW_CLIP_VOLUME_HPP__
@@ -0,0 +1,61 @@
+// Copyright [2015] Albert Huang
+
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+#include <vector>
+
+#include "sceneview/clip_volume.hpp"
+
+using sv::AxisAlignedBox;
+using sv::ClipVolume;
+using sv::Plane;
+
+TEST(ClipVolume, Planes) {
+  ClipVolume volume;
+  EXPECT_TRUE(volume.Empty());
+  EXPECT_TRUE(volume.Contains(QVector3D(1e6, -1e6, 1e6)));
+
+  // Keep everything below z = 2.5.
+  volume.SetPlanes({ Plane(0, 0, -1, 2.5) });
+  EXPECT_FALSE(volume.Empty());
+  EXPECT_TRUE(volume.Contains(QVector3D(10, 10, 2)));
+  EXPECT_FALSE(volume.Contains(QVector3D(10, 10, 3)));
+
+  EXPECT_TRUE(volume.Excludes(
+        AxisAlignedBox(QVector3D(0, 0, 3), QVector3D(1, 1, 4))));
+  EXPECT_FALSE(volume.Excludes(
+        AxisAlignedBox(QVector3D(0, 0, 2), QVector3D(1, 1, 4))));
+  EXPECT_FALSE(volume.Excludes(AxisAlignedBox()));
+}
+
+TEST(ClipVolume, SectionBox) {
+  ClipVolume volume;
+  QMatrix4x4 transform;
+  transform.translate(10, 0, 0);
+  transform.rotate(45, 0, 0, 1);
+  volume.SetSectionBox(transform, QVector3D(2, 2, 2));
+  ASSERT_TRUE(volume.HasSectionBox());
+  ASSERT_EQ(6u, volume.Planes().size());
+
+  EXPECT_TRUE(volume.Contains(QVector3D(10, 0, 0)));
+  // Inside along the diagonal of the rotated box, but outside along x.
+  EXPECT_TRUE(volume.Contains(QVector3D(11.3, 0, 0)));
+  EXPECT_FALSE(volume.Contains(QVector3D(10.8, 0.8, 0)));
+  EXPECT_FALSE(volume.Contains(QVector3D(10, 0, 1.1)));
+
+  EXPECT_TRUE(volume.Excludes(
+        AxisAlignedBox(QVector3D(-1, -1, -1), QVector3D(1, 1, 1))));
+  EXPECT_FALSE(volume.Excludes(
+        AxisAlignedBox(QVector3D(9, -1, -1), QVector3D(11, 1, 1))));
+
+  volume.SetPlanes({ Plane(0, 0, -1, 0), Plane(0, 1, 0, 0) });
+  EXPECT_EQ(8u, volume.Planes().size());
+  EXPECT_FALSE(volume.Contains(QVector3D(10, 0, 0.5)));
+  EXPECT_THROW(volume.SetPlanes(std::vector<Plane>(3, Plane(0, 0, 1, 0))),
+      std::invalid_argument);
+
+  volume.ClearSectionBox();
+  EXPECT_EQ(2u, volume.Planes().size());
+  EXPECT_TRUE(volume.Contains(QVector3D(100, 1, -1)));
+}
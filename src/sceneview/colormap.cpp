@@ -0,0 +1,108 @@
+// Copyright [2015] Albert Huang
+
+#include "sceneview/colormap.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace sv {
+
+// Viridis, sampled at nine evenly spaced values.
+static const int kNumViridisStops = 9;
+static const float kViridisStops[kNumViridisStops][3] = {
+  { 68, 1, 84 },
+  { 71, 44, 122 },
+  { 59, 81, 139 },
+  { 44, 113, 142 },
+  { 33, 144, 141 },
+  { 39, 173, 129 },
+  { 92, 200, 99 },
+  { 170, 220, 50 },
+  { 253, 231, 37 }
+};
+
+static uint8_t ToByte(float value) {
+  return static_cast<uint8_t>(
+      std::min(std::max(value, 0.0f), 1.0f) * 255 + 0.5f);
+}
+
+static void Viridis(float value, float* rgb) {
+  const float position = value * (kNumViridisStops - 1);
+  const int stop = std::min(static_cast<int>(position),
+      kNumViridisStops - 2);
+  const float t = position - stop;
+  for (int channel = 0; channel < 3; ++channel) {
+    rgb[channel] = ((1 - t) * kViridisStops[stop][channel] +
+        t * kViridisStops[stop + 1][channel]) / 255;
+  }
+}
+
+std::vector<uint8_t> ColormapRgba(Colormap colormap, int size) {
+  if (size < 2) {
+    throw std::invalid_argument("A colormap needs at least two samples");
+  }
+
+  std::vector<uint8_t> result(4 * size);
+  for (int ind = 0; ind < size; ++ind) {
+    const float value = static_cast<float>(ind) / (size - 1);
+    float rgb[3];
+    switch (colormap) {
+      case Colormap::kGrayscale:
+        rgb[0] = rgb[1] = rgb[2] = value;
+        break;
+      case Colormap::kJet:
+        rgb[0] = 1.5f - std::fabs(4 * value - 3);
+        rgb[1] = 1.5f - std::fabs(4 * value - 2);
+        rgb[2] = 1.5f - std::fabs(4 * value - 1);
+        break;
+      case Colormap::kViridis:
+        Viridis(value, rgb);
+        break;
+      default:
+        throw std::invalid_argument("Invalid colormap");
+    }
+    result[4 * ind] = ToByte(rgb[0]);
+    result[4 * ind + 1] = ToByte(rgb[1]);
+    result[4 * ind + 2] = ToByte(rgb[2]);
+    result[4 * ind + 3] = 255;
+  }
+  return result;
+}
+
+std::vector<uint8_t> LabelPaletteRgba(int num_labels) {
+  const float kGoldenRatioConjugate = 0.618033988749895f;
+  const float kSaturation = 0.65f;
+  const float kValue = 0.95f;
+
+  std::vector<uint8_t> result(4 * std::max(num_labels, 0));
+  float hue = 0;
+  for (int label = 0; label < num_labels; ++label) {
+    // HSV to RGB.
+    const float sector = hue * 6;
+    const int sector_ind = static_cast<int>(sector) % 6;
+    const float f = sector - std::floor(sector);
+    const float p = kValue * (1 - kSaturation);
+    const float q = kValue * (1 - kSaturation * f);
+    const float t = kValue * (1 - kSaturation * (1 - f));
+    float rgb[3];
+    switch (sector_ind) {
+      case 0: rgb[0] = kValue; rgb[1] = t; rgb[2] = p; break;
+      case 1: rgb[0] = q; rgb[1] = kValue; rgb[2] = p; break;
+      case 2: rgb[0] = p; rgb[1] = kValue; rgb[2] = t; break;
+      case 3: rgb[0] = p; rgb[1] = q; rgb[2] = kValue; break;
+      case 4: rgb[0] = t; rgb[1] = p; rgb[2] = kValue; break;
+      default: rgb[0] = kValue; rgb[1] = p; rgb[2] = q; break;
+    }
+    result[4 * label] = ToByte(rgb[0]);
+    result[4 * label + 1] = ToByte(rgb[1]);
+    result[4 * label + 2] = ToByte(rgb[2]);
+    result[4 * label + 3] = 255;
+
+    hue += kGoldenRatioConjugate;
+    hue -= std::floor(hue);
+  }
+  return result;
+}
+
+}  // namespace sv
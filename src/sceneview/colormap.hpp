@@ -0,0 +1,67 @@
+// Copyright [2015] Albert Huang
+
+#ifndef SCENEVIEW_COLORMAP_HPP__
+#define SCENEVIEW_COLORMAP_HPP__
+
+#include <cstdint>
+#include <vector>
+
+namespace sv {
+
+/**
+ * Colormaps for mapping scalar values to colors.
+ *
+ * @ingroup sv_resources
+ */
+enum class Colormap {
+  /**
+   * Black to white.
+   */
+  kGrayscale,
+
+  /**
+   * Blue through cyan, yellow and red.
+   */
+  kJet,
+
+  /**
+   * Dark purple through blue and green to yellow, with evenly increasing
+   * lightness.
+   */
+  kViridis
+};
+
+/**
+ * Samples a colormap at evenly spaced values from 0 to 1.
+ *
+ * The result is suitable for a @p size by 1 RGBA texture, such as the one
+ * read by the StockResources::kScalarColormapNoLighting shader.
+ *
+ * @return 4 * @p size bytes, as red, green, blue and alpha for each sample.
+ *
+ * @ingroup sv_resources
+ * @headerfile sceneview/colormap.hpp
+ */
+std::vector<uint8_t> ColormapRgba(Colormap colormap, int size = 256);
+
+/**
+ * Generates a palette of distinct colors for integer labels.
+ *
+ * Hues are spaced by the golden ratio, so that labels that are close
+ * together, which are often the most common ones, have clearly different
+ * colors however many labels there are.
+ *
+ * The result is suitable for a @p num_labels by 1 RGBA texture, such as
+ * the one read by the StockResources::kLabelPaletteNoLighting shader.
+ *
+ * @return 4 * @p num_labels bytes, as red, green, blue and alpha for each
+ * label.
+ *
+ * @ingroup sv_resources
+ * @headerfile sceneview/colormap.hpp
+ */
+std::vector<uint8_t> LabelPaletteRgba(int num_labels);
+
+}  // namespace sv
+
+#endif  // SCENEVIEW_COLORMAP_HPP__
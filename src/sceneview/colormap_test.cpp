@@ -0,0 +1,74 @@
+// Copyright [2015] Albert Huang
+
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <stdexcept>
+#include <vector>
+
+#include "sceneview/colormap.hpp"
+
+using sv::Colormap;
+using sv::ColormapRgba;
+using sv::LabelPaletteRgba;
+
+TEST(Colormap, Endpoints) {
+  const std::vector<uint8_t> gray = ColormapRgba(Colormap::kGrayscale, 3);
+  ASSERT_EQ(12u, gray.size());
+  EXPECT_EQ(0, gray[0]);
+  EXPECT_EQ(128, gray[4]);
+  EXPECT_EQ(255, gray[8]);
+  EXPECT_EQ(255, gray[3]);
+
+  const std::vector<uint8_t> jet = ColormapRgba(Colormap::kJet);
+  ASSERT_EQ(4u * 256, jet.size());
+  // Starts blue and ends red.
+  EXPECT_GT(jet[2], jet[0]);
+  EXPECT_GT(jet[4 * 255], jet[4 * 255 + 2]);
+
+  const std::vector<uint8_t> viridis = ColormapRgba(Colormap::kViridis);
+  EXPECT_EQ(68, viridis[0]);
+  EXPECT_EQ(84, viridis[2]);
+  EXPECT_EQ(253, viridis[4 * 255]);
+  EXPECT_EQ(37, viridis[4 * 255 + 2]);
+
+  EXPECT_THROW(ColormapRgba(Colormap::kJet, 1), std::invalid_argument);
+}
+
+TEST(Colormap, ViridisLightness) {
+  const std::vector<uint8_t> viridis = ColormapRgba(Colormap::kViridis, 64);
+  int prev_lightness = -1;
+  for (int ind = 0; ind < 64; ++ind) {
+    const int lightness = 2 * viridis[4 * ind] + 7 * viridis[4 * ind + 1] +
+        viridis[4 * ind + 2];
+    EXPECT_GT(lightness, prev_lightness);
+    prev_lightness = lightness;
+  }
+}
+
+TEST(Colormap, LabelPalette) {
+  EXPECT_TRUE(LabelPaletteRgba(0).empty());
+
+  const int num_labels = 32;
+  const std::vector<uint8_t> palette = LabelPaletteRgba(num_labels);
+  ASSERT_EQ(4u * num_labels, palette.size());
+  for (int label = 0; label < num_labels; ++label) {
+    EXPECT_EQ(255, palette[4 * label + 3]);
+    for (int other = label + 1; other < num_labels; ++other) {
+      int distance = 0;
+      for (int channel = 0; channel < 3; ++channel) {
+        distance += std::abs(palette[4 * label + channel] -
+            palette[4 * other + channel]);
+      }
+      EXPECT_GT(distance, 0);
+    }
+    if (label > 0) {
+      int distance = 0;
+      for (int channel = 0; channel < 3; ++channel) {
+        distance += std::abs(palette[4 * label + channel] -
+            palette[4 * (label - 1) + channel]);
+      }
+      EXPECT_GT(distance, 100);
+    }
+  }
+}
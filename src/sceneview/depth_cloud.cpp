@@ -0,0 +1,192 @@
+// Copyright [2015] Albert Huang
+
+#include "sceneview/internal_gl.hpp"
+
+#include "sceneview/depth_cloud.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include <QOpenGLTexture>
+
+#include "sceneview/stock_resources.hpp"
+
+namespace sv {
+
+// Triangles whose corners differ in depth by more than this fraction of
+// the depth are taken to span a discontinuity.
+static const float kMeshEdgeRatio = 0.05;
+
+// Retrieves the grid for depth images of a size, creating it if needed.
+// Each vertex holds the pixel coordinates of a pixel.
+static GeometryResource::Ptr GetOrMakeGrid(
+    const ResourceManager::Ptr& resources, int width, int height,
+    DepthCloud::Mode mode) {
+  const bool mesh = mode == DepthCloud::Mode::kMesh;
+  const QString name = QString("geom:sv_depth_grid:%1x%2:%3")
+    .arg(width).arg(height).arg(mesh ? "mesh" : "points");
+  GeometryResource::Ptr geometry = resources->GetGeometry(name);
+  if (geometry) {
+    return geometry;
+  }
+
+  GeometryData gdata;
+  gdata.gl_mode = mesh ? GL_TRIANGLES : GL_POINTS;
+  gdata.vertices.reserve(width * height);
+  for (int y = 0; y < height; ++y) {
+    for (int x = 0; x < width; ++x) {
+      gdata.vertices.emplace_back(x, y, 0);
+    }
+  }
+  if (mesh) {
+    gdata.indices.reserve(6 * (width - 1) * (height - 1));
+    for (int y = 0; y + 1 < height; ++y) {
+      for (int x = 0; x + 1 < width; ++x) {
+        const uint32_t corner = y * width + x;
+        gdata.indices.insert(gdata.indices.end(), {
+            corner, corner + 1, corner + width,
+            corner + 1, corner + width + 1, corner + width });
+      }
+    }
+  }
+  geometry = resources->MakeGeometry(name);
+  geometry->Load(gdata);
+  return geometry;
+}
+
+DepthCloud::Ptr DepthCloud::Create(const ResourceManager::Ptr& resources,
+    int width, int height, Mode mode) {
+  if (width <= 0 || height <= 0) {
+    throw std::invalid_argument("Invalid depth image size");
+  }
+  StockResources stock(resources);
+  MaterialResource::Ptr material =
+    stock.NewMaterial(StockResources::kDepthCloudColormap);
+  material->AddTexture("colormap",
+      StockResources::ColormapTexture(Colormap::kJet));
+  return Ptr(new DepthCloud(resources,
+        GetOrMakeGrid(resources, width, height, mode), material, width,
+        height, mode));
+}
+
+DepthCloud::DepthCloud(const ResourceManager::Ptr& resources,
+    const GeometryResource::Ptr& geometry,
+    const MaterialResource::Ptr& material, int width, int height,
+    Mode mode) :
+  Drawable(geometry, material),
+  resources_(resources),
+  width_(width),
+  height_(height),
+  mode_(mode),
+  fx_(width),
+  fy_(width),
+  cx_(0.5 * (width - 1)),
+  cy_(0.5 * (height - 1)),
+  depth_scale_(0.001),
+  max_depth_(10),
+  colormap_min_(0),
+  colormap_max_(10),
+  colormap_range_set_(false),
+  depth_texture_(resources->MakeStreamingTexture()),
+  color_texture_(),
+  has_depth_(false),
+  box_() {
+  // Depths are read at exact pixels, and never blended across edges.
+  depth_texture_->Initialize(width, height,
+      StreamingTextureResource::PixelFormat::kR16);
+  depth_texture_->Texture()->setMinificationFilter(QOpenGLTexture::Nearest);
+  depth_texture_->Texture()->setMagnificationFilter(QOpenGLTexture::Nearest);
+  UpdateMaterial();
+  UpdateBoundingBox();
+}
+
+void DepthCloud::SetIntrinsics(float fx, float fy, float cx, float cy) {
+  fx_ = fx;
+  fy_ = fy;
+  cx_ = cx;
+  cy_ = cy;
+  UpdateMaterial();
+  UpdateBoundingBox();
+}
+
+void DepthCloud::SetDepthScale(float depth_scale) {
+  depth_scale_ = depth_scale;
+  UpdateMaterial();
+}
+
+void DepthCloud::SetMaxDepth(float max_depth) {
+  max_depth_ = max_depth;
+  if (!colormap_range_set_) {
+    colormap_max_ = max_depth;
+  }
+  UpdateMaterial();
+  UpdateBoundingBox();
+}
+
+void DepthCloud::SetColormapRange(float min_depth, float max_depth) {
+  colormap_min_ = min_depth;
+  colormap_max_ = max_depth;
+  colormap_range_set_ = true;
+  UpdateMaterial();
+}
+
+void DepthCloud::UploadDepth(const uint16_t* depth, int stride) {
+  depth_texture_->Upload(depth, stride);
+  has_depth_ = true;
+}
+
+void DepthCloud::UploadColor(const void* pixels, int stride,
+    StreamingTextureResource::PixelFormat format, int width, int height) {
+  if (width <= 0 || height <= 0) {
+    width = width_;
+    height = height_;
+  }
+  if (!color_texture_ || color_texture_->Format() != format ||
+      color_texture_->Width() != width ||
+      color_texture_->Height() != height) {
+    if (!color_texture_) {
+      color_texture_ = resources_->MakeStreamingTexture();
+      StockResources stock(resources_);
+      SetMaterial(stock.NewMaterial(StockResources::kDepthCloudColorImage));
+    }
+    color_texture_->Initialize(width, height, format);
+    Material()->AddTexture(kTexture0, color_texture_->Texture());
+    UpdateMaterial();
+  }
+  color_texture_->Upload(pixels, stride);
+}
+
+void DepthCloud::UpdateMaterial() {
+  const MaterialResource::Ptr& material = Material();
+  material->AddTexture("depth_image", depth_texture_->Texture());
+  material->SetParam("image_size", static_cast<float>(width_),
+      static_cast<float>(height_));
+  material->SetParam("depth_intrinsics", fx_, fy_, cx_, cy_);
+  material->SetParam("depth_scale", depth_scale_);
+  material->SetParam("depth_max", max_depth_);
+  material->SetParam("depth_edge_ratio",
+      mode_ == Mode::kMesh ? kMeshEdgeRatio : 0.0f);
+
+  // Only the colormap shader has a depth range.
+  if (!color_texture_) {
+    material->SetParam("depth_range", colormap_min_, colormap_max_);
+  }
+}
+
+void DepthCloud::UpdateBoundingBox() {
+  // The frustum is widest at the maximum depth, and comes to a point at
+  // the camera.
+  const float x0 = -cx_ / fx_ * max_depth_;
+  const float x1 = (width_ - 1 - cx_) / fx_ * max_depth_;
+  const float y0 = -cy_ / fy_ * max_depth_;
+  const float y1 = (height_ - 1 - cy_) / fy_ * max_depth_;
+  const AxisAlignedBox box(
+      QVector3D(std::min(x0, 0.0f), std::min(y0, 0.0f), 0),
+      QVector3D(std::max(x1, 0.0f), std::max(y1, 0.0f), max_depth_));
+  if (box != box_) {
+    box_ = box;
+    BoundingBoxChanged();
+  }
+}
+
+}  // namespace sv
@@ -0,0 +1,179 @@
+// Copyright [2015] Albert Huang
+
+#ifndef SCENEVIEW_DEPTH_CLOUD_HPP__
+#define SCENEVIEW_DEPTH_CLOUD_HPP__
+
+#include <cstdint>
+#include <memory>
+
+#include <sceneview/axis_aligned_box.hpp>
+#include <sceneview/drawable.hpp>
+#include <sceneview/resource_manager.hpp>
+#include <sceneview/streaming_texture_resource.hpp>
+
+namespace sv {
+
+/**
+ * Draws a depth image as 3D points or as a surface, back-projected on the
+ * GPU.
+ *
+ * Only the depth image, and optionally a color image, is uploaded for each
+ * frame. The geometry is a static grid with a vertex for each pixel, shared
+ * by all depth clouds of the same size, and the vertex shader reads the
+ * depth of its pixel and back-projects it with the pinhole camera
+ * intrinsics. Pixels with a depth of 0 or beyond the maximum depth are not
+ * drawn. Compared to building and loading a GeometryData for each frame,
+ * this uploads 2 bytes per pixel instead of about 24, and does no work on
+ * the CPU.
+ *
+ * Points are in the camera optical frame: x right, y down and z forward,
+ * in meters. Put the drawable in a DrawNode under the camera's pose.
+ *
+ * @code
+ * // With the OpenGL context current:
+ * DepthCloud::Ptr cloud = DepthCloud::Create(resources, 640, 480);
+ * cloud->SetIntrinsics(525.0, 525.0, 319.5, 239.5);
+ * scene->MakeDrawNode(camera_node)->Add(cloud);
+ *
+ * // For each frame:
+ * cloud->UploadDepth(depth_frame.data, depth_frame.stride);
+ * cloud->UploadColor(color_frame.data, color_frame.stride);
+ * @endcode
+ *
+ * Until UploadColor() is called, points are colored by depth with the
+ * StockResources::kDepthCloudColormap material. The colormap and other
+ * parameters can be changed on Material().
+ *
+ * @ingroup sv_scenegraph
+ * @headerfile sceneview/depth_cloud.hpp
+ */
+class DepthCloud : public Drawable {
+  public:
+    typedef std::shared_ptr<DepthCloud> Ptr;
+
+    /**
+     * How the grid of pixels is drawn.
+     */
+    enum class Mode {
+      /// A point for each pixel.
+      kPoints,
+      /// Triangles between neighboring pixels. Triangles that would be
+      /// stretched across a depth discontinuity aren't drawn.
+      kMesh,
+    };
+
+    /**
+     * Creates a depth cloud for depth images of the specified size.
+     *
+     * Must be called with a current OpenGL context.
+     *
+     * @throw std::invalid_argument if the size is not positive.
+     */
+    static Ptr Create(const ResourceManager::Ptr& resources, int width,
+        int height, Mode mode = Mode::kPoints);
+
+    /**
+     * Sets the pinhole intrinsics of the depth camera, in pixels, with
+     * pixel centers at integer coordinates.
+     */
+    void SetIntrinsics(float fx, float fy, float cx, float cy);
+
+    /**
+     * Sets the depth in meters of a raw depth unit. The default, 0.001, is
+     * for depth images in millimeters.
+     */
+    void SetDepthScale(float depth_scale);
+
+    /**
+     * Sets the maximum depth drawn, in meters. Also bounds the drawable's
+     * bounding box and, until SetColormapRange() is called, the depths
+     * mapped to the colormap. The default is 10.
+     */
+    void SetMaxDepth(float max_depth);
+
+    /**
+     * Sets the depths, in meters, mapped to the first and the last colors
+     * of the colormap. Has no effect once a color image is uploaded.
+     */
+    void SetColormapRange(float min_depth, float max_depth);
+
+    /**
+     * Replaces the depth image.
+     *
+     * Must be called with a current OpenGL context.
+     *
+     * @param stride the number of bytes between the starts of consecutive
+     *        rows, or 0 if the rows are tightly packed.
+     */
+    void UploadDepth(const uint16_t* depth, int stride = 0);
+
+    /**
+     * Replaces the color image, which must be registered to the depth
+     * image. It may have a different resolution.
+     *
+     * Must be called with a current OpenGL context. The first call switches
+     * the material to StockResources::kDepthCloudColorImage, and sets up a
+     * color texture of the specified size and format.
+     */
+    void UploadColor(const void* pixels, int stride = 0,
+        StreamingTextureResource::PixelFormat format =
+        StreamingTextureResource::PixelFormat::kRGB8,
+        int width = 0, int height = 0);
+
+    int Width() const { return width_; }
+
+    int Height() const { return height_; }
+
+    const StreamingTextureResource::Ptr& DepthTexture() const {
+      return depth_texture_;
+    }
+
+    const StreamingTextureResource::Ptr& ColorTexture() const {
+      return color_texture_;
+    }
+
+    /**
+     * Nothing is drawn until a depth image is uploaded.
+     */
+    bool PreDraw() override { return has_depth_; }
+
+    /**
+     * The part of the camera frustum up to the maximum depth.
+     */
+    const AxisAlignedBox& BoundingBox() override { return box_; }
+
+  private:
+    DepthCloud(const ResourceManager::Ptr& resources,
+        const GeometryResource::Ptr& geometry,
+        const MaterialResource::Ptr& material, int width, int height,
+        Mode mode);
+
+    void UpdateMaterial();
+
+    void UpdateBoundingBox();
+
+    ResourceManager::Ptr resources_;
+    int width_;
+    int height_;
+    Mode mode_;
+
+    float fx_;
+    float fy_;
+    float cx_;
+    float cy_;
+    float depth_scale_;
+    float max_depth_;
+    float colormap_min_;
+    float colormap_max_;
+    bool colormap_range_set_;
+
+    StreamingTextureResource::Ptr depth_texture_;
+    StreamingTextureResource::Ptr color_texture_;
+    bool has_depth_;
+
+    AxisAlignedBox box_;
+};
+
+}  // namespace sv
+
+#endif  // SCENEVIEW_DEPTH_CLOUD_HPP__
@@ -4,12 +4,17 @@
 
 #include "sceneview/draw_context.hpp"
 
+#include <algorithm>
 #include <cmath>
+#include <limits>
 #include <vector>
 
 #include <QOpenGLTexture>
+#include <QVector2D>
+#include <QVector4D>
 
 #include "sceneview/camera_node.hpp"
+#include "sceneview/clip_volume.hpp"
 #include "sceneview/draw_group.hpp"
 #include "sceneview/group_node.hpp"
 #include "sceneview/light_node.hpp"
@@ -119,11 +124,38 @@ static double squaredDistanceToAABB(const QVector3D& point,
   return vec.lengthSquared();
 }
 
+// Computes the diameter, in pixels, of the bounding sphere of a world frame
+// bounding box.
+static float ProjectedScreenSize(const AxisAlignedBox& box,
+    const QMatrix4x4& view_mat, const QMatrix4x4& proj_mat,
+    int viewport_height) {
+  if (!box.Valid()) {
+    return std::numeric_limits<float>::infinity();
+  }
+  const QVector3D center = view_mat.map((box.Max() + box.Min()) / 2);
+  const float radius = (box.Max() - box.Min()).length() / 2;
+
+  // Clip space w of the sphere center. This is the view depth for a
+  // perspective projection, and constant for an orthographic projection.
+  const float clip_w = proj_mat(3, 0) * center.x() +
+    proj_mat(3, 1) * center.y() + proj_mat(3, 2) * center.z() +
+    proj_mat(3, 3);
+  const bool perspective = proj_mat(3, 3) == 0;
+  if (clip_w <= 0 || (perspective && clip_w <= radius)) {
+    // The camera is inside or very close to the sphere.
+    return std::numeric_limits<float>::infinity();
+  }
+  return radius * proj_mat(1, 1) / clip_w * viewport_height;
+}
+
 DrawContext::DrawContext(const ResourceManager::Ptr& resources,
     const Scene::Ptr& scene) :
   resources_(resources),
   scene_(scene),
   clear_color_(0, 0, 0, 255),
+  screen_size_(0),
+  lod_level_(0),
+  lod_hysteresis_(0.1),
   bounding_box_node_(nullptr),
   draw_bounding_boxes_(false) {}
 
@@ -174,6 +206,11 @@ void DrawContext::Draw(int viewport_width,
   glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
   gl_point_size_ = 1;
   glPointSize(gl_point_size_);
+  gl_program_point_size_ = false;
+  glDisable(GL_VERTEX_PROGRAM_POINT_SIZE);
+#ifdef GL_POINT_SPRITE
+  glDisable(GL_POINT_SPRITE);
+#endif
   gl_line_width_ = 1;
   glLineWidth(gl_line_width_);
   gl_blend_ = false;
@@ -212,6 +249,10 @@ void DrawContext::SetClearColor(const QColor& color) {
   clear_color_ = color;
 }
 
+void DrawContext::SetLodHysteresis(float hysteresis) {
+  lod_hysteresis_ = hysteresis;
+}
+
 void DrawContext::SetDrawGroups(const std::vector<DrawGroup*>& groups) {
   draw_groups_ = groups;
   std::sort(draw_groups_.begin(), draw_groups_.end(),
@@ -291,6 +332,14 @@ void DrawContext::DrawDrawGroup(DrawGroup* dgroup) {
 
   Frustum frustum = cur_camera_;
   const QVector3D eye = cur_camera_->WorldTransform().map(QVector3D(0, 0, 0));
+  const QMatrix4x4 view_mat = cur_camera_->GetViewMatrix();
+  const QMatrix4x4 proj_mat = cur_camera_->GetProjectionMatrix();
+
+  // Everything is drawn relative to the camera, in double precision up to
+  // the model-view matrices.
+  camera_origin_ = cur_camera_->WorldOrigin();
+  clip_volume_ = &dgroup->GetClipVolume();
+  EnableClipPlanes(cur_camera_->GetRelativeViewMatrix());
 
   // Figure out which nodes to draw and some data about them.
   std::vector<DrawNodeData> to_draw;
@@ -320,7 +369,7 @@ void DrawContext::DrawDrawGroup(DrawGroup* dgroup) {
     dndata.node = draw_node;
 
     // Cache the model mat matrix and world frame bounding box
-    dndata.model_mat = draw_node->WorldTransform();
+    dndata.model_mat = draw_node->RelativeTransform(camera_origin_);
 
     // Compute the world frame axis-aligned bounding box
     dndata.world_bbox = draw_node->WorldBoundingBox();
@@ -332,6 +381,11 @@ void DrawContext::DrawDrawGroup(DrawGroup* dgroup) {
       continue;
     }
 
+    // Skip nodes that would be clipped away entirely.
+    if (clip_volume_->Excludes(dndata.world_bbox)) {
+      continue;
+    }
+
     dndata.squared_distance = squaredDistanceToAABB(eye,
         dndata.world_bbox);
 
@@ -363,12 +417,71 @@ void DrawContext::DrawDrawGroup(DrawGroup* dgroup) {
   for (DrawNodeData& dndata : to_draw) {
     const QString name = dndata.node->Name();
     model_mat_ = dndata.model_mat;
+    screen_size_ = ProjectedScreenSize(dndata.world_bbox, view_mat, proj_mat,
+        viewport_height_);
     DrawDrawNode(dndata.node);
 
     if (draw_bounding_boxes_) {
       DrawBoundingBox(dndata.world_bbox);
     }
   }
+
+  DisableClipPlanes();
+}
+
+void DrawContext::EnableClipPlanes(const QMatrix4x4& view_mat) {
+  if (max_clip_planes_ < 0) {
+    glGetIntegerv(GL_MAX_CLIP_PLANES, &max_clip_planes_);
+  }
+
+  const std::vector<Plane>& planes = clip_volume_->Planes();
+  num_clip_planes_ = planes.size();
+  if (num_clip_planes_ > max_clip_planes_) {
+    // This runs for every draw group in every frame, so only warn once.
+    // The extra planes stay disabled.
+    static bool warned = false;
+    if (!warned) {
+      qWarning("Too many clip planes. Max: %d", max_clip_planes_);
+      warned = true;
+    }
+    num_clip_planes_ = max_clip_planes_;
+  }
+
+  // Move the planes to the camera relative frame.
+  for (int plane_ind = 0; plane_ind < ClipVolume::kMaxPlanes; ++plane_ind) {
+    if (plane_ind >= num_clip_planes_) {
+      clip_planes_[plane_ind] = QVector4D();
+      continue;
+    }
+    const QVector3D& normal = planes[plane_ind].Normal();
+    const double offset = planes[plane_ind].D() +
+      normal.x() * camera_origin_.x + normal.y() * camera_origin_.y +
+      normal.z() * camera_origin_.z;
+    clip_planes_[plane_ind] = QVector4D(normal, offset);
+  }
+
+  // glClipPlane() transforms the planes by the inverse of the modelview
+  // matrix, so with the view matrix loaded they end up in eye space, where
+  // shaders that write gl_ClipVertex are clipped. Shaders that write
+  // gl_ClipDistance get the planes as the sv_clip_planes uniform instead.
+  glMatrixMode(GL_MODELVIEW);
+  glPushMatrix();
+  glLoadMatrixf(view_mat.constData());
+  for (int plane_ind = 0; plane_ind < num_clip_planes_; ++plane_ind) {
+    const QVector4D& plane = clip_planes_[plane_ind];
+    const GLdouble equation[4] = { plane.x(), plane.y(), plane.z(),
+      plane.w() };
+    glClipPlane(GL_CLIP_PLANE0 + plane_ind, equation);
+    glEnable(GL_CLIP_PLANE0 + plane_ind);
+  }
+  glPopMatrix();
+}
+
+void DrawContext::DisableClipPlanes() {
+  for (int plane_ind = 0; plane_ind < num_clip_planes_; ++plane_ind) {
+    glDisable(GL_CLIP_PLANE0 + plane_ind);
+  }
+  num_clip_planes_ = 0;
 }
 
 void DrawContext::DrawDrawNode(DrawNode* draw_node) {
@@ -388,6 +501,9 @@ void DrawContext::DrawDrawNode(DrawNode* draw_node) {
 
     ActivateMaterial();
 
+    geometry_->ProcessPendingLods();
+    lod_level_ = SelectLod(drawable.get());
+
     if (drawable->PreDraw()) {
       DrawGeometry();
     }
@@ -406,6 +522,24 @@ void DrawContext::DrawDrawNode(DrawNode* draw_node) {
   }
 }
 
+int DrawContext::SelectLod(Drawable* drawable) {
+  const int num_lods = geometry_->NumLods();
+  int level = std::min(drawable->lod_level_, num_lods - 1);
+
+  // Only switch levels once the screen size is past the threshold by some
+  // margin, so that drawables near a threshold don't flicker between levels.
+  while (level > 0 && screen_size_ >
+      geometry_->LodMaxScreenSize(level) * (1 + lod_hysteresis_)) {
+    level--;
+  }
+  while (level + 1 < num_lods && screen_size_ <
+      geometry_->LodMaxScreenSize(level + 1) * (1 - lod_hysteresis_)) {
+    level++;
+  }
+  drawable->lod_level_ = level;
+  return level;
+}
+
 void DrawContext::ActivateMaterial() {
   program_->bind();
 
@@ -465,6 +599,22 @@ void DrawContext::ActivateMaterial() {
     glPointSize(gl_point_size_);
   }
 
+  const bool mat_program_point_size = material_->ProgramPointSize();
+  if (gl_program_point_size_ != mat_program_point_size) {
+    gl_program_point_size_ = mat_program_point_size;
+    if (gl_program_point_size_) {
+      glEnable(GL_VERTEX_PROGRAM_POINT_SIZE);
+#ifdef GL_POINT_SPRITE
+      glEnable(GL_POINT_SPRITE);
+#endif
+    } else {
+      glDisable(GL_VERTEX_PROGRAM_POINT_SIZE);
+#ifdef GL_POINT_SPRITE
+      glDisable(GL_POINT_SPRITE);
+#endif
+    }
+  }
+
   const float mat_line_width = material_->LineWidth();
   if (gl_line_width_ != mat_line_width) {
     gl_line_width_ = mat_line_width;
@@ -490,10 +640,11 @@ void DrawContext::ActivateMaterial() {
     glBlendFunc(gl_sfactor_, gl_dfactor_);
   }
 
-  // Set shader standard variables
+  // Set shader standard variables. The world frame of the shaders is
+  // centered on the camera, see DrawDrawGroup().
   const ShaderStandardVariables& locs = shader_->StandardVariables();
   const QMatrix4x4 proj_mat = cur_camera_->GetProjectionMatrix();
-  const QMatrix4x4 view_mat = cur_camera_->GetViewMatrix();
+  const QMatrix4x4 view_mat = cur_camera_->GetRelativeViewMatrix();
 
   // Set uniform variables
   if (locs.sv_proj_mat >= 0) {
@@ -519,6 +670,14 @@ void DrawContext::ActivateMaterial() {
     program_->setUniformValue(locs.sv_model_normal_mat,
         model_mat_.normalMatrix());
   }
+  if (locs.sv_clip_planes >= 0) {
+    program_->setUniformValueArray(locs.sv_clip_planes, clip_planes_,
+        ClipVolume::kMaxPlanes);
+  }
+  if (locs.sv_viewport_size >= 0) {
+    program_->setUniformValue(locs.sv_viewport_size,
+        QVector2D(viewport_width_, viewport_height_));
+  }
 
   const std::vector<LightNode*>& lights = scene_->Lights();
   int num_lights = lights.size();
@@ -543,7 +702,8 @@ void DrawContext::ActivateMaterial() {
     }
 
     if (light_loc.position >= 0) {
-      const QVector3D light_pos = light_node->Translation();
+      const QVector3D light_pos =
+        (light_node->PreciseTranslation() - camera_origin_).ToVector3D();
       program_->setUniformValue(light_loc.position, light_pos);
     }
 
@@ -586,26 +746,45 @@ void DrawContext::ActivateMaterial() {
     const std::shared_ptr<QOpenGLTexture>& texture = item.second;
     texture->bind(texunit);
     program_->setUniformValue(texname.toStdString().c_str(), texunit);
+    ++texunit;
   }
 }
 
 static void SetupAttributeArray(QOpenGLShaderProgram* program,
     int location, int num_attributes,
-    GLenum attr_type, int offset, int attribute_size) {
+    GLenum attr_type, qint64 offset, int attribute_size) {
   if (location < 0) {
     return;
   }
 
   if (num_attributes > 0) {
     program->enableAttributeArray(location);
-    program->setAttributeBuffer(location,
-        attr_type, offset, attribute_size, 0);
+    // QOpenGLShaderProgram::setAttributeBuffer() takes the offset as an int,
+    // which doesn't reach past 2 GiB into the vertex buffer.
+    glVertexAttribPointer(location, attribute_size, attr_type, GL_FALSE, 0,
+        reinterpret_cast<const void*>(static_cast<uintptr_t>(offset)));
   } else {
     program->disableAttributeArray(location);
   }
 }
 
+static int IndexSize(GLenum index_type) {
+  switch (index_type) {
+    case GL_UNSIGNED_BYTE:
+      return sizeof(uint8_t);
+    case GL_UNSIGNED_SHORT:
+      return sizeof(uint16_t);
+    default:
+      return sizeof(uint32_t);
+  }
+}
+
 void DrawContext::DrawGeometry() {
+  const int num_instances = geometry_->NumInstances();
+  if (num_instances <= 0) {
+    return;
+  }
+
   // Load geometry and bind a vertex buffer
   QOpenGLBuffer* vbo = geometry_->VBO();
   vbo->bind();
@@ -624,19 +803,100 @@ void DrawContext::DrawGeometry() {
       geometry_->NumShininess(), GL_FLOAT, geometry_->ShininessOffset(), 1);
   SetupAttributeArray(program_, locs.sv_tex_coords_0,
       geometry_->NumTexCoords0(), GL_FLOAT, geometry_->TexCoords0Offset(), 2);
+  SetupAttributeArray(program_, locs.sv_timestamp,
+      geometry_->NumTimestamps(), GL_FLOAT, geometry_->TimestampsOffset(), 1);
+  SetupAttributeArray(program_, locs.sv_anchor,
+      geometry_->NumAnchors(), GL_FLOAT, geometry_->AnchorsOffset(), 1);
+  SetupAttributeArray(program_, locs.sv_scalar,
+      geometry_->NumScalars(), GL_FLOAT, geometry_->ScalarsOffset(), 1);
+  SetupAttributeArray(program_, locs.sv_label,
+      geometry_->NumLabels(), GL_FLOAT, geometry_->LabelsOffset(), 1);
 
   // TODO load custom attribute arrays
 
+#ifdef GL_VERTEX_ATTRIB_ARRAY_DIVISOR
+  geometry_->EnableInstanceArrays(program_);
+#endif
+
+  // Issue a draw call for every instance. With a single instance, the
+  // instanced and the plain draw calls are equivalent.
+  const GLenum gl_mode = geometry_->GLMode();
+  auto draw_arrays = [&](int first, int count) {
+#ifdef GL_VERTEX_ATTRIB_ARRAY_DIVISOR
+    if (num_instances > 1) {
+      glDrawArraysInstanced(gl_mode, first, count, num_instances);
+    } else {
+      glDrawArrays(gl_mode, first, count);
+    }
+#else
+    for (int instance = 0; instance < num_instances; ++instance) {
+      geometry_->SetInstanceAttributes(program_, instance);
+      glDrawArrays(gl_mode, first, count);
+    }
+#endif
+  };
+  auto draw_elements = [&](int count, uintptr_t index_offset) {
+    const GLenum index_type = geometry_->IndexType();
+    const void* indices = reinterpret_cast<const void*>(index_offset);
+#ifdef GL_VERTEX_ATTRIB_ARRAY_DIVISOR
+    if (num_instances > 1) {
+      glDrawElementsInstanced(gl_mode, count, index_type, indices,
+          num_instances);
+    } else {
+      glDrawElements(gl_mode, count, index_type, indices);
+    }
+#else
+    for (int instance = 0; instance < num_instances; ++instance) {
+      geometry_->SetInstanceAttributes(program_, instance);
+      glDrawElements(gl_mode, count, index_type, indices);
+    }
+#endif
+  };
+
   // Draw the geometry
+  geometry_->PrepareDrawRanges(cur_camera_->GetProjectionMatrix() *
+      cur_camera_->GetRelativeViewMatrix() * model_mat_);
   QOpenGLBuffer* index_buffer = geometry_->IndexBuffer();
   if (index_buffer) {
     index_buffer->bind();
-    glDrawElements(geometry_->GLMode(), geometry_->NumIndices(),
-        geometry_->IndexType(), 0);
+#ifdef GL_PRIMITIVE_RESTART
+    if (geometry_->PrimitiveRestart()) {
+      glEnable(GL_PRIMITIVE_RESTART);
+      glPrimitiveRestartIndex(geometry_->PrimitiveRestartIndex());
+    }
+#endif
+    if (lod_level_ == 0) {
+      const int index_size = IndexSize(geometry_->IndexType());
+      const int num_ranges = geometry_->NumDrawRanges();
+      for (int range = 0; range < num_ranges; ++range) {
+        int first;
+        int count;
+        geometry_->DrawRange(range, &first, &count);
+        draw_elements(count, first * index_size);
+      }
+    } else {
+      draw_elements(geometry_->LodNumIndices(lod_level_),
+          geometry_->LodIndexOffset(lod_level_));
+    }
+#ifdef GL_PRIMITIVE_RESTART
+    if (geometry_->PrimitiveRestart()) {
+      glDisable(GL_PRIMITIVE_RESTART);
+    }
+#endif
     index_buffer->release();
   } else {
-    glDrawArrays(geometry_->GLMode(), 0, geometry_->NumVertices());
+    const int num_ranges = geometry_->NumDrawRanges();
+    for (int range = 0; range < num_ranges; ++range) {
+      int first;
+      int count;
+      geometry_->DrawRange(range, &first, &count);
+      draw_arrays(first, count);
+    }
   }
+
+#ifdef GL_VERTEX_ATTRIB_ARRAY_DIVISOR
+  geometry_->DisableInstanceArrays(program_);
+#endif
   vbo->release();
 }
 
@@ -677,7 +937,7 @@ void DrawContext::DrawBoundingBox(const AxisAlignedBox& box) {
 
   bounding_box_node_->SetScale(box.Max() - box.Min());
   bounding_box_node_->SetTranslation(box.Min());
-  model_mat_ = bounding_box_node_->WorldTransform();
+  model_mat_ = bounding_box_node_->RelativeTransform(camera_origin_);
 
   DrawDrawNode(bounding_box_node_);
 }
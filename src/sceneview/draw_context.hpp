@@ -6,10 +6,13 @@
 #include <vector>
 
 #include <QColor>
+#include <QVector4D>
 
+#include <sceneview/clip_volume.hpp>
 #include <sceneview/drawable.hpp>
 #include <sceneview/resource_manager.hpp>
 #include <sceneview/scene.hpp>
+#include <sceneview/vector3d.hpp>
 
 class QOpenGLShaderProgram;
 
@@ -35,6 +38,8 @@ class DrawContext {
 
     void SetDrawGroups(const std::vector<DrawGroup*>& groups);
 
+    void SetLodHysteresis(float hysteresis);
+
   private:
     void PrepareFixedFunctionPipeline();
 
@@ -44,10 +49,16 @@ class DrawContext {
 
     void ActivateMaterial();
 
+    int SelectLod(Drawable* drawable);
+
     void DrawGeometry();
 
     void DrawBoundingBox(const AxisAlignedBox& box);
 
+    void EnableClipPlanes(const QMatrix4x4& view_mat);
+
+    void DisableClipPlanes();
+
     ResourceManager::Ptr resources_;
 
     Scene::Ptr scene_;
@@ -59,11 +70,24 @@ class DrawContext {
     int viewport_height_ = 0;
     CameraNode* cur_camera_ = nullptr;
 
+    // World position of the camera. Shaders get transforms relative to it,
+    // so that scenes far from the world origin are drawn accurately.
+    Vector3d camera_origin_;
+
+    // Clip planes relative to the camera, and the number enabled.
+    const ClipVolume* clip_volume_ = nullptr;
+    QVector4D clip_planes_[ClipVolume::kMaxPlanes];
+    int num_clip_planes_ = 0;
+    int max_clip_planes_ = -1;
+
     MaterialResource::Ptr material_;
     GeometryResource::Ptr geometry_;
     ShaderResource::Ptr shader_;
     QOpenGLShaderProgram* program_;
     QMatrix4x4 model_mat_;
+    float screen_size_;
+    int lod_level_;
+    float lod_hysteresis_;
 
     std::vector<DrawGroup*> draw_groups_;
 
@@ -73,6 +97,7 @@ class DrawContext {
     bool gl_depth_write_;
     bool gl_color_write_;
     float gl_point_size_;
+    bool gl_program_point_size_;
     float gl_line_width_;
     bool gl_blend_;
     GLenum gl_sfactor_;
@@ -7,6 +7,8 @@
 
 #include <QString>
 
+#include <sceneview/clip_volume.hpp>
+
 namespace sv {
 
 class CameraNode;
@@ -42,6 +44,16 @@ class DrawGroup {
 
     CameraNode* GetCamera() { return camera_; }
 
+    /**
+     * Retrieve the clip planes and section box of this draw group.
+     *
+     * Draw nodes entirely outside the clip volume are not drawn, and the
+     * stock shaders clip the rest.
+     */
+    ClipVolume& GetClipVolume() { return clip_volume_; }
+
+    const ClipVolume& GetClipVolume() const { return clip_volume_; }
+
   private:
     friend class Scene;
 
@@ -61,6 +73,8 @@ class DrawGroup {
 
     CameraNode* camera_ = nullptr;
 
+    ClipVolume clip_volume_;
+
     std::unordered_set<DrawNode*> nodes_;
 };
 
@@ -6,7 +6,7 @@ namespace sv {
 
 Drawable::Drawable(const GeometryResource::Ptr& geometry,
     const MaterialResource::Ptr& material) :
-  geometry_(geometry), material_(material) {
+  geometry_(geometry), material_(material), lod_level_(0) {
   if (geometry_) {
     geometry_->AddListener(this);
   }
@@ -85,6 +85,8 @@ class Drawable {
 
     friend class GeometryResource;
 
+    friend class DrawContext;
+
     void AddListener(DrawNode* listener);
 
     void RemoveListener(DrawNode* listener);
@@ -93,6 +95,9 @@ class Drawable {
 
     GeometryResource::Ptr geometry_;
     MaterialResource::Ptr material_;
+
+    // Level of detail last used to draw the geometry.
+    int lod_level_;
 };
 
 }  // namespace sv
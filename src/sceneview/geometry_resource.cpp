@@ -1,10 +1,20 @@
 // Copyright [2015] Albert Huang
 
+#include "sceneview/internal_gl.hpp"
+
 #include "sceneview/geometry_resource.hpp"
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <string>
+#include <utility>
 #include <vector>
 
 #include "drawable.hpp"
+#include "mesh_simplifier.hpp"
+#include "thread_pool.hpp"
 
 #if 0
 #define dbg(fmt, ...) printf(fmt, __VA_ARGS__)
@@ -15,168 +25,574 @@
 namespace sv {
 
 GeometryResource::GeometryResource(const QString& name) :
+  GeometryResource(name, false) {}
+
+GeometryResource::GeometryResource(const QString& name, bool self_managed) :
   name_(name),
   created_vbo_(false),
   vbo_(),
   index_buffer_(QOpenGLBuffer::IndexBuffer),
-  vertex_offset_(0),
-  normal_offset_(0),
-  diffuse_offset_(0),
-  specular_offset_(0),
-  shininess_offset_(0),
-  tex_coords_0_offset_(0),
-  num_vertices_(0),
-  num_normals_(0),
-  num_diffuse_(0),
-  num_specular_(0),
-  num_shininess_(0),
-  num_tex_coords_0_(0),
+  capacity_(0),
+  reserved_capacity_(0),
   num_indices_(0),
   gl_mode_(0),
   index_type_(GL_UNSIGNED_INT),
-  bounding_box_() {
+  primitive_restart_(false),
+  bounding_box_(),
+  self_managed_(self_managed) {
+  for (int attr_ind = 0; attr_ind < kNumVertexAttributes; ++attr_ind) {
+    offsets_[attr_ind] = 0;
+    counts_[attr_ind] = 0;
+    present_[attr_ind] = false;
+  }
 }
 
 GeometryResource::~GeometryResource() {
-  dbg("destroying geometry resource %s\n", name_.c_str());
+  dbg("destroying geometry resource %s\n", name_.toStdString().c_str());
   if (created_vbo_) {
     vbo_.destroy();
   }
-  if (num_indices_) {
+  if (index_buffer_.isCreated()) {
     index_buffer_.destroy();
   }
 }
 
-void GeometryResource::Load(const GeometryData& data) {
-  if (!created_vbo_) {
-    vbo_.create();
-    created_vbo_ = true;
+int GeometryResource::NumComponents(VertexAttribute attribute) {
+  switch (attribute) {
+    case VertexAttribute::kVertices:
+    case VertexAttribute::kNormals:
+      return 3;
+    case VertexAttribute::kDiffuse:
+    case VertexAttribute::kSpecular:
+      return 4;
+    case VertexAttribute::kShininess:
+    case VertexAttribute::kTimestamps:
+    case VertexAttribute::kAnchors:
+    case VertexAttribute::kScalars:
+    case VertexAttribute::kLabels:
+      return 1;
+    case VertexAttribute::kTexCoords0:
+      return 2;
   }
-  vbo_.bind();
+  throw std::invalid_argument("Invalid vertex attribute");
+}
+
+static const char* AttributeName(VertexAttribute attribute) {
+  switch (attribute) {
+    case VertexAttribute::kVertices:
+      return "vertices";
+    case VertexAttribute::kNormals:
+      return "normals";
+    case VertexAttribute::kDiffuse:
+      return "diffuse";
+    case VertexAttribute::kSpecular:
+      return "specular";
+    case VertexAttribute::kShininess:
+      return "shininess";
+    case VertexAttribute::kTexCoords0:
+      return "tex_coords_0";
+    case VertexAttribute::kTimestamps:
+      return "timestamps";
+    case VertexAttribute::kAnchors:
+      return "anchors";
+    case VertexAttribute::kScalars:
+      return "scalars";
+    case VertexAttribute::kLabels:
+      return "labels";
+  }
+  return "unknown";
+}
 
-  vertex_offset_ = 0;
-  normal_offset_ = 0;
-  diffuse_offset_ = 0;
-  specular_offset_ = 0;
-  shininess_offset_ = 0;
-  tex_coords_0_offset_ = 0;
+// Returns true if values of an attribute can be read with the stride of a
+// span.
+static bool ValidStride(VertexAttribute attribute, const StridedSpan& span) {
+  return span.stride == 0 || span.stride >=
+    GeometryResource::NumComponents(attribute) *
+    static_cast<int>(sizeof(GLfloat));
+}
 
-  const int num_vertices = data.vertices.size();
-  const int num_normals = data.normals.size();
-  const int num_diffuse = data.diffuse.size();
-  const int num_specular = data.specular.size();
-  const int num_shininess = data.shininess.size();
-  const int num_tex_coords_0 = data.tex_coords_0.size();
+// Number of values to pack at a time when uploading strided data.
+static const int kUploadChunkSize = 65536;
 
-  // check inputs
-  if (num_vertices != num_normals && (num_normals != 0)) {
-    throw std::invalid_argument("#vertices != #normals");
-  }
-  if (num_vertices != num_diffuse && (num_diffuse != 0)) {
-    throw std::invalid_argument("#vertices != #diffuse");
-  }
-  if (num_vertices != num_specular && (num_specular != 0)) {
-    throw std::invalid_argument("#vertices != #specular");
-  }
-  if (num_vertices != num_shininess && (num_shininess != 0)) {
-    throw std::invalid_argument("#vertices != #shininess");
+static GeometryDataView MakeView(const GeometryData& data) {
+  GeometryDataView view;
+  view.vertices = StridedSpan(
+      reinterpret_cast<const float*>(data.vertices.data()),
+      data.vertices.size());
+  view.normals = StridedSpan(
+      reinterpret_cast<const float*>(data.normals.data()),
+      data.normals.size());
+  view.diffuse = StridedSpan(
+      reinterpret_cast<const float*>(data.diffuse.data()),
+      data.diffuse.size());
+  view.specular = StridedSpan(
+      reinterpret_cast<const float*>(data.specular.data()),
+      data.specular.size());
+  view.shininess = StridedSpan(data.shininess.data(), data.shininess.size());
+  view.tex_coords_0 = StridedSpan(
+      reinterpret_cast<const float*>(data.tex_coords_0.data()),
+      data.tex_coords_0.size());
+  view.timestamps = StridedSpan(data.timestamps.data(),
+      data.timestamps.size());
+  view.anchors = StridedSpan(data.anchors.data(), data.anchors.size());
+  view.scalars = StridedSpan(data.scalars.data(), data.scalars.size());
+  view.labels = StridedSpan(data.labels.data(), data.labels.size());
+  view.indices = data.indices.data();
+  view.num_indices = data.indices.size();
+  view.gl_mode = data.gl_mode;
+  return view;
+}
+
+// Returns a pointer to the values of an attribute in a GeometryData,
+// growing the attribute to at least @p size values.
+static float* AttributeData(GeometryData* data, VertexAttribute attribute,
+    int size) {
+  switch (attribute) {
+    case VertexAttribute::kVertices:
+      data->vertices.resize(std::max<int>(size, data->vertices.size()));
+      return reinterpret_cast<float*>(data->vertices.data());
+    case VertexAttribute::kNormals:
+      data->normals.resize(std::max<int>(size, data->normals.size()));
+      return reinterpret_cast<float*>(data->normals.data());
+    case VertexAttribute::kDiffuse:
+      data->diffuse.resize(std::max<int>(size, data->diffuse.size()));
+      return reinterpret_cast<float*>(data->diffuse.data());
+    case VertexAttribute::kSpecular:
+      data->specular.resize(std::max<int>(size, data->specular.size()));
+      return reinterpret_cast<float*>(data->specular.data());
+    case VertexAttribute::kShininess:
+      data->shininess.resize(std::max<int>(size, data->shininess.size()));
+      return data->shininess.data();
+    case VertexAttribute::kTexCoords0:
+      data->tex_coords_0.resize(
+          std::max<int>(size, data->tex_coords_0.size()));
+      return reinterpret_cast<float*>(data->tex_coords_0.data());
+    case VertexAttribute::kTimestamps:
+      data->timestamps.resize(std::max<int>(size, data->timestamps.size()));
+      return data->timestamps.data();
+    case VertexAttribute::kAnchors:
+      data->anchors.resize(std::max<int>(size, data->anchors.size()));
+      return data->anchors.data();
+    case VertexAttribute::kScalars:
+      data->scalars.resize(std::max<int>(size, data->scalars.size()));
+      return data->scalars.data();
+    case VertexAttribute::kLabels:
+      data->labels.resize(std::max<int>(size, data->labels.size()));
+      return data->labels.data();
   }
-  if (num_vertices != num_tex_coords_0 && (num_tex_coords_0 != 0)) {
-    throw std::invalid_argument("#vertices != #tex_coords_0");
+  return nullptr;
+}
+
+// Projected size at which a level of detail with as many triangles as the
+// full resolution geometry stops being used.
+static const float kLodReferenceScreenSize = 1000;
+
+static int IndexSize(GLenum index_type) {
+  switch (index_type) {
+    case GL_UNSIGNED_BYTE:
+      return sizeof(uint8_t);
+    case GL_UNSIGNED_SHORT:
+      return sizeof(uint16_t);
+    default:
+      return sizeof(uint32_t);
   }
+}
 
-  int offset = 0;
-  const int vertices_size = num_vertices * 3 * sizeof(GLfloat);
-  const int normals_size = num_normals * 3 * sizeof(GLfloat);
-  const int diffuse_size = num_diffuse * 4 * sizeof(GLfloat);
-  const int specular_size = num_specular * 4 * sizeof(GLfloat);
-  const int shininess_size = num_shininess * 1 * sizeof(GLfloat);
-  const int tex_coords_0_size = num_tex_coords_0 * 2 * sizeof(GLfloat);
-  const int total_size =
-    vertices_size + normals_size + diffuse_size + tex_coords_0_size;
+template <typename IndexType>
+static void WriteIndices(QOpenGLBuffer* buffer, qint64 offset,
+    const uint32_t* indices, int num_indices) {
+  std::vector<IndexType> converted(indices, indices + num_indices);
+  BufferSubData(buffer, offset, converted.data(),
+      static_cast<qint64>(num_indices) * sizeof(IndexType));
+}
 
-  vbo_.allocate(total_size);
+template <typename IndexType>
+static void UploadIndices(QOpenGLBuffer* buffer, const uint32_t* indices,
+    int num_indices) {
+  // Convert the indices into the smallest type that can represent them.
+  std::vector<IndexType> converted(indices, indices + num_indices);
+  BufferData(buffer, static_cast<qint64>(num_indices) * sizeof(IndexType),
+      converted.data());
+}
 
-  if (num_vertices) {
-    vbo_.write(offset, data.vertices.data(), vertices_size);
-    vertex_offset_ = offset;
-    offset += vertices_size;
+qint64 GeometryResource::BufferSize(qint64 size) {
+  if (size < 0 || size > std::numeric_limits<GLsizeiptr>::max()) {
+    throw std::invalid_argument("Buffer size exceeds the address space");
   }
+  return size;
+}
 
-  if (num_normals) {
-    vbo_.write(offset, data.normals.data(), normals_size);
-    normal_offset_ = offset;
-    offset += normals_size;
+int GeometryResource::GrowCapacity(int capacity, qint64 min_capacity) {
+  if (min_capacity > std::numeric_limits<int>::max()) {
+    throw std::invalid_argument("Capacity exceeds the largest int");
   }
+  const qint64 doubled = std::min<qint64>(static_cast<qint64>(capacity) * 2,
+      std::numeric_limits<int>::max());
+  return static_cast<int>(std::max(min_capacity, doubled));
+}
 
-  if (num_diffuse) {
-    vbo_.write(offset, data.diffuse.data(), diffuse_size);
-    diffuse_offset_ = offset;
-    offset += diffuse_size;
-  }
+void GeometryResource::Load(const GeometryData& data) {
+  CheckNotSelfManaged("Load()");
+  Load(MakeView(data));
+}
 
-  if (num_specular) {
-    vbo_.write(offset, data.specular.data(), specular_size);
-    specular_offset_ = offset;
-    offset += specular_size;
-  }
+void GeometryResource::LoadAndKeep(GeometryData&& data) {
+  CheckNotSelfManaged("LoadAndKeep()");
+  Load(MakeView(data));
+
+  // Moving the vectors transfers ownership of their storage, so this doesn't
+  // copy the data.
+  cpu_data_.reset(new GeometryData(std::move(data)));
+}
+
+void GeometryResource::Load(const GeometryDataView& data) {
+  CheckNotSelfManaged("Load()");
+  cpu_data_.reset();
+  lods_.clear();
+  pending_lods_ = std::future<std::vector<std::vector<uint32_t>>>();
 
-  if (num_shininess) {
-    vbo_.write(offset, data.shininess.data(), shininess_size);
-    shininess_offset_ = offset;
-    offset += shininess_size;
+  const int num_vertices = data.vertices.count;
+
+  const StridedSpan* spans[kNumVertexAttributes];
+  GetSpans(data, spans);
+
+  // check inputs
+  for (int attr_ind = 0; attr_ind < kNumVertexAttributes; ++attr_ind) {
+    const VertexAttribute attribute = static_cast<VertexAttribute>(attr_ind);
+    const StridedSpan& span = *spans[attr_ind];
+    if (span.count != 0 && span.count != num_vertices) {
+      throw std::invalid_argument(std::string("#vertices != #") +
+          AttributeName(attribute));
+    }
+    if (span.count < 0 || (span.count && !span.data) ||
+        !ValidStride(attribute, span)) {
+      throw std::invalid_argument(std::string("Invalid span for ") +
+          AttributeName(attribute));
+    }
+  }
+  if (data.num_indices < 0 || (data.num_indices && !data.indices)) {
+    throw std::invalid_argument("Invalid indices");
   }
 
-  if (num_tex_coords_0) {
-    vbo_.write(offset, data.tex_coords_0.data(), tex_coords_0_size);
-    tex_coords_0_offset_ = offset;
-    offset += tex_coords_0_size;
+  for (int attr_ind = 0; attr_ind < kNumVertexAttributes; ++attr_ind) {
+    counts_[attr_ind] = spans[attr_ind]->count;
+    present_[attr_ind] = spans[attr_ind]->count > 0;
   }
 
-  num_vertices_ = num_vertices;
-  num_normals_ = num_normals;
-  num_diffuse_ = num_diffuse;
-  num_specular_ = num_specular;
-  num_shininess_ = num_shininess;
-  num_tex_coords_0_ = num_tex_coords_0;
+  // Lay out and allocate each attribute block, then fill it in.
+  AllocateVBO(std::max(num_vertices, reserved_capacity_), false);
+
+  for (int attr_ind = 0; attr_ind < kNumVertexAttributes; ++attr_ind) {
+    if (present_[attr_ind]) {
+      WriteSpan(static_cast<VertexAttribute>(attr_ind), 0, *spans[attr_ind]);
+    }
+  }
 
   gl_mode_ = data.gl_mode;
 
   // load indices
-  num_indices_ = data.indices.size();
+  num_indices_ = data.num_indices;
+  primitive_restart_ = std::find(data.indices,
+      data.indices + data.num_indices, kPrimitiveRestartIndex) !=
+    data.indices + data.num_indices;
   if (num_indices_) {
-    index_buffer_.create();
+    // Reuse the index buffer object across loads.
+    if (!index_buffer_.isCreated()) {
+      index_buffer_.create();
+    }
     index_buffer_.bind();
 
-    if (num_vertices < 256) {
-      // Optimize and convert the indices into a vector of unsigned shorts.
-      std::vector<uint8_t> indices_byte(data.indices.begin(),
-          data.indices.end());
-      index_buffer_.allocate(indices_byte.data(),
-          num_indices_ * sizeof(uint8_t));
+    // With primitive restart, the largest value of the index type is
+    // reserved as the restart index.
+    const int max_vertices_byte = primitive_restart_ ? 255 : 256;
+    const int max_vertices_short = primitive_restart_ ? 65535 : 65536;
+    if (num_vertices < max_vertices_byte) {
+      UploadIndices<uint8_t>(&index_buffer_, data.indices, num_indices_);
       index_type_ = GL_UNSIGNED_BYTE;
-    } else if (num_vertices < 65536) {
-      // Optimize and convert the indices into a vector of unsigned shorts.
-      std::vector<uint16_t> indices_short(data.indices.begin(),
-          data.indices.end());
-      index_buffer_.allocate(indices_short.data(),
-          num_indices_ * sizeof(uint16_t));
+    } else if (num_vertices < max_vertices_short) {
+      UploadIndices<uint16_t>(&index_buffer_, data.indices, num_indices_);
       index_type_ = GL_UNSIGNED_SHORT;
     } else {
-      index_buffer_.allocate(data.indices.data(),
-          num_indices_ * sizeof(uint32_t));
+      BufferData(&index_buffer_,
+          BufferSize(static_cast<qint64>(num_indices_) * sizeof(uint32_t)),
+          data.indices);
       index_type_ = GL_UNSIGNED_INT;
     }
   }
 
   // Initialize the bounding box
-  bounding_box_ = AxisAlignedBox();
-  for (const auto& vertex : data.vertices) {
-    bounding_box_.IncludePoint(QVector3D(vertex.x(), vertex.y(), vertex.z()));
+  bounding_box_ = AxisAlignedBox::FromPoints(data.vertices.data, num_vertices,
+      data.vertices.stride);
+
+  NotifyBoundingBoxChanged();
+}
+
+void GeometryResource::Reserve(int num_vertices) {
+  CheckNotSelfManaged("Reserve()");
+  if (num_vertices < 0) {
+    throw std::invalid_argument("Invalid capacity");
+  }
+  if (created_vbo_ && num_vertices > capacity_) {
+    AllocateVBO(num_vertices, true);
   }
+  reserved_capacity_ = num_vertices;
 
-  for (Drawable* listener : listeners_) {
-    listener->BoundingBoxChanged();
+  // Geometry that gets updated in place is better off in memory that the
+  // driver expects to be modified.
+  vbo_.setUsagePattern(QOpenGLBuffer::DynamicDraw);
+}
+
+void GeometryResource::Update(VertexAttribute attribute, int first, int count,
+    const void* data) {
+  CheckNotSelfManaged("Update()");
+  const int attr_ind = static_cast<int>(attribute);
+  if (!present_[attr_ind]) {
+    throw std::invalid_argument(std::string("Can't update attribute ") +
+        AttributeName(attribute) + " - it wasn't loaded");
+  }
+  if (first < 0 || count < 0 || first > counts_[attr_ind] ||
+      count > std::numeric_limits<int>::max() - first) {
+    throw std::invalid_argument("Invalid update range");
+  }
+  if (count == 0) {
+    return;
+  }
+
+  const int end = first + count;
+  if (end > capacity_) {
+    AllocateVBO(GrowCapacity(capacity_, end), true);
+  }
+
+  const qint64 value_size = NumComponents(attribute) * sizeof(GLfloat);
+  vbo_.bind();
+  BufferSubData(&vbo_, offsets_[attr_ind] + first * value_size, data,
+      count * value_size);
+  vbo_.release();
+
+  counts_[attr_ind] = std::max(counts_[attr_ind], end);
+
+  // Keep the system memory copy in sync.
+  if (cpu_data_) {
+    float* values = AttributeData(cpu_data_.get(), attribute, end);
+    const GLfloat* src = static_cast<const GLfloat*>(data);
+    std::copy(src, src + count * NumComponents(attribute),
+        values + first * NumComponents(attribute));
+  }
+
+  if (attribute == VertexAttribute::kVertices) {
+    const AxisAlignedBox box = AxisAlignedBox::FromPoints(
+        static_cast<const GLfloat*>(data), count);
+    if (box.Valid()) {
+      bounding_box_.IncludeBox(box);
+    }
+
+    NotifyBoundingBoxChanged();
+  }
+}
+
+void GeometryResource::AllocateVBO(int capacity, bool preserve_contents) {
+  // Compute the block layout for the new capacity.
+  qint64 new_offsets[kNumVertexAttributes];
+  qint64 total_size = 0;
+  for (int attr_ind = 0; attr_ind < kNumVertexAttributes; ++attr_ind) {
+    new_offsets[attr_ind] = 0;
+    if (present_[attr_ind]) {
+      new_offsets[attr_ind] = total_size;
+      total_size += static_cast<qint64>(capacity) *
+        NumComponents(static_cast<VertexAttribute>(attr_ind)) *
+        sizeof(GLfloat);
+    }
+  }
+  const qint64 buffer_size = BufferSize(total_size);
+
+  if (!created_vbo_ || !preserve_contents) {
+    if (!created_vbo_) {
+      vbo_.create();
+      created_vbo_ = true;
+    }
+    vbo_.bind();
+    BufferData(&vbo_, buffer_size);
+  } else {
+    // Copy the existing contents into the new buffer.
+    QOpenGLBuffer new_vbo(QOpenGLBuffer::VertexBuffer);
+    new_vbo.setUsagePattern(vbo_.usagePattern());
+    new_vbo.create();
+    new_vbo.bind();
+    BufferData(&new_vbo, buffer_size);
+
+    for (int attr_ind = 0; attr_ind < kNumVertexAttributes; ++attr_ind) {
+      if (!present_[attr_ind]) {
+        continue;
+      }
+      const qint64 size = static_cast<qint64>(counts_[attr_ind]) *
+        NumComponents(static_cast<VertexAttribute>(attr_ind)) *
+        sizeof(GLfloat);
+      CopyBufferSubData(&vbo_, offsets_[attr_ind],
+          &new_vbo, new_offsets[attr_ind], size);
+    }
+
+    vbo_.destroy();
+    vbo_ = new_vbo;
+  }
+
+  for (int attr_ind = 0; attr_ind < kNumVertexAttributes; ++attr_ind) {
+    offsets_[attr_ind] = new_offsets[attr_ind];
+  }
+  capacity_ = capacity;
+}
+
+void GeometryResource::WriteSpan(VertexAttribute attribute, int first,
+    const StridedSpan& span) {
+  const int attr_ind = static_cast<int>(attribute);
+  const int num_components = NumComponents(attribute);
+  const qint64 value_size = num_components * sizeof(GLfloat);
+  const qint64 offset = offsets_[attr_ind] + first * value_size;
+
+  if (span.stride == 0 || span.stride == value_size) {
+    BufferSubData(&vbo_, offset, span.data, span.count * value_size);
+    return;
+  }
+
+  // Pack strided values into a small buffer, one chunk at a time.
+  std::vector<GLfloat> chunk;
+  const char* src = reinterpret_cast<const char*>(span.data);
+  for (int chunk_first = 0; chunk_first < span.count;
+      chunk_first += kUploadChunkSize) {
+    const int count = std::min(kUploadChunkSize, span.count - chunk_first);
+    chunk.resize(count * num_components);
+    for (int value_ind = 0; value_ind < count; ++value_ind) {
+      const GLfloat* value = reinterpret_cast<const GLfloat*>(
+          src + static_cast<size_t>(chunk_first + value_ind) * span.stride);
+      std::copy(value, value + num_components,
+          &chunk[value_ind * num_components]);
+    }
+    BufferSubData(&vbo_, offset + chunk_first * value_size, chunk.data(),
+        count * value_size);
+  }
+}
+
+void GeometryResource::SetLods(
+    const std::vector<std::vector<uint32_t>>& lod_indices) {
+  CheckNotSelfManaged("SetLods()");
+  if (!num_indices_ || gl_mode_ != GL_TRIANGLES) {
+    throw std::invalid_argument(
+        "Levels of detail require indexed triangle geometry");
+  }
+  const uint32_t num_vertices = NumVertices();
+  qint64 total_indices = num_indices_;
+  for (const std::vector<uint32_t>& indices : lod_indices) {
+    if (indices.size() % 3) {
+      throw std::invalid_argument("Invalid level of detail indices");
+    }
+    for (uint32_t index : indices) {
+      if (index >= num_vertices) {
+        throw std::invalid_argument("Vertex index out of range");
+      }
+    }
+    total_indices += indices.size();
+  }
+
+  // Build a new index buffer with the full resolution indices copied over
+  // from the existing buffer, followed by each level of detail.
+  const int index_size = IndexSize(index_type_);
+  const qint64 buffer_size = BufferSize(total_indices * index_size);
+  QOpenGLBuffer new_buffer(QOpenGLBuffer::IndexBuffer);
+  new_buffer.create();
+  new_buffer.bind();
+  BufferData(&new_buffer, buffer_size);
+  CopyBufferSubData(&index_buffer_, 0, &new_buffer, 0,
+      static_cast<qint64>(num_indices_) * index_size);
+  new_buffer.bind();
+
+  lods_.clear();
+  int first_index = num_indices_;
+  for (const std::vector<uint32_t>& indices : lod_indices) {
+    const int num_indices = indices.size();
+    const qint64 offset = static_cast<qint64>(first_index) * index_size;
+    switch (index_type_) {
+      case GL_UNSIGNED_BYTE:
+        WriteIndices<uint8_t>(&new_buffer, offset, indices.data(),
+            num_indices);
+        break;
+      case GL_UNSIGNED_SHORT:
+        WriteIndices<uint16_t>(&new_buffer, offset, indices.data(),
+            num_indices);
+        break;
+      default:
+        BufferSubData(&new_buffer, offset, indices.data(),
+            static_cast<qint64>(num_indices) * index_size);
+        break;
+    }
+
+    LevelOfDetail lod;
+    lod.first_index = first_index;
+    lod.num_indices = num_indices;
+    lod.max_screen_size = kLodReferenceScreenSize *
+      std::sqrt(static_cast<float>(num_indices) / num_indices_);
+    lods_.push_back(lod);
+    first_index += num_indices;
+  }
+  new_buffer.release();
+
+  index_buffer_.destroy();
+  index_buffer_ = new_buffer;
+}
+
+void GeometryResource::GenerateLods(const GeometryData& data,
+    int max_levels) {
+  CheckNotSelfManaged("GenerateLods()");
+  if (data.gl_mode != GL_TRIANGLES || data.indices.empty()) {
+    throw std::invalid_argument(
+        "Levels of detail require indexed triangle geometry");
+  }
+  std::shared_ptr<std::vector<QVector3D>> vertices =
+    std::make_shared<std::vector<QVector3D>>(data.vertices);
+  std::shared_ptr<std::vector<uint32_t>> indices =
+    std::make_shared<std::vector<uint32_t>>(data.indices);
+  pending_lods_ = ThreadPool::Default()->Submit([vertices, indices,
+      max_levels]() {
+    return GenerateLodChain(*vertices, *indices, max_levels);
+  });
+}
+
+void GeometryResource::ProcessPendingLods() {
+  if (!pending_lods_.valid() ||
+      pending_lods_.wait_for(std::chrono::seconds(0)) !=
+      std::future_status::ready) {
+    return;
+  }
+  try {
+    SetLods(pending_lods_.get());
+  } catch (const std::exception& ex) {
+    dbg("failed to generate levels of detail: %s\n", ex.what());
+  }
+}
+
+qint64 GeometryResource::LodIndexOffset(int level) const {
+  return level == 0 ? 0 :
+    static_cast<qint64>(lods_[level - 1].first_index) * IndexSize(index_type_);
+}
+
+float GeometryResource::LodMaxScreenSize(int level) const {
+  return level == 0 ? std::numeric_limits<float>::infinity() :
+    lods_[level - 1].max_screen_size;
+}
+
+void GeometryResource::SetLodMaxScreenSize(int level, float max_screen_size) {
+  if (level < 1 || level >= NumLods()) {
+    throw std::invalid_argument("Invalid level of detail");
+  }
+  lods_[level - 1].max_screen_size = max_screen_size;
+}
+
+GLuint GeometryResource::PrimitiveRestartIndex() const {
+  switch (index_type_) {
+    case GL_UNSIGNED_BYTE:
+      return 0xFF;
+    case GL_UNSIGNED_SHORT:
+      return 0xFFFF;
+    default:
+      return kPrimitiveRestartIndex;
   }
 }
 
@@ -184,6 +600,50 @@ QOpenGLBuffer* GeometryResource::IndexBuffer() {
   return num_indices_ ? &index_buffer_ : nullptr;
 }
 
+void GeometryResource::CheckNotSelfManaged(const char* method) const {
+  if (self_managed_) {
+    throw std::logic_error(std::string(method) +
+        " is not supported by geometry resource " + name_.toStdString());
+  }
+}
+
+void GeometryResource::GetSpans(const GeometryDataView& data,
+    const StridedSpan* spans[kNumVertexAttributes]) {
+  spans[static_cast<int>(VertexAttribute::kVertices)] = &data.vertices;
+  spans[static_cast<int>(VertexAttribute::kNormals)] = &data.normals;
+  spans[static_cast<int>(VertexAttribute::kDiffuse)] = &data.diffuse;
+  spans[static_cast<int>(VertexAttribute::kSpecular)] = &data.specular;
+  spans[static_cast<int>(VertexAttribute::kShininess)] = &data.shininess;
+  spans[static_cast<int>(VertexAttribute::kTexCoords0)] = &data.tex_coords_0;
+  spans[static_cast<int>(VertexAttribute::kTimestamps)] = &data.timestamps;
+  spans[static_cast<int>(VertexAttribute::kAnchors)] = &data.anchors;
+  spans[static_cast<int>(VertexAttribute::kScalars)] = &data.scalars;
+  spans[static_cast<int>(VertexAttribute::kLabels)] = &data.labels;
+}
+
+void GeometryResource::CheckSpans(
+    const StridedSpan* const spans[kNumVertexAttributes], int num_vertices,
+    const char* message,
+    std::initializer_list<VertexAttribute> generated) const {
+  for (int attr_ind = 0; attr_ind < kNumVertexAttributes; ++attr_ind) {
+    const VertexAttribute attribute = static_cast<VertexAttribute>(attr_ind);
+    const StridedSpan& span = *spans[attr_ind];
+    const bool expected = present_[attr_ind] &&
+      std::find(generated.begin(), generated.end(), attribute) ==
+      generated.end();
+    if (span.count != (expected ? num_vertices : 0) ||
+        (span.count && !span.data) || !ValidStride(attribute, span)) {
+      throw std::invalid_argument(message);
+    }
+  }
+}
+
+void GeometryResource::NotifyBoundingBoxChanged() {
+  for (Drawable* listener : listeners_) {
+    listener->BoundingBoxChanged();
+  }
+}
+
 void GeometryResource::AddListener(Drawable* listener) {
   listeners_.push_back(listener);
 }
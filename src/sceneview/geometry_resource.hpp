@@ -4,9 +4,12 @@
 #define SCENEVIEW_GEOMETRY_RESOURCE_HPP__
 
 #include <cstdint>
+#include <future>
+#include <initializer_list>
 #include <memory>
 #include <vector>
 
+#include <QMatrix4x4>
 #include <QString>
 #include <QVector2D>
 #include <QVector3D>
@@ -15,6 +18,8 @@
 
 #include <sceneview/axis_aligned_box.hpp>
 
+class QOpenGLShaderProgram;
+
 namespace sv {
 
 class Drawable;
@@ -61,6 +66,32 @@ struct GeometryData {
    */
   std::vector<QVector2D> tex_coords_0;
 
+  /**
+   * Per-vertex timestamps, in seconds. This must be either empty or the same
+   * size as vertices.
+   */
+  std::vector<float> timestamps;
+
+  /**
+   * Per-vertex anchor indices, for geometry whose vertices are relative to
+   * the poses of an AnchorSet. This must be either empty or the same size as
+   * vertices.
+   */
+  std::vector<float> anchors;
+
+  /**
+   * Per-vertex scalar values, such as intensity or range, for the colormap
+   * stock shaders. This must be either empty or the same size as vertices.
+   */
+  std::vector<float> scalars;
+
+  /**
+   * Per-vertex integer labels, such as semantic classes, stored as floats
+   * for the label palette stock shaders. This must be either empty or the
+   * same size as vertices.
+   */
+  std::vector<float> labels;
+
   /**
    * Vertex indices. If specified, then the geometry is drawn using
    * glDrawElements(). If not, then the geometry is drawn with glDrawArrays().
@@ -74,6 +105,109 @@ struct GeometryData {
   GLenum gl_mode;
 };
 
+/**
+ * Index value that ends the current primitive and starts a new one.
+ *
+ * If the indices of a geometry contain this value, then primitive restart is
+ * enabled when drawing it. It is converted as needed when indices are stored
+ * as GL_UNSIGNED_BYTE or GL_UNSIGNED_SHORT.
+ *
+ * @ingroup sv_resources
+ */
+const uint32_t kPrimitiveRestartIndex = 0xFFFFFFFF;
+
+/**
+ * Read-only view of per-vertex float values in memory owned by the caller.
+ *
+ * The number of floats per value is implied by the attribute the span is
+ * used for (e.g., 3 for vertices and normals, 4 for colors). Values may be
+ * interleaved with other data, as long as consecutive values are @p stride
+ * bytes apart.
+ *
+ * @ingroup sv_resources
+ * @headerfile sceneview/geometry_resource.hpp
+ */
+struct StridedSpan {
+  StridedSpan() : data(nullptr), count(0), stride(0) {}
+
+  StridedSpan(const float* data, int count, int stride = 0) :
+    data(data), count(count), stride(stride) {}
+
+  /**
+   * Pointer to the first float of the first value.
+   */
+  const float* data;
+
+  /**
+   * Number of values.
+   */
+  int count;
+
+  /**
+   * Number of bytes between the start of consecutive values. Zero means the
+   * values are tightly packed.
+   */
+  int stride;
+};
+
+/**
+ * Geometry description that refers to memory owned by the caller.
+ *
+ * This is the zero-copy counterpart to GeometryData. It can be used to load
+ * data that already lives in contiguous buffers (point cloud structs,
+ * memory-mapped files, etc.) without first copying it into QVector3D
+ * vectors. Each span must be either empty or have as many values as
+ * vertices.
+ *
+ * @ingroup sv_resources
+ * @headerfile sceneview/geometry_resource.hpp
+ */
+struct GeometryDataView {
+  GeometryDataView() : indices(nullptr), num_indices(0), gl_mode(0) {}
+
+  StridedSpan vertices;
+  StridedSpan normals;
+  StridedSpan diffuse;
+  StridedSpan specular;
+  StridedSpan shininess;
+  StridedSpan tex_coords_0;
+  StridedSpan timestamps;
+  StridedSpan anchors;
+  StridedSpan scalars;
+  StridedSpan labels;
+
+  /**
+   * Vertex indices, or nullptr to draw with glDrawArrays().
+   */
+  const uint32_t* indices;
+  int num_indices;
+
+  /**
+   * The OpenGL primitive type.
+   */
+  GLenum gl_mode;
+};
+
+/**
+ * Identifies one of the per-vertex attributes stored in a GeometryResource.
+ *
+ * Each value corresponds to the GeometryData field of the same name.
+ *
+ * @ingroup sv_resources
+ */
+enum class VertexAttribute {
+  kVertices,
+  kNormals,
+  kDiffuse,
+  kSpecular,
+  kShininess,
+  kTexCoords0,
+  kTimestamps,
+  kAnchors,
+  kScalars,
+  kLabels
+};
+
 /**
  * Geometry that can be rendered with glDrawArrays() or glDrawElements().
  *
@@ -92,42 +226,164 @@ class GeometryResource {
   public:
     typedef std::shared_ptr<GeometryResource> Ptr;
 
-    ~GeometryResource();
+    virtual ~GeometryResource();
 
     /**
      * Loads the specified geometry into this resource.
      *
      * Automatically allocates buffers in graphics memory as needed.
      */
-    void Load(const GeometryData& data);
+    virtual void Load(const GeometryData& data);
+
+    /**
+     * Loads the specified geometry into this resource, and keeps the data.
+     *
+     * The data is uploaded, and then moved into this resource without being
+     * copied. It remains available via CpuData() until the next call to
+     * Load() or ReleaseCpuData(). Calls to Update() are applied to the kept
+     * data as well.
+     *
+     * Use Load() instead unless the data is needed afterwards, since the
+     * kept copy stays in system memory for as long as the resource does.
+     */
+    virtual void LoadAndKeep(GeometryData&& data);
+
+    /**
+     * Loads geometry directly from caller-owned memory.
+     *
+     * Tightly packed spans are uploaded with a single transfer. Strided spans
+     * are packed and uploaded in fixed size chunks, so at most a small
+     * temporary buffer is needed regardless of the size of the geometry.
+     *
+     * @throw std::invalid_argument if a span has the wrong number of values,
+     * or a stride that is smaller than the size of a value.
+     */
+    virtual void Load(const GeometryDataView& data);
+
+    /**
+     * Retrieve the geometry data kept by LoadAndKeep().
+     *
+     * Returns nullptr if the geometry was loaded some other way, or if the
+     * data was released.
+     */
+    const GeometryData* CpuData() const { return cpu_data_.get(); }
+
+    /**
+     * Frees the geometry data kept by LoadAndKeep().
+     */
+    void ReleaseCpuData() { cpu_data_.reset(); }
+
+    /**
+     * Reserves graphics memory for at least @p num_vertices vertices.
+     *
+     * Subsequent calls to Load() lay out each attribute with room for this
+     * many vertices, so that Update() can grow the attributes up to that size
+     * without reallocating the vertex buffer.
+     */
+    virtual void Reserve(int num_vertices);
+
+    /**
+     * Retrieve the number of vertices that each attribute has room for
+     * without reallocating the vertex buffer.
+     */
+    int Capacity() const { return capacity_; }
+
+    /**
+     * Overwrites a range of values of a single vertex attribute.
+     *
+     * Only the modified range is transferred to graphics memory (via
+     * glBufferSubData()).
+     *
+     * @param attribute the attribute to modify. The attribute must have been
+     *        present in the GeometryData passed to the most recent call to
+     *        Load().
+     * @param first index of the first vertex to modify.
+     * @param count number of vertices to modify.
+     * @param data tightly packed float values, with as many components per
+     *        vertex as the corresponding GeometryData field (e.g., 3 floats
+     *        per vertex for VertexAttribute::kVertices, 4 floats per vertex for
+     *        VertexAttribute::kDiffuse).
+     *
+     * If @p first + @p count is larger than the current number of values for
+     * the attribute, then the attribute grows. If this exceeds Capacity(),
+     * then the capacity is doubled and existing contents are copied to the
+     * new buffer in graphics memory. It's up to the caller to grow all
+     * attributes in lockstep.
+     *
+     * When vertices are updated, the bounding box is expanded to include the
+     * new vertices. The bounding box never shrinks as a result of Update(),
+     * so overwriting vertices may leave it larger than strictly necessary.
+     * Call Load() to recompute a tight bounding box.
+     *
+     * @throw std::invalid_argument if the attribute wasn't loaded, or if the
+     * range is invalid.
+     */
+    virtual void Update(VertexAttribute attribute, int first, int count,
+        const void* data);
 
     QOpenGLBuffer* VBO() { return &vbo_; }
 
     QOpenGLBuffer* IndexBuffer();
 
-    int VertexOffset() const { return vertex_offset_; }
+    qint64 VertexOffset() const { return Offset(VertexAttribute::kVertices); }
+
+    int NumVertices() const { return Count(VertexAttribute::kVertices); }
+
+    qint64 NormalOffset() const { return Offset(VertexAttribute::kNormals); }
+
+    int NumNormals() const { return Count(VertexAttribute::kNormals); }
+
+    qint64 DiffuseOffset() const { return Offset(VertexAttribute::kDiffuse); }
+
+    int NumDiffuse() const { return Count(VertexAttribute::kDiffuse); }
+
+    int NumSpecular() const { return Count(VertexAttribute::kSpecular); }
 
-    int NumVertices() const { return num_vertices_; }
+    qint64 SpecularOffset() const { return Offset(VertexAttribute::kSpecular); }
 
-    int NormalOffset() const { return normal_offset_; }
+    int NumShininess() const { return Count(VertexAttribute::kShininess); }
 
-    int NumNormals() const { return num_normals_; }
+    qint64 ShininessOffset() const {
+      return Offset(VertexAttribute::kShininess); }
 
-    int DiffuseOffset() const { return diffuse_offset_; }
+    qint64 TexCoords0Offset() const {
+      return Offset(VertexAttribute::kTexCoords0); }
 
-    int NumDiffuse() const { return num_diffuse_; }
+    int NumTexCoords0() const { return Count(VertexAttribute::kTexCoords0); }
 
-    int NumSpecular() const { return num_specular_; }
+    qint64 TimestampsOffset() const {
+      return Offset(VertexAttribute::kTimestamps); }
 
-    int SpecularOffset() const { return specular_offset_; }
+    int NumTimestamps() const { return Count(VertexAttribute::kTimestamps); }
 
-    int NumShininess() const { return num_shininess_; }
+    qint64 AnchorsOffset() const { return Offset(VertexAttribute::kAnchors); }
 
-    int ShininessOffset() const { return shininess_offset_; }
+    int NumAnchors() const { return Count(VertexAttribute::kAnchors); }
+
+    qint64 ScalarsOffset() const { return Offset(VertexAttribute::kScalars); }
+
+    int NumScalars() const { return Count(VertexAttribute::kScalars); }
+
+    qint64 LabelsOffset() const { return Offset(VertexAttribute::kLabels); }
+
+    int NumLabels() const { return Count(VertexAttribute::kLabels); }
+
+    /**
+     * Retrieve the byte offset of an attribute in the vertex buffer.
+     */
+    qint64 Offset(VertexAttribute attribute) const {
+      return offsets_[static_cast<int>(attribute)]; }
 
-    int TexCoords0Offset() const { return tex_coords_0_offset_; }
+    /**
+     * Retrieve the number of values loaded for an attribute.
+     */
+    int Count(VertexAttribute attribute) const {
+      return counts_[static_cast<int>(attribute)]; }
 
-    int NumTexCoords0() const { return num_tex_coords_0_; }
+    /**
+     * Retrieve the number of floats per vertex for an attribute.
+     */
+    static int NumComponents(VertexAttribute attribute);
 
     int NumIndices() const { return num_indices_; }
 
@@ -137,6 +393,17 @@ class GeometryResource {
      */
     GLenum IndexType() const { return index_type_; }
 
+    /**
+     * Returns true if the indices contain kPrimitiveRestartIndex.
+     */
+    bool PrimitiveRestart() const { return primitive_restart_; }
+
+    /**
+     * Returns the restart index to pass to glPrimitiveRestartIndex(), which
+     * depends on IndexType().
+     */
+    GLuint PrimitiveRestartIndex() const;
+
     /**
      * What kind of primitives are in this geometry (GL_POINTS, GL_LINE_STRIP,
      * ...)
@@ -145,17 +412,234 @@ class GeometryResource {
 
     const AxisAlignedBox& BoundingBox() const { return bounding_box_; }
 
+    /**
+     * Retrieve the number of contiguous ranges to draw.
+     *
+     * Ranges are of vertices for non-indexed geometry, and of indices for
+     * indexed geometry. Most geometry is drawn as a single range of all
+     * vertices or indices. Subclasses that keep their vertices in a ring
+     * buffer or a pool may have several. Coarser levels of detail are always
+     * drawn as a single range.
+     */
+    virtual int NumDrawRanges() const { return 1; }
+
+    /**
+     * Retrieve the first vertex or index and the number of vertices or
+     * indices of a range to draw.
+     */
+    virtual void DrawRange(int range, int* first, int* count) const {
+      *first = 0;
+      *count = num_indices_ ? num_indices_ : NumVertices();
+    }
+
+    /**
+     * Called before the geometry is drawn, with the model-view-projection
+     * matrix it is drawn with.
+     *
+     * Subclasses can override this to skip parts of the geometry that are
+     * outside the view frustum when computing the draw ranges.
+     */
+    virtual void PrepareDrawRanges(const QMatrix4x4& model_view_projection) {}
+
+    /**
+     * Retrieve the number of instances of the geometry to draw.
+     *
+     * Most geometry is drawn once. Subclasses that draw many copies of the
+     * same geometry with a single instanced draw call return the number of
+     * copies, and provide the per-instance vertex attributes with
+     * EnableInstanceArrays(). If this returns 0, nothing is drawn.
+     */
+    virtual int NumInstances() const { return 1; }
+
+    /**
+     * Called before an instanced draw call to bind the per-instance
+     * attribute arrays of @p program, with a vertex attribute divisor of 1.
+     */
+    virtual void EnableInstanceArrays(QOpenGLShaderProgram* program) {}
+
+    /**
+     * Called after an instanced draw call to undo EnableInstanceArrays().
+     * The divisor is attribute state, and must be reset to 0.
+     */
+    virtual void DisableInstanceArrays(QOpenGLShaderProgram* program) {}
+
+    /**
+     * Sets the per-instance attributes of @p program to constant values for
+     * a single instance.
+     *
+     * Only used when the OpenGL headers lack instanced draw calls, in which
+     * case each instance is drawn with its own draw call.
+     */
+    virtual void SetInstanceAttributes(QOpenGLShaderProgram* program,
+        int instance) {}
+
+    /**
+     * Sets coarser levels of detail for indexed triangle geometry.
+     *
+     * Each level is a triangle list that indexes into the same vertices as
+     * the full resolution geometry (e.g., as produced by SimplifyMesh() or
+     * GenerateLodChain()), ordered from finest to coarsest. All levels share
+     * a single index buffer. Level 0 is always the geometry passed to
+     * Load(), and loading new geometry discards the coarser levels.
+     *
+     * When drawing, the level is chosen based on the projected size of the
+     * geometry on screen. See SetLodMaxScreenSize().
+     *
+     * @throw std::invalid_argument if the geometry isn't an indexed triangle
+     * list, or an index is out of range.
+     */
+    virtual void SetLods(
+        const std::vector<std::vector<uint32_t>>& lod_indices);
+
+    /**
+     * Generates levels of detail in the background.
+     *
+     * Simplifies @p data, which should be the data most recently passed to
+     * Load(), on a worker thread with GenerateLodChain(). The levels are
+     * uploaded the next time the geometry is drawn after they're ready. If
+     * other geometry is loaded in the meantime, the results are discarded.
+     *
+     * @param data the geometry to simplify. It's copied, so it doesn't have
+     *        to outlive this call.
+     * @param max_levels the maximum number of levels to generate, not
+     *        including the full resolution level.
+     */
+    virtual void GenerateLods(const GeometryData& data, int max_levels = 4);
+
+    /**
+     * Retrieve the number of levels of detail, including the full resolution
+     * level.
+     */
+    int NumLods() const { return 1 + lods_.size(); }
+
+    /**
+     * Retrieve the number of indices in a level of detail.
+     */
+    int LodNumIndices(int level) const {
+      return level == 0 ? num_indices_ : lods_[level - 1].num_indices; }
+
+    /**
+     * Retrieve the byte offset of a level of detail in the index buffer.
+     */
+    qint64 LodIndexOffset(int level) const;
+
+    /**
+     * Retrieve the projected size, in pixels, above which a level of detail
+     * is no longer used.
+     */
+    float LodMaxScreenSize(int level) const;
+
+    /**
+     * Sets the projected size, in pixels, above which a level of detail is
+     * no longer used.
+     *
+     * The projected size is the diameter of the bounding sphere of the
+     * geometry's bounding box on screen. By default, a level with 1/N as
+     * many triangles as the full resolution geometry is used up to
+     * 1000 / sqrt(N) pixels.
+     */
+    void SetLodMaxScreenSize(int level, float max_screen_size);
+
+  protected:
+    static constexpr int kNumVertexAttributes = 10;
+
+    explicit GeometryResource(const QString& name);
+
+    /**
+     * @param self_managed true for subclasses that manage the vertex buffer
+     *        themselves. Load(), LoadAndKeep(), Reserve(), Update(),
+     *        SetLods() and GenerateLods() would replace its contents, and
+     *        throw std::logic_error instead.
+     */
+    GeometryResource(const QString& name, bool self_managed);
+
+    /**
+     * Notifies listeners that the bounding box has changed.
+     */
+    void NotifyBoundingBoxChanged();
+
+    /**
+     * Throws std::logic_error if the geometry is self managed, since
+     * @p method would replace the contents of the vertex buffer.
+     */
+    void CheckNotSelfManaged(const char* method) const;
+
+    /**
+     * Fills @p spans with pointers to the span of each vertex attribute of
+     * @p data, in VertexAttribute order.
+     */
+    static void GetSpans(const GeometryDataView& data,
+        const StridedSpan* spans[kNumVertexAttributes]);
+
+    /**
+     * Checks spans of new values for the present attributes. Each present
+     * attribute must have @p num_vertices values, except for those in
+     * @p generated, which the subclass fills in itself. All other spans must
+     * be empty.
+     *
+     * @throw std::invalid_argument with @p message if a span doesn't match,
+     * or has an invalid stride.
+     */
+    void CheckSpans(const StridedSpan* const spans[kNumVertexAttributes],
+        int num_vertices, const char* message,
+        std::initializer_list<VertexAttribute> generated = {}) const;
+
+    /**
+     * Lays out each present attribute with room for @p capacity values, and
+     * allocates the vertex buffer.
+     *
+     * If @p preserve_contents is true, the loaded values are copied into the
+     * new buffer in graphics memory.
+     */
+    void AllocateVBO(int capacity, bool preserve_contents);
+
+    /**
+     * Writes the values of @p span to an attribute, starting at value
+     * @p first. The vertex buffer must be bound, and have room for the
+     * values.
+     */
+    void WriteSpan(VertexAttribute attribute, int first,
+        const StridedSpan& span);
+
+    /**
+     * Returns @p size, the number of bytes in a buffer, after checking that
+     * it can be allocated.
+     *
+     * @throw std::invalid_argument if the size is negative or doesn't fit in
+     * a GLsizeiptr.
+     */
+    static qint64 BufferSize(qint64 size);
+
+    /**
+     * Returns the capacity to grow a buffer holding @p capacity values to,
+     * so that it holds at least @p min_capacity values. This is double the
+     * current capacity, up to the largest count that fits in an int.
+     *
+     * @throw std::invalid_argument if @p min_capacity doesn't fit in an int.
+     */
+    static int GrowCapacity(int capacity, qint64 min_capacity);
+
   private:
     friend class ResourceManager;
 
     friend class Drawable;
 
-    explicit GeometryResource(const QString& name);
+    friend class DrawContext;
+
+    struct LevelOfDetail {
+      int first_index;
+      int num_indices;
+      float max_screen_size;
+    };
+
+    // Uploads levels of detail generated by GenerateLods(), if they're ready.
+    void ProcessPendingLods();
 
     void AddListener(Drawable* drawable);
 
     void RemoveListener(Drawable* drawable);
 
+  protected:
     const QString name_;
 
     // Vertex buffer to hold the data in graphics memory
@@ -163,28 +647,34 @@ class GeometryResource {
     QOpenGLBuffer vbo_;
     QOpenGLBuffer index_buffer_;
 
-    int vertex_offset_;
-    int normal_offset_;
-    int diffuse_offset_;
-    int specular_offset_;
-    int shininess_offset_;
-    int tex_coords_0_offset_;
+    // Each attribute is stored as a contiguous block in the vertex buffer
+    // with room for capacity_ values. Attributes not present in the last
+    // loaded GeometryData have no block.
+    qint64 offsets_[kNumVertexAttributes];
+    int counts_[kNumVertexAttributes];
+    bool present_[kNumVertexAttributes];
 
-    int num_vertices_;
-    int num_normals_;
-    int num_diffuse_;
-    int num_specular_;
-    int num_shininess_;
-    int num_tex_coords_0_;
+    int capacity_;
+    int reserved_capacity_;
 
     int num_indices_;
 
     GLenum gl_mode_;
     GLenum index_type_;
+    bool primitive_restart_;
 
     AxisAlignedBox bounding_box_;
 
+    // System memory copy of the geometry, if requested.
+    std::unique_ptr<GeometryData> cpu_data_;
+
+  private:
+    const bool self_managed_;
+
     std::vector<Drawable*> listeners_;
+
+    std::vector<LevelOfDetail> lods_;
+    std::future<std::vector<std::vector<uint32_t>>> pending_lods_;
 };
 
 }  // namespace sv
@@ -82,7 +82,8 @@ void GridRenderer::RenderBegin() {
   // Calculate camera distance from grid
   CameraNode* camera = GetViewport()->GetCamera();
   const double distance =
-    (camera->Translation() - camera->GetLookAt()).length();
+    (camera->PreciseTranslation() - camera->GetPreciseLookAt())
+    .ToVector3D().length();
 
   const double grid_spacing = RoundTo125(distance / 10);
   draw_node_->SetScale(grid_spacing, grid_spacing, 1);
@@ -51,7 +51,7 @@ void GroupNode::CopyAsChildren(Scene* scene, GroupNode* root) {
   std::deque<SceneNode*>
     to_process(tocopy_children.begin(), tocopy_children.end());
 
-  SetTranslation(root->Translation());
+  SetPreciseTranslation(root->PreciseTranslation());
   SetRotation(root->Rotation());
   SetScale(root->Scale());
   SetVisible(root->Visible());
@@ -103,7 +103,7 @@ void GroupNode::CopyAsChildren(Scene* scene, GroupNode* root) {
         break;
     }
 
-    node_copy->SetTranslation(to_copy->Translation());
+    node_copy->SetPreciseTranslation(to_copy->PreciseTranslation());
     node_copy->SetRotation(to_copy->Rotation());
     node_copy->SetScale(to_copy->Scale());
     node_copy->SetVisible(to_copy->Visible());
@@ -0,0 +1,169 @@
+// Copyright [2015] Albert Huang
+
+#include "sceneview/internal_gl.hpp"
+
+#include "sceneview/growing_geometry_resource.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#if 0
+#define dbg(fmt, ...) printf(fmt, __VA_ARGS__)
+#else
+#define dbg(...)
+#endif
+
+namespace sv {
+
+// Initial size of the index buffer, in indices.
+static const int kMinIndexCapacity = 1024;
+
+GrowingGeometryResource::GrowingGeometryResource(const QString& name) :
+  GeometryResource(name, true),
+  index_capacity_(0) {}
+
+GrowingGeometryResource::~GrowingGeometryResource() {}
+
+void GrowingGeometryResource::Initialize(GLenum gl_mode,
+    const std::vector<VertexAttribute>& attributes, int initial_capacity) {
+  if (std::find(attributes.begin(), attributes.end(),
+        VertexAttribute::kVertices) == attributes.end()) {
+    throw std::invalid_argument("Growing geometry must have vertices");
+  }
+
+  for (int attr_ind = 0; attr_ind < kNumVertexAttributes; ++attr_ind) {
+    present_[attr_ind] = false;
+    counts_[attr_ind] = 0;
+  }
+  for (VertexAttribute attribute : attributes) {
+    present_[static_cast<int>(attribute)] = true;
+  }
+
+  gl_mode_ = gl_mode;
+  num_indices_ = 0;
+  index_type_ = GL_UNSIGNED_INT;
+  primitive_restart_ = false;
+  bounding_box_ = AxisAlignedBox();
+
+  // The buffer is written to over and over.
+  vbo_.setUsagePattern(QOpenGLBuffer::DynamicDraw);
+  AllocateVBO(std::max(initial_capacity, 1), false);
+  vbo_.release();
+
+  NotifyBoundingBoxChanged();
+}
+
+void GrowingGeometryResource::Append(const GeometryDataView& data) {
+  if (!created_vbo_) {
+    throw std::logic_error("Initialize() must be called before Append()");
+  }
+
+  // Check inputs
+  const StridedSpan* spans[kNumVertexAttributes];
+  GetSpans(data, spans);
+  const int num_new_vertices = data.vertices.count;
+  CheckSpans(spans, num_new_vertices,
+      "Appended data doesn't match the geometry attributes");
+  const int vertices_ind = static_cast<int>(VertexAttribute::kVertices);
+  if (num_new_vertices >
+      std::numeric_limits<int>::max() - counts_[vertices_ind]) {
+    throw std::invalid_argument("Too many vertices");
+  }
+  const int num_vertices = counts_[vertices_ind] + num_new_vertices;
+  if (data.num_indices < 0 || (data.num_indices && !data.indices)) {
+    throw std::invalid_argument("Invalid indices");
+  }
+  if (data.num_indices > std::numeric_limits<int>::max() - num_indices_) {
+    throw std::invalid_argument("Too many indices");
+  }
+  bool restart = false;
+  for (int index_ind = 0; index_ind < data.num_indices; ++index_ind) {
+    const uint32_t index = data.indices[index_ind];
+    if (index == kPrimitiveRestartIndex) {
+      restart = true;
+    } else if (index >= static_cast<uint32_t>(num_vertices)) {
+      throw std::invalid_argument("Vertex index out of range");
+    }
+  }
+
+  // Upload the new vertices after the existing ones.
+  if (num_new_vertices) {
+    if (num_vertices > capacity_) {
+      AllocateVBO(GrowCapacity(capacity_, num_vertices), true);
+      dbg("%s: grew to %d vertices\n", name_.toStdString().c_str(),
+          capacity_);
+    }
+    vbo_.bind();
+    for (int attr_ind = 0; attr_ind < kNumVertexAttributes; ++attr_ind) {
+      if (present_[attr_ind]) {
+        WriteSpan(static_cast<VertexAttribute>(attr_ind), counts_[attr_ind],
+            *spans[attr_ind]);
+        counts_[attr_ind] = num_vertices;
+      }
+    }
+    vbo_.release();
+  }
+
+  // Upload the new indices after the existing ones.
+  if (data.num_indices) {
+    const int num_indices = num_indices_ + data.num_indices;
+    if (num_indices > index_capacity_) {
+      GrowIndexBuffer(GrowCapacity(index_capacity_,
+            std::max(num_indices, kMinIndexCapacity)));
+    }
+    index_buffer_.bind();
+    BufferSubData(&index_buffer_,
+        static_cast<qint64>(num_indices_) * sizeof(uint32_t), data.indices,
+        static_cast<qint64>(data.num_indices) * sizeof(uint32_t));
+    index_buffer_.release();
+    num_indices_ = num_indices;
+    primitive_restart_ = primitive_restart_ || restart;
+  }
+
+  // Extend the bounding box, and only notify listeners if it actually grew.
+  const AxisAlignedBox new_box = AxisAlignedBox::FromPoints(
+      data.vertices.data, num_new_vertices, data.vertices.stride);
+  if (new_box.Valid()) {
+    AxisAlignedBox box = bounding_box_;
+    box.IncludeBox(new_box);
+    if (!bounding_box_.Valid() || box.Min() != bounding_box_.Min() ||
+        box.Max() != bounding_box_.Max()) {
+      bounding_box_ = box;
+      NotifyBoundingBoxChanged();
+    }
+  }
+}
+
+void GrowingGeometryResource::Clear() {
+  for (int attr_ind = 0; attr_ind < kNumVertexAttributes; ++attr_ind) {
+    counts_[attr_ind] = 0;
+  }
+  num_indices_ = 0;
+  primitive_restart_ = false;
+  bounding_box_ = AxisAlignedBox();
+  NotifyBoundingBoxChanged();
+}
+
+void GrowingGeometryResource::GrowIndexBuffer(int capacity) {
+  QOpenGLBuffer new_buffer(QOpenGLBuffer::IndexBuffer);
+  new_buffer.setUsagePattern(QOpenGLBuffer::DynamicDraw);
+  new_buffer.create();
+  new_buffer.bind();
+  BufferData(&new_buffer,
+      BufferSize(static_cast<qint64>(capacity) * sizeof(uint32_t)));
+  if (num_indices_) {
+    CopyBufferSubData(&index_buffer_, 0, &new_buffer, 0,
+        static_cast<qint64>(num_indices_) * sizeof(uint32_t));
+  }
+  new_buffer.release();
+
+  if (index_buffer_.isCreated()) {
+    index_buffer_.destroy();
+  }
+  index_buffer_ = new_buffer;
+  index_capacity_ = capacity;
+}
+
+}  // namespace sv
@@ -0,0 +1,106 @@
+// Copyright [2015] Albert Huang
+
+#ifndef SCENEVIEW_GROWING_GEOMETRY_RESOURCE_HPP__
+#define SCENEVIEW_GROWING_GEOMETRY_RESOURCE_HPP__
+
+#include <memory>
+#include <vector>
+
+#include <sceneview/geometry_resource.hpp>
+
+namespace sv {
+
+/**
+ * Geometry that only ever grows, such as an accumulated map or a trajectory.
+ *
+ * Loading the complete geometry with GeometryResource::Load() every time
+ * some data is added costs time proportional to the total size of the
+ * geometry. GrowingGeometryResource instead uploads only the appended data:
+ *
+ * @code
+ * geom->Initialize(GL_POINTS,
+ *     { VertexAttribute::kVertices, VertexAttribute::kDiffuse });
+ *
+ * // For each new scan:
+ * GeometryDataView scan;
+ * scan.vertices = StridedSpan(&points[0].x, num_points, sizeof(Point));
+ * scan.diffuse = StridedSpan(&points[0].r, num_points, sizeof(Point));
+ * geom->Append(scan);
+ * @endcode
+ *
+ * When the vertex or index buffer runs out of room, its capacity is doubled
+ * and the existing contents are copied within graphics memory, so the
+ * amortized cost of appending is proportional to the size of the appended
+ * data. The bounding box is extended with the appended vertices, and
+ * listeners are notified at most once per call to Append().
+ *
+ * The geometry is only ever appended to, so Load(), LoadAndKeep(), Reserve(),
+ * Update(), SetLods() and GenerateLods() aren't supported, and throw
+ * std::logic_error.
+ *
+ * GrowingGeometryResource objects cannot be directly instantiated. Instead,
+ * use ResourceManager.
+ *
+ * @ingroup sv_resources
+ * @headerfile sceneview/growing_geometry_resource.hpp
+ */
+class GrowingGeometryResource : public GeometryResource {
+  public:
+    typedef std::shared_ptr<GrowingGeometryResource> Ptr;
+
+    ~GrowingGeometryResource();
+
+    /**
+     * Discards any existing geometry, and sets the vertex attributes that
+     * appended data provides.
+     *
+     * Must be called with a current OpenGL context, before any call to
+     * Append().
+     *
+     * @param gl_mode the primitive type (GL_POINTS, GL_LINE_STRIP, ...)
+     * @param attributes the vertex attributes. VertexAttribute::kVertices
+     *        must be included.
+     * @param initial_capacity the number of vertices to allocate room for
+     *        up front.
+     *
+     * @throw std::invalid_argument if the attributes don't include vertices.
+     */
+    void Initialize(GLenum gl_mode,
+        const std::vector<VertexAttribute>& attributes,
+        int initial_capacity = 1024);
+
+    /**
+     * Appends vertices and indices.
+     *
+     * Each attribute passed to Initialize() must have a span with as many
+     * values as @p data.vertices. Spans of other attributes must be empty.
+     * Indices are optional, and refer to vertices by their position in the
+     * complete geometry (i.e., they are not relative to the appended
+     * vertices). The geometry is drawn with glDrawElements() once any
+     * indices have been appended. @p data.gl_mode is ignored.
+     *
+     * @throw std::invalid_argument if the spans don't match the attributes
+     * passed to Initialize(), or an index refers to a vertex that doesn't
+     * exist.
+     */
+    void Append(const GeometryDataView& data);
+
+    /**
+     * Removes all vertices and indices, but keeps the graphics memory so
+     * that the geometry can grow again without reallocating.
+     */
+    void Clear();
+
+  private:
+    friend class ResourceManager;
+
+    explicit GrowingGeometryResource(const QString& name);
+
+    void GrowIndexBuffer(int capacity);
+
+    int index_capacity_;
+};
+
+}  // namespace sv
+
+#endif  // SCENEVIEW_GROWING_GEOMETRY_RESOURCE_HPP__
@@ -0,0 +1,316 @@
+// Copyright [2015] Albert Huang
+
+#include "sceneview/internal_gl.hpp"
+
+#include "sceneview/heightfield.hpp"
+
+#include <algorithm>
+#include <limits>
+
+#include <QMatrix4x4>
+#include <QOpenGLTexture>
+
+#include "sceneview/camera_node.hpp"
+#include "sceneview/draw_node.hpp"
+#include "sceneview/drawable.hpp"
+#include "sceneview/group_node.hpp"
+#include "sceneview/stock_resources.hpp"
+#include "sceneview/viewport.hpp"
+
+#if 0
+#define dbg(fmt, ...) printf(fmt, __VA_ARGS__)
+#else
+#define dbg(...)
+#endif
+
+namespace sv {
+
+// Above this many changed rectangles, they are merged into one.
+static const int kMaxDirtyRects = 16;
+
+/**
+ * Draws one placement of the hole of a level. Only the drawable that matches
+ * the current placement is drawn, and the bounding box follows the level
+ * instead of the static grid.
+ */
+class HeightfieldRingDrawable : public Drawable {
+  public:
+    HeightfieldRingDrawable(const GeometryResource::Ptr& geometry,
+        const MaterialResource::Ptr& material) :
+      Drawable(geometry, material),
+      active_(false) {}
+
+    bool PreDraw() override { return active_; }
+
+    const AxisAlignedBox& BoundingBox() override { return box_; }
+
+    void SetActive(bool active) { active_ = active; }
+
+    void SetBoundingBox(const AxisAlignedBox& box) {
+      if (box != box_) {
+        box_ = box;
+        BoundingBoxChanged();
+      }
+    }
+
+  private:
+    bool active_;
+    AxisAlignedBox box_;
+};
+
+// Identifies the geometry of a level with a hole offset. Index 0 is the full
+// grid of level 0.
+static int GeometryIndex(int hole_x, int hole_y) {
+  return 1 + (hole_y + 1) * 3 + hole_x + 1;
+}
+
+Heightfield::Ptr Heightfield::Create(Viewport* viewport, GroupNode* parent,
+    int width, int height, float spacing, int grid_size) {
+  return Ptr(new Heightfield(viewport, parent, width, height, spacing,
+        grid_size));
+}
+
+Heightfield::Heightfield(Viewport* viewport, GroupNode* parent,
+    int width, int height, float spacing, int grid_size) :
+  resources_(viewport->GetResources()),
+  scene_(viewport->GetScene()),
+  spacing_(spacing),
+  clipmap_(width, height, grid_size),
+  heights_(static_cast<size_t>(width) * height, 0),
+  height_set_(static_cast<size_t>(width) * height, false),
+  any_height_set_(false),
+  min_height_(0),
+  max_height_(0),
+  auto_color_range_(true),
+  color_min_(0),
+  color_max_(0) {
+  node_ = scene_->MakeGroup(parent);
+  dirty_.push_back(Rect { 0, 0, width, height });
+}
+
+Heightfield::~Heightfield() {
+  if (scene_->ContainsNode(node_)) {
+    scene_->DestroyNode(node_);
+  }
+}
+
+void Heightfield::SetHeights(int x, int y, int width, int height,
+    const float* heights, int stride) {
+  if (!stride) {
+    stride = width;
+  }
+  const int x_begin = std::max(x, 0);
+  const int y_begin = std::max(y, 0);
+  const int x_end = std::min(x + width, Width());
+  const int y_end = std::min(y + height, Height());
+  if (x_begin >= x_end || y_begin >= y_end) {
+    return;
+  }
+
+  // If one of the extremes is overwritten, then the range may shrink, and
+  // has to be recomputed from all of the heights.
+  bool overwrote_extreme = false;
+  float new_min = std::numeric_limits<float>::infinity();
+  float new_max = -std::numeric_limits<float>::infinity();
+  for (int row = y_begin; row < y_end; ++row) {
+    const float* src = heights + (row - y) * stride + (x_begin - x);
+    const size_t first = static_cast<size_t>(row) * Width() + x_begin;
+    for (int col = 0; col < x_end - x_begin; ++col) {
+      const size_t ind = first + col;
+      if (height_set_[ind] && (heights_[ind] == min_height_ ||
+            heights_[ind] == max_height_)) {
+        overwrote_extreme = true;
+      }
+      heights_[ind] = src[col];
+      height_set_[ind] = true;
+      new_min = std::min(new_min, src[col]);
+      new_max = std::max(new_max, src[col]);
+    }
+  }
+  if (overwrote_extreme) {
+    RecomputeHeightRange();
+  } else if (!any_height_set_) {
+    min_height_ = new_min;
+    max_height_ = new_max;
+  } else {
+    min_height_ = std::min(min_height_, new_min);
+    max_height_ = std::max(max_height_, new_max);
+  }
+  any_height_set_ = true;
+
+  dirty_.push_back(Rect { x_begin, y_begin, x_end - x_begin,
+      y_end - y_begin });
+  if (static_cast<int>(dirty_.size()) > kMaxDirtyRects) {
+    Rect merged = dirty_.front();
+    for (const Rect& rect : dirty_) {
+      const int merged_x_end = std::max(merged.x + merged.width,
+          rect.x + rect.width);
+      const int merged_y_end = std::max(merged.y + merged.height,
+          rect.y + rect.height);
+      merged.x = std::min(merged.x, rect.x);
+      merged.y = std::min(merged.y, rect.y);
+      merged.width = merged_x_end - merged.x;
+      merged.height = merged_y_end - merged.y;
+    }
+    dirty_.assign(1, merged);
+  }
+}
+
+void Heightfield::RecomputeHeightRange() {
+  min_height_ = std::numeric_limits<float>::infinity();
+  max_height_ = -std::numeric_limits<float>::infinity();
+  for (size_t ind = 0; ind < heights_.size(); ++ind) {
+    if (height_set_[ind]) {
+      min_height_ = std::min(min_height_, heights_[ind]);
+      max_height_ = std::max(max_height_, heights_[ind]);
+    }
+  }
+}
+
+void Heightfield::SetColorRange(float min_height, float max_height) {
+  auto_color_range_ = false;
+  color_min_ = min_height;
+  color_max_ = max_height;
+  UpdateColorRange();
+}
+
+void Heightfield::ResetColorRange() {
+  auto_color_range_ = true;
+  UpdateColorRange();
+}
+
+void Heightfield::Update(CameraNode* camera) {
+  if (!texture_) {
+    InitializeGL();
+  }
+  UploadHeights();
+
+  const QVector3D eye = node_->WorldTransform().inverted() *
+    camera->WorldTransform().column(3).toVector3D();
+  clipmap_.Update(eye.x() / spacing_, eye.y() / spacing_);
+
+  const float half_size = clipmap_.GridSize() / 2;
+  const float max_x = spacing_ * (Width() - 1);
+  const float max_y = spacing_ * (Height() - 1);
+  for (int level_ind = 0; level_ind < clipmap_.NumLevels(); ++level_ind) {
+    const HeightfieldClipmap::Level& level = clipmap_.GetLevel(level_ind);
+    LevelData& level_data = levels_[level_ind];
+    level_data.material->SetParam("hf_center",
+        static_cast<float>(level.center_x),
+        static_cast<float>(level.center_y));
+
+    // Grids outside the heightfield are discarded by the shader, so the
+    // bounding box is clipped to it.
+    const float extent = spacing_ * level.scale * half_size;
+    const float center_x = spacing_ * level.center_x;
+    const float center_y = spacing_ * level.center_y;
+    const AxisAlignedBox box(
+        QVector3D(std::min(std::max(center_x - extent, 0.0f), max_x),
+          std::min(std::max(center_y - extent, 0.0f), max_y), min_height_),
+        QVector3D(std::min(center_x + extent, max_x),
+          std::min(center_y + extent, max_y), max_height_));
+
+    const int active = level_ind == 0 ? 0 :
+      GeometryIndex(level.hole_x, level.hole_y) - 1;
+    for (size_t ind = 0; ind < level_data.drawables.size(); ++ind) {
+      level_data.drawables[ind]->SetActive(static_cast<int>(ind) == active);
+      level_data.drawables[ind]->SetBoundingBox(box);
+    }
+  }
+}
+
+void Heightfield::InitializeGL() {
+  texture_.reset(new QOpenGLTexture(QOpenGLTexture::Target2D));
+  texture_->setSize(Width(), Height());
+  texture_->setFormat(QOpenGLTexture::R32F);
+  texture_->allocateStorage();
+  texture_->setMinificationFilter(QOpenGLTexture::Nearest);
+  texture_->setMagnificationFilter(QOpenGLTexture::Nearest);
+  texture_->setWrapMode(QOpenGLTexture::ClampToEdge);
+
+  // The grids hold grid coordinates, and are shared by all levels.
+  const int grid_size = clipmap_.GridSize();
+  GeometryData gdata;
+  gdata.gl_mode = GL_TRIANGLES;
+  for (int row = 0; row <= grid_size; ++row) {
+    for (int col = 0; col <= grid_size; ++col) {
+      gdata.vertices.emplace_back(col - grid_size / 2, row - grid_size / 2,
+          0);
+    }
+  }
+  gdata.indices = HeightfieldClipmap::MakeIndices(grid_size, false);
+  geometries_.push_back(resources_->MakeGeometry());
+  geometries_.back()->Load(gdata);
+  for (int hole_y = -1; hole_y <= 1; ++hole_y) {
+    for (int hole_x = -1; hole_x <= 1; ++hole_x) {
+      gdata.indices = HeightfieldClipmap::MakeIndices(grid_size, true,
+          hole_x, hole_y);
+      geometries_.push_back(resources_->MakeGeometry());
+      geometries_.back()->Load(gdata);
+    }
+  }
+
+  StockResources stock(resources_);
+  levels_.resize(clipmap_.NumLevels());
+  for (int level_ind = 0; level_ind < clipmap_.NumLevels(); ++level_ind) {
+    LevelData& level_data = levels_[level_ind];
+    level_data.material =
+      stock.NewMaterial(StockResources::kHeightfieldLighting);
+    level_data.material->AddTexture("hf_heights", texture_);
+    level_data.material->SetParam("hf_size", static_cast<float>(Width()),
+        static_cast<float>(Height()));
+    level_data.material->SetParam("hf_spacing", spacing_);
+    level_data.material->SetParam("hf_grid_radius",
+        static_cast<float>(grid_size / 2));
+    level_data.material->SetParam("hf_scale",
+        static_cast<float>(clipmap_.GetLevel(level_ind).scale));
+    // The outer edge of each level but the coarsest meets a coarser level.
+    level_data.material->SetParam("hf_stitch",
+        level_ind + 1 < clipmap_.NumLevels() ? 1.0f : 0.0f);
+
+    level_data.draw_node = scene_->MakeDrawNode(node_);
+    level_data.draw_node->SetSelectionMask(node_->GetSelectionMask());
+    const size_t first = level_ind == 0 ? 0 : 1;
+    const size_t last = level_ind == 0 ? 1 : geometries_.size();
+    for (size_t geom_ind = first; geom_ind < last; ++geom_ind) {
+      HeightfieldRingDrawable* drawable = new HeightfieldRingDrawable(
+          geometries_[geom_ind], level_data.material);
+      level_data.drawables.push_back(drawable);
+      level_data.draw_node->Add(Drawable::Ptr(drawable));
+    }
+  }
+  UpdateColorRange();
+}
+
+void Heightfield::UploadHeights() {
+  if (dirty_.empty()) {
+    return;
+  }
+  texture_->bind();
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+  glPixelStorei(GL_UNPACK_ROW_LENGTH, Width());
+  for (const Rect& rect : dirty_) {
+    glTexSubImage2D(GL_TEXTURE_2D, 0, rect.x, rect.y, rect.width,
+        rect.height, GL_RED, GL_FLOAT,
+        &heights_[rect.y * Width() + rect.x]);
+    dbg("Wrote heights (%d, %d) %dx%d\n", rect.x, rect.y, rect.width,
+        rect.height);
+  }
+  glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+  texture_->release();
+  dirty_.clear();
+
+  if (auto_color_range_) {
+    UpdateColorRange();
+  }
+}
+
+void Heightfield::UpdateColorRange() {
+  const float color_min = auto_color_range_ ? min_height_ : color_min_;
+  const float color_max = auto_color_range_ ? max_height_ : color_max_;
+  for (LevelData& level_data : levels_) {
+    level_data.material->SetParam("hf_color_range", color_min, color_max);
+  }
+}
+
+}  // namespace sv
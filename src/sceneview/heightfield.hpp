@@ -0,0 +1,196 @@
+// Copyright [2015] Albert Huang
+
+#ifndef SCENEVIEW_HEIGHTFIELD_HPP__
+#define SCENEVIEW_HEIGHTFIELD_HPP__
+
+#include <memory>
+#include <vector>
+
+#include <sceneview/geometry_resource.hpp>
+#include <sceneview/heightfield_clipmap.hpp>
+#include <sceneview/material_resource.hpp>
+#include <sceneview/resource_manager.hpp>
+#include <sceneview/scene.hpp>
+
+class QOpenGLTexture;
+
+namespace sv {
+
+class CameraNode;
+class DrawNode;
+class GroupNode;
+class HeightfieldRingDrawable;
+class Viewport;
+
+/**
+ * Draws an elevation map, such as a digital elevation model or a terrain map
+ * built by a robot, as a lit surface colored by height.
+ *
+ * The heights are stored in a floating point texture, and the surface is
+ * drawn with a few small static grids that are displaced in the vertex
+ * shader. The grids are arranged as a HeightfieldClipmap: a fine grid around
+ * the camera, surrounded by rings of coarser and coarser grids. Moving the
+ * camera only moves the grids, and changing the heights only writes the
+ * changed texels to the texture, so neither rebuilds any geometry. Normals
+ * and colors are computed in the shader.
+ *
+ * Texel (x, y) of the heightfield is at (x, y) * spacing on the xy plane of
+ * Node(), and its height is its z coordinate.
+ *
+ * @code
+ * Heightfield::Ptr terrain = Heightfield::Create(viewport, scene->Root(),
+ *     2048, 2048, 0.5);
+ * terrain->SetHeights(0, 0, 2048, 2048, elevations.data());
+ *
+ * // When the map changes:
+ * terrain->SetHeights(x, y, width, height, patch.data());
+ *
+ * // In Renderer::RenderBegin(), or elsewhere with the OpenGL context
+ * // current, once per frame:
+ * terrain->Update(viewport->GetCamera());
+ * @endcode
+ *
+ * @ingroup sv_scenegraph
+ * @headerfile sceneview/heightfield.hpp
+ */
+class Heightfield {
+  public:
+    typedef std::shared_ptr<Heightfield> Ptr;
+
+    /**
+     * Creates a heightfield. All heights start at zero.
+     *
+     * @param viewport provides the scene and resources.
+     * @param parent the parent of Node().
+     * @param width the number of texels along x.
+     * @param height the number of texels along y.
+     * @param spacing the distance between adjacent texels, in the units of
+     *        Node().
+     * @param grid_size the number of cells along each side of each grid. Must
+     *        be a multiple of 4, and at least 8.
+     */
+    static Ptr Create(Viewport* viewport, GroupNode* parent,
+        int width, int height, float spacing, int grid_size = 64);
+
+    ~Heightfield();
+
+    /**
+     * Sets the heights of a rectangle of texels.
+     *
+     * Heights must be finite. The texture is written by the next call to
+     * Update().
+     *
+     * @param heights the heights, in row major order.
+     * @param stride the number of floats between the starts of consecutive
+     *        rows of @p heights, or 0 if the rows are packed.
+     */
+    void SetHeights(int x, int y, int width, int height,
+        const float* heights, int stride = 0);
+
+    /**
+     * Retrieve the height of a texel.
+     */
+    float HeightAt(int x, int y) const { return heights_[y * Width() + x]; }
+
+    /**
+     * Sets the heights that are mapped to the ends of the color map. By
+     * default, the color map spans the range of the heights.
+     */
+    void SetColorRange(float min_height, float max_height);
+
+    /**
+     * Makes the color map span the range of the heights again.
+     */
+    void ResetColorRange();
+
+    /**
+     * Places the grids around the camera, and writes changed heights to the
+     * texture.
+     *
+     * Must be called with the OpenGL context current, typically once per
+     * frame before drawing.
+     */
+    void Update(CameraNode* camera);
+
+    int Width() const { return clipmap_.Width(); }
+
+    int Height() const { return clipmap_.Height(); }
+
+    float Spacing() const { return spacing_; }
+
+    /**
+     * Retrieve the lowest of the heights that have been set, or 0 if none
+     * have.
+     */
+    float MinHeight() const { return min_height_; }
+
+    /**
+     * Retrieve the highest of the heights that have been set, or 0 if none
+     * have.
+     */
+    float MaxHeight() const { return max_height_; }
+
+    /**
+     * Retrieve the group node that the heightfield is drawn under.
+     */
+    GroupNode* Node() { return node_; }
+
+    /**
+     * Retrieve the layout of the grids, as of the last call to Update().
+     */
+    const HeightfieldClipmap& Clipmap() const { return clipmap_; }
+
+  private:
+    struct Rect {
+      int x;
+      int y;
+      int width;
+      int height;
+    };
+
+    // The drawables of a level, one for each placement of the hole.
+    struct LevelData {
+      MaterialResource::Ptr material;
+      DrawNode* draw_node;
+      std::vector<HeightfieldRingDrawable*> drawables;
+    };
+
+    Heightfield(Viewport* viewport, GroupNode* parent, int width, int height,
+        float spacing, int grid_size);
+
+    void InitializeGL();
+
+    void UploadHeights();
+
+    void UpdateColorRange();
+
+    void RecomputeHeightRange();
+
+    ResourceManager::Ptr resources_;
+    Scene::Ptr scene_;
+    GroupNode* node_;
+
+    float spacing_;
+    HeightfieldClipmap clipmap_;
+    std::vector<float> heights_;
+
+    // Which heights have been set, and their range.
+    std::vector<bool> height_set_;
+    bool any_height_set_;
+    float min_height_;
+    float max_height_;
+    bool auto_color_range_;
+    float color_min_;
+    float color_max_;
+
+    // Rectangles of texels that changed since the last upload.
+    std::vector<Rect> dirty_;
+
+    std::shared_ptr<QOpenGLTexture> texture_;
+    std::vector<GeometryResource::Ptr> geometries_;
+    std::vector<LevelData> levels_;
+};
+
+}  // namespace sv
+
+#endif  // SCENEVIEW_HEIGHTFIELD_HPP__
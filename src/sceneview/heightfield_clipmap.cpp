@@ -0,0 +1,76 @@
+// Copyright [2015] Albert Huang
+
+#include "sceneview/heightfield_clipmap.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace sv {
+
+HeightfieldClipmap::HeightfieldClipmap(int width, int height,
+    int grid_size) :
+  width_(width),
+  height_(height),
+  grid_size_(grid_size) {
+  if (width <= 0 || height <= 0 || grid_size < 8 || grid_size % 4) {
+    throw std::invalid_argument("Invalid heightfield clipmap size");
+  }
+
+  // A level centered anywhere on the heightfield must reach its far edge.
+  const int64_t extent = 2 * static_cast<int64_t>(std::max(width, height));
+  int num_levels = 1;
+  while ((static_cast<int64_t>(grid_size) << (num_levels - 1)) < extent) {
+    ++num_levels;
+  }
+  levels_.resize(num_levels);
+  Update(0, 0);
+}
+
+void HeightfieldClipmap::Update(double x, double y) {
+  x = std::min(std::max(x, 0.0), static_cast<double>(width_));
+  y = std::min(std::max(y, 0.0), static_cast<double>(height_));
+  for (int level_ind = 0; level_ind < NumLevels(); ++level_ind) {
+    Level& level = levels_[level_ind];
+    level.scale = 1 << level_ind;
+    const double snap = 2.0 * level.scale;
+    level.center_x = static_cast<int>(std::floor(x / snap + 0.5) * snap);
+    level.center_y = static_cast<int>(std::floor(y / snap + 0.5) * snap);
+    if (level_ind == 0) {
+      level.hole_x = 0;
+      level.hole_y = 0;
+    } else {
+      const Level& finer = levels_[level_ind - 1];
+      level.hole_x = (finer.center_x - level.center_x) / level.scale;
+      level.hole_y = (finer.center_y - level.center_y) / level.scale;
+    }
+  }
+}
+
+std::vector<uint32_t> HeightfieldClipmap::MakeIndices(int grid_size,
+    bool hole, int hole_x, int hole_y) {
+  const int hole_x_begin = grid_size / 4 + hole_x;
+  const int hole_y_begin = grid_size / 4 + hole_y;
+  const int hole_size = grid_size / 2;
+  const int row = grid_size + 1;
+
+  std::vector<uint32_t> indices;
+  indices.reserve(6 * grid_size * grid_size);
+  for (int cell_y = 0; cell_y < grid_size; ++cell_y) {
+    for (int cell_x = 0; cell_x < grid_size; ++cell_x) {
+      if (hole &&
+          cell_x >= hole_x_begin && cell_x < hole_x_begin + hole_size &&
+          cell_y >= hole_y_begin && cell_y < hole_y_begin + hole_size) {
+        continue;
+      }
+      const uint32_t v00 = cell_y * row + cell_x;
+      const uint32_t v10 = v00 + 1;
+      const uint32_t v01 = v00 + row;
+      const uint32_t v11 = v01 + 1;
+      indices.insert(indices.end(), { v00, v10, v11, v00, v11, v01 });
+    }
+  }
+  return indices;
+}
+
+}  // namespace sv
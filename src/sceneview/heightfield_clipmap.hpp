@@ -0,0 +1,121 @@
+// Copyright [2015] Albert Huang
+
+#ifndef SCENEVIEW_HEIGHTFIELD_CLIPMAP_HPP__
+#define SCENEVIEW_HEIGHTFIELD_CLIPMAP_HPP__
+
+#include <cstdint>
+#include <vector>
+
+namespace sv {
+
+/**
+ * Layout of the nested grids used to draw a heightfield at a level of detail
+ * that decreases with the distance from the camera.
+ *
+ * Every level is a grid of grid_size x grid_size cells. Cells of level L are
+ * 2^L heightfield texels wide, so that each level covers twice the extent of
+ * the previous one. Level 0 is a full grid centered near the camera. Each
+ * coarser level is a ring: the full grid minus a hole of grid_size / 2 cells
+ * that is filled by the next finer level.
+ *
+ * Level L is centered on a multiple of 2^(L + 1) texels. This keeps the
+ * vertices of each level on the grid of the next coarser level, so that
+ * levels meet without gaps once the odd vertices on the outer edge of each
+ * level are moved onto the coarser edge. Since the centers of two adjacent
+ * levels are snapped differently, the hole of a ring is offset by up to one
+ * cell from the middle of the ring, in each direction.
+ *
+ * The clipmap only computes the layout, and never touches graphics memory.
+ *
+ * @ingroup sv_resources
+ * @headerfile sceneview/heightfield_clipmap.hpp
+ */
+class HeightfieldClipmap {
+  public:
+    /**
+     * Placement of a level.
+     */
+    struct Level {
+      /**
+       * Center of the level, in texels.
+       */
+      int center_x;
+      int center_y;
+
+      /**
+       * Width of a cell of the level, in texels.
+       */
+      int scale;
+
+      /**
+       * Offset of the hole from the middle of the level, in cells of the
+       * level. Each is -1, 0 or 1. Both are 0 for level 0, which doesn't have
+       * a hole.
+       */
+      int hole_x;
+      int hole_y;
+    };
+
+    /**
+     * Constructor.
+     *
+     * @param width the width of the heightfield, in texels.
+     * @param height the height of the heightfield, in texels.
+     * @param grid_size the number of cells along each side of a level. Must
+     *        be a multiple of 4, and at least 8.
+     *
+     * @throw std::invalid_argument if a size is invalid.
+     */
+    HeightfieldClipmap(int width, int height, int grid_size);
+
+    int Width() const { return width_; }
+
+    int Height() const { return height_; }
+
+    int GridSize() const { return grid_size_; }
+
+    /**
+     * Retrieve the number of levels. There are just enough levels for the
+     * coarsest one to cover the whole heightfield from anywhere on it.
+     */
+    int NumLevels() const { return levels_.size(); }
+
+    /**
+     * Places the levels around a point.
+     *
+     * @param x the x coordinate of the point, in texels. Clamped to the
+     *        heightfield.
+     * @param y the y coordinate of the point, in texels. Clamped to the
+     *        heightfield.
+     */
+    void Update(double x, double y);
+
+    /**
+     * Retrieve the placement of a level, as of the last call to Update().
+     */
+    const Level& GetLevel(int level) const { return levels_[level]; }
+
+    /**
+     * Computes the triangle indices of a level.
+     *
+     * The vertices of a level are the (grid_size + 1)^2 grid points in row
+     * major order, starting at the lowest x and y.
+     *
+     * @param grid_size the number of cells along each side of the level.
+     * @param hole whether to leave out the hole.
+     * @param hole_x the offset of the hole along x, in cells.
+     * @param hole_y the offset of the hole along y, in cells.
+     */
+    static std::vector<uint32_t> MakeIndices(int grid_size, bool hole,
+        int hole_x = 0, int hole_y = 0);
+
+  private:
+    int width_;
+    int height_;
+    int grid_size_;
+    std::vector<Level> levels_;
+};
+
+}  // namespace sv
+
+#endif  // SCENEVIEW_HEIGHTFIELD_CLIPMAP_HPP__
@@ -0,0 +1,78 @@
+// Copyright [2015] Albert Huang
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstdlib>
+#include <set>
+#include <stdexcept>
+#include <vector>
+
+#include "sceneview/heightfield_clipmap.hpp"
+
+using sv::HeightfieldClipmap;
+
+TEST(HeightfieldClipmap, Levels) {
+  HeightfieldClipmap small(50, 20, 64);
+  EXPECT_EQ(2, small.NumLevels());
+
+  HeightfieldClipmap large(1000, 300, 64);
+  EXPECT_EQ(6, large.NumLevels());
+  EXPECT_EQ(32, large.GetLevel(5).scale);
+
+  EXPECT_THROW(HeightfieldClipmap(100, 100, 30), std::invalid_argument);
+  EXPECT_THROW(HeightfieldClipmap(0, 100, 64), std::invalid_argument);
+}
+
+TEST(HeightfieldClipmap, Placement) {
+  const int grid_size = 16;
+  HeightfieldClipmap clipmap(1024, 1024, grid_size);
+  for (double x = 0; x < 100; x += 3.7) {
+    clipmap.Update(x, 1000 - x);
+    for (int level_ind = 0; level_ind < clipmap.NumLevels(); ++level_ind) {
+      const HeightfieldClipmap::Level& level = clipmap.GetLevel(level_ind);
+      EXPECT_EQ(0, level.center_x % (2 * level.scale));
+      EXPECT_EQ(0, level.center_y % (2 * level.scale));
+      EXPECT_LE(std::abs(level.hole_x), 1);
+      EXPECT_LE(std::abs(level.hole_y), 1);
+      if (level_ind == 0) {
+        continue;
+      }
+
+      // The hole is exactly covered by the next finer level.
+      const HeightfieldClipmap::Level& finer =
+        clipmap.GetLevel(level_ind - 1);
+      const int hole_min_x = level.center_x +
+        (level.hole_x - grid_size / 4) * level.scale;
+      const int hole_min_y = level.center_y +
+        (level.hole_y - grid_size / 4) * level.scale;
+      EXPECT_EQ(finer.center_x - grid_size / 2 * finer.scale, hole_min_x);
+      EXPECT_EQ(finer.center_y - grid_size / 2 * finer.scale, hole_min_y);
+    }
+  }
+
+  // Points off the heightfield are clamped to it.
+  clipmap.Update(-500, 5000);
+  EXPECT_EQ(0, clipmap.GetLevel(0).center_x);
+  EXPECT_EQ(1024, clipmap.GetLevel(0).center_y);
+}
+
+TEST(HeightfieldClipmap, Indices) {
+  const std::vector<uint32_t> full = HeightfieldClipmap::MakeIndices(8, false);
+  EXPECT_EQ(6u * 64, full.size());
+  for (uint32_t index : full) {
+    EXPECT_LT(index, 81u);
+  }
+
+  const std::vector<uint32_t> ring =
+    HeightfieldClipmap::MakeIndices(8, true, 1, -1);
+  EXPECT_EQ(6u * (64 - 16), ring.size());
+
+  // The hole spans cells 3 to 6 along x and 1 to 4 along y, so the vertices
+  // strictly inside it are unused.
+  std::set<uint32_t> used(ring.begin(), ring.end());
+  EXPECT_FALSE(used.count(2 * 9 + 4));
+  EXPECT_TRUE(used.count(1 * 9 + 3));
+  EXPECT_TRUE(used.count(5 * 9 + 7));
+  EXPECT_TRUE(used.count(2 * 9 + 2));
+}
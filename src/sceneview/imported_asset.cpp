@@ -0,0 +1,167 @@
+// Copyright [2015] Albert Huang
+
+#include "sceneview/internal_gl.hpp"
+
+#include "sceneview/imported_asset.hpp"
+
+#include <QElapsedTimer>
+#include <QOpenGLTexture>
+
+#include "sceneview/draw_node.hpp"
+#include "sceneview/group_node.hpp"
+#include "sceneview/stock_resources.hpp"
+
+#if 0
+#define dbg(fmt, ...) printf(fmt, __VA_ARGS__)
+#else
+#define dbg(...)
+#endif
+
+namespace sv {
+
+// Meshes with at least this many triangles get levels of detail.
+static const size_t kMinTrianglesForLods = 10000;
+
+ImportedAssetBuilder::ImportedAssetBuilder(
+    const ResourceManager::Ptr& resources,
+    const Scene::Ptr& scene, GroupNode* root,
+    const ImportedAsset::Ptr& asset) :
+  resources_(resources),
+  scene_(scene),
+  root_(root),
+  asset_(asset),
+  num_materials_built_(0),
+  num_meshes_built_(0) {}
+
+bool ImportedAssetBuilder::Build(double time_budget) {
+  QElapsedTimer timer;
+  timer.start();
+  if (groups_.empty()) {
+    BuildNodes();
+  }
+  while (!Done()) {
+    if (num_materials_built_ < asset_->materials.size()) {
+      BuildMaterial(num_materials_built_++);
+    } else {
+      BuildMesh(num_meshes_built_++);
+    }
+    if (time_budget >= 0 && timer.nsecsElapsed() > time_budget * 1e6) {
+      break;
+    }
+  }
+  return Done();
+}
+
+bool ImportedAssetBuilder::Done() const {
+  return !groups_.empty() &&
+    num_materials_built_ == asset_->materials.size() &&
+    num_meshes_built_ == asset_->meshes.size();
+}
+
+void ImportedAssetBuilder::BuildNodes() {
+  mesh_nodes_.resize(asset_->meshes.size());
+  for (size_t node_ind = 0; node_ind < asset_->nodes.size(); ++node_ind) {
+    const ImportedNode& node = asset_->nodes[node_ind];
+    GroupNode* group;
+    if (node.parent < 0) {
+      group = root_;
+    } else {
+      group = scene_->MakeGroup(groups_[node.parent]);
+    }
+    group->SetTranslation(node.translation);
+    group->SetRotation(node.rotation);
+    group->SetScale(node.scale);
+    groups_.push_back(group);
+
+    for (int mesh_ind : node.meshes) {
+      mesh_nodes_[mesh_ind].push_back(node_ind);
+    }
+  }
+
+  // An asset without nodes still gets built, but has nothing to draw.
+  if (groups_.empty()) {
+    groups_.push_back(root_);
+  }
+  dbg("Built %d nodes\n", static_cast<int>(groups_.size()));
+}
+
+void ImportedAssetBuilder::BuildMaterial(int material_ind) {
+  const ImportedMaterial& imported = asset_->materials[material_ind];
+
+  // The appropriate shader to load depends on whether the material has a
+  // texture or not.
+  StockResources stock(resources_);
+  MaterialResource::Ptr material;
+  if (!imported.diffuse_texture.isNull()) {
+    material = resources_->MakeMaterial(
+        stock.Shader(StockResources::kTextureUniformColorLighting));
+
+    std::shared_ptr<QOpenGLTexture> texture(
+        new QOpenGLTexture(imported.diffuse_texture));
+    texture->setMinificationFilter(QOpenGLTexture::LinearMipMapLinear);
+    texture->setMagnificationFilter(QOpenGLTexture::Linear);
+    material->AddTexture("diffuse_tex_0", texture);
+  } else {
+    material = stock.NewMaterial(StockResources::kUniformColorLighting);
+  }
+
+  material->SetParam("diffuse", imported.diffuse[0], imported.diffuse[1],
+      imported.diffuse[2], imported.diffuse[3]);
+  material->SetParam("specular", imported.specular[0], imported.specular[1],
+      imported.specular[2], imported.specular[3]);
+  material->SetParam("shininess", imported.shininess);
+  material->SetTwoSided(imported.two_sided);
+  materials_.push_back(material);
+}
+
+void ImportedAssetBuilder::BuildMesh(int mesh_ind) {
+  const ImportedMesh& mesh = asset_->meshes[mesh_ind];
+  if (mesh_nodes_[mesh_ind].empty()) {
+    return;
+  }
+
+  GeometryResource::Ptr geom = resources_->MakeGeometry();
+  if (mesh.view.vertices.data) {
+    geom->Load(mesh.view);
+  } else {
+    geom->Load(mesh.data);
+  }
+
+  // Large meshes get simplified levels of detail in the background.
+  if (mesh.view.vertices.data) {
+    const GeometryDataView& view = mesh.view;
+    if (view.gl_mode == GL_TRIANGLES &&
+        view.num_indices / 3 >= static_cast<int>(kMinTrianglesForLods)) {
+      GeometryData lod_data;
+      lod_data.gl_mode = GL_TRIANGLES;
+      const int stride = view.vertices.stride ?
+        view.vertices.stride : 3 * sizeof(float);
+      const char* vertex = reinterpret_cast<const char*>(view.vertices.data);
+      lod_data.vertices.reserve(view.vertices.count);
+      for (int ind = 0; ind < view.vertices.count; ++ind) {
+        const float* xyz = reinterpret_cast<const float*>(vertex);
+        lod_data.vertices.emplace_back(xyz[0], xyz[1], xyz[2]);
+        vertex += stride;
+      }
+      lod_data.indices.assign(view.indices,
+          view.indices + view.num_indices);
+      geom->GenerateLods(lod_data);
+    }
+  } else if (mesh.data.gl_mode == GL_TRIANGLES &&
+      mesh.data.indices.size() / 3 >= kMinTrianglesForLods) {
+    geom->GenerateLods(mesh.data);
+  }
+
+  // Instances share the drawable. Its level of detail hysteresis is then
+  // shared too, which only delays switching levels.
+  const Drawable::Ptr drawable =
+    Drawable::Create(geom, materials_[mesh.material]);
+  for (int node_ind : mesh_nodes_[mesh_ind]) {
+    const ImportedNode& node = asset_->nodes[node_ind];
+    DrawNode* draw_node = scene_->MakeDrawNode(groups_[node_ind], node.name);
+    draw_node->Add(drawable);
+  }
+  dbg("Built mesh %d (%d vertices)\n", mesh_ind, geom->NumVertices());
+}
+
+}  // namespace sv
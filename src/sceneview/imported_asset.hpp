@@ -0,0 +1,197 @@
+// Copyright [2015] Albert Huang
+
+#ifndef SCENEVIEW_IMPORTED_ASSET_HPP__
+#define SCENEVIEW_IMPORTED_ASSET_HPP__
+
+#include <memory>
+#include <vector>
+
+#include <QImage>
+#include <QQuaternion>
+#include <QString>
+#include <QVector3D>
+
+#include <sceneview/geometry_resource.hpp>
+#include <sceneview/material_resource.hpp>
+#include <sceneview/resource_manager.hpp>
+#include <sceneview/scene.hpp>
+
+namespace sv {
+
+class GroupNode;
+
+/**
+ * Material of an imported asset, before it is turned into a
+ * MaterialResource.
+ *
+ * @ingroup sv_resources
+ * @headerfile sceneview/imported_asset.hpp
+ */
+struct ImportedMaterial {
+  ImportedMaterial() :
+    diffuse { 0, 0, 0, 1 },
+    specular { 0, 0, 0, 1 },
+    shininess(0),
+    two_sided(false) {}
+
+  /// RGBA diffuse color.
+  float diffuse[4];
+
+  /// RGBA specular color.
+  float specular[4];
+
+  float shininess;
+
+  bool two_sided;
+
+  /// Diffuse texture. A null image if the material isn't textured.
+  QImage diffuse_texture;
+};
+
+/**
+ * Mesh of an imported asset, before it is uploaded to graphics memory.
+ *
+ * @ingroup sv_resources
+ * @headerfile sceneview/imported_asset.hpp
+ */
+struct ImportedMesh {
+  GeometryData data;
+
+  /**
+   * If view has vertices, the mesh is loaded from the memory that it
+   * refers to instead of from data, e.g., from the buffers of a
+   * memory-mapped file. storage keeps that memory alive.
+   */
+  GeometryDataView view;
+
+  std::shared_ptr<const void> storage;
+
+  /// Index into ImportedAsset::materials.
+  int material;
+};
+
+/**
+ * Node of an imported asset's scene graph.
+ *
+ * @ingroup sv_resources
+ * @headerfile sceneview/imported_asset.hpp
+ */
+struct ImportedNode {
+  ImportedNode() : parent(-1), scale(1, 1, 1) {}
+
+  /// Index into ImportedAsset::nodes, or -1 for the root node.
+  int parent;
+
+  QString name;
+
+  QVector3D translation;
+
+  QQuaternion rotation;
+
+  QVector3D scale;
+
+  /// Indices into ImportedAsset::meshes of the meshes drawn by this node.
+  std::vector<int> meshes;
+};
+
+/**
+ * An asset read from file, held in system memory.
+ *
+ * Reading an asset doesn't need an OpenGL context, so it can be done on a
+ * worker thread with AssetImporter::ReadFile(). The asset is then turned
+ * into scene graph nodes and resources with ImportedAssetBuilder.
+ *
+ * @ingroup sv_resources
+ * @headerfile sceneview/imported_asset.hpp
+ */
+struct ImportedAsset {
+  typedef std::shared_ptr<ImportedAsset> Ptr;
+
+  std::vector<ImportedMaterial> materials;
+
+  std::vector<ImportedMesh> meshes;
+
+  /// The first node is the root node. Parents come before their children.
+  std::vector<ImportedNode> nodes;
+};
+
+/**
+ * Builds scene graph nodes and resources from an ImportedAsset, a few
+ * meshes at a time.
+ *
+ * Uploading a large asset to graphics memory can take much longer than a
+ * frame. The builder splits the work into steps, one per mesh or texture,
+ * so that it can be spread over several frames with a time budget per call
+ * to Build(). Meshes are drawn as soon as they are uploaded. Nodes that
+ * draw the same mesh share its Drawable.
+ *
+ * @code
+ * ImportedAssetBuilder builder(resources, scene, group, asset);
+ *
+ * // Once per frame, with the OpenGL context current:
+ * if (!builder.Done()) {
+ *   builder.Build(4);
+ * }
+ * @endcode
+ *
+ * @ingroup sv_resources
+ * @headerfile sceneview/imported_asset.hpp
+ */
+class ImportedAssetBuilder {
+  public:
+    /**
+     * Constructor.
+     *
+     * @param resources used to create materials and geometries.
+     * @param scene the scene to add nodes to.
+     * @param root receives the transform of the asset's root node. The
+     *        other nodes of the asset are created below it.
+     * @param asset the asset to build. Must not be modified until Done().
+     */
+    ImportedAssetBuilder(const ResourceManager::Ptr& resources,
+        const Scene::Ptr& scene, GroupNode* root,
+        const ImportedAsset::Ptr& asset);
+
+    /**
+     * Builds until done, or until the time budget runs out. At least one
+     * step is done per call.
+     *
+     * Must be called with the OpenGL context current.
+     *
+     * @param time_budget maximum time to spend, in milliseconds. If
+     *        negative, the whole asset is built.
+     *
+     * @return true if the asset is completely built.
+     */
+    bool Build(double time_budget);
+
+    /**
+     * Returns true if the asset is completely built.
+     */
+    bool Done() const;
+
+  private:
+    void BuildNodes();
+
+    void BuildMaterial(int material_ind);
+
+    void BuildMesh(int mesh_ind);
+
+    ResourceManager::Ptr resources_;
+    Scene::Ptr scene_;
+    GroupNode* root_;
+    ImportedAsset::Ptr asset_;
+
+    std::vector<GroupNode*> groups_;
+    std::vector<MaterialResource::Ptr> materials_;
+
+    // For each mesh, the nodes that draw it.
+    std::vector<std::vector<int>> mesh_nodes_;
+
+    size_t num_materials_built_;
+    size_t num_meshes_built_;
+};
+
+}  // namespace sv
+
+#endif  // SCENEVIEW_IMPORTED_ASSET_HPP__
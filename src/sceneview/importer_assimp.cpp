@@ -14,12 +14,9 @@
 #include <QFileInfo>
 #include <QDir>
 #include <QImage>
-#include <QOpenGLTexture>
 #include <QRegularExpression>
 
-#include "sceneview/group_node.hpp"
-#include "sceneview/draw_node.hpp"
-#include "sceneview/stock_resources.hpp"
+#include "sceneview/mesh_optimizer.hpp"
 
 //#define DBG
 #ifdef DBG
@@ -68,7 +65,7 @@ struct AssimpMaterial {
 
   float index_of_refraction;
 
-  std::vector<std::shared_ptr<QOpenGLTexture>> tex_diffuse;
+  std::vector<QImage> tex_diffuse;
   // TODO(albert) add texture fields
 };
 
@@ -104,33 +101,11 @@ void AssimpMaterial::Print() const {
   printf("  index of refraction: %f\n", index_of_refraction);
 }
 
-// ### Texture shader
-ShaderResource::Ptr TextureShader(const ResourceManager::Ptr& resources) {
-  const QString shader_name = "sv_stock_shader:assimp_textured";
-
-  ShaderResource::Ptr shader = resources->GetShader(shader_name);
-  if (shader) {
-    return shader;
-  }
-
-  shader = resources->MakeShader(shader_name);
-  shader->LoadFromFiles(":sceneview/stock_shaders/lighting",
-      "#define COLOR_UNIFORM\n"
-      "#define USE_TEXTURE0\n");
-
-  if (!shader) {
-    shader.reset();
-  }
-  return shader;
-}
-
 // ### Importer
 
 class Importer {
   public:
-    explicit Importer(ResourceManager::Ptr resources);
-
-    Scene::Ptr ImportFile(const QString& fname, const QString& scene_name);
+    bool ReadFile(const QString& fname, ImportedAsset* asset);
 
   private:
     AssimpMaterial LoadMaterial(const aiMaterial& mat);
@@ -140,21 +115,12 @@ class Importer {
         const int tex_ind,
         AssimpMaterial* mat);
 
-    ResourceManager::Ptr resources_;
     QString fname_;
 
     const struct aiScene* ai_scene_;
-    std::vector<MaterialResource::Ptr> materials_;
-    std::vector<GeometryResource::Ptr> geometries_;
-    std::map<GeometryResource::Ptr, MaterialResource::Ptr>
-      geometry_materials_;
 };
 
-Importer::Importer(ResourceManager::Ptr resources) : resources_(resources) {
-}
-
-Scene::Ptr Importer::ImportFile(const QString& fname,
-    const QString& scene_name) {
+bool Importer::ReadFile(const QString& fname, ImportedAsset* asset) {
   Assimp::Importer importer;
   ai_scene_ = importer.ReadFile(fname.toStdString(),
       aiProcess_Triangulate |
@@ -169,15 +135,11 @@ Scene::Ptr Importer::ImportFile(const QString& fname,
       aiProcess_OptimizeGraph);
 
   if (!ai_scene_) {
-    return nullptr;
+    return false;
   }
 
   fname_ = fname;
 
-  Scene::Ptr model = resources_->MakeScene(scene_name);
-
-  StockResources stock(resources_);
-
   // Add materials
   for (size_t mat_index = 0; mat_index < ai_scene_->mNumMaterials;
       ++mat_index) {
@@ -189,41 +151,27 @@ Scene::Ptr Importer::ImportFile(const QString& fname,
     am_mat.Print();
 #endif
 
-    MaterialResource::Ptr material;
+    ImportedMaterial material;
+    for (int i = 0; i < 3; ++i) {
+      material.diffuse[i] = am_mat.diffuse[i];
+      material.specular[i] = am_mat.specular[i];
+    }
+    material.diffuse[3] = am_mat.opacity;
+    material.specular[3] = am_mat.opacity;
+    material.shininess = am_mat.shininess * am_mat.shininess_strength;
+    material.two_sided = am_mat.two_sided;
 
-    // The appropriate shader to load depends on whether the material has a
-    // texture or not.
+    // TODO(albert) allow more than one texture
+    // TODO(albert) allow more than diffuse textures.
     if (!am_mat.tex_diffuse.empty()) {
-      ShaderResource::Ptr shader = TextureShader(resources_);
-      material = resources_->MakeMaterial(shader);
-
-      material->AddTexture("diffuse_tex_0", am_mat.tex_diffuse.front());
-      // TODO(albert) allow more than one texture
-      // TODO(albert) allow more than diffuse textures.
-    } else {
-      material = stock.NewMaterial(StockResources::kUniformColorLighting);
+      material.diffuse_texture = am_mat.tex_diffuse.front();
     }
 
-    material->SetParam("diffuse",
-        am_mat.diffuse[0],
-        am_mat.diffuse[1],
-        am_mat.diffuse[2],
-        am_mat.opacity);
-    material->SetParam("specular",
-        am_mat.specular[0],
-        am_mat.specular[1],
-        am_mat.specular[2],
-        am_mat.opacity);
-//    material->SetParam("ambient", am_mat.ambient);
-    material->SetParam("shininess",
-        am_mat.shininess * am_mat.shininess_strength);
-
-    material->SetTwoSided(am_mat.two_sided);
-
-    materials_.push_back(material);
+    asset->materials.push_back(material);
   }
 
   // Add meshes
+  std::vector<int> mesh_mapping(ai_scene_->mNumMeshes, -1);
   for (size_t mesh_index = 0; mesh_index < ai_scene_->mNumMeshes;
       ++mesh_index) {
     const aiMesh* mesh = ai_scene_->mMeshes[mesh_index];
@@ -237,8 +185,13 @@ Scene::Ptr Importer::ImportFile(const QString& fname,
       continue;
     }
 
+    asset->meshes.emplace_back();
+    ImportedMesh& imported = asset->meshes.back();
+    imported.material = mesh->mMaterialIndex;
+    mesh_mapping[mesh_index] = asset->meshes.size() - 1;
+
     // Add vertices and normal vectors
-    GeometryData gdata;
+    GeometryData& gdata = imported.data;
     gdata.gl_mode = GL_TRIANGLES;
     for (size_t vert_ind = 0; vert_ind < mesh->mNumVertices; ++vert_ind) {
       const aiVector3D& ai_vertex = mesh->mVertices[vert_ind];
@@ -247,8 +200,6 @@ Scene::Ptr Importer::ImportFile(const QString& fname,
       gdata.normals.emplace_back(ai_normal.x, ai_normal.y, ai_normal.z);
     }
 
-    const MaterialResource::Ptr& material = materials_[mesh->mMaterialIndex];
-
     // Load texture coordinates
     const int tex_set = 0;
     std::vector<QVector2D>& tex_coords = gdata.tex_coords_0;
@@ -269,19 +220,17 @@ Scene::Ptr Importer::ImportFile(const QString& fname,
       gdata.indices.push_back(ai_face.mIndices[2]);
     }
 
-    GeometryResource::Ptr geom = resources_->MakeGeometry();
-    geom->Load(gdata);
-    geometries_.push_back(geom);
-    geometry_materials_[geometries_.back()] = material;
+    // Reorder triangles and vertices for faster rendering.
+    OptimizeMesh(&gdata, kMeshOptimizeDefault);
   }
 
-  // Create the graph structure
+  // Create the graph structure. Nodes are visited breadth first, so parents
+  // come before their children.
   std::deque<const aiNode*> nodes_to_process = { ai_scene_->mRootNode };
-  std::map<const aiNode*, GroupNode*> node_mapping = {
-    { ai_scene_->mRootNode, model->Root() }
+  std::map<const aiNode*, int> node_mapping = {
+    { nullptr, -1 }
   };
 
-  std::vector<GroupNode*> groups;
   while (!nodes_to_process.empty()) {
     const aiNode* ai_node = nodes_to_process.front();
     nodes_to_process.pop_front();
@@ -291,26 +240,17 @@ Scene::Ptr Importer::ImportFile(const QString& fname,
       nodes_to_process.push_back(child);
     }
 
-    // create a group node to match this node.
-    const aiNode* ai_parent = ai_node->mParent;
-    GroupNode* parent = node_mapping[ai_parent];
-    GroupNode* group;
-    if (ai_node == ai_scene_->mRootNode) {
-      group = model->Root();
-    } else {
-      group = model->MakeGroup(parent);
-    }
-    groups.push_back(group);
+    ImportedNode node;
+    node.parent = ai_node == ai_scene_->mRootNode ? -1 :
+      node_mapping[ai_node->mParent];
 
-    // attach draw nodes to this group
+    // meshes drawn by this node
     for (size_t mesh_ind = 0; mesh_ind < ai_node->mNumMeshes; ++mesh_ind) {
       const size_t mesh_id = ai_node->mMeshes[mesh_ind];
-      assert(mesh_id < geometries_.size());
-      GeometryResource::Ptr& geom = geometries_[mesh_id];
-      assert(geometry_materials_.find(geom) != geometry_materials_.end());
-      MaterialResource::Ptr& material = geometry_materials_[geom];
-      DrawNode* draw_node = model->MakeDrawNode(group);
-      draw_node->Add(geom, material);
+      assert(mesh_id < mesh_mapping.size());
+      if (mesh_mapping[mesh_id] >= 0) {
+        node.meshes.push_back(mesh_mapping[mesh_id]);
+      }
     }
 
     // The node transform
@@ -319,38 +259,17 @@ Scene::Ptr Importer::ImportFile(const QString& fname,
     aiVector3D ai_scale;
     ai_node->mTransformation.Decompose(ai_scale, ai_quat, ai_pos);
 
-    group->SetTranslation(QVector3D(ai_pos.x, ai_pos.y, ai_pos.z));
-    group->SetScale(QVector3D(ai_scale.x, ai_scale.y, ai_scale.z));
-    group->SetRotation(QQuaternion(ai_quat.w, ai_quat.x, ai_quat.y, ai_quat.z));
-
-    node_mapping[ai_node] = group;
-  }
-
-  dbg("loaded %d nodes", static_cast<int>(groups.size()));
+    node.translation = QVector3D(ai_pos.x, ai_pos.y, ai_pos.z);
+    node.scale = QVector3D(ai_scale.x, ai_scale.y, ai_scale.z);
+    node.rotation = QQuaternion(ai_quat.w, ai_quat.x, ai_quat.y, ai_quat.z);
 
-#if DBG
-  for (size_t i = 0; i < groups.size(); ++i) {
-    dbg("node %d", static_cast<int>(i));
-    GroupNode* group = groups[i];
-    const QVector3D pos = group->Translation();
-    const QQuaternion rot = group->Rotation();
-    const QVector3D scale = group->Scale();
-    dbg("   children: %d", static_cast<int>(group->Children().size()));
-    dbg("   pos   %.3f, %.3f, %.3f", pos.x(), pos.y(), pos.z());
-    dbg("   quat  %.3f, %.3f, %.3f, %.3f",
-        rot.x(), rot.y(), rot.z(), rot.scalar());
-    dbg("   scale %.3f, %.3f, %.3f", scale.x(), scale.y(), scale.z());
-    AxisAlignedBox box = group->WorldBoundingBox();
-    dbg("    bounding box: %s", box.ToString().toStdString().c_str());
+    node_mapping[ai_node] = asset->nodes.size();
+    asset->nodes.push_back(node);
   }
 
-  GroupNode* group = model->Root();
-  AxisAlignedBox box = group->WorldBoundingBox();
-  dbg("model: %d children", static_cast<int>(group->Children().size()));
-  dbg("    bounding box: %s", box.ToString().toStdString().c_str());
-#endif
+  dbg("loaded %d nodes", static_cast<int>(asset->nodes.size()));
 
-  return model;
+  return true;
 }
 
 void Importer::LoadTexture(const aiMaterial& ai_mat,
@@ -401,13 +320,10 @@ void Importer::LoadTexture(const aiMaterial& ai_mat,
   if (tex_img.isNull()) {
     dbg("  Failed to recognize texture file %s",
         tex_fname.toStdString().c_str());
+    return;
   }
 
-  std::shared_ptr<QOpenGLTexture> texture(new QOpenGLTexture(tex_img));
-  texture->setMinificationFilter(QOpenGLTexture::LinearMipMapLinear);
-  texture->setMagnificationFilter(QOpenGLTexture::Linear);
-
-  mat->tex_diffuse.push_back(texture);
+  mat->tex_diffuse.push_back(tex_img);
 }
 
 AssimpMaterial Importer::LoadMaterial(const aiMaterial& mat) {
@@ -466,9 +382,8 @@ AssimpMaterial Importer::LoadMaterial(const aiMaterial& mat) {
 
 }  // namespace
 
-Scene::Ptr ImportAssimpFile(ResourceManager::Ptr resources,
-    const QString& fname, const QString& scene_name) {
-  return Importer(resources).ImportFile(fname, scene_name);
+bool ReadAssimpFile(const QString& fname, ImportedAsset* asset) {
+  return Importer().ReadFile(fname, asset);
 }
 
 }  // namespace sv
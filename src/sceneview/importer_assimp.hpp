@@ -3,20 +3,23 @@
 #ifndef SCENEVIEW_ASSIMP_IMPORTER_HPP__
 #define SCENEVIEW_ASSIMP_IMPORTER_HPP__
 
-#include <sceneview/scene.hpp>
-#include <sceneview/resource_manager.hpp>
+#include <QString>
+
+#include <sceneview/imported_asset.hpp>
 
 namespace sv {
 
 /**
- * Imports assets from a file.
+ * Reads assets from a file into system memory.
+ *
+ * Doesn't use OpenGL, and can be called from any thread.
  *
  * @param fname file name. This can also be a Qt resource specifier (e.g.,
  * ":/assets/model.obj")
+ *
+ * @return false if the file couldn't be read.
  */
-Scene::Ptr ImportAssimpFile(ResourceManager::Ptr resources,
-    const QString& fname,
-    const QString& scene_name = ResourceManager::kAutoName);
+bool ReadAssimpFile(const QString& fname, ImportedAsset* asset);
 
 }  // namespace sv
 
@@ -0,0 +1,808 @@
+// Copyright [2015] Albert Huang
+
+#include "sceneview/internal_gl.hpp"
+
+#include "sceneview/importer_gltf.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <QByteArray>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QImage>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMatrix3x3>
+
+#include "sceneview/thread_pool.hpp"
+
+#if 0
+#define dbg(fmt, ...) printf(fmt, __VA_ARGS__)
+#else
+#define dbg(...)
+#endif
+
+namespace sv {
+
+namespace {
+
+const uint32_t kGlbMagic = 0x46546C67;
+const uint32_t kGlbVersion = 2;
+const uint32_t kGlbJsonChunk = 0x4E4F534A;
+const uint32_t kGlbBinChunk = 0x004E4942;
+
+struct Bytes {
+  Bytes() : data(nullptr), size(0) {}
+  Bytes(const char* data, size_t size) : data(data), size(size) {}
+
+  const char* data;
+  size_t size;
+};
+
+// Memory that the meshes of an asset refer to. Shared by the meshes via
+// ImportedMesh::storage.
+struct GltfStorage {
+  ~GltfStorage() {
+    for (size_t file_ind = 0; file_ind < files.size(); ++file_ind) {
+      files[file_ind]->unmap(mapped[file_ind]);
+    }
+  }
+
+  // Memory-mapped files.
+  std::vector<std::unique_ptr<QFile>> files;
+  std::vector<uchar*> mapped;
+
+  // Files that couldn't be mapped, and buffers from data URIs.
+  std::deque<QByteArray> bytes;
+
+  // Converted attributes and indices.
+  std::deque<std::vector<float>> floats;
+  std::deque<std::vector<uint32_t>> indices;
+};
+
+// Values of a glTF accessor.
+struct Accessor {
+  const char* data;
+  int count;
+  GLenum component_type;
+  int num_components;
+  int stride;
+  bool normalized;
+};
+
+bool MapFile(const QString& fname, GltfStorage* storage, Bytes* bytes) {
+  std::unique_ptr<QFile> file(new QFile(fname));
+  if (!file->open(QIODevice::ReadOnly)) {
+    return false;
+  }
+  const qint64 size = file->size();
+  uchar* mapped = size > 0 ? file->map(0, size) : nullptr;
+  if (mapped) {
+    *bytes = Bytes(reinterpret_cast<const char*>(mapped), size);
+    storage->files.push_back(std::move(file));
+    storage->mapped.push_back(mapped);
+  } else {
+    storage->bytes.push_back(file->readAll());
+    *bytes = Bytes(storage->bytes.back().constData(),
+        storage->bytes.back().size());
+  }
+  return true;
+}
+
+int ComponentSize(GLenum type) {
+  switch (type) {
+    case GL_BYTE:
+    case GL_UNSIGNED_BYTE:
+      return 1;
+    case GL_SHORT:
+    case GL_UNSIGNED_SHORT:
+      return 2;
+    case GL_UNSIGNED_INT:
+    case GL_FLOAT:
+      return 4;
+  }
+  throw std::runtime_error("Invalid glTF component type " +
+      std::to_string(type));
+}
+
+int NumComponents(const QString& type) {
+  if (type == "SCALAR") {
+    return 1;
+  } else if (type == "VEC2") {
+    return 2;
+  } else if (type == "VEC3") {
+    return 3;
+  } else if (type == "VEC4" || type == "MAT2") {
+    return 4;
+  } else if (type == "MAT3") {
+    return 9;
+  } else if (type == "MAT4") {
+    return 16;
+  }
+  throw std::runtime_error("Invalid glTF accessor type " +
+      type.toStdString());
+}
+
+template <typename T>
+T Load(const char* src) {
+  T value;
+  std::memcpy(&value, src, sizeof(T));
+  return value;
+}
+
+float ReadComponent(const char* src, GLenum type, bool normalized) {
+  switch (type) {
+    case GL_BYTE:
+      return normalized ? std::max(Load<int8_t>(src) / 127.0f, -1.0f) :
+        Load<int8_t>(src);
+    case GL_UNSIGNED_BYTE:
+      return normalized ? Load<uint8_t>(src) / 255.0f : Load<uint8_t>(src);
+    case GL_SHORT:
+      return normalized ? std::max(Load<int16_t>(src) / 32767.0f, -1.0f) :
+        Load<int16_t>(src);
+    case GL_UNSIGNED_SHORT:
+      return normalized ? Load<uint16_t>(src) / 65535.0f :
+        Load<uint16_t>(src);
+    case GL_UNSIGNED_INT:
+      return Load<uint32_t>(src);
+    default:
+      return Load<float>(src);
+  }
+}
+
+// Retrieve an element of a top level array, e.g., a node or an accessor.
+QJsonObject Element(const QJsonObject& root, const char* array, int ind) {
+  const QJsonArray elements = root.value(array).toArray();
+  if (ind < 0 || ind >= elements.size()) {
+    throw std::runtime_error("Invalid glTF " + std::string(array) +
+        " index " + std::to_string(ind));
+  }
+  return elements.at(ind).toObject();
+}
+
+void SetTransform(const QJsonObject& node, ImportedNode* imported) {
+  const QJsonArray matrix = node.value("matrix").toArray();
+  if (matrix.size() == 16) {
+    // The matrix is column major. It is decomposed into translation,
+    // rotation and scale, assuming that it has no shear.
+    float values[16];
+    for (int ind = 0; ind < 16; ++ind) {
+      values[ind] = matrix.at(ind).toDouble();
+    }
+    QVector3D axes[3];
+    float scale[3];
+    for (int col = 0; col < 3; ++col) {
+      axes[col] = QVector3D(values[4 * col], values[4 * col + 1],
+          values[4 * col + 2]);
+      scale[col] = axes[col].length();
+    }
+    if (QVector3D::dotProduct(QVector3D::crossProduct(axes[0], axes[1]),
+          axes[2]) < 0) {
+      scale[0] = -scale[0];
+    }
+    QMatrix3x3 rotation;
+    for (int col = 0; col < 3; ++col) {
+      for (int row = 0; row < 3; ++row) {
+        rotation(row, col) = scale[col] ? values[4 * col + row] / scale[col] :
+          (row == col);
+      }
+    }
+    imported->translation = QVector3D(values[12], values[13], values[14]);
+    imported->rotation = QQuaternion::fromRotationMatrix(rotation);
+    imported->scale = QVector3D(scale[0], scale[1], scale[2]);
+    return;
+  }
+
+  const QJsonArray translation = node.value("translation").toArray();
+  if (translation.size() == 3) {
+    imported->translation = QVector3D(translation.at(0).toDouble(),
+        translation.at(1).toDouble(), translation.at(2).toDouble());
+  }
+  // glTF quaternions are x, y, z, w.
+  const QJsonArray rotation = node.value("rotation").toArray();
+  if (rotation.size() == 4) {
+    imported->rotation = QQuaternion(rotation.at(3).toDouble(),
+        rotation.at(0).toDouble(), rotation.at(1).toDouble(),
+        rotation.at(2).toDouble());
+  }
+  const QJsonArray scale = node.value("scale").toArray();
+  if (scale.size() == 3) {
+    imported->scale = QVector3D(scale.at(0).toDouble(),
+        scale.at(1).toDouble(), scale.at(2).toDouble());
+  }
+}
+
+class GltfReader {
+  public:
+    GltfReader(const QString& fname, ImportedAsset* asset);
+
+    bool Read();
+
+  private:
+    void ParseGlb(const Bytes& file, QByteArray* json);
+
+    void LoadBuffers();
+
+    void LoadMaterials();
+
+    void DecodeImages(const std::vector<int>& material_images);
+
+    void LoadMeshes();
+
+    void LoadNodes();
+
+    int DefaultMaterial();
+
+    Accessor GetAccessor(int accessor_ind);
+
+    StridedSpan FloatSpan(int accessor_ind, int num_components, float fill);
+
+    void LoadIndices(int accessor_ind, GeometryDataView* view);
+
+    StridedSpan ComputeNormals(const GeometryDataView& view);
+
+    QString FilePath(const QString& uri) const;
+
+    QString fname_;
+    ImportedAsset* asset_;
+    std::shared_ptr<GltfStorage> storage_;
+    QJsonObject root_;
+
+    // The binary chunk of a .glb file, and the contents of each buffer.
+    Bytes glb_bin_;
+    std::vector<Bytes> buffers_;
+
+    // Indices into ImportedAsset::meshes of the primitives of each mesh.
+    std::vector<std::vector<int>> mesh_primitives_;
+
+    int default_material_;
+    int num_converted_;
+};
+
+GltfReader::GltfReader(const QString& fname, ImportedAsset* asset) :
+  fname_(fname),
+  asset_(asset),
+  storage_(std::make_shared<GltfStorage>()),
+  default_material_(-1),
+  num_converted_(0) {}
+
+bool GltfReader::Read() {
+  const QString suffix = QFileInfo(fname_).suffix().toLower();
+  if (suffix != "gltf" && suffix != "glb") {
+    return false;
+  }
+  Bytes file;
+  if (!MapFile(fname_, storage_.get(), &file)) {
+    qDebug("Error opening file %s\n", fname_.toStdString().c_str());
+    return false;
+  }
+
+  QByteArray json;
+  if (suffix == "glb") {
+    ParseGlb(file, &json);
+  } else {
+    json = QByteArray::fromRawData(file.data, file.size);
+  }
+  QJsonParseError error;
+  const QJsonDocument document = QJsonDocument::fromJson(json, &error);
+  if (error.error != QJsonParseError::NoError || !document.isObject()) {
+    throw std::runtime_error(fname_.toStdString() + ": " +
+        error.errorString().toStdString());
+  }
+  root_ = document.object();
+
+  const QJsonArray required = root_.value("extensionsRequired").toArray();
+  if (!required.isEmpty()) {
+    throw GltfUnsupportedError(fname_.toStdString() +
+        ": unsupported glTF extension " +
+        required.at(0).toString().toStdString());
+  }
+
+  LoadBuffers();
+  LoadMaterials();
+  LoadMeshes();
+  LoadNodes();
+  dbg("Read %d meshes, converted %d accessors\n",
+      static_cast<int>(asset_->meshes.size()), num_converted_);
+  return true;
+}
+
+void GltfReader::ParseGlb(const Bytes& file, QByteArray* json) {
+  uint32_t header[3];
+  if (file.size < sizeof(header)) {
+    throw std::runtime_error(fname_.toStdString() + " is truncated");
+  }
+  std::memcpy(header, file.data, sizeof(header));
+  if (header[0] != kGlbMagic || header[1] != kGlbVersion) {
+    throw std::runtime_error(fname_.toStdString() +
+        " is not a glTF 2.0 binary file");
+  }
+
+  const size_t length = std::min<size_t>(header[2], file.size);
+  size_t pos = sizeof(header);
+  while (pos + 8 <= length) {
+    uint32_t chunk[2];
+    std::memcpy(chunk, file.data + pos, sizeof(chunk));
+    pos += sizeof(chunk);
+    if (chunk[0] > length - pos) {
+      throw std::runtime_error(fname_.toStdString() + " is truncated");
+    }
+    if (chunk[1] == kGlbJsonChunk && json->isEmpty()) {
+      *json = QByteArray::fromRawData(file.data + pos, chunk[0]);
+    } else if (chunk[1] == kGlbBinChunk && !glb_bin_.data) {
+      glb_bin_ = Bytes(file.data + pos, chunk[0]);
+    }
+    pos += chunk[0];
+  }
+  if (json->isEmpty()) {
+    throw std::runtime_error(fname_.toStdString() + " has no JSON chunk");
+  }
+}
+
+QString GltfReader::FilePath(const QString& uri) const {
+  return QFileInfo(fname_).dir().absolutePath() + "/" +
+    QString::fromUtf8(QByteArray::fromPercentEncoding(uri.toUtf8()));
+}
+
+void GltfReader::LoadBuffers() {
+  const QJsonArray buffers = root_.value("buffers").toArray();
+  for (int buffer_ind = 0; buffer_ind < buffers.size(); ++buffer_ind) {
+    const QJsonObject buffer = buffers.at(buffer_ind).toObject();
+    const size_t length = buffer.value("byteLength").toDouble();
+    Bytes bytes;
+    if (!buffer.contains("uri")) {
+      // Only the first buffer of a .glb file can be its binary chunk.
+      if (buffer_ind != 0 || !glb_bin_.data) {
+        throw std::runtime_error("glTF buffer " +
+            std::to_string(buffer_ind) + " has no data");
+      }
+      bytes = glb_bin_;
+    } else {
+      const QString uri = buffer.value("uri").toString();
+      if (uri.startsWith("data:")) {
+        const int comma = uri.indexOf(',');
+        if (comma < 0 || !uri.left(comma).endsWith(";base64")) {
+          throw std::runtime_error("Unsupported glTF data URI");
+        }
+        storage_->bytes.push_back(
+            QByteArray::fromBase64(uri.mid(comma + 1).toLatin1()));
+        bytes = Bytes(storage_->bytes.back().constData(),
+            storage_->bytes.back().size());
+      } else if (!MapFile(FilePath(uri), storage_.get(), &bytes)) {
+        throw std::runtime_error("Unable to open " +
+            FilePath(uri).toStdString());
+      }
+    }
+    if (bytes.size < length) {
+      throw std::runtime_error("glTF buffer " + std::to_string(buffer_ind) +
+          " is truncated");
+    }
+    buffers_.push_back(bytes);
+  }
+}
+
+void GltfReader::LoadMaterials() {
+  const QJsonArray materials = root_.value("materials").toArray();
+  std::vector<int> material_images;
+  for (int material_ind = 0; material_ind < materials.size();
+      ++material_ind) {
+    const QJsonObject material = materials.at(material_ind).toObject();
+    const QJsonObject pbr =
+      material.value("pbrMetallicRoughness").toObject();
+    ImportedMaterial imported;
+    const QJsonArray factor = pbr.value("baseColorFactor").toArray();
+    for (int comp = 0; comp < 4; ++comp) {
+      imported.diffuse[comp] =
+        factor.size() == 4 ? factor.at(comp).toDouble() : 1;
+    }
+    imported.two_sided = material.value("doubleSided").toBool();
+    asset_->materials.push_back(imported);
+
+    int image_ind = -1;
+    const QJsonObject base_texture = pbr.value("baseColorTexture").toObject();
+    if (base_texture.contains("index")) {
+      const QJsonObject texture = Element(root_, "textures",
+          base_texture.value("index").toInt());
+      image_ind = texture.value("source").toInt(-1);
+    }
+    material_images.push_back(image_ind);
+  }
+  DecodeImages(material_images);
+}
+
+void GltfReader::DecodeImages(const std::vector<int>& material_images) {
+  std::vector<int> images;
+  for (int image_ind : material_images) {
+    if (image_ind >= 0) {
+      images.push_back(image_ind);
+    }
+  }
+  std::sort(images.begin(), images.end());
+  images.erase(std::unique(images.begin(), images.end()), images.end());
+
+  // Find the encoded images here, and decode them in parallel.
+  std::vector<Bytes> sources(images.size());
+  std::vector<QString> paths(images.size());
+  for (size_t ind = 0; ind < images.size(); ++ind) {
+    const QJsonObject image = Element(root_, "images", images[ind]);
+    if (image.contains("bufferView")) {
+      const QJsonObject view = Element(root_, "bufferViews",
+          image.value("bufferView").toInt());
+      const int buffer_ind = view.value("buffer").toInt();
+      const size_t offset = view.value("byteOffset").toDouble();
+      const size_t length = view.value("byteLength").toDouble();
+      if (buffer_ind < 0 || buffer_ind >= static_cast<int>(buffers_.size()) ||
+          offset + length > buffers_[buffer_ind].size) {
+        throw std::runtime_error("glTF image " + std::to_string(images[ind]) +
+            " is out of bounds");
+      }
+      sources[ind] = Bytes(buffers_[buffer_ind].data + offset, length);
+    } else {
+      const QString uri = image.value("uri").toString();
+      if (uri.startsWith("data:")) {
+        const int comma = uri.indexOf(',');
+        storage_->bytes.push_back(
+            QByteArray::fromBase64(uri.mid(comma + 1).toLatin1()));
+        sources[ind] = Bytes(storage_->bytes.back().constData(),
+            storage_->bytes.back().size());
+      } else {
+        paths[ind] = FilePath(uri);
+      }
+    }
+  }
+
+  std::vector<QImage> decoded(images.size());
+  ThreadPool::Default()->ParallelFor(images.size(), [&](int ind) {
+    if (sources[ind].data) {
+      decoded[ind].loadFromData(
+          reinterpret_cast<const uchar*>(sources[ind].data),
+          sources[ind].size);
+    } else {
+      decoded[ind] = QImage(paths[ind]);
+    }
+  });
+
+  for (size_t material_ind = 0; material_ind < material_images.size();
+      ++material_ind) {
+    const int image_ind = material_images[material_ind];
+    if (image_ind < 0) {
+      continue;
+    }
+    const size_t ind = std::lower_bound(images.begin(), images.end(),
+        image_ind) - images.begin();
+    if (decoded[ind].isNull()) {
+      dbg("Failed to decode image %d\n", image_ind);
+      continue;
+    }
+    // glTF texture coordinates start at the top left of the image, which
+    // is the first row that QOpenGLTexture uploads.
+    asset_->materials[material_ind].diffuse_texture = decoded[ind];
+  }
+}
+
+int GltfReader::DefaultMaterial() {
+  if (default_material_ < 0) {
+    ImportedMaterial material;
+    std::fill(material.diffuse, material.diffuse + 4, 1.0f);
+    default_material_ = asset_->materials.size();
+    asset_->materials.push_back(material);
+  }
+  return default_material_;
+}
+
+Accessor GltfReader::GetAccessor(int accessor_ind) {
+  const QJsonObject accessor = Element(root_, "accessors", accessor_ind);
+  if (accessor.contains("sparse") || !accessor.contains("bufferView")) {
+    throw GltfUnsupportedError(fname_.toStdString() +
+        ": sparse glTF accessors are not supported");
+  }
+  Accessor result;
+  result.count = accessor.value("count").toInt();
+  result.component_type = accessor.value("componentType").toInt();
+  result.num_components = NumComponents(accessor.value("type").toString());
+  result.normalized = accessor.value("normalized").toBool();
+  const int element_size =
+    ComponentSize(result.component_type) * result.num_components;
+
+  const QJsonObject view = Element(root_, "bufferViews",
+      accessor.value("bufferView").toInt());
+  const int buffer_ind = view.value("buffer").toInt();
+  const size_t view_offset = view.value("byteOffset").toDouble();
+  const size_t view_length = view.value("byteLength").toDouble();
+  const size_t offset = accessor.value("byteOffset").toDouble();
+  result.stride = view.value("byteStride").toInt(element_size);
+  const size_t size = result.count <= 0 ? 0 : offset +
+    static_cast<size_t>(result.stride) * (result.count - 1) + element_size;
+  if (buffer_ind < 0 || buffer_ind >= static_cast<int>(buffers_.size()) ||
+      view_offset + view_length > buffers_[buffer_ind].size ||
+      size > view_length || result.count < 0 ||
+      result.stride < element_size) {
+    throw std::runtime_error("glTF accessor " +
+        std::to_string(accessor_ind) + " is out of bounds");
+  }
+  result.data = buffers_[buffer_ind].data + view_offset + offset;
+  return result;
+}
+
+static void CheckIndices(const uint32_t* indices, int num_indices,
+    int num_vertices) {
+  for (int ind = 0; ind < num_indices; ++ind) {
+    if (indices[ind] >= static_cast<uint32_t>(num_vertices)) {
+      throw std::runtime_error("glTF index is out of bounds");
+    }
+  }
+}
+
+StridedSpan GltfReader::FloatSpan(int accessor_ind, int num_components,
+    float fill) {
+  const Accessor accessor = GetAccessor(accessor_ind);
+  if (accessor.component_type == GL_FLOAT &&
+      accessor.num_components == num_components &&
+      reinterpret_cast<uintptr_t>(accessor.data) % sizeof(float) == 0 &&
+      accessor.stride % sizeof(float) == 0) {
+    return StridedSpan(reinterpret_cast<const float*>(accessor.data),
+        accessor.count, accessor.stride);
+  }
+
+  // Convert other layouts to tightly packed floats. Missing components are
+  // set to fill.
+  storage_->floats.emplace_back(
+      static_cast<size_t>(accessor.count) * num_components);
+  std::vector<float>& values = storage_->floats.back();
+  const int component_size = ComponentSize(accessor.component_type);
+  for (int ind = 0; ind < accessor.count; ++ind) {
+    const char* element =
+      accessor.data + static_cast<size_t>(ind) * accessor.stride;
+    for (int comp = 0; comp < num_components; ++comp) {
+      values[ind * num_components + comp] = comp < accessor.num_components ?
+        ReadComponent(element + comp * component_size,
+            accessor.component_type, accessor.normalized) : fill;
+    }
+  }
+  ++num_converted_;
+  return StridedSpan(values.data(), accessor.count);
+}
+
+void GltfReader::LoadIndices(int accessor_ind, GeometryDataView* view) {
+  const Accessor accessor = GetAccessor(accessor_ind);
+  if (accessor.num_components != 1) {
+    throw std::runtime_error("glTF indices must be scalars");
+  }
+  view->num_indices = accessor.count;
+  if (accessor.component_type == GL_UNSIGNED_INT &&
+      accessor.stride == sizeof(uint32_t) &&
+      reinterpret_cast<uintptr_t>(accessor.data) % sizeof(uint32_t) == 0) {
+    // The indices are uploaded straight from the file, so check them.
+    const uint32_t* indices = reinterpret_cast<const uint32_t*>(accessor.data);
+    CheckIndices(indices, accessor.count, view->vertices.count);
+    view->indices = indices;
+    return;
+  }
+
+  storage_->indices.emplace_back(accessor.count);
+  std::vector<uint32_t>& indices = storage_->indices.back();
+  for (int ind = 0; ind < accessor.count; ++ind) {
+    const char* element =
+      accessor.data + static_cast<size_t>(ind) * accessor.stride;
+    switch (accessor.component_type) {
+      case GL_UNSIGNED_BYTE:
+        indices[ind] = Load<uint8_t>(element);
+        break;
+      case GL_UNSIGNED_SHORT:
+        indices[ind] = Load<uint16_t>(element);
+        break;
+      case GL_UNSIGNED_INT:
+        indices[ind] = Load<uint32_t>(element);
+        break;
+      default:
+        throw std::runtime_error("Invalid glTF index type");
+    }
+  }
+  CheckIndices(indices.data(), accessor.count, view->vertices.count);
+  ++num_converted_;
+  view->indices = indices.data();
+}
+
+StridedSpan GltfReader::ComputeNormals(const GeometryDataView& view) {
+  const int num_vertices = view.vertices.count;
+  const int stride = view.vertices.stride ?
+    view.vertices.stride : 3 * sizeof(float);
+  const char* vertices = reinterpret_cast<const char*>(view.vertices.data);
+  auto vertex = [&](uint32_t ind) {
+    const float* xyz = reinterpret_cast<const float*>(vertices +
+        static_cast<size_t>(ind) * stride);
+    return QVector3D(xyz[0], xyz[1], xyz[2]);
+  };
+
+  // Area weighted sum of the normals of the triangles around each vertex.
+  storage_->floats.emplace_back(3 * num_vertices, 0.0f);
+  std::vector<float>& normals = storage_->floats.back();
+  const int num_corners = view.indices ? view.num_indices : num_vertices;
+  for (int corner = 0; corner + 2 < num_corners; corner += 3) {
+    uint32_t triangle[3];
+    for (int ind = 0; ind < 3; ++ind) {
+      triangle[ind] = view.indices ? view.indices[corner + ind] :
+        corner + ind;
+      if (triangle[ind] >= static_cast<uint32_t>(num_vertices)) {
+        throw std::runtime_error("glTF index is out of bounds");
+      }
+    }
+    const QVector3D v0 = vertex(triangle[0]);
+    const QVector3D normal = QVector3D::crossProduct(
+        vertex(triangle[1]) - v0, vertex(triangle[2]) - v0);
+    for (uint32_t vertex_ind : triangle) {
+      normals[3 * vertex_ind] += normal.x();
+      normals[3 * vertex_ind + 1] += normal.y();
+      normals[3 * vertex_ind + 2] += normal.z();
+    }
+  }
+  for (int vertex_ind = 0; vertex_ind < num_vertices; ++vertex_ind) {
+    float* normal = &normals[3 * vertex_ind];
+    const QVector3D unit =
+      QVector3D(normal[0], normal[1], normal[2]).normalized();
+    normal[0] = unit.x();
+    normal[1] = unit.y();
+    normal[2] = unit.z();
+  }
+  return StridedSpan(normals.data(), num_vertices);
+}
+
+void GltfReader::LoadMeshes() {
+  const QJsonArray meshes = root_.value("meshes").toArray();
+  const int num_materials = asset_->materials.size();
+  for (int mesh_ind = 0; mesh_ind < meshes.size(); ++mesh_ind) {
+    const QJsonArray primitives =
+      meshes.at(mesh_ind).toObject().value("primitives").toArray();
+    mesh_primitives_.emplace_back();
+    for (int prim_ind = 0; prim_ind < primitives.size(); ++prim_ind) {
+      const QJsonObject primitive = primitives.at(prim_ind).toObject();
+      const QJsonObject attributes = primitive.value("attributes").toObject();
+      if (!attributes.contains("POSITION")) {
+        continue;
+      }
+
+      // glTF primitive modes have the values of the OpenGL primitive types.
+      ImportedMesh imported;
+      GeometryDataView& view = imported.view;
+      view.gl_mode = primitive.value("mode").toInt(GL_TRIANGLES);
+      if (view.gl_mode > GL_TRIANGLE_FAN) {
+        throw std::runtime_error("Invalid glTF primitive mode");
+      }
+      view.vertices = FloatSpan(attributes.value("POSITION").toInt(), 3, 0);
+      if (view.vertices.count == 0) {
+        continue;
+      }
+      if (attributes.contains("NORMAL")) {
+        view.normals = FloatSpan(attributes.value("NORMAL").toInt(), 3, 0);
+      }
+      if (attributes.contains("COLOR_0")) {
+        view.diffuse = FloatSpan(attributes.value("COLOR_0").toInt(), 4, 1);
+      }
+      if (attributes.contains("TEXCOORD_0")) {
+        view.tex_coords_0 =
+          FloatSpan(attributes.value("TEXCOORD_0").toInt(), 2, 0);
+      }
+      for (const StridedSpan* span :
+          { &view.normals, &view.diffuse, &view.tex_coords_0 }) {
+        if (span->data && span->count != view.vertices.count) {
+          throw std::runtime_error("glTF attributes of mesh " +
+              std::to_string(mesh_ind) + " have different counts");
+        }
+      }
+      if (primitive.contains("indices")) {
+        LoadIndices(primitive.value("indices").toInt(), &view);
+      }
+      if (!view.normals.data && view.gl_mode == GL_TRIANGLES) {
+        view.normals = ComputeNormals(view);
+      }
+
+      if (primitive.contains("material")) {
+        imported.material = primitive.value("material").toInt();
+        if (imported.material < 0 || imported.material >= num_materials) {
+          throw std::runtime_error("Invalid glTF material index");
+        }
+      } else {
+        imported.material = DefaultMaterial();
+      }
+      imported.storage = storage_;
+      mesh_primitives_.back().push_back(asset_->meshes.size());
+      asset_->meshes.push_back(imported);
+    }
+  }
+}
+
+void GltfReader::LoadNodes() {
+  const QJsonArray nodes = root_.value("nodes").toArray();
+
+  // The root nodes of the default scene, or without scenes, all the nodes
+  // that aren't children.
+  std::vector<int> roots;
+  if (!root_.value("scenes").toArray().isEmpty()) {
+    const QJsonObject scene = Element(root_, "scenes",
+        root_.value("scene").toInt(0));
+    const QJsonArray scene_nodes = scene.value("nodes").toArray();
+    for (int ind = 0; ind < scene_nodes.size(); ++ind) {
+      roots.push_back(scene_nodes.at(ind).toInt());
+    }
+  } else {
+    std::vector<bool> is_child(nodes.size(), false);
+    for (int node_ind = 0; node_ind < nodes.size(); ++node_ind) {
+      const QJsonArray children =
+        nodes.at(node_ind).toObject().value("children").toArray();
+      for (int ind = 0; ind < children.size(); ++ind) {
+        const int child = children.at(ind).toInt();
+        if (child >= 0 && child < nodes.size()) {
+          is_child[child] = true;
+        }
+      }
+    }
+    for (int node_ind = 0; node_ind < nodes.size(); ++node_ind) {
+      if (!is_child[node_ind]) {
+        roots.push_back(node_ind);
+      }
+    }
+  }
+
+  // Nodes are visited breadth first, so parents come before their
+  // children. The glTF root nodes are children of the asset's root node.
+  asset_->nodes.push_back(ImportedNode());
+  std::deque<std::pair<int, int>> to_visit;
+  for (int node_ind : roots) {
+    to_visit.emplace_back(node_ind, 0);
+  }
+  std::vector<bool> visited(nodes.size(), false);
+  while (!to_visit.empty()) {
+    const int node_ind = to_visit.front().first;
+    const int parent = to_visit.front().second;
+    to_visit.pop_front();
+    if (node_ind < 0 || node_ind >= nodes.size()) {
+      throw std::runtime_error("Invalid glTF node index " +
+          std::to_string(node_ind));
+    }
+    if (visited[node_ind]) {
+      dbg("Skipping node %d, which has several parents\n", node_ind);
+      continue;
+    }
+    visited[node_ind] = true;
+
+    const QJsonObject node = nodes.at(node_ind).toObject();
+    ImportedNode imported;
+    imported.parent = parent;
+    imported.name = node.value("name").toString();
+    SetTransform(node, &imported);
+    if (node.contains("mesh")) {
+      const int mesh_ind = node.value("mesh").toInt();
+      if (mesh_ind < 0 ||
+          mesh_ind >= static_cast<int>(mesh_primitives_.size())) {
+        throw std::runtime_error("Invalid glTF mesh index " +
+            std::to_string(mesh_ind));
+      }
+      imported.meshes = mesh_primitives_[mesh_ind];
+    }
+
+    const int imported_ind = asset_->nodes.size();
+    asset_->nodes.push_back(imported);
+    const QJsonArray children = node.value("children").toArray();
+    for (int ind = 0; ind < children.size(); ++ind) {
+      to_visit.emplace_back(children.at(ind).toInt(), imported_ind);
+    }
+  }
+}
+
+}  // namespace
+
+bool ReadGltfFile(const QString& fname, ImportedAsset* asset) {
+  return GltfReader(fname, asset).Read();
+}
+
+}  // namespace sv
@@ -0,0 +1,54 @@
+// Copyright [2015] Albert Huang
+
+#ifndef SCENEVIEW_IMPORTER_GLTF_HPP__
+#define SCENEVIEW_IMPORTER_GLTF_HPP__
+
+#include <stdexcept>
+#include <string>
+
+#include <QString>
+
+#include <sceneview/imported_asset.hpp>
+
+namespace sv {
+
+/**
+ * Thrown by ReadGltfFile() for files that use glTF features it doesn't
+ * support, such as required extensions or sparse accessors.
+ *
+ * @ingroup sv_resources
+ * @headerfile sceneview/importer_gltf.hpp
+ */
+class GltfUnsupportedError : public std::runtime_error {
+  public:
+    explicit GltfUnsupportedError(const std::string& what) :
+      std::runtime_error(what) {}
+};
+
+/**
+ * Reads a model from a glTF 2.0 file (.gltf or .glb) into system memory.
+ *
+ * The file and its external buffers are memory-mapped. Vertex attributes
+ * that are floats with the component count that GeometryResource expects
+ * are referred to in place by ImportedMesh::view, and uploaded from the
+ * mapping without being copied. Other attributes and indices are
+ * converted. Texture images are decoded in parallel on the
+ * ThreadPool::Default() threads.
+ *
+ * Each glTF mesh primitive becomes an ImportedMesh, and all the nodes that
+ * instance a glTF mesh draw the same ImportedMesh objects. Skins, morph
+ * targets, animations, cameras and sparse accessors are not supported.
+ *
+ * Doesn't use OpenGL, and can be called from any thread.
+ *
+ * @return false if the file couldn't be opened, or isn't a .gltf or .glb
+ * file.
+ * @throw GltfUnsupportedError if the file requires an extension, or uses a
+ * sparse accessor.
+ * @throw std::runtime_error if the file can't be parsed.
+ */
+bool ReadGltfFile(const QString& fname, ImportedAsset* asset);
+
+}  // namespace sv
+
+#endif  // SCENEVIEW_IMPORTER_GLTF_HPP__
@@ -7,15 +7,14 @@
 #include <map>
 #include <sstream>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include <QFile>
 #include <QVector3D>
 #include <QVector4D>
 
-#include "sceneview/group_node.hpp"
-#include "sceneview/draw_node.hpp"
-#include "sceneview/stock_resources.hpp"
+#include "sceneview/mesh_optimizer.hpp"
 
 #if 0
 #define dbg(...) printf(__VA_ARGS__)
@@ -139,16 +138,14 @@ class Tokenizer {
 
 class Parser {
   public:
-    Parser(const ResourceManager::Ptr& resources,
-        const QString& scene_name,
-        QIODevice* input) :
-      resources_(resources),
-      scene_(resources->MakeScene(scene_name)),
-      scene_name_(scene_->Name()),
-      stock_(resources_),
+    Parser(QIODevice* input, ImportedAsset* asset) :
+      asset_(asset),
       tokenizer_(input) {}
 
-    Scene::Ptr Parse() {
+    void Parse() {
+      // Each clump is drawn by a child of the root node.
+      asset_->nodes.emplace_back();
+
       GetToken();
 
       EatTokenOrDie("ModelBegin");
@@ -162,30 +159,6 @@ class Parser {
           break;
         }
       }
-
-#if 0
-      const std::vector<SceneNode*>& children = scene_->Root()->Children();
-      for (size_t i = 0; i < children.size(); ++i) {
-        dbg("node %d\n", static_cast<int>(i));
-        DrawNode* shape = dynamic_cast<DrawNode*>(children[i]);
-        const QVector3D pos = shape->Translation();
-        const QQuaternion rot = shape->Rotation();
-        const QVector3D scale = shape->Scale();
-        dbg("   pos   %.3f, %.3f, %.3f\n", pos.x(), pos.y(), pos.z());
-        dbg("   quat  %.3f, %.3f, %.3f, %.3f\n",
-            rot.x(), rot.y(), rot.z(), rot.scalar());
-        dbg("   scale %.3f, %.3f, %.3f\n", scale.x(), scale.y(), scale.z());
-        AxisAlignedBox box = shape->BoundingBox();
-        dbg("    bounding box: %s\n", box.ToString().toStdString().c_str());
-      }
-
-      GroupNode* group = scene_->Root();
-      AxisAlignedBox box = group->BoundingBox();
-      dbg("model: %d children\n", static_cast<int>(group->Children().size()));
-      dbg("    bounding box: %s\n", box.ToString().toStdString().c_str());
-#endif
-
-      return scene_;
     }
 
   private:
@@ -194,7 +167,8 @@ class Parser {
       GetToken();
       const std::string clump_name = cur_tok_.value;
 
-      GeometryData gdata;
+      ImportedMesh mesh;
+      GeometryData& gdata = mesh.data;
       gdata.gl_mode = GL_TRIANGLES;
 
       float color[3] = { 0, 0, 0 };
@@ -312,23 +286,27 @@ class Parser {
         gdata.normals[vertex_ind].normalize();
       }
 
-      GeometryResource::Ptr geom = resources_->MakeGeometry();
-      geom->Load(gdata);
-
-      MaterialResource::Ptr material =
-        stock_.NewMaterial(StockResources::kUniformColorLighting);
-//      material->SetParam("ambient",
-//        color[0] * ambient, color[1] * ambient, color[2] * ambient, opacity);
-      material->SetParam("diffuse",
-        color[0] * diffuse, color[1] * diffuse, color[2] * diffuse, opacity);
-      material->SetParam("specular",
-        color[0] * specular, color[1] * specular, color[2] * specular, opacity);
-      material->SetParam("shininess", 16.0f);
-      material->SetTwoSided(true);
-
-      DrawNode* shape = scene_->MakeDrawNode(scene_->Root(),
-          QString::fromStdString(clump_name));
-      shape->Add(geom, material);
+      // Reorder triangles and vertices for faster rendering.
+      OptimizeMesh(&gdata, kMeshOptimizeDefault);
+
+      ImportedMaterial material;
+      for (int i = 0; i < 3; ++i) {
+        material.diffuse[i] = color[i] * diffuse;
+        material.specular[i] = color[i] * specular;
+      }
+      material.diffuse[3] = opacity;
+      material.specular[3] = opacity;
+      material.shininess = 16.0f;
+      material.two_sided = true;
+      mesh.material = asset_->materials.size();
+      asset_->materials.push_back(material);
+
+      ImportedNode node;
+      node.parent = 0;
+      node.name = QString::fromStdString(clump_name);
+      node.meshes.push_back(asset_->meshes.size());
+      asset_->meshes.push_back(std::move(mesh));
+      asset_->nodes.push_back(node);
     }
 
     int ParseInt() {
@@ -365,10 +343,7 @@ class Parser {
       }
     }
 
-    ResourceManager::Ptr resources_;
-    Scene::Ptr scene_;
-    QString scene_name_;
-    StockResources stock_;
+    ImportedAsset* asset_;
     Tokenizer tokenizer_;
     Token cur_tok_;
     Token next_tok_;
@@ -376,17 +351,17 @@ class Parser {
 
 }  // namespace
 
-Scene::Ptr ImportRwxFile(ResourceManager::Ptr resources,
-        const QString& fname, const QString& resource_name) {
+bool ReadRwxFile(const QString& fname, ImportedAsset* asset) {
   QFile file(fname);
 
   if (!file.open(QIODevice::ReadOnly)) {
     qDebug("Error opening file %s\n", fname.toStdString().c_str());
-    return Scene::Ptr();
+    return false;
   }
 
-  Parser parser(resources, resource_name, &file);
-  return parser.Parse();
+  Parser parser(&file, asset);
+  parser.Parse();
+  return true;
 }
 
 }  // namespace sv
@@ -3,17 +3,21 @@
 #ifndef SCENEVIEW_IMPORTER_RWX_HPP__
 #define SCENEVIEW_IMPORTER_RWX_HPP__
 
-#include <sceneview/scene.hpp>
-#include <sceneview/resource_manager.hpp>
+#include <QString>
+
+#include <sceneview/imported_asset.hpp>
 
 namespace sv {
 
 /**
- * Imports a model from a .rwx file (Renderware)
+ * Reads a model from a .rwx file (Renderware) into system memory.
+ *
+ * Doesn't use OpenGL, and can be called from any thread.
+ *
+ * @return false if the file couldn't be opened.
+ * @throw std::runtime_error if the file can't be parsed.
  */
-Scene::Ptr ImportRwxFile(ResourceManager::Ptr resources,
-        const QString& fname,
-        const QString& resource_name = ResourceManager::kAutoName);
+bool ReadRwxFile(const QString& fname, ImportedAsset* asset);
 
 }  // namespace sv
 
@@ -2,6 +2,10 @@
 
 #include "sceneview/internal_gl.hpp"
 
+#include <vector>
+
+#include <QOpenGLBuffer>
+
 namespace sv {
 
 const char* glErrorString(GLenum error) {
@@ -27,4 +31,36 @@ const char* glErrorString(GLenum error) {
   }
 }
 
+void CopyBufferSubData(QOpenGLBuffer* src, int64_t src_offset,
+    QOpenGLBuffer* dst, int64_t dst_offset, int64_t size) {
+  if (size <= 0) {
+    return;
+  }
+#ifdef GL_COPY_READ_BUFFER
+  glBindBuffer(GL_COPY_READ_BUFFER, src->bufferId());
+  glBindBuffer(GL_COPY_WRITE_BUFFER, dst->bufferId());
+  glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+      src_offset, dst_offset, size);
+  glBindBuffer(GL_COPY_READ_BUFFER, 0);
+  glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+#else
+  std::vector<char> data(size);
+  src->bind();
+  glGetBufferSubData(src->type(), src_offset, size, data.data());
+  dst->bind();
+  BufferSubData(dst, dst_offset, data.data(), size);
+#endif
+}
+
+void BufferData(QOpenGLBuffer* buffer, int64_t size, const void* data) {
+  glBufferData(buffer->type(), static_cast<GLsizeiptr>(size), data,
+      buffer->usagePattern());
+}
+
+void BufferSubData(QOpenGLBuffer* buffer, int64_t offset, const void* data,
+    int64_t size) {
+  glBufferSubData(buffer->type(), static_cast<GLintptr>(offset),
+      static_cast<GLsizeiptr>(size), data);
+}
+
 }  // namespace sv
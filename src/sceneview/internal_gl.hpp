@@ -11,12 +11,42 @@
 #include <GL/glext.h>
 #endif
 
+#include <cstdint>
 #include <string>
 
+class QOpenGLBuffer;
+
 namespace sv {
 
 const char* glErrorString(GLenum error);
 
+/**
+ * Copies a range of bytes from one buffer object to another.
+ *
+ * Uses glCopyBufferSubData() when available so that the data never leaves
+ * graphics memory, and falls back to reading back through system memory
+ * otherwise.
+ */
+void CopyBufferSubData(QOpenGLBuffer* src, int64_t src_offset,
+    QOpenGLBuffer* dst, int64_t dst_offset, int64_t size);
+
+/**
+ * Allocates the storage of a bound buffer object with its usage pattern,
+ * and fills it with @p data if it isn't null.
+ *
+ * Unlike QOpenGLBuffer::allocate(), which takes an int, the size may exceed
+ * 2 GiB.
+ */
+void BufferData(QOpenGLBuffer* buffer, int64_t size,
+    const void* data = nullptr);
+
+/**
+ * Overwrites a range of a bound buffer object. Like BufferData(), the
+ * offset and size may exceed 2 GiB.
+ */
+void BufferSubData(QOpenGLBuffer* buffer, int64_t offset, const void* data,
+    int64_t size);
+
 }
 
 #endif  // INTERNAL_GL_H__
@@ -95,6 +95,15 @@ class MaterialResource {
 
     float PointSize() const { return point_size_; }
 
+    /**
+     * Sets whether the shader sets the size of points with gl_PointSize,
+     * instead of using PointSize(). This also enables point sprites, so
+     * that fragment shaders can read gl_PointCoord.
+     */
+    void SetProgramPointSize(bool value) { program_point_size_ = value; }
+
+    bool ProgramPointSize() const { return program_point_size_; }
+
     void SetLineWidth(float line_width) { line_width_ = line_width; }
 
     float LineWidth() const { return line_width_; }
@@ -145,6 +154,8 @@ class MaterialResource {
 
     float point_size_ = 1;
 
+    bool program_point_size_ = false;
+
     float line_width_ = 1;
 
     bool blend_ = false;
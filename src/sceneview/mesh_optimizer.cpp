@@ -0,0 +1,379 @@
+// Copyright [2015] Albert Huang
+
+#include "sceneview/mesh_optimizer.hpp"
+
+#include <cmath>
+#include <algorithm>
+#include <deque>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+namespace sv {
+
+// Parameters for Forsyth's vertex cache optimization. These are the values
+// suggested in the original article.
+static const int kCacheSize = 32;
+static const float kCacheDecayPower = 1.5f;
+static const float kLastTriScore = 0.75f;
+static const float kValenceBoostScale = 2.0f;
+static const float kValenceBoostPower = 0.5f;
+
+static float VertexScore(int cache_position, int remaining_triangles) {
+  if (remaining_triangles == 0) {
+    // No triangles left to draw with this vertex.
+    return -1.0f;
+  }
+
+  float score = 0;
+  if (cache_position >= 0) {
+    if (cache_position < 3) {
+      // The vertex was used in the last triangle. Give it a fixed score so
+      // that strip-like orderings aren't overly favored.
+      score = kLastTriScore;
+    } else {
+      const float scale = 1.0f / (kCacheSize - 3);
+      score = std::pow(1.0f - (cache_position - 3) * scale,
+          kCacheDecayPower);
+    }
+  }
+
+  // Boost vertices with few remaining triangles, so that they're finished
+  // off instead of being left behind.
+  score += kValenceBoostScale *
+    std::pow(static_cast<float>(remaining_triangles), -kValenceBoostPower);
+  return score;
+}
+
+void OptimizeVertexCache(std::vector<uint32_t>* indices, int num_vertices) {
+  const int num_triangles = indices->size() / 3;
+  if (num_triangles == 0) {
+    return;
+  }
+  for (uint32_t index : *indices) {
+    if (index >= static_cast<uint32_t>(num_vertices)) {
+      throw std::invalid_argument("Vertex index out of range");
+    }
+  }
+
+  // For each vertex, the list of triangles that still need to be drawn. The
+  // first remaining[v] entries in the vertex's range of vertex_triangles are
+  // the triangles that haven't been added yet.
+  std::vector<int> remaining(num_vertices, 0);
+  for (uint32_t index : *indices) {
+    remaining[index]++;
+  }
+  std::vector<int> triangles_start(num_vertices + 1, 0);
+  for (int vert_ind = 0; vert_ind < num_vertices; ++vert_ind) {
+    triangles_start[vert_ind + 1] = triangles_start[vert_ind] +
+      remaining[vert_ind];
+  }
+  std::vector<int> vertex_triangles(indices->size());
+  std::vector<int> fill(triangles_start.begin(), triangles_start.end() - 1);
+  for (int tri_ind = 0; tri_ind < num_triangles; ++tri_ind) {
+    for (int corner = 0; corner < 3; ++corner) {
+      const uint32_t vertex = (*indices)[tri_ind * 3 + corner];
+      vertex_triangles[fill[vertex]++] = tri_ind;
+    }
+  }
+
+  std::vector<int> cache_position(num_vertices, -1);
+  std::vector<float> vertex_score(num_vertices);
+  for (int vert_ind = 0; vert_ind < num_vertices; ++vert_ind) {
+    vertex_score[vert_ind] = VertexScore(-1, remaining[vert_ind]);
+  }
+
+  std::vector<float> triangle_score(num_triangles, 0);
+  std::vector<bool> triangle_added(num_triangles, false);
+  int best_triangle = 0;
+  for (int tri_ind = 0; tri_ind < num_triangles; ++tri_ind) {
+    for (int corner = 0; corner < 3; ++corner) {
+      triangle_score[tri_ind] +=
+        vertex_score[(*indices)[tri_ind * 3 + corner]];
+    }
+    if (triangle_score[tri_ind] > triangle_score[best_triangle]) {
+      best_triangle = tri_ind;
+    }
+  }
+
+  std::vector<uint32_t> result;
+  result.reserve(indices->size());
+  std::vector<uint32_t> cache;
+  std::vector<uint32_t> new_cache;
+  cache.reserve(kCacheSize + 3);
+  new_cache.reserve(kCacheSize + 3);
+  int next_unadded = 0;
+
+  for (int num_added = 0; num_added < num_triangles; ++num_added) {
+    if (best_triangle < 0) {
+      // None of the vertices in the cache have any triangles left. Pick up
+      // where we left off in the original order.
+      while (triangle_added[next_unadded]) {
+        next_unadded++;
+      }
+      best_triangle = next_unadded;
+    }
+
+    const uint32_t* triangle = &(*indices)[best_triangle * 3];
+    triangle_added[best_triangle] = true;
+    result.insert(result.end(), triangle, triangle + 3);
+
+    // Remove the triangle from each of its vertices' remaining triangles.
+    for (int corner = 0; corner < 3; ++corner) {
+      const uint32_t vertex = triangle[corner];
+      int* begin = &vertex_triangles[triangles_start[vertex]];
+      int* end = begin + remaining[vertex];
+      int* found = std::find(begin, end, best_triangle);
+      std::swap(*found, *(end - 1));
+      remaining[vertex]--;
+    }
+
+    // Move the triangle's vertices to the front of the cache.
+    new_cache.assign(triangle, triangle + 3);
+    new_cache.erase(std::unique(new_cache.begin(), new_cache.end()),
+        new_cache.end());
+    for (uint32_t vertex : cache) {
+      if (std::find(triangle, triangle + 3, vertex) == triangle + 3) {
+        new_cache.push_back(vertex);
+      }
+    }
+    for (size_t pos = kCacheSize; pos < new_cache.size(); ++pos) {
+      cache_position[new_cache[pos]] = -1;
+    }
+
+    // Rescore the affected vertices and their remaining triangles.
+    for (size_t pos = 0; pos < new_cache.size(); ++pos) {
+      const uint32_t vertex = new_cache[pos];
+      if (pos < static_cast<size_t>(kCacheSize)) {
+        cache_position[vertex] = pos;
+      }
+      const float score = VertexScore(cache_position[vertex],
+          remaining[vertex]);
+      const float delta = score - vertex_score[vertex];
+      vertex_score[vertex] = score;
+      const int* vert_tris = &vertex_triangles[triangles_start[vertex]];
+      for (int ind = 0; ind < remaining[vertex]; ++ind) {
+        triangle_score[vert_tris[ind]] += delta;
+      }
+    }
+    if (new_cache.size() > static_cast<size_t>(kCacheSize)) {
+      new_cache.resize(kCacheSize);
+    }
+    cache.swap(new_cache);
+
+    // The next triangle is the best scoring triangle that uses a vertex in
+    // the cache.
+    best_triangle = -1;
+    float best_score = -1;
+    for (uint32_t vertex : cache) {
+      const int* vert_tris = &vertex_triangles[triangles_start[vertex]];
+      for (int ind = 0; ind < remaining[vertex]; ++ind) {
+        const int tri_ind = vert_tris[ind];
+        if (triangle_score[tri_ind] > best_score) {
+          best_score = triangle_score[tri_ind];
+          best_triangle = tri_ind;
+        }
+      }
+    }
+  }
+
+  indices->swap(result);
+}
+
+template <typename T>
+static void PermuteVertices(std::vector<T>* values,
+    const std::vector<uint32_t>& remap) {
+  if (values->empty()) {
+    return;
+  }
+  std::vector<T> permuted(values->size());
+  for (size_t ind = 0; ind < values->size(); ++ind) {
+    permuted[remap[ind]] = (*values)[ind];
+  }
+  values->swap(permuted);
+}
+
+void OptimizeVertexFetch(GeometryData* data) {
+  const uint32_t num_vertices = data->vertices.size();
+  const uint32_t kUnassigned = 0xFFFFFFFF;
+  std::vector<uint32_t> remap(num_vertices, kUnassigned);
+
+  uint32_t next_vertex = 0;
+  for (uint32_t& index : data->indices) {
+    if (index == kPrimitiveRestartIndex) {
+      continue;
+    }
+    if (index >= num_vertices) {
+      throw std::invalid_argument("Vertex index out of range");
+    }
+    if (remap[index] == kUnassigned) {
+      remap[index] = next_vertex++;
+    }
+    index = remap[index];
+  }
+  for (uint32_t& new_index : remap) {
+    if (new_index == kUnassigned) {
+      new_index = next_vertex++;
+    }
+  }
+
+  PermuteVertices(&data->vertices, remap);
+  PermuteVertices(&data->normals, remap);
+  PermuteVertices(&data->diffuse, remap);
+  PermuteVertices(&data->specular, remap);
+  PermuteVertices(&data->shininess, remap);
+  PermuteVertices(&data->tex_coords_0, remap);
+  PermuteVertices(&data->timestamps, remap);
+  PermuteVertices(&data->anchors, remap);
+  PermuteVertices(&data->scalars, remap);
+  PermuteVertices(&data->labels, remap);
+}
+
+static uint64_t EdgeKey(uint32_t from, uint32_t to) {
+  return (static_cast<uint64_t>(from) << 32) | to;
+}
+
+std::vector<uint32_t> MakeTriangleStrips(
+    const std::vector<uint32_t>& indices) {
+  const int num_triangles = indices.size() / 3;
+
+  // Map each directed edge to the triangles that contain it, in winding
+  // order.
+  std::unordered_map<uint64_t, std::vector<int>> edge_triangles;
+  for (int tri_ind = 0; tri_ind < num_triangles; ++tri_ind) {
+    const uint32_t* triangle = &indices[tri_ind * 3];
+    for (int corner = 0; corner < 3; ++corner) {
+      edge_triangles[EdgeKey(triangle[corner],
+          triangle[(corner + 1) % 3])].push_back(tri_ind);
+    }
+  }
+
+  std::vector<bool> visited(num_triangles, false);
+
+  // Finds an unvisited triangle containing the directed edge from -> to, and
+  // returns its third vertex.
+  auto find_neighbor = [&](uint32_t from, uint32_t to, int* neighbor,
+      uint32_t* third) {
+    auto iter = edge_triangles.find(EdgeKey(from, to));
+    if (iter == edge_triangles.end()) {
+      return false;
+    }
+    for (int tri_ind : iter->second) {
+      if (visited[tri_ind]) {
+        continue;
+      }
+      const uint32_t* triangle = &indices[tri_ind * 3];
+      for (int corner = 0; corner < 3; ++corner) {
+        if (triangle[corner] == from && triangle[(corner + 1) % 3] == to) {
+          *neighbor = tri_ind;
+          *third = triangle[(corner + 2) % 3];
+          return true;
+        }
+      }
+    }
+    return false;
+  };
+
+  std::vector<uint32_t> result;
+  std::vector<uint32_t> strip;
+  for (int tri_ind = 0; tri_ind < num_triangles; ++tri_ind) {
+    if (visited[tri_ind]) {
+      continue;
+    }
+    visited[tri_ind] = true;
+
+    // Start the strip with whichever rotation of the triangle can be
+    // continued.
+    const uint32_t* triangle = &indices[tri_ind * 3];
+    int rotation = 0;
+    for (int rot = 0; rot < 3; ++rot) {
+      int neighbor;
+      uint32_t third;
+      if (find_neighbor(triangle[(rot + 2) % 3], triangle[(rot + 1) % 3],
+            &neighbor, &third)) {
+        rotation = rot;
+        break;
+      }
+    }
+    strip.clear();
+    for (int corner = 0; corner < 3; ++corner) {
+      strip.push_back(triangle[(rotation + corner) % 3]);
+    }
+
+    // Extend the strip. Odd triangles in a strip have their first two
+    // vertices swapped to keep a consistent winding.
+    while (true) {
+      const size_t num_strip = strip.size();
+      const uint32_t prev = strip[num_strip - 2];
+      const uint32_t last = strip[num_strip - 1];
+      const bool odd = (num_strip - 2) % 2 == 1;
+      int neighbor;
+      uint32_t third;
+      const bool found = odd ?
+        find_neighbor(last, prev, &neighbor, &third) :
+        find_neighbor(prev, last, &neighbor, &third);
+      if (!found) {
+        break;
+      }
+      visited[neighbor] = true;
+      strip.push_back(third);
+    }
+
+    if (!result.empty()) {
+      result.push_back(kPrimitiveRestartIndex);
+    }
+    result.insert(result.end(), strip.begin(), strip.end());
+  }
+  return result;
+}
+
+double AverageCacheMissRatio(const std::vector<uint32_t>& indices,
+    int num_vertices, int cache_size) {
+  const int num_triangles = indices.size() / 3;
+  if (num_triangles == 0) {
+    return 0;
+  }
+  std::vector<bool> in_cache(num_vertices, false);
+  std::deque<uint32_t> fifo;
+  int num_misses = 0;
+  for (uint32_t index : indices) {
+    if (in_cache[index]) {
+      continue;
+    }
+    num_misses++;
+    fifo.push_back(index);
+    in_cache[index] = true;
+    if (static_cast<int>(fifo.size()) > cache_size) {
+      in_cache[fifo.front()] = false;
+      fifo.pop_front();
+    }
+  }
+  return static_cast<double>(num_misses) / num_triangles;
+}
+
+void OptimizeMesh(GeometryData* data, int optimizations) {
+  if (data->gl_mode != GL_TRIANGLES || data->indices.empty()) {
+    return;
+  }
+  if (data->indices.size() % 3) {
+    throw std::invalid_argument("Number of indices must be a multiple of 3");
+  }
+
+  if (optimizations & kMeshOptimizeVertexCache) {
+    OptimizeVertexCache(&data->indices, data->vertices.size());
+  }
+
+  if (optimizations & kMeshOptimizeStrips) {
+    std::vector<uint32_t> strips = MakeTriangleStrips(data->indices);
+    if (strips.size() < data->indices.size()) {
+      data->indices.swap(strips);
+      data->gl_mode = GL_TRIANGLE_STRIP;
+    }
+  }
+
+  if (optimizations & kMeshOptimizeVertexFetch) {
+    OptimizeVertexFetch(data);
+  }
+}
+
+}  // namespace sv
@@ -0,0 +1,115 @@
+// Copyright [2015] Albert Huang
+
+#ifndef SCENEVIEW_MESH_OPTIMIZER_HPP__
+#define SCENEVIEW_MESH_OPTIMIZER_HPP__
+
+#include <cstdint>
+#include <vector>
+
+#include <sceneview/geometry_resource.hpp>
+
+namespace sv {
+
+/**
+ * Optimizations that can be applied with OptimizeMesh().
+ *
+ * Values can be combined with bitwise OR.
+ *
+ * @ingroup sv_resources
+ */
+enum MeshOptimization {
+  /**
+   * Leave the mesh unmodified.
+   */
+  kMeshOptimizeNone = 0,
+
+  /**
+   * Reorder triangles to make better use of the post-transform vertex cache.
+   */
+  kMeshOptimizeVertexCache = 1,
+
+  /**
+   * Reorder vertices to match the order in which they are first referenced,
+   * for better memory locality when fetching vertex data.
+   */
+  kMeshOptimizeVertexFetch = 2,
+
+  /**
+   * Convert triangle lists into triangle strips separated by
+   * kPrimitiveRestartIndex, if that results in fewer indices.
+   */
+  kMeshOptimizeStrips = 4,
+
+  /**
+   * Optimizations that never change how the mesh is drawn.
+   */
+  kMeshOptimizeDefault = kMeshOptimizeVertexCache | kMeshOptimizeVertexFetch
+};
+
+/**
+ * Optimizes indexed triangle geometry for rendering.
+ *
+ * Geometry that isn't an indexed triangle list (GL_TRIANGLES) is left
+ * unmodified.
+ *
+ * @param data the geometry to optimize, in place.
+ * @param optimizations a bitwise OR of MeshOptimization values.
+ *
+ * @ingroup sv_resources
+ * @headerfile sceneview/mesh_optimizer.hpp
+ */
+void OptimizeMesh(GeometryData* data, int optimizations);
+
+/**
+ * Reorders triangles for post-transform vertex cache locality.
+ *
+ * Uses Tom Forsyth's "Linear-Speed Vertex Cache Optimisation" scoring. The
+ * set of triangles and the winding of each triangle are preserved.
+ *
+ * @param indices triangle list indices, reordered in place.
+ * @param num_vertices the number of vertices referenced by the indices.
+ *
+ * @ingroup sv_resources
+ * @headerfile sceneview/mesh_optimizer.hpp
+ */
+void OptimizeVertexCache(std::vector<uint32_t>* indices, int num_vertices);
+
+/**
+ * Reorders vertices in the order that they're first referenced by the
+ * indices, and remaps the indices to match.
+ *
+ * Vertices that aren't referenced by any index are moved to the end.
+ *
+ * @ingroup sv_resources
+ * @headerfile sceneview/mesh_optimizer.hpp
+ */
+void OptimizeVertexFetch(GeometryData* data);
+
+/**
+ * Converts triangle list indices into triangle strips.
+ *
+ * Strips are separated by kPrimitiveRestartIndex. Triangle winding is
+ * preserved.
+ *
+ * @return the strip indices, to be drawn with GL_TRIANGLE_STRIP.
+ *
+ * @ingroup sv_resources
+ * @headerfile sceneview/mesh_optimizer.hpp
+ */
+std::vector<uint32_t> MakeTriangleStrips(const std::vector<uint32_t>& indices);
+
+/**
+ * Computes the average number of vertex shader invocations per triangle
+ * (ACMR) for a FIFO vertex cache of the specified size.
+ *
+ * Lower is better. Useful for evaluating vertex cache optimization.
+ *
+ * @ingroup sv_resources
+ * @headerfile sceneview/mesh_optimizer.hpp
+ */
+double AverageCacheMissRatio(const std::vector<uint32_t>& indices,
+    int num_vertices, int cache_size);
+
+}  // namespace sv
+
+#endif  // SCENEVIEW_MESH_OPTIMIZER_HPP__
@@ -0,0 +1,190 @@
+// Copyright [2015] Albert Huang
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+#include <set>
+#include <tuple>
+#include <vector>
+
+#include "sceneview/mesh_optimizer.hpp"
+
+using sv::GeometryData;
+
+typedef std::tuple<QVector3D, QVector3D, QVector3D> Triangle;
+
+// Build a regular grid of triangles, with triangles in random order.
+static GeometryData MakeShuffledGrid(int size) {
+  GeometryData data;
+  data.gl_mode = GL_TRIANGLES;
+  for (int row = 0; row <= size; ++row) {
+    for (int col = 0; col <= size; ++col) {
+      data.vertices.emplace_back(col, row, 0);
+      data.normals.emplace_back(0, 0, 1);
+    }
+  }
+  std::vector<std::vector<uint32_t>> triangles;
+  for (int row = 0; row < size; ++row) {
+    for (int col = 0; col < size; ++col) {
+      const uint32_t v00 = row * (size + 1) + col;
+      const uint32_t v01 = v00 + 1;
+      const uint32_t v10 = v00 + size + 1;
+      const uint32_t v11 = v10 + 1;
+      triangles.push_back({ v00, v01, v11 });
+      triangles.push_back({ v00, v11, v10 });
+    }
+  }
+  std::mt19937 rng(1);
+  std::shuffle(triangles.begin(), triangles.end(), rng);
+  for (const auto& triangle : triangles) {
+    data.indices.insert(data.indices.end(), triangle.begin(), triangle.end());
+  }
+  return data;
+}
+
+// Rotate a triangle so that comparisons don't depend on which vertex comes
+// first, while still distinguishing winding.
+static Triangle Canonical(const QVector3D& a, const QVector3D& b,
+    const QVector3D& c) {
+  auto less = [](const QVector3D& p, const QVector3D& q) {
+    return std::make_tuple(p.x(), p.y(), p.z()) <
+      std::make_tuple(q.x(), q.y(), q.z());
+  };
+  if (!less(b, a) && !less(c, a)) {
+    return Triangle(a, b, c);
+  } else if (!less(a, b) && !less(c, b)) {
+    return Triangle(b, c, a);
+  }
+  return Triangle(c, a, b);
+}
+
+// Expand the geometry into a sorted list of triangles.
+static std::vector<Triangle> Triangles(const GeometryData& data) {
+  std::vector<Triangle> result;
+  const std::vector<uint32_t>& indices = data.indices;
+  if (data.gl_mode == GL_TRIANGLES) {
+    for (size_t ind = 0; ind + 2 < indices.size(); ind += 3) {
+      result.push_back(Canonical(data.vertices[indices[ind]],
+            data.vertices[indices[ind + 1]],
+            data.vertices[indices[ind + 2]]));
+    }
+  } else {
+    size_t strip_start = 0;
+    for (size_t ind = 0; ind + 2 < indices.size(); ++ind) {
+      if (indices[ind] == sv::kPrimitiveRestartIndex) {
+        strip_start = ind + 1;
+        continue;
+      }
+      if (indices[ind + 1] == sv::kPrimitiveRestartIndex ||
+          indices[ind + 2] == sv::kPrimitiveRestartIndex) {
+        continue;
+      }
+      const QVector3D& a = data.vertices[indices[ind]];
+      const QVector3D& b = data.vertices[indices[ind + 1]];
+      const QVector3D& c = data.vertices[indices[ind + 2]];
+      if ((ind - strip_start) % 2 == 0) {
+        result.push_back(Canonical(a, b, c));
+      } else {
+        result.push_back(Canonical(b, a, c));
+      }
+    }
+  }
+  std::sort(result.begin(), result.end(),
+      [](const Triangle& t0, const Triangle& t1) {
+        auto key = [](const Triangle& t) {
+          return std::make_tuple(
+              std::get<0>(t).x(), std::get<0>(t).y(),
+              std::get<1>(t).x(), std::get<1>(t).y(),
+              std::get<2>(t).x(), std::get<2>(t).y());
+        };
+        return key(t0) < key(t1);
+      });
+  return result;
+}
+
+TEST(MeshOptimizer, VertexCache) {
+  GeometryData data = MakeShuffledGrid(40);
+  const std::vector<Triangle> expected = Triangles(data);
+  const double acmr_before = sv::AverageCacheMissRatio(data.indices,
+      data.vertices.size(), 16);
+
+  sv::OptimizeVertexCache(&data.indices, data.vertices.size());
+
+  EXPECT_EQ(expected, Triangles(data));
+  const double acmr_after = sv::AverageCacheMissRatio(data.indices,
+      data.vertices.size(), 16);
+  EXPECT_LT(acmr_after, acmr_before);
+  EXPECT_LT(acmr_after, 1.0);
+}
+
+TEST(MeshOptimizer, VertexFetch) {
+  GeometryData data = MakeShuffledGrid(10);
+  // Add an unreferenced vertex.
+  data.vertices.emplace_back(-1, -1, -1);
+  data.normals.emplace_back(1, 0, 0);
+  const std::vector<Triangle> expected = Triangles(data);
+
+  sv::OptimizeVertexFetch(&data);
+
+  EXPECT_EQ(expected, Triangles(data));
+
+  // Vertices are referenced in increasing order.
+  uint32_t max_index = 0;
+  for (uint32_t index : data.indices) {
+    EXPECT_LE(index, max_index + 1);
+    max_index = std::max(max_index, index);
+  }
+  EXPECT_EQ(QVector3D(-1, -1, -1), data.vertices.back());
+  EXPECT_EQ(QVector3D(1, 0, 0), data.normals.back());
+}
+
+TEST(MeshOptimizer, VertexFetchAttributes) {
+  // Every per-vertex attribute follows its vertex. Each attribute is
+  // derived from the vertex position so that it can be checked after the
+  // reorder.
+  GeometryData data = MakeShuffledGrid(10);
+  for (const QVector3D& vertex : data.vertices) {
+    const float id = vertex.y() * 100 + vertex.x();
+    data.timestamps.push_back(id + 0.25f);
+    data.anchors.push_back(id);
+    data.scalars.push_back(-id);
+    data.labels.push_back(id * 2);
+  }
+
+  sv::OptimizeMesh(&data, sv::kMeshOptimizeVertexCache |
+      sv::kMeshOptimizeVertexFetch);
+
+  ASSERT_EQ(data.vertices.size(), data.scalars.size());
+  for (size_t ind = 0; ind < data.vertices.size(); ++ind) {
+    const float id = data.vertices[ind].y() * 100 + data.vertices[ind].x();
+    EXPECT_EQ(id + 0.25f, data.timestamps[ind]);
+    EXPECT_EQ(id, data.anchors[ind]);
+    EXPECT_EQ(-id, data.scalars[ind]);
+    EXPECT_EQ(id * 2, data.labels[ind]);
+  }
+}
+
+TEST(MeshOptimizer, Strips) {
+  GeometryData data = MakeShuffledGrid(20);
+  const std::vector<Triangle> expected = Triangles(data);
+
+  sv::OptimizeMesh(&data, sv::kMeshOptimizeVertexCache |
+      sv::kMeshOptimizeStrips);
+
+  EXPECT_EQ(static_cast<GLenum>(GL_TRIANGLE_STRIP), data.gl_mode);
+  EXPECT_EQ(expected, Triangles(data));
+  EXPECT_LT(data.indices.size(), expected.size() * 3);
+}
+
+TEST(MeshOptimizer, IgnoresNonTriangles) {
+  GeometryData data;
+  data.gl_mode = GL_LINES;
+  data.vertices = { QVector3D(0, 0, 0), QVector3D(1, 0, 0) };
+  data.indices = { 1, 0 };
+
+  sv::OptimizeMesh(&data, sv::kMeshOptimizeDefault);
+
+  EXPECT_EQ(1u, data.indices[0]);
+  EXPECT_EQ(QVector3D(0, 0, 0), data.vertices[0]);
+}
@@ -0,0 +1,303 @@
+// Copyright [2015] Albert Huang
+
+#include "sceneview/mesh_simplifier.hpp"
+
+#include <algorithm>
+#include <array>
+#include <map>
+#include <queue>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace sv {
+
+namespace {
+
+// Symmetric 4x4 matrix representing a sum of squared distances to planes.
+struct Quadric {
+  Quadric() {
+    std::fill(q, q + 10, 0.0);
+  }
+
+  // Squared distance to the plane n . x + d = 0, scaled by weight.
+  Quadric(const QVector3D& n, double d, double weight) {
+    const double a = n.x();
+    const double b = n.y();
+    const double c = n.z();
+    q[0] = weight * a * a;
+    q[1] = weight * a * b;
+    q[2] = weight * a * c;
+    q[3] = weight * a * d;
+    q[4] = weight * b * b;
+    q[5] = weight * b * c;
+    q[6] = weight * b * d;
+    q[7] = weight * c * c;
+    q[8] = weight * c * d;
+    q[9] = weight * d * d;
+  }
+
+  Quadric& operator+=(const Quadric& other) {
+    for (int ind = 0; ind < 10; ++ind) {
+      q[ind] += other.q[ind];
+    }
+    return *this;
+  }
+
+  double Error(const QVector3D& p) const {
+    const double x = p.x();
+    const double y = p.y();
+    const double z = p.z();
+    return q[0] * x * x + 2 * q[1] * x * y + 2 * q[2] * x * z +
+      2 * q[3] * x + q[4] * y * y + 2 * q[5] * y * z + 2 * q[6] * y +
+      q[7] * z * z + 2 * q[8] * z + q[9];
+  }
+
+  double q[10];
+};
+
+struct Collapse {
+  double cost;
+  uint32_t from;
+  uint32_t to;
+  int from_version;
+  int to_version;
+
+  bool operator<(const Collapse& other) const {
+    // Reversed, so that std::priority_queue yields the cheapest first.
+    return cost > other.cost;
+  }
+};
+
+class Simplifier {
+  public:
+    Simplifier(const std::vector<QVector3D>& vertices,
+        const std::vector<uint32_t>& indices) :
+      vertices_(vertices),
+      vertex_triangles_(vertices.size()),
+      quadrics_(vertices.size()),
+      locked_(vertices.size(), false),
+      removed_(vertices.size(), false),
+      version_(vertices.size(), 0),
+      num_alive_(0) {
+      const uint32_t num_vertices = vertices.size();
+      std::map<std::pair<uint32_t, uint32_t>, int> edge_counts;
+      for (size_t ind = 0; ind + 2 < indices.size(); ind += 3) {
+        Triangle tri = {{ indices[ind], indices[ind + 1], indices[ind + 2] }};
+        if (tri[0] >= num_vertices || tri[1] >= num_vertices ||
+            tri[2] >= num_vertices) {
+          throw std::invalid_argument("Vertex index out of range");
+        }
+        if (tri[0] == tri[1] || tri[1] == tri[2] || tri[0] == tri[2]) {
+          // Degenerate triangles don't draw anything. Drop them.
+          continue;
+        }
+        const int tri_ind = triangles_.size();
+        triangles_.push_back(tri);
+        alive_.push_back(true);
+        num_alive_++;
+        for (int corner = 0; corner < 3; ++corner) {
+          vertex_triangles_[tri[corner]].push_back(tri_ind);
+          const uint32_t v0 = tri[corner];
+          const uint32_t v1 = tri[(corner + 1) % 3];
+          edge_counts[std::make_pair(std::min(v0, v1), std::max(v0, v1))]++;
+        }
+
+        // Accumulate the plane of the triangle, weighted by area.
+        const QVector3D& p0 = vertices[tri[0]];
+        const QVector3D cross = QVector3D::crossProduct(
+            vertices[tri[1]] - p0, vertices[tri[2]] - p0);
+        const double length = cross.length();
+        if (length > 0) {
+          const QVector3D normal = cross / length;
+          const Quadric quadric(normal, -QVector3D::dotProduct(normal, p0),
+              length / 2);
+          for (int corner = 0; corner < 3; ++corner) {
+            quadrics_[tri[corner]] += quadric;
+          }
+        }
+      }
+
+      // Lock vertices on boundaries and non-manifold edges.
+      for (const auto& item : edge_counts) {
+        if (item.second != 2) {
+          locked_[item.first.first] = true;
+          locked_[item.first.second] = true;
+        }
+      }
+
+      for (const Triangle& tri : triangles_) {
+        for (int corner = 0; corner < 3; ++corner) {
+          PushCollapse(tri[corner], tri[(corner + 1) % 3]);
+        }
+      }
+    }
+
+    std::vector<uint32_t> Simplify(int target_num_triangles,
+        double max_error) {
+      while (num_alive_ > target_num_triangles && !queue_.empty()) {
+        const Collapse collapse = queue_.top();
+        queue_.pop();
+        if (removed_[collapse.from] || removed_[collapse.to] ||
+            version_[collapse.from] != collapse.from_version ||
+            version_[collapse.to] != collapse.to_version) {
+          continue;
+        }
+        if (collapse.cost > max_error) {
+          break;
+        }
+        if (!CollapseIsValid(collapse.from, collapse.to)) {
+          continue;
+        }
+        DoCollapse(collapse.from, collapse.to);
+      }
+
+      std::vector<uint32_t> result;
+      result.reserve(num_alive_ * 3);
+      for (size_t tri_ind = 0; tri_ind < triangles_.size(); ++tri_ind) {
+        if (alive_[tri_ind]) {
+          result.insert(result.end(), triangles_[tri_ind].begin(),
+              triangles_[tri_ind].end());
+        }
+      }
+      return result;
+    }
+
+  private:
+    typedef std::array<uint32_t, 3> Triangle;
+
+    // Queues the cheaper direction of collapsing the edge between v0 and v1.
+    void PushCollapse(uint32_t v0, uint32_t v1) {
+      Quadric quadric = quadrics_[v0];
+      quadric += quadrics_[v1];
+      Collapse collapse;
+      collapse.cost = -1;
+      if (!locked_[v0]) {
+        collapse.cost = quadric.Error(vertices_[v1]);
+        collapse.from = v0;
+        collapse.to = v1;
+      }
+      if (!locked_[v1]) {
+        const double cost = quadric.Error(vertices_[v0]);
+        if (collapse.cost < 0 || cost < collapse.cost) {
+          collapse.cost = cost;
+          collapse.from = v1;
+          collapse.to = v0;
+        }
+      }
+      if (collapse.cost < 0) {
+        return;
+      }
+      collapse.from_version = version_[collapse.from];
+      collapse.to_version = version_[collapse.to];
+      queue_.push(collapse);
+    }
+
+    // Returns true if moving @p from onto @p to doesn't flip any triangle.
+    bool CollapseIsValid(uint32_t from, uint32_t to) const {
+      for (int tri_ind : vertex_triangles_[from]) {
+        if (!alive_[tri_ind]) {
+          continue;
+        }
+        const Triangle& tri = triangles_[tri_ind];
+        if (tri[0] == to || tri[1] == to || tri[2] == to) {
+          // This triangle collapses.
+          continue;
+        }
+        QVector3D before[3];
+        QVector3D after[3];
+        for (int corner = 0; corner < 3; ++corner) {
+          before[corner] = vertices_[tri[corner]];
+          after[corner] = tri[corner] == from ? vertices_[to] : before[corner];
+        }
+        const QVector3D normal_before = QVector3D::crossProduct(
+            before[1] - before[0], before[2] - before[0]);
+        const QVector3D normal_after = QVector3D::crossProduct(
+            after[1] - after[0], after[2] - after[0]);
+        if (QVector3D::dotProduct(normal_before, normal_after) <= 0) {
+          return false;
+        }
+      }
+      return true;
+    }
+
+    void DoCollapse(uint32_t from, uint32_t to) {
+      for (int tri_ind : vertex_triangles_[from]) {
+        if (!alive_[tri_ind]) {
+          continue;
+        }
+        Triangle& tri = triangles_[tri_ind];
+        if (tri[0] == to || tri[1] == to || tri[2] == to) {
+          alive_[tri_ind] = false;
+          num_alive_--;
+          continue;
+        }
+        std::replace(tri.begin(), tri.end(), from, to);
+        vertex_triangles_[to].push_back(tri_ind);
+      }
+      vertex_triangles_[from].clear();
+      removed_[from] = true;
+      quadrics_[to] += quadrics_[from];
+      version_[to]++;
+
+      // Drop references to dead triangles, and requeue the edges around the
+      // vertex whose quadric changed.
+      std::vector<int>& to_triangles = vertex_triangles_[to];
+      to_triangles.erase(std::remove_if(to_triangles.begin(),
+            to_triangles.end(),
+            [this](int tri_ind) { return !alive_[tri_ind]; }),
+          to_triangles.end());
+      for (int tri_ind : to_triangles) {
+        for (uint32_t vertex : triangles_[tri_ind]) {
+          if (vertex != to) {
+            PushCollapse(to, vertex);
+          }
+        }
+      }
+    }
+
+    const std::vector<QVector3D>& vertices_;
+    std::vector<Triangle> triangles_;
+    std::vector<bool> alive_;
+    std::vector<std::vector<int>> vertex_triangles_;
+    std::vector<Quadric> quadrics_;
+    std::vector<bool> locked_;
+    std::vector<bool> removed_;
+    std::vector<int> version_;
+    std::priority_queue<Collapse> queue_;
+    int num_alive_;
+};
+
+}  // namespace
+
+std::vector<uint32_t> SimplifyMesh(const std::vector<QVector3D>& vertices,
+    const std::vector<uint32_t>& indices, int target_num_triangles,
+    double max_error) {
+  Simplifier simplifier(vertices, indices);
+  return simplifier.Simplify(target_num_triangles, max_error);
+}
+
+std::vector<std::vector<uint32_t>> GenerateLodChain(
+    const std::vector<QVector3D>& vertices,
+    const std::vector<uint32_t>& indices, int max_levels,
+    double reduction) {
+  // Levels that don't shrink by at least this much aren't worth keeping.
+  const double kMinReduction = 0.9;
+
+  std::vector<std::vector<uint32_t>> result;
+  const std::vector<uint32_t>* previous = &indices;
+  for (int level = 0; level < max_levels; ++level) {
+    const int num_triangles = previous->size() / 3;
+    std::vector<uint32_t> simplified = SimplifyMesh(vertices, *previous,
+        num_triangles * reduction);
+    if (simplified.empty() ||
+        simplified.size() > previous->size() * kMinReduction) {
+      break;
+    }
+    result.push_back(std::move(simplified));
+    previous = &result.back();
+  }
+  return result;
+}
+
+}  // namespace sv
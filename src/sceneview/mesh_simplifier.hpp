@@ -0,0 +1,64 @@
+// Copyright [2015] Albert Huang
+
+#ifndef SCENEVIEW_MESH_SIMPLIFIER_HPP__
+#define SCENEVIEW_MESH_SIMPLIFIER_HPP__
+
+#include <cstdint>
+#include <vector>
+
+#include <QVector3D>
+
+namespace sv {
+
+/**
+ * Simplifies a triangle mesh by quadric error edge collapse.
+ *
+ * Implements the algorithm of Garland and Heckbert, "Surface Simplification
+ * Using Quadric Error Metrics". Edges are collapsed onto one of their
+ * endpoints, so the simplified mesh uses a subset of the original vertices
+ * and only the indices change. This lets a level of detail share the vertex
+ * buffer of the full resolution mesh.
+ *
+ * Vertices on open boundaries (including seams where vertices are split
+ * because of differing normals or texture coordinates) are never removed.
+ * Collapses that would flip a triangle are rejected.
+ *
+ * @param vertices vertex positions.
+ * @param indices triangle list indices.
+ * @param target_num_triangles stop once the mesh has at most this many
+ *        triangles.
+ * @param max_error stop once the cheapest collapse exceeds this squared
+ *        distance error.
+ *
+ * @return the indices of the simplified triangle list. If the mesh can't be
+ * simplified, then this may have more than @p target_num_triangles
+ * triangles.
+ *
+ * @ingroup sv_resources
+ * @headerfile sceneview/mesh_simplifier.hpp
+ */
+std::vector<uint32_t> SimplifyMesh(const std::vector<QVector3D>& vertices,
+    const std::vector<uint32_t>& indices, int target_num_triangles,
+    double max_error = 1e30);
+
+/**
+ * Generates a chain of successively simplified index buffers.
+ *
+ * Each level has roughly @p reduction times as many triangles as the
+ * previous one, starting from @p indices. Generation stops after
+ * @p max_levels levels, or when a level can't be reduced substantially.
+ *
+ * @return the coarser levels only (i.e., the full resolution indices are not
+ * included).
+ *
+ * @ingroup sv_resources
+ * @headerfile sceneview/mesh_simplifier.hpp
+ */
+std::vector<std::vector<uint32_t>> GenerateLodChain(
+    const std::vector<QVector3D>& vertices,
+    const std::vector<uint32_t>& indices, int max_levels,
+    double reduction = 0.5);
+
+}  // namespace sv
+
+#endif  // SCENEVIEW_MESH_SIMPLIFIER_HPP__
@@ -0,0 +1,122 @@
+// Copyright [2015] Albert Huang
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <vector>
+
+#include "sceneview/mesh_simplifier.hpp"
+
+// Build a closed, finely tessellated sphere as a latitude/longitude grid.
+static void MakeSphere(int num_rings, int num_slices,
+    std::vector<QVector3D>* vertices, std::vector<uint32_t>* indices) {
+  vertices->emplace_back(0, 0, 1);
+  for (int ring = 1; ring < num_rings; ++ring) {
+    const double phi = M_PI * ring / num_rings;
+    for (int slice = 0; slice < num_slices; ++slice) {
+      const double theta = 2 * M_PI * slice / num_slices;
+      vertices->emplace_back(sin(phi) * cos(theta), sin(phi) * sin(theta),
+          cos(phi));
+    }
+  }
+  vertices->emplace_back(0, 0, -1);
+  const uint32_t south = vertices->size() - 1;
+
+  auto ring_vertex = [num_slices](int ring, int slice) {
+    return static_cast<uint32_t>(1 + (ring - 1) * num_slices +
+        (slice % num_slices));
+  };
+  for (int slice = 0; slice < num_slices; ++slice) {
+    indices->insert(indices->end(),
+        { 0, ring_vertex(1, slice), ring_vertex(1, slice + 1) });
+    indices->insert(indices->end(), { south,
+        ring_vertex(num_rings - 1, slice + 1),
+        ring_vertex(num_rings - 1, slice) });
+  }
+  for (int ring = 1; ring < num_rings - 1; ++ring) {
+    for (int slice = 0; slice < num_slices; ++slice) {
+      const uint32_t v00 = ring_vertex(ring, slice);
+      const uint32_t v01 = ring_vertex(ring, slice + 1);
+      const uint32_t v10 = ring_vertex(ring + 1, slice);
+      const uint32_t v11 = ring_vertex(ring + 1, slice + 1);
+      indices->insert(indices->end(), { v00, v10, v11 });
+      indices->insert(indices->end(), { v00, v11, v01 });
+    }
+  }
+}
+
+TEST(MeshSimplifier, Sphere) {
+  std::vector<QVector3D> vertices;
+  std::vector<uint32_t> indices;
+  MakeSphere(32, 64, &vertices, &indices);
+  const int num_triangles = indices.size() / 3;
+
+  const std::vector<uint32_t> simplified = sv::SimplifyMesh(vertices,
+      indices, num_triangles / 4);
+  ASSERT_EQ(0u, simplified.size() % 3);
+  EXPECT_LE(simplified.size() / 3, static_cast<size_t>(num_triangles / 4));
+  EXPECT_GT(simplified.size() / 3, static_cast<size_t>(num_triangles / 8));
+
+  // Every triangle still faces outwards.
+  for (size_t ind = 0; ind < simplified.size(); ind += 3) {
+    ASSERT_LT(simplified[ind], vertices.size());
+    const QVector3D& p0 = vertices[simplified[ind]];
+    const QVector3D& p1 = vertices[simplified[ind + 1]];
+    const QVector3D& p2 = vertices[simplified[ind + 2]];
+    const QVector3D normal = QVector3D::crossProduct(p1 - p0, p2 - p0);
+    EXPECT_GT(QVector3D::dotProduct(normal, p0 + p1 + p2), 0);
+  }
+}
+
+TEST(MeshSimplifier, FlatGridKeepsBoundary) {
+  // A flat grid can be simplified without error, but its boundary vertices
+  // must be kept.
+  const int size = 16;
+  std::vector<QVector3D> vertices;
+  std::vector<uint32_t> indices;
+  for (int row = 0; row <= size; ++row) {
+    for (int col = 0; col <= size; ++col) {
+      vertices.emplace_back(col, row, 0);
+    }
+  }
+  for (int row = 0; row < size; ++row) {
+    for (int col = 0; col < size; ++col) {
+      const uint32_t v00 = row * (size + 1) + col;
+      const uint32_t v01 = v00 + 1;
+      const uint32_t v10 = v00 + size + 1;
+      const uint32_t v11 = v10 + 1;
+      indices.insert(indices.end(), { v00, v01, v11, v00, v11, v10 });
+    }
+  }
+
+  const std::vector<uint32_t> simplified = sv::SimplifyMesh(vertices,
+      indices, 0, 1e-6);
+  EXPECT_LT(simplified.size(), indices.size() / 4);
+
+  std::vector<bool> used(vertices.size(), false);
+  for (uint32_t index : simplified) {
+    used[index] = true;
+  }
+  for (size_t vert_ind = 0; vert_ind < vertices.size(); ++vert_ind) {
+    const QVector3D& vertex = vertices[vert_ind];
+    if (vertex.x() == 0 || vertex.y() == 0 || vertex.x() == size ||
+        vertex.y() == size) {
+      EXPECT_TRUE(used[vert_ind]);
+    }
+  }
+}
+
+TEST(MeshSimplifier, LodChain) {
+  std::vector<QVector3D> vertices;
+  std::vector<uint32_t> indices;
+  MakeSphere(32, 64, &vertices, &indices);
+
+  const std::vector<std::vector<uint32_t>> lods =
+    sv::GenerateLodChain(vertices, indices, 4);
+  ASSERT_EQ(4u, lods.size());
+  size_t previous_size = indices.size();
+  for (const std::vector<uint32_t>& lod : lods) {
+    EXPECT_LT(lod.size(), previous_size);
+    previous_size = lod.size();
+  }
+}
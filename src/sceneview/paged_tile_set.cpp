@@ -0,0 +1,239 @@
+// Copyright [2015] Albert Huang
+
+#include "sceneview/internal_gl.hpp"
+
+#include "sceneview/paged_tile_set.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+#include <utility>
+
+#include <QMatrix4x4>
+
+#include "sceneview/asset_importer.hpp"
+#include "sceneview/camera_node.hpp"
+#include "sceneview/group_node.hpp"
+#include "sceneview/thread_pool.hpp"
+#include "sceneview/viewport.hpp"
+
+#if 0
+#define dbg(fmt, ...) printf(fmt, __VA_ARGS__)
+#else
+#define dbg(...)
+#endif
+
+namespace sv {
+
+// Limits the number of tile reads queued at a time, so that tiles that are
+// no longer needed don't tie up the worker threads.
+static const int kMaxPendingReadsPerThread = 1;
+
+// Weight of the newest measurement in the camera velocity estimate.
+static const float kVelocitySmoothing = 0.3;
+
+static float DistanceToBox(const QVector3D& point, const AxisAlignedBox& box) {
+  const QVector3D& bmin = box.Min();
+  const QVector3D& bmax = box.Max();
+  QVector3D delta;
+  for (int axis = 0; axis < 3; ++axis) {
+    if (point[axis] < bmin[axis]) {
+      delta[axis] = bmin[axis] - point[axis];
+    } else if (point[axis] > bmax[axis]) {
+      delta[axis] = point[axis] - bmax[axis];
+    }
+  }
+  return delta.length();
+}
+
+PagedTileSet::Ptr PagedTileSet::Create(Viewport* viewport,
+    GroupNode* parent) {
+  return Ptr(new PagedTileSet(viewport, parent));
+}
+
+PagedTileSet::PagedTileSet(Viewport* viewport, GroupNode* parent) :
+  resources_(viewport->GetResources()),
+  scene_(viewport->GetScene()),
+  node_(scene_->MakeGroup(parent)),
+  load_distance_(100),
+  unload_distance_(150),
+  prefetch_time_(2),
+  upload_time_budget_(4),
+  num_loaded_tiles_(0),
+  have_camera_position_(false) {}
+
+PagedTileSet::~PagedTileSet() {
+  // Destroying the group node also destroys the nodes of loaded tiles. Reads
+  // that are still running finish in the background, and the results are
+  // dropped.
+  if (scene_->ContainsNode(node_)) {
+    scene_->DestroyNode(node_);
+  }
+}
+
+int PagedTileSet::AddTile(const AxisAlignedBox& box,
+    const QString& filename) {
+  if (!box.Valid()) {
+    throw std::invalid_argument("Invalid bounding box for tile " +
+        filename.toStdString());
+  }
+  tiles_.emplace_back();
+  Tile& tile = tiles_.back();
+  tile.box = box;
+  tile.filename = filename;
+  return tiles_.size() - 1;
+}
+
+void PagedTileSet::Update(CameraNode* camera) {
+  TrackCamera(camera);
+
+  ReceiveTiles();
+
+  // Tiles are prioritized by their distance to the current or predicted
+  // camera position, whichever is nearer.
+  const QVector3D predicted_position =
+    camera_position_ + camera_velocity_ * prefetch_time_;
+  const float unload_distance = std::max(unload_distance_, load_distance_);
+  std::vector<std::pair<float, int>> to_read;
+  int num_reading = 0;
+  for (size_t tile_ind = 0; tile_ind < tiles_.size(); ++tile_ind) {
+    Tile& tile = tiles_[tile_ind];
+    tile.priority = std::min(DistanceToBox(camera_position_, tile.box),
+        DistanceToBox(predicted_position, tile.box));
+    switch (tile.state) {
+      case TileState::kUnloaded:
+        if (tile.priority <= load_distance_) {
+          to_read.push_back(std::make_pair(tile.priority, tile_ind));
+        }
+        break;
+      case TileState::kReading:
+      case TileState::kUploading:
+      case TileState::kLoaded:
+        if (tile.priority > unload_distance) {
+          Unload(tile_ind);
+        } else if (tile.state == TileState::kReading) {
+          ++num_reading;
+        }
+        break;
+      case TileState::kFailed:
+        break;
+    }
+  }
+
+  // Queue reads, nearest tiles first.
+  std::sort(to_read.begin(), to_read.end());
+  const int max_pending =
+    kMaxPendingReadsPerThread * ThreadPool::Default()->NumThreads();
+  for (const std::pair<float, int>& item : to_read) {
+    if (num_reading >= max_pending) {
+      break;
+    }
+    Tile& tile = tiles_[item.second];
+    const QString filename = tile.filename;
+    tile.pending = ThreadPool::Default()->Submit([filename]() {
+      return AssetImporter::ReadFile(filename);
+    });
+    tile.state = TileState::kReading;
+    in_progress_.push_back(item.second);
+    ++num_reading;
+    dbg("Reading tile %d\n", item.second);
+  }
+
+  UploadTiles();
+}
+
+void PagedTileSet::TrackCamera(CameraNode* camera) {
+  const QVector3D world_position =
+    camera->WorldTransform().column(3).toVector3D();
+  const QVector3D position = node_->WorldTransform().inverted() *
+    world_position;
+  if (have_camera_position_) {
+    const double elapsed = camera_timer_.nsecsElapsed() * 1e-9;
+    if (elapsed > 0) {
+      const QVector3D velocity = (position - camera_position_) / elapsed;
+      camera_velocity_ += (velocity - camera_velocity_) * kVelocitySmoothing;
+    }
+  }
+  camera_timer_.start();
+  camera_position_ = position;
+  have_camera_position_ = true;
+}
+
+void PagedTileSet::ReceiveTiles() {
+  for (int tile_ind : in_progress_) {
+    Tile& tile = tiles_[tile_ind];
+    if (tile.state != TileState::kReading ||
+        tile.pending.wait_for(std::chrono::seconds(0)) !=
+        std::future_status::ready) {
+      continue;
+    }
+    ImportedAsset::Ptr asset;
+    try {
+      asset = tile.pending.get();
+    } catch (const std::exception& ex) {
+      dbg("Tile %d: %s\n", tile_ind, ex.what());
+    }
+    if (!asset) {
+      tile.state = TileState::kFailed;
+      continue;
+    }
+    tile.node = scene_->MakeGroup(node_);
+    tile.node->SetSelectionMask(node_->GetSelectionMask());
+    tile.builder.reset(new ImportedAssetBuilder(resources_, scene_,
+          tile.node, asset));
+    tile.state = TileState::kUploading;
+  }
+  in_progress_.remove_if([this](int tile_ind) {
+      return tiles_[tile_ind].state == TileState::kFailed;
+  });
+}
+
+void PagedTileSet::UploadTiles() {
+  std::vector<std::pair<float, int>> uploading;
+  for (int tile_ind : in_progress_) {
+    const Tile& tile = tiles_[tile_ind];
+    if (tile.state == TileState::kUploading) {
+      uploading.push_back(std::make_pair(tile.priority, tile_ind));
+    }
+  }
+  std::sort(uploading.begin(), uploading.end());
+
+  QElapsedTimer timer;
+  timer.start();
+  bool uploaded = false;
+  for (const std::pair<float, int>& item : uploading) {
+    const double remaining = upload_time_budget_ - timer.nsecsElapsed() * 1e-6;
+    if (uploaded && remaining <= 0) {
+      break;
+    }
+    Tile& tile = tiles_[item.second];
+    uploaded = true;
+    if (!tile.builder->Build(std::max(remaining, 0.0))) {
+      continue;
+    }
+    tile.builder.reset();
+    tile.state = TileState::kLoaded;
+    in_progress_.remove(item.second);
+    ++num_loaded_tiles_;
+    dbg("Loaded tile %d\n", item.second);
+  }
+}
+
+void PagedTileSet::Unload(int tile_ind) {
+  Tile& tile = tiles_[tile_ind];
+  if (tile.state == TileState::kLoaded) {
+    --num_loaded_tiles_;
+  } else {
+    in_progress_.remove(tile_ind);
+  }
+  if (tile.node) {
+    scene_->DestroyNode(tile.node);
+    tile.node = nullptr;
+  }
+  tile.builder.reset();
+  tile.pending = std::future<ImportedAsset::Ptr>();
+  tile.state = TileState::kUnloaded;
+  dbg("Unloaded tile %d\n", tile_ind);
+}
+
+}  // namespace sv
@@ -0,0 +1,223 @@
+// Copyright [2015] Albert Huang
+
+#ifndef SCENEVIEW_PAGED_TILE_SET_HPP__
+#define SCENEVIEW_PAGED_TILE_SET_HPP__
+
+#include <future>
+#include <list>
+#include <memory>
+#include <vector>
+
+#include <QElapsedTimer>
+#include <QString>
+#include <QVector3D>
+
+#include <sceneview/axis_aligned_box.hpp>
+#include <sceneview/imported_asset.hpp>
+#include <sceneview/resource_manager.hpp>
+#include <sceneview/scene.hpp>
+
+namespace sv {
+
+class CameraNode;
+class GroupNode;
+class Viewport;
+
+/**
+ * Large map split into tiles, each stored in its own model file, that are
+ * loaded when the camera approaches them.
+ *
+ * Each tile is described by a bounding box and a file name. Only the tiles
+ * near the camera are kept in memory. When the camera comes within the load
+ * distance of a tile, the tile's file is read by AssetImporter::ReadFile()
+ * on a worker thread, and then uploaded to graphics memory by
+ * ImportedAssetBuilder on the rendering thread, a few meshes per frame
+ * subject to a time budget. A tile is unloaded once the camera is farther
+ * away than the unload distance. The unload distance is larger than the load
+ * distance, so that a camera moving back and forth near the load distance
+ * doesn't repeatedly load and unload the same tiles.
+ *
+ * To hide loading latency, tiles are also loaded if they are within the load
+ * distance of where the camera is predicted to be after the prefetch time,
+ * extrapolating from its recent velocity.
+ *
+ * The tile bounding boxes are in the coordinate frame of Node(), and should
+ * contain the models in their files. Each loaded tile is drawn below its own
+ * GroupNode, which receives the transform of the model's root node.
+ *
+ * @code
+ * PagedTileSet::Ptr tiles = PagedTileSet::Create(viewport, scene->Root());
+ * for (const TileInfo& info : tile_index) {
+ *   tiles->AddTile(info.box, info.filename);
+ * }
+ *
+ * // In Renderer::RenderBegin(), or elsewhere with the OpenGL context
+ * // current, once per frame:
+ * tiles->Update(viewport->GetCamera());
+ * @endcode
+ *
+ * @ingroup sv_scenegraph
+ * @headerfile sceneview/paged_tile_set.hpp
+ */
+class PagedTileSet {
+  public:
+    typedef std::shared_ptr<PagedTileSet> Ptr;
+
+    /**
+     * Creates an empty tile set.
+     *
+     * @param viewport provides the scene and resources.
+     * @param parent the parent of Node().
+     */
+    static Ptr Create(Viewport* viewport, GroupNode* parent);
+
+    ~PagedTileSet();
+
+    /**
+     * Adds a tile. The tile isn't loaded until the camera approaches it.
+     *
+     * @param box bounds of the tile, in the coordinate frame of Node().
+     * @param filename the model file of the tile. Any format supported by
+     *        AssetImporter can be used.
+     *
+     * @return the index of the tile.
+     */
+    int AddTile(const AxisAlignedBox& box, const QString& filename);
+
+    /**
+     * Queues loads of tiles near the camera, uploads loaded tiles, and
+     * unloads far tiles.
+     *
+     * Must be called with the OpenGL context current, typically once per
+     * frame before drawing. The camera velocity is estimated from the
+     * camera positions passed to successive calls.
+     */
+    void Update(CameraNode* camera);
+
+    /**
+     * Sets the distance from the camera to a tile's bounding box below which
+     * the tile is loaded. The default is 100.
+     */
+    void SetLoadDistance(float distance) { load_distance_ = distance; }
+
+    float LoadDistance() const { return load_distance_; }
+
+    /**
+     * Sets the distance from the camera to a tile's bounding box above which
+     * the tile is unloaded. Values smaller than the load distance are
+     * treated as the load distance. The default is 150.
+     */
+    void SetUnloadDistance(float distance) { unload_distance_ = distance; }
+
+    float UnloadDistance() const { return unload_distance_; }
+
+    /**
+     * Sets how far ahead, in seconds, the camera position is predicted for
+     * prefetching tiles. Set to zero to disable prefetching. The default is
+     * 2 seconds.
+     */
+    void SetPrefetchTime(double seconds) { prefetch_time_ = seconds; }
+
+    double PrefetchTime() const { return prefetch_time_; }
+
+    /**
+     * Sets the maximum time, in milliseconds, spent uploading loaded tiles
+     * to graphics memory in each call to Update(). At least one mesh is
+     * uploaded per call if any are ready. The default is 4 ms.
+     */
+    void SetUploadTimeBudget(double milliseconds) {
+      upload_time_budget_ = milliseconds;
+    }
+
+    /**
+     * Retrieve the group node that all tiles are drawn under.
+     */
+    GroupNode* Node() { return node_; }
+
+    /**
+     * Retrieve the group node of a tile, or nullptr if the tile isn't
+     * loaded. The node is destroyed when the tile is unloaded.
+     */
+    GroupNode* TileNode(int tile) { return tiles_[tile].node; }
+
+    /**
+     * Returns true if a tile is completely uploaded.
+     */
+    bool TileLoaded(int tile) const {
+      return tiles_[tile].state == TileState::kLoaded;
+    }
+
+    int NumTiles() const { return tiles_.size(); }
+
+    /**
+     * Retrieve the number of tiles that are completely uploaded.
+     */
+    int NumLoadedTiles() const { return num_loaded_tiles_; }
+
+    /**
+     * Retrieve the estimated camera velocity, in the coordinate frame of
+     * Node().
+     */
+    const QVector3D& CameraVelocity() const { return camera_velocity_; }
+
+  private:
+    enum class TileState {
+      kUnloaded,
+      kReading,
+      kUploading,
+      kLoaded,
+      // The file couldn't be read. The tile isn't retried.
+      kFailed
+    };
+
+    struct Tile {
+      Tile() : node(nullptr), state(TileState::kUnloaded), priority(0) {}
+
+      AxisAlignedBox box;
+      QString filename;
+
+      GroupNode* node;
+      TileState state;
+      std::future<ImportedAsset::Ptr> pending;
+      std::unique_ptr<ImportedAssetBuilder> builder;
+
+      // Distance used to order loads and uploads, nearest first.
+      float priority;
+    };
+
+    PagedTileSet(Viewport* viewport, GroupNode* parent);
+
+    // Updates the camera position and velocity estimate.
+    void TrackCamera(CameraNode* camera);
+
+    void ReceiveTiles();
+
+    void UploadTiles();
+
+    void Unload(int tile_ind);
+
+    ResourceManager::Ptr resources_;
+    Scene::Ptr scene_;
+    GroupNode* node_;
+
+    float load_distance_;
+    float unload_distance_;
+    double prefetch_time_;
+    double upload_time_budget_;
+
+    std::vector<Tile> tiles_;
+
+    // Tiles that are being read or uploaded.
+    std::list<int> in_progress_;
+
+    int num_loaded_tiles_;
+
+    QElapsedTimer camera_timer_;
+    bool have_camera_position_;
+    QVector3D camera_position_;
+    QVector3D camera_velocity_;
+};
+
+}  // namespace sv
+
+#endif  // SCENEVIEW_PAGED_TILE_SET_HPP__
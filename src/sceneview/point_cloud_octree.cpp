@@ -0,0 +1,578 @@
+// Copyright [2015] Albert Huang
+
+#include "sceneview/point_cloud_octree.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <deque>
+#include <stdexcept>
+#include <string>
+#include <unordered_set>
+#include <utility>
+
+#include <QDir>
+
+namespace sv {
+
+namespace {
+
+const char kMagic[4] = { 'S', 'V', 'P', 'C' };
+const uint32_t kVersion = 1;
+
+// Nodes this deep are never split, so that coincident points can't cause
+// unbounded recursion.
+const int kMaxDepth = 20;
+
+struct FileHeader {
+  char magic[4];
+  uint32_t version;
+  float root_min[3];
+  float root_size;
+  uint64_t num_points;
+  uint64_t node_table_offset;
+  uint32_t num_nodes;
+  uint32_t reserved;
+};
+
+struct NodeRecord {
+  int32_t parent;
+  uint32_t num_points;
+  uint64_t offset;
+  float bounds_min[3];
+  float bounds_max[3];
+  uint8_t octant;
+  uint8_t depth;
+  uint8_t reserved[6];
+};
+
+// Set of occupied subsampling grid cells of a node. Starts out as a hash
+// set, and switches to a bitmap of the whole grid once that's smaller.
+class CellSet {
+  public:
+    bool Insert(uint32_t cell) {
+      if (!bits_.empty()) {
+        uint64_t& word = bits_[cell / 64];
+        const uint64_t bit = static_cast<uint64_t>(1) << (cell % 64);
+        if (word & bit) {
+          return false;
+        }
+        word |= bit;
+        return true;
+      }
+
+      if (!cells_.insert(cell).second) {
+        return false;
+      }
+      if (cells_.size() > kMaxSparseCells) {
+        bits_.resize(kNumCells / 64);
+        for (uint32_t occupied : cells_) {
+          bits_[occupied / 64] |= static_cast<uint64_t>(1) << (occupied % 64);
+        }
+        std::unordered_set<uint32_t>().swap(cells_);
+      }
+      return true;
+    }
+
+    void Clear() {
+      std::unordered_set<uint32_t>().swap(cells_);
+      std::vector<uint64_t>().swap(bits_);
+    }
+
+  private:
+    static const uint32_t kNumCells = PointCloudOctree::kGridSize *
+      PointCloudOctree::kGridSize * PointCloudOctree::kGridSize;
+
+    // A hash set entry takes about 32 bytes, so past this many cells the
+    // bitmap is smaller.
+    static const size_t kMaxSparseCells = kNumCells / 256;
+
+    std::unordered_set<uint32_t> cells_;
+    std::vector<uint64_t> bits_;
+};
+
+// Run of a node's points in the spill file.
+struct SpillChunk {
+  int64_t offset;
+  int64_t num_points;
+};
+
+static_assert(sizeof(PointRecord) == 16, "Unexpected PointRecord padding");
+static_assert(sizeof(FileHeader) == 48, "Unexpected FileHeader padding");
+static_assert(sizeof(NodeRecord) == 48, "Unexpected NodeRecord padding");
+
+}  // namespace
+
+struct PointCloudOctreeBuilder::Node {
+  Node(const QVector3D& min, float size, int depth) :
+    min(min), size(size), depth(depth), leaf(true), num_spilled(0) {}
+
+  int64_t NumPoints() const { return points.size() + num_spilled; }
+
+  int Octant(const PointRecord& point) const {
+    const float half = size / 2;
+    return (point.x >= min.x() + half ? 1 : 0) |
+      (point.y >= min.y() + half ? 2 : 0) |
+      (point.z >= min.z() + half ? 4 : 0);
+  }
+
+  uint32_t Cell(const PointRecord& point) const {
+    const int grid_size = PointCloudOctree::kGridSize;
+    const float scale = grid_size / size;
+    const int cx = std::max(0, std::min(grid_size - 1,
+          static_cast<int>((point.x - min.x()) * scale)));
+    const int cy = std::max(0, std::min(grid_size - 1,
+          static_cast<int>((point.y - min.y()) * scale)));
+    const int cz = std::max(0, std::min(grid_size - 1,
+          static_cast<int>((point.z - min.z()) * scale)));
+    return (cx * grid_size + cy) * grid_size + cz;
+  }
+
+  bool Contains(const PointRecord& point) const {
+    return point.x >= min.x() && point.x <= min.x() + size &&
+      point.y >= min.y() && point.y <= min.y() + size &&
+      point.z >= min.z() && point.z <= min.z() + size;
+  }
+
+  void IncrementDepth() {
+    depth++;
+    for (std::unique_ptr<Node>& child : children) {
+      if (child) {
+        child->IncrementDepth();
+      }
+    }
+  }
+
+  QVector3D min;
+  float size;
+  int depth;
+  bool leaf;
+
+  // Points held in memory.
+  std::vector<PointRecord> points;
+
+  // Points spilled to disk, and their bounding box.
+  std::vector<SpillChunk> spilled;
+  int64_t num_spilled;
+  AxisAlignedBox spilled_bounds;
+
+  // Occupied subsampling grid cells. Only used by inner nodes.
+  CellSet cells;
+
+  std::unique_ptr<Node> children[8];
+};
+
+PointCloudOctreeBuilder::PointCloudOctreeBuilder(int max_leaf_points,
+    int64_t max_memory_points) :
+  max_leaf_points_(std::max(max_leaf_points, 1)),
+  max_memory_points_(std::max<int64_t>(max_memory_points, 1)),
+  num_points_(0),
+  num_memory_points_(0),
+  temp_dirname_(QDir::tempPath()),
+  spill_size_(0) {}
+
+PointCloudOctreeBuilder::~PointCloudOctreeBuilder() {}
+
+void PointCloudOctreeBuilder::SetBounds(const AxisAlignedBox& bounds) {
+  if (num_points_ > 0) {
+    throw std::logic_error("Octree bounds must be set before adding points");
+  }
+  const QVector3D extent = bounds.Max() - bounds.Min();
+  const float size = std::max(std::max(extent.x(), extent.y()), extent.z());
+  root_.reset(new Node(bounds.Min(), size > 0 ? size : 1, 0));
+}
+
+void PointCloudOctreeBuilder::SetTemporaryDirectory(const QString& dirname) {
+  temp_dirname_ = dirname;
+}
+
+void PointCloudOctreeBuilder::AddPoints(const PointRecord* points,
+    int num_points) {
+  if (!root_) {
+    const AxisAlignedBox bounds = AxisAlignedBox::FromPoints(&points->x,
+        num_points, sizeof(PointRecord));
+    if (!bounds.Valid()) {
+      return;
+    }
+    const QVector3D extent = bounds.Max() - bounds.Min();
+    const float size = std::max(std::max(extent.x(), extent.y()), extent.z());
+    // Pad the cube slightly, so that the points on the far faces of the
+    // bounding box land inside of it despite rounding.
+    root_.reset(new Node(bounds.Min(), size > 0 ? size * 1.001f : 1, 0));
+  }
+
+  for (int point_ind = 0; point_ind < num_points; ++point_ind) {
+    const PointRecord& point = points[point_ind];
+    if (!std::isfinite(point.x) || !std::isfinite(point.y) ||
+        !std::isfinite(point.z)) {
+      continue;
+    }
+    if (!root_->Contains(point)) {
+      GrowRoot(point);
+    }
+    Insert(root_.get(), point);
+    num_points_++;
+
+    if (num_memory_points_ > max_memory_points_) {
+      SpillPoints();
+    }
+  }
+}
+
+void PointCloudOctreeBuilder::Insert(Node* node, const PointRecord& point) {
+  while (true) {
+    if (node->leaf) {
+      node->points.push_back(point);
+      num_memory_points_++;
+      if (node->NumPoints() > max_leaf_points_ && node->depth < kMaxDepth) {
+        Split(node);
+      }
+      return;
+    }
+
+    if (node->cells.Insert(node->Cell(point))) {
+      node->points.push_back(point);
+      num_memory_points_++;
+      return;
+    }
+
+    // The grid cell is taken. Pass the point down.
+    const int octant = node->Octant(point);
+    std::unique_ptr<Node>& child = node->children[octant];
+    if (!child) {
+      const float half = node->size / 2;
+      const QVector3D child_min = node->min + QVector3D(
+          octant & 1 ? half : 0,
+          octant & 2 ? half : 0,
+          octant & 4 ? half : 0);
+      child.reset(new Node(child_min, half, node->depth + 1));
+    }
+    node = child.get();
+  }
+}
+
+void PointCloudOctreeBuilder::Split(Node* node) {
+  node->leaf = false;
+  const std::vector<PointRecord> points = TakePoints(node);
+  for (const PointRecord& point : points) {
+    Insert(node, point);
+  }
+}
+
+void PointCloudOctreeBuilder::GrowRoot(const PointRecord& point) {
+  while (!root_->Contains(point)) {
+    // Double the root cube towards the point, and make the old root a child
+    // of the new one.
+    const float size = root_->size;
+    const QVector3D& min = root_->min;
+    const bool grow_x = point.x < min.x();
+    const bool grow_y = point.y < min.y();
+    const bool grow_z = point.z < min.z();
+    const QVector3D new_min(
+        grow_x ? min.x() - size : min.x(),
+        grow_y ? min.y() - size : min.y(),
+        grow_z ? min.z() - size : min.z());
+    const int octant = (grow_x ? 1 : 0) | (grow_y ? 2 : 0) | (grow_z ? 4 : 0);
+
+    std::unique_ptr<Node> new_root(new Node(new_min, size * 2, 0));
+    new_root->leaf = false;
+    root_->IncrementDepth();
+
+    // Resample the old root into the new one, as if its points had been
+    // inserted from the top. Points whose cells in the new root are taken
+    // stay where they are.
+    Node* old_root = root_.get();
+    const std::vector<PointRecord> points = TakePoints(old_root);
+    old_root->cells.Clear();
+    for (const PointRecord& point : points) {
+      if (new_root->cells.Insert(new_root->Cell(point))) {
+        new_root->points.push_back(point);
+      } else {
+        if (!old_root->leaf) {
+          old_root->cells.Insert(old_root->Cell(point));
+        }
+        old_root->points.push_back(point);
+      }
+    }
+    num_memory_points_ += points.size();
+
+    new_root->children[octant] = std::move(root_);
+    root_ = std::move(new_root);
+  }
+}
+
+void PointCloudOctreeBuilder::SpillPoints() {
+  std::vector<Node*> nodes;
+  std::vector<Node*> to_visit = { root_.get() };
+  while (!to_visit.empty()) {
+    Node* node = to_visit.back();
+    to_visit.pop_back();
+    if (!node->points.empty()) {
+      nodes.push_back(node);
+    }
+    for (std::unique_ptr<Node>& child : node->children) {
+      if (child) {
+        to_visit.push_back(child.get());
+      }
+    }
+  }
+
+  // Spilling the largest nodes first keeps the chunks in the spill file
+  // large, and the number of writes small.
+  std::sort(nodes.begin(), nodes.end(), [](const Node* a, const Node* b) {
+    return a->points.size() > b->points.size();
+  });
+  for (Node* node : nodes) {
+    if (num_memory_points_ <= max_memory_points_ / 2) {
+      break;
+    }
+    SpillNode(node);
+  }
+}
+
+void PointCloudOctreeBuilder::SpillNode(Node* node) {
+  if (!spill_file_) {
+    spill_file_.reset(new QTemporaryFile(
+          temp_dirname_ + "/sv_octree_XXXXXX"));
+    if (!spill_file_->open()) {
+      spill_file_.reset();
+      throw std::runtime_error("Unable to create a temporary file in " +
+          temp_dirname_.toStdString());
+    }
+  }
+
+  const qint64 size = node->points.size() * sizeof(PointRecord);
+  if (!spill_file_->seek(spill_size_) ||
+      spill_file_->write(reinterpret_cast<const char*>(node->points.data()),
+        size) != size) {
+    throw std::runtime_error("Error writing " +
+        spill_file_->fileName().toStdString());
+  }
+
+  SpillChunk chunk;
+  chunk.offset = spill_size_;
+  chunk.num_points = node->points.size();
+  node->spilled.push_back(chunk);
+  node->num_spilled += chunk.num_points;
+  const AxisAlignedBox box = AxisAlignedBox::FromPoints(
+      &node->points.data()->x, node->points.size(), sizeof(PointRecord));
+  node->spilled_bounds.IncludeBox(box);
+
+  spill_size_ += size;
+  num_memory_points_ -= node->points.size();
+  std::vector<PointRecord>().swap(node->points);
+}
+
+void PointCloudOctreeBuilder::ReadSpilled(const Node* node,
+    std::vector<PointRecord>* points) const {
+  for (const SpillChunk& chunk : node->spilled) {
+    const size_t first = points->size();
+    points->resize(first + chunk.num_points);
+    const qint64 size = chunk.num_points * sizeof(PointRecord);
+    if (!spill_file_->seek(chunk.offset) ||
+        spill_file_->read(reinterpret_cast<char*>(points->data() + first),
+          size) != size) {
+      throw std::runtime_error("Error reading " +
+          spill_file_->fileName().toStdString());
+    }
+  }
+}
+
+std::vector<PointRecord> PointCloudOctreeBuilder::TakePoints(Node* node) {
+  // The space of the spilled chunks isn't reused, so the spill file keeps
+  // growing as nodes are split.
+  std::vector<PointRecord> points;
+  points.reserve(node->NumPoints());
+  ReadSpilled(node, &points);
+  points.insert(points.end(), node->points.begin(), node->points.end());
+  num_memory_points_ -= node->points.size();
+
+  std::vector<PointRecord>().swap(node->points);
+  std::vector<SpillChunk>().swap(node->spilled);
+  node->num_spilled = 0;
+  node->spilled_bounds = AxisAlignedBox();
+  return points;
+}
+
+void PointCloudOctreeBuilder::Save(const QString& filename) const {
+  // Number the nodes breadth first, so that parents come before children.
+  std::vector<const Node*> nodes;
+  std::vector<NodeRecord> records;
+  if (root_) {
+    std::deque<std::pair<const Node*, int>> to_visit = {
+      std::make_pair(root_.get(), -1) };
+    while (!to_visit.empty()) {
+      const Node* node = to_visit.front().first;
+      NodeRecord record;
+      std::memset(&record, 0, sizeof(record));
+      record.parent = to_visit.front().second;
+      record.num_points = node->NumPoints();
+      record.depth = node->depth;
+      to_visit.pop_front();
+
+      const int node_ind = nodes.size();
+      nodes.push_back(node);
+      records.push_back(record);
+      for (int octant = 0; octant < 8; ++octant) {
+        if (node->children[octant]) {
+          to_visit.push_back(std::make_pair(node->children[octant].get(),
+                node_ind));
+        }
+      }
+    }
+  }
+
+  // Compute the tight bounds of each subtree, children first.
+  std::vector<AxisAlignedBox> bounds(nodes.size());
+  for (int node_ind = nodes.size() - 1; node_ind >= 0; --node_ind) {
+    const Node* node = nodes[node_ind];
+    AxisAlignedBox box = AxisAlignedBox::FromPoints(&node->points.data()->x,
+        node->points.size(), sizeof(PointRecord));
+    if (node->spilled_bounds.Valid()) {
+      box.IncludeBox(node->spilled_bounds);
+    }
+    if (bounds[node_ind].Valid()) {
+      box.IncludeBox(bounds[node_ind]);
+    }
+    bounds[node_ind] = box;
+
+    NodeRecord& record = records[node_ind];
+    for (int axis = 0; axis < 3; ++axis) {
+      record.bounds_min[axis] = box.Min()[axis];
+      record.bounds_max[axis] = box.Max()[axis];
+    }
+
+    if (record.parent >= 0) {
+      const Node* parent = nodes[record.parent];
+      for (int octant = 0; octant < 8; ++octant) {
+        if (parent->children[octant].get() == node) {
+          record.octant = octant;
+        }
+      }
+      if (box.Valid()) {
+        bounds[record.parent].IncludeBox(box);
+      }
+    }
+  }
+
+  FileHeader header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  if (root_) {
+    header.root_min[0] = root_->min.x();
+    header.root_min[1] = root_->min.y();
+    header.root_min[2] = root_->min.z();
+    header.root_size = root_->size;
+  }
+  header.num_points = 0;
+  uint64_t offset = sizeof(FileHeader);
+  for (NodeRecord& record : records) {
+    record.offset = offset;
+    offset += record.num_points * sizeof(PointRecord);
+    header.num_points += record.num_points;
+  }
+  header.node_table_offset = offset;
+  header.num_nodes = records.size();
+
+  QFile file(filename);
+  if (!file.open(QIODevice::WriteOnly)) {
+    throw std::runtime_error("Unable to open " + filename.toStdString() +
+        " for writing");
+  }
+  bool ok = file.write(reinterpret_cast<const char*>(&header),
+      sizeof(header)) == sizeof(header);
+  std::vector<PointRecord> spilled;
+  for (const Node* node : nodes) {
+    spilled.clear();
+    ReadSpilled(node, &spilled);
+    const qint64 spilled_size = spilled.size() * sizeof(PointRecord);
+    ok = ok && (spilled_size == 0 || file.write(
+          reinterpret_cast<const char*>(spilled.data()), spilled_size) ==
+        spilled_size);
+    const qint64 size = node->points.size() * sizeof(PointRecord);
+    ok = ok && (size == 0 || file.write(
+          reinterpret_cast<const char*>(node->points.data()), size) == size);
+  }
+  const qint64 table_size = records.size() * sizeof(NodeRecord);
+  ok = ok && (table_size == 0 || file.write(
+        reinterpret_cast<const char*>(records.data()), table_size) ==
+      table_size);
+  if (!ok) {
+    throw std::runtime_error("Error writing " + filename.toStdString());
+  }
+}
+
+PointCloudOctree::PointCloudOctree(const QString& filename) :
+  file_(filename),
+  data_(nullptr),
+  num_points_(0) {
+  if (!file_.open(QIODevice::ReadOnly)) {
+    throw std::runtime_error("Unable to open " + filename.toStdString());
+  }
+  const uint64_t file_size = file_.size();
+  FileHeader header;
+  if (file_size < sizeof(header)) {
+    throw std::runtime_error(filename.toStdString() +
+        " is not a point cloud octree");
+  }
+  data_ = file_.map(0, file_size);
+  if (!data_) {
+    throw std::runtime_error("Unable to map " + filename.toStdString());
+  }
+  std::memcpy(&header, data_, sizeof(header));
+  if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) ||
+      header.version != kVersion) {
+    throw std::runtime_error(filename.toStdString() +
+        " is not a point cloud octree");
+  }
+  if (header.node_table_offset > file_size ||
+      (file_size - header.node_table_offset) / sizeof(NodeRecord) <
+      header.num_nodes) {
+    throw std::runtime_error(filename.toStdString() + " is truncated");
+  }
+  num_points_ = header.num_points;
+
+  nodes_.resize(header.num_nodes);
+  for (uint32_t node_ind = 0; node_ind < header.num_nodes; ++node_ind) {
+    NodeRecord record;
+    std::memcpy(&record, data_ + header.node_table_offset +
+        node_ind * sizeof(NodeRecord), sizeof(record));
+    if (record.parent >= static_cast<int32_t>(node_ind) ||
+        (node_ind > 0 && record.parent < 0) || record.octant >= 8 ||
+        record.offset > header.node_table_offset ||
+        (header.node_table_offset - record.offset) / sizeof(PointRecord) <
+        record.num_points) {
+      throw std::runtime_error(filename.toStdString() + " is corrupt");
+    }
+
+    Node& node = nodes_[node_ind];
+    node.bounds = AxisAlignedBox(
+        QVector3D(record.bounds_min[0], record.bounds_min[1],
+          record.bounds_min[2]),
+        QVector3D(record.bounds_max[0], record.bounds_max[1],
+          record.bounds_max[2]));
+    node.spacing = std::ldexp(header.root_size / kGridSize, -record.depth);
+    node.depth = record.depth;
+    node.parent = record.parent;
+    std::fill(node.children, node.children + 8, -1);
+    node.num_points = record.num_points;
+    node.offset = record.offset;
+    if (record.parent >= 0) {
+      nodes_[record.parent].children[record.octant] = node_ind;
+    }
+  }
+}
+
+PointCloudOctree::~PointCloudOctree() {
+  if (data_) {
+    file_.unmap(const_cast<uint8_t*>(data_));
+  }
+}
+
+const PointRecord* PointCloudOctree::NodePoints(int node_ind) const {
+  return reinterpret_cast<const PointRecord*>(data_ +
+      nodes_[node_ind].offset);
+}
+
+}  // namespace sv
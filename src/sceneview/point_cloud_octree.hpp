@@ -0,0 +1,238 @@
+// Copyright [2015] Albert Huang
+
+#ifndef SCENEVIEW_POINT_CLOUD_OCTREE_HPP__
+#define SCENEVIEW_POINT_CLOUD_OCTREE_HPP__
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <QFile>
+#include <QString>
+#include <QTemporaryFile>
+
+#include <sceneview/axis_aligned_box.hpp>
+
+namespace sv {
+
+/**
+ * A single point, as stored in a point cloud octree file.
+ *
+ * @ingroup sv_resources
+ * @headerfile sceneview/point_cloud_octree.hpp
+ */
+struct PointRecord {
+  float x;
+  float y;
+  float z;
+  uint8_t r;
+  uint8_t g;
+  uint8_t b;
+  uint8_t a;
+};
+
+/**
+ * Builds a multi-resolution octree from a point cloud, and writes it to disk
+ * for use with PointCloudOctree and PointCloudResource.
+ *
+ * The octree is organized in the style of Potree. Each node stores a
+ * subsample of the points within its cube, taking at most one point per cell
+ * of a regular grid that has PointCloudOctree::kGridSize cells along each
+ * axis. Points that don't fit in a node are passed down to its children. The
+ * points of a node together with those of all of its ancestors therefore
+ * form a progressively denser representation of the cloud, and a renderer
+ * can stop descending wherever the grid spacing of a node becomes
+ * negligible on screen.
+ *
+ * Points can be added incrementally, e.g., as a SLAM map grows. If a point
+ * falls outside of the current root cube, then the octree grows upwards by
+ * making the root a child of a new root twice its size. Save() can be called
+ * at any time to write a snapshot of the octree.
+ *
+ * Clouds that don't fit in memory can be built as well. Once more than a
+ * given number of points are held in memory, the points of the largest
+ * nodes are spilled to a temporary file, and only read back when a leaf node
+ * is split or the octree is saved. Besides the points in memory, each inner
+ * node keeps track of its occupied grid cells, which takes at most 256 KiB
+ * per node.
+ *
+ * @ingroup sv_resources
+ * @headerfile sceneview/point_cloud_octree.hpp
+ */
+class PointCloudOctreeBuilder {
+  public:
+    /**
+     * @param max_leaf_points leaf nodes are split once they hold more than
+     *        this many points.
+     * @param max_memory_points points are spilled to disk once more than
+     *        this many are held in memory.
+     */
+    explicit PointCloudOctreeBuilder(int max_leaf_points = 20000,
+        int64_t max_memory_points = 20000000);
+
+    ~PointCloudOctreeBuilder();
+
+    PointCloudOctreeBuilder(const PointCloudOctreeBuilder&) = delete;
+    PointCloudOctreeBuilder& operator=(const PointCloudOctreeBuilder&) = delete;
+
+    /**
+     * Sets the extents of the root node.
+     *
+     * Optional. If not called, then the root node is sized to fit the first
+     * batch of points. Must be called before any points are added.
+     *
+     * @throw std::logic_error if points have already been added.
+     */
+    void SetBounds(const AxisAlignedBox& bounds);
+
+    /**
+     * Sets the directory of the temporary file that points are spilled to.
+     *
+     * Optional. Defaults to the system temporary directory. Must be called
+     * before any points are spilled.
+     */
+    void SetTemporaryDirectory(const QString& dirname);
+
+    /**
+     * Adds points to the octree. Points with non-finite coordinates are
+     * skipped.
+     *
+     * @throw std::runtime_error if points can't be spilled to disk.
+     */
+    void AddPoints(const PointRecord* points, int num_points);
+
+    /**
+     * Retrieve the number of points in the octree.
+     */
+    int64_t NumPoints() const { return num_points_; }
+
+    /**
+     * Writes the octree to a file.
+     *
+     * @throw std::runtime_error if the file can't be written, or if spilled
+     * points can't be read back.
+     */
+    void Save(const QString& filename) const;
+
+  private:
+    struct Node;
+
+    void Insert(Node* node, const PointRecord& point);
+
+    void Split(Node* node);
+
+    void GrowRoot(const PointRecord& point);
+
+    // Spills the points of the largest nodes until at most half of the
+    // memory budget is used.
+    void SpillPoints();
+
+    void SpillNode(Node* node);
+
+    // Appends the spilled points of a node to @p points.
+    void ReadSpilled(const Node* node, std::vector<PointRecord>* points) const;
+
+    // Removes and returns all points of a node, spilled or not.
+    std::vector<PointRecord> TakePoints(Node* node);
+
+    int max_leaf_points_;
+    int64_t max_memory_points_;
+    std::unique_ptr<Node> root_;
+    int64_t num_points_;
+
+    // Number of points held in memory.
+    int64_t num_memory_points_;
+
+    QString temp_dirname_;
+    std::unique_ptr<QTemporaryFile> spill_file_;
+    int64_t spill_size_;
+};
+
+/**
+ * Read-only access to a point cloud octree file written by
+ * PointCloudOctreeBuilder.
+ *
+ * The file is memory mapped, so opening even a very large octree is cheap,
+ * and NodePoints() only touches the disk when the returned points are read.
+ * Once opened, a PointCloudOctree can be read from multiple threads.
+ *
+ * @ingroup sv_resources
+ * @headerfile sceneview/point_cloud_octree.hpp
+ */
+class PointCloudOctree {
+  public:
+    /**
+     * Number of grid cells along each axis of a node used for subsampling.
+     */
+    static const int kGridSize = 128;
+
+    /**
+     * Octree node.
+     */
+    struct Node {
+      /**
+       * Tight bounding box of the points in the node and its descendants.
+       */
+      AxisAlignedBox bounds;
+
+      /**
+       * Minimum distance between the points of this node, along each axis.
+       */
+      float spacing;
+
+      int depth;
+
+      /**
+       * Index of the parent node, or -1 for the root.
+       */
+      int parent;
+
+      /**
+       * Indices of the child nodes, or -1 for missing children.
+       */
+      int children[8];
+
+      int num_points;
+      uint64_t offset;
+    };
+
+    typedef std::shared_ptr<PointCloudOctree> Ptr;
+
+    /**
+     * Opens an octree file.
+     *
+     * @throw std::runtime_error if the file can't be opened, or isn't a valid
+     * octree file.
+     */
+    explicit PointCloudOctree(const QString& filename);
+
+    ~PointCloudOctree();
+
+    PointCloudOctree(const PointCloudOctree&) = delete;
+    PointCloudOctree& operator=(const PointCloudOctree&) = delete;
+
+    /**
+     * Retrieve all nodes, parents before children. The root is node 0.
+     */
+    const std::vector<Node>& Nodes() const { return nodes_; }
+
+    /**
+     * Retrieve the points of the specified node.
+     */
+    const PointRecord* NodePoints(int node_ind) const;
+
+    /**
+     * Retrieve the total number of points in the octree.
+     */
+    int64_t NumPoints() const { return num_points_; }
+
+  private:
+    QFile file_;
+    const uint8_t* data_;
+    std::vector<Node> nodes_;
+    int64_t num_points_;
+};
+
+}  // namespace sv
+
+#endif  // SCENEVIEW_POINT_CLOUD_OCTREE_HPP__
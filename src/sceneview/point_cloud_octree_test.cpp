@@ -0,0 +1,170 @@
+// Copyright [2015] Albert Huang
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "sceneview/point_cloud_octree.hpp"
+
+using sv::AxisAlignedBox;
+using sv::PointCloudOctree;
+using sv::PointCloudOctreeBuilder;
+using sv::PointRecord;
+
+static const char* kFilename = "point_cloud_octree_test.svpc";
+
+static std::vector<PointRecord> RandomPoints(int num_points, float min,
+    float max, int seed) {
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<float> dist(min, max);
+  std::vector<PointRecord> points(num_points);
+  for (PointRecord& point : points) {
+    point.x = dist(rng);
+    point.y = dist(rng);
+    point.z = dist(rng);
+    point.r = rng() % 256;
+    point.g = rng() % 256;
+    point.b = rng() % 256;
+    point.a = 255;
+  }
+  return points;
+}
+
+static bool Contains(const AxisAlignedBox& box, const PointRecord& point) {
+  return point.x >= box.Min().x() && point.x <= box.Max().x() &&
+    point.y >= box.Min().y() && point.y <= box.Max().y() &&
+    point.z >= box.Min().z() && point.z <= box.Max().z();
+}
+
+// Checks the structure of the octree, and returns the total number of points
+// in the nodes.
+static int64_t CheckOctree(const PointCloudOctree& octree) {
+  const std::vector<PointCloudOctree::Node>& nodes = octree.Nodes();
+  int64_t num_points = 0;
+  for (size_t node_ind = 0; node_ind < nodes.size(); ++node_ind) {
+    const PointCloudOctree::Node& node = nodes[node_ind];
+    if (node_ind == 0) {
+      EXPECT_EQ(-1, node.parent);
+      EXPECT_EQ(0, node.depth);
+    } else {
+      EXPECT_LT(node.parent, static_cast<int>(node_ind));
+      const PointCloudOctree::Node& parent = nodes[node.parent];
+      EXPECT_EQ(parent.depth + 1, node.depth);
+      EXPECT_FLOAT_EQ(parent.spacing / 2, node.spacing);
+    }
+
+    const PointRecord* points = octree.NodePoints(node_ind);
+    for (int point_ind = 0; point_ind < node.num_points; ++point_ind) {
+      EXPECT_TRUE(Contains(node.bounds, points[point_ind]));
+    }
+    num_points += node.num_points;
+
+    for (int child : node.children) {
+      if (child >= 0) {
+        EXPECT_EQ(static_cast<int>(node_ind), nodes[child].parent);
+      }
+    }
+  }
+  return num_points;
+}
+
+TEST(PointCloudOctree, BuildAndLoad) {
+  const std::vector<PointRecord> points = RandomPoints(50000, -10, 10, 1);
+  PointCloudOctreeBuilder builder(1000);
+  builder.AddPoints(points.data(), 20000);
+  builder.AddPoints(points.data() + 20000, 30000);
+  EXPECT_EQ(50000, builder.NumPoints());
+  builder.Save(kFilename);
+
+  {
+    PointCloudOctree octree(kFilename);
+    EXPECT_EQ(50000, octree.NumPoints());
+    EXPECT_GT(octree.Nodes().size(), 1u);
+    EXPECT_EQ(50000, CheckOctree(octree));
+
+    // The root is a subsample, and doesn't hold everything.
+    EXPECT_GT(octree.Nodes()[0].num_points, 0);
+    EXPECT_LT(octree.Nodes()[0].num_points, 50000);
+  }
+  std::remove(kFilename);
+}
+
+TEST(PointCloudOctree, GrowRoot) {
+  PointCloudOctreeBuilder builder(100);
+  const std::vector<PointRecord> first = RandomPoints(1000, 0, 1, 2);
+  const std::vector<PointRecord> second = RandomPoints(1000, -20, 5, 3);
+  builder.AddPoints(first.data(), first.size());
+  builder.AddPoints(second.data(), second.size());
+  builder.Save(kFilename);
+
+  {
+    PointCloudOctree octree(kFilename);
+    EXPECT_EQ(2000, octree.NumPoints());
+    EXPECT_EQ(2000, CheckOctree(octree));
+    const AxisAlignedBox& bounds = octree.Nodes()[0].bounds;
+    for (const PointRecord& point : first) {
+      EXPECT_TRUE(Contains(bounds, point));
+    }
+    for (const PointRecord& point : second) {
+      EXPECT_TRUE(Contains(bounds, point));
+    }
+
+    // The new root holds a subsample of the old one.
+    EXPECT_GT(octree.Nodes()[0].num_points, 0);
+  }
+  std::remove(kFilename);
+}
+
+TEST(PointCloudOctree, SpillToDisk) {
+  const std::vector<PointRecord> points = RandomPoints(50000, -10, 10, 4);
+  PointCloudOctreeBuilder in_memory(1000);
+  in_memory.AddPoints(points.data(), 20000);
+  in_memory.AddPoints(points.data() + 20000, 30000);
+  in_memory.Save(kFilename);
+  std::vector<int> node_points;
+  {
+    PointCloudOctree octree(kFilename);
+    for (const PointCloudOctree::Node& node : octree.Nodes()) {
+      node_points.push_back(node.num_points);
+    }
+  }
+
+  // Spilling doesn't change the structure of the octree.
+  PointCloudOctreeBuilder spilled(1000, 2000);
+  spilled.AddPoints(points.data(), 20000);
+  spilled.AddPoints(points.data() + 20000, 30000);
+  spilled.Save(kFilename);
+  {
+    PointCloudOctree octree(kFilename);
+    EXPECT_EQ(50000, CheckOctree(octree));
+    ASSERT_EQ(node_points.size(), octree.Nodes().size());
+    for (size_t node_ind = 0; node_ind < node_points.size(); ++node_ind) {
+      EXPECT_EQ(node_points[node_ind], octree.Nodes()[node_ind].num_points);
+    }
+  }
+  std::remove(kFilename);
+}
+
+TEST(PointCloudOctree, CoincidentPoints) {
+  std::vector<PointRecord> points(5000);
+  for (PointRecord& point : points) {
+    point.x = 1;
+    point.y = 2;
+    point.z = 3;
+  }
+  PointCloudOctreeBuilder builder(100);
+  builder.AddPoints(points.data(), points.size());
+  builder.Save(kFilename);
+  {
+    PointCloudOctree octree(kFilename);
+    EXPECT_EQ(5000, CheckOctree(octree));
+  }
+  std::remove(kFilename);
+}
+
+TEST(PointCloudOctree, InvalidFile) {
+  EXPECT_THROW(PointCloudOctree("no_such_file.svpc"), std::runtime_error);
+}
@@ -0,0 +1,974 @@
+// Copyright [2015] Albert Huang
+
+#include "sceneview/internal_gl.hpp"
+
+#include "sceneview/point_cloud_reader.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+
+#include <QByteArray>
+#include <QFile>
+#include <QFileInfo>
+
+#include "sceneview/thread_pool.hpp"
+
+#if 0
+#define dbg(fmt, ...) printf(fmt, __VA_ARGS__)
+#else
+#define dbg(...)
+#endif
+
+namespace sv {
+
+namespace {
+
+// Files are split into chunks of about this many bytes, parsed in parallel.
+const int64_t kChunkBytes = 1 << 22;
+
+// Powers of ten that are exactly representable as doubles.
+const double kExactPowersOf10[] = {
+  1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12,
+  1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+enum class FieldType {
+  kInt8,
+  kUint8,
+  kInt16,
+  kUint16,
+  kInt32,
+  kUint32,
+  kFloat32,
+  kFloat64
+};
+
+enum class Encoding {
+  kAscii,
+  kBinaryLittleEndian,
+  kBinaryBigEndian
+};
+
+struct Field {
+  std::string name;
+  FieldType type;
+
+  // Byte offset in a binary record.
+  int offset;
+
+  // Index of the first value in an ASCII line.
+  int column;
+};
+
+// Where the points are in a file, and how they are encoded.
+struct Layout {
+  Layout() :
+    encoding(Encoding::kAscii),
+    record_size(0),
+    num_columns(0),
+    num_points(0),
+    data_begin(0),
+    data_end(0) {}
+
+  std::vector<Field> fields;
+  Encoding encoding;
+  int record_size;
+  int num_columns;
+  int64_t num_points;
+  size_t data_begin;
+  size_t data_end;
+};
+
+// The values of a point that are kept.
+enum Role {
+  kX,
+  kY,
+  kZ,
+  kNormalX,
+  kNormalY,
+  kNormalZ,
+  kRed,
+  kGreen,
+  kBlue,
+  kAlpha,
+  kPackedColor,
+  kScalar,
+  kNumRoles
+};
+
+int FieldSize(FieldType type) {
+  switch (type) {
+    case FieldType::kInt8:
+    case FieldType::kUint8:
+      return 1;
+    case FieldType::kInt16:
+    case FieldType::kUint16:
+      return 2;
+    case FieldType::kInt32:
+    case FieldType::kUint32:
+    case FieldType::kFloat32:
+      return 4;
+    case FieldType::kFloat64:
+      return 8;
+  }
+  return 0;
+}
+
+template <typename T>
+T LoadRaw(const char* src, bool swap) {
+  char bytes[sizeof(T)];
+  if (swap) {
+    std::reverse_copy(src, src + sizeof(T), bytes);
+  } else {
+    std::memcpy(bytes, src, sizeof(T));
+  }
+  T value;
+  std::memcpy(&value, bytes, sizeof(T));
+  return value;
+}
+
+double LoadValue(const char* src, FieldType type, bool swap) {
+  switch (type) {
+    case FieldType::kInt8:
+      return LoadRaw<int8_t>(src, swap);
+    case FieldType::kUint8:
+      return LoadRaw<uint8_t>(src, swap);
+    case FieldType::kInt16:
+      return LoadRaw<int16_t>(src, swap);
+    case FieldType::kUint16:
+      return LoadRaw<uint16_t>(src, swap);
+    case FieldType::kInt32:
+      return LoadRaw<int32_t>(src, swap);
+    case FieldType::kUint32:
+      return LoadRaw<uint32_t>(src, swap);
+    case FieldType::kFloat32:
+      return LoadRaw<float>(src, swap);
+    case FieldType::kFloat64:
+      return LoadRaw<double>(src, swap);
+  }
+  return 0;
+}
+
+// Scales integer color components to [0, 1]. Float components are assumed
+// to be in [0, 1] already.
+float NormalizeColor(double value, FieldType type) {
+  switch (type) {
+    case FieldType::kInt16:
+    case FieldType::kUint16:
+      return value / 65535;
+    case FieldType::kFloat32:
+    case FieldType::kFloat64:
+      return value;
+    default:
+      return value / 255;
+  }
+}
+
+bool IsDigit(char c) {
+  return c >= '0' && c <= '9';
+}
+
+bool IsSeparator(char c) {
+  return c == ' ' || c == '\t' || c == ',' || c == '\r' || c == '\n';
+}
+
+// Parses a number with strtod(), for what ParseNumber() doesn't handle
+// itself: nan, inf, and numbers that need more than 53 bits or large
+// exponents.
+double SlowParseNumber(const char* begin, const char** end) {
+  char buf[64];
+  const char* token_end = begin;
+  while (token_end < *end && !IsSeparator(*token_end) &&
+      token_end - begin < static_cast<int>(sizeof(buf)) - 1) {
+    ++token_end;
+  }
+  const int length = token_end - begin;
+  std::memcpy(buf, begin, length);
+  buf[length] = 0;
+  char* parsed_end;
+  const double value = std::strtod(buf, &parsed_end);
+  if (parsed_end != buf + length) {
+    throw std::runtime_error("Invalid number: " + std::string(buf));
+  }
+  *end = token_end;
+  return value;
+}
+
+// Parses the number after any separators at *pos, and moves *pos past it.
+// Returns false if the line ends first.
+//
+// Decimal numbers with up to 19 significant digits and small exponents are
+// converted exactly as strtod() would, with one multiplication or division
+// by an exact power of ten, and without depending on the locale.
+bool ParseNumber(const char** pos, const char* end, double* value) {
+  const char* ptr = *pos;
+  while (ptr < end && IsSeparator(*ptr) && *ptr != '\n') {
+    ++ptr;
+  }
+  if (ptr == end || *ptr == '\n') {
+    *pos = ptr;
+    return false;
+  }
+
+  const char* begin = ptr;
+  const bool negative = *ptr == '-';
+  if (*ptr == '-' || *ptr == '+') {
+    ++ptr;
+  }
+  uint64_t mantissa = 0;
+  int num_digits = 0;
+  int exponent = 0;
+  bool has_digits = false;
+  for (; ptr < end && IsDigit(*ptr); ++ptr) {
+    has_digits = true;
+    if (num_digits < 19) {
+      mantissa = 10 * mantissa + (*ptr - '0');
+      num_digits += mantissa != 0;
+    } else {
+      ++exponent;
+    }
+  }
+  if (ptr < end && *ptr == '.') {
+    for (++ptr; ptr < end && IsDigit(*ptr); ++ptr) {
+      has_digits = true;
+      if (num_digits < 19) {
+        mantissa = 10 * mantissa + (*ptr - '0');
+        num_digits += mantissa != 0;
+        --exponent;
+      }
+    }
+  }
+  if (has_digits && ptr < end && (*ptr == 'e' || *ptr == 'E')) {
+    const char* exponent_begin = ptr++;
+    const bool negative_exponent = ptr < end && *ptr == '-';
+    if (ptr < end && (*ptr == '-' || *ptr == '+')) {
+      ++ptr;
+    }
+    int exponent_value = 0;
+    bool has_exponent_digits = false;
+    for (; ptr < end && IsDigit(*ptr); ++ptr) {
+      has_exponent_digits = true;
+      exponent_value = std::min(10 * exponent_value + (*ptr - '0'), 100000);
+    }
+    if (has_exponent_digits) {
+      exponent += negative_exponent ? -exponent_value : exponent_value;
+    } else {
+      ptr = exponent_begin;
+    }
+  }
+
+  if (!has_digits || (ptr < end && !IsSeparator(*ptr)) ||
+      mantissa > (1ull << 53) || exponent < -22 || exponent > 22) {
+    *pos = end;
+    *value = SlowParseNumber(begin, pos);
+    return true;
+  }
+  double result = mantissa;
+  if (exponent < 0) {
+    result /= kExactPowersOf10[-exponent];
+  } else {
+    result *= kExactPowersOf10[exponent];
+  }
+  *value = negative ? -result : result;
+  *pos = ptr;
+  return true;
+}
+
+// Returns the position after the end of the line at pos.
+size_t SkipLine(const char* data, size_t size, size_t pos) {
+  const void* newline = std::memchr(data + pos, '\n', size - pos);
+  return newline ?
+    static_cast<const char*>(newline) - data + 1 : size;
+}
+
+size_t SkipLines(const char* data, size_t size, size_t pos,
+    int64_t num_lines) {
+  for (int64_t line = 0; line < num_lines && pos < size; ++line) {
+    pos = SkipLine(data, size, pos);
+  }
+  return pos;
+}
+
+// Reads a header line, without its line ending.
+std::string ReadLine(const char* data, size_t size, size_t* pos) {
+  const size_t begin = *pos;
+  *pos = SkipLine(data, size, begin);
+  size_t end = *pos;
+  while (end > begin && (data[end - 1] == '\n' || data[end - 1] == '\r')) {
+    --end;
+  }
+  return std::string(data + begin, end - begin);
+}
+
+void AddField(Layout* layout, const std::string& name, FieldType type,
+    int count) {
+  layout->fields.push_back(
+      Field { name, type, layout->record_size, layout->num_columns });
+  layout->record_size += FieldSize(type) * count;
+  layout->num_columns += count;
+}
+
+FieldType PlyType(const std::string& name) {
+  if (name == "char" || name == "int8") {
+    return FieldType::kInt8;
+  } else if (name == "uchar" || name == "uint8") {
+    return FieldType::kUint8;
+  } else if (name == "short" || name == "int16") {
+    return FieldType::kInt16;
+  } else if (name == "ushort" || name == "uint16") {
+    return FieldType::kUint16;
+  } else if (name == "int" || name == "int32") {
+    return FieldType::kInt32;
+  } else if (name == "uint" || name == "uint32") {
+    return FieldType::kUint32;
+  } else if (name == "float" || name == "float32") {
+    return FieldType::kFloat32;
+  } else if (name == "double" || name == "float64") {
+    return FieldType::kFloat64;
+  }
+  throw std::runtime_error("Unknown PLY property type " + name);
+}
+
+Layout ParsePlyHeader(const char* data, size_t size) {
+  Layout layout;
+  size_t pos = 0;
+  if (ReadLine(data, size, &pos) != "ply") {
+    throw std::runtime_error("Not a PLY file");
+  }
+
+  // Elements before the vertices are skipped, and elements after them are
+  // ignored.
+  bool in_vertex = false;
+  bool seen_vertex = false;
+  bool vertex_last = true;
+  bool variable_size_before = false;
+  int64_t element_count = 0;
+  int64_t lines_before = 0;
+  size_t bytes_before = 0;
+  while (true) {
+    if (pos >= size) {
+      throw std::runtime_error("PLY header has no end_header");
+    }
+    std::istringstream tokens(ReadLine(data, size, &pos));
+    std::string keyword;
+    tokens >> keyword;
+    if (keyword == "end_header") {
+      break;
+    } else if (keyword == "format") {
+      std::string format;
+      tokens >> format;
+      if (format == "ascii") {
+        layout.encoding = Encoding::kAscii;
+      } else if (format == "binary_little_endian") {
+        layout.encoding = Encoding::kBinaryLittleEndian;
+      } else if (format == "binary_big_endian") {
+        layout.encoding = Encoding::kBinaryBigEndian;
+      } else {
+        throw std::runtime_error("Unknown PLY format " + format);
+      }
+    } else if (keyword == "element") {
+      std::string name;
+      tokens >> name >> element_count;
+      if (seen_vertex && element_count > 0) {
+        vertex_last = false;
+      }
+      in_vertex = name == "vertex";
+      if (in_vertex) {
+        seen_vertex = true;
+        layout.num_points = element_count;
+      } else if (!seen_vertex) {
+        lines_before += element_count;
+      }
+    } else if (keyword == "property") {
+      std::string type;
+      std::string name;
+      tokens >> type;
+      if (type == "list") {
+        if (in_vertex) {
+          throw std::runtime_error("PLY vertex lists are not supported");
+        }
+        variable_size_before |= !seen_vertex && element_count > 0;
+        continue;
+      }
+      tokens >> name;
+      if (in_vertex) {
+        AddField(&layout, name, PlyType(type), 1);
+      } else if (!seen_vertex) {
+        bytes_before += FieldSize(PlyType(type)) * element_count;
+      }
+    }
+  }
+  if (!seen_vertex) {
+    throw std::runtime_error("PLY file has no vertex element");
+  }
+
+  if (layout.encoding == Encoding::kAscii) {
+    layout.data_begin = SkipLines(data, size, pos, lines_before);
+    layout.data_end = vertex_last ? size :
+      SkipLines(data, size, layout.data_begin, layout.num_points);
+  } else {
+    if (variable_size_before) {
+      throw std::runtime_error(
+          "Binary PLY lists before the vertices are not supported");
+    }
+    layout.data_begin = pos + bytes_before;
+    layout.data_end = layout.data_begin +
+      layout.num_points * layout.record_size;
+  }
+  return layout;
+}
+
+Layout ParsePcdHeader(const char* data, size_t size) {
+  Layout layout;
+  std::vector<std::string> names;
+  std::vector<int> sizes;
+  std::vector<char> types;
+  std::vector<int> counts;
+  int64_t width = 0;
+  int64_t height = 1;
+  int64_t num_points = -1;
+  size_t pos = 0;
+  while (true) {
+    if (pos >= size) {
+      throw std::runtime_error("PCD header has no DATA line");
+    }
+    std::istringstream tokens(ReadLine(data, size, &pos));
+    std::string keyword;
+    tokens >> keyword;
+    if (keyword == "FIELDS") {
+      std::string name;
+      while (tokens >> name) {
+        names.push_back(name);
+      }
+    } else if (keyword == "SIZE") {
+      int value;
+      while (tokens >> value) {
+        sizes.push_back(value);
+      }
+    } else if (keyword == "TYPE") {
+      char value;
+      while (tokens >> value) {
+        types.push_back(value);
+      }
+    } else if (keyword == "COUNT") {
+      int value;
+      while (tokens >> value) {
+        counts.push_back(value);
+      }
+    } else if (keyword == "WIDTH") {
+      tokens >> width;
+    } else if (keyword == "HEIGHT") {
+      tokens >> height;
+    } else if (keyword == "POINTS") {
+      tokens >> num_points;
+    } else if (keyword == "DATA") {
+      std::string format;
+      tokens >> format;
+      if (format == "ascii") {
+        layout.encoding = Encoding::kAscii;
+      } else if (format == "binary") {
+        layout.encoding = Encoding::kBinaryLittleEndian;
+      } else {
+        throw std::runtime_error("Unsupported PCD data format " + format);
+      }
+      break;
+    }
+  }
+
+  counts.resize(names.size(), 1);
+  if (sizes.size() != names.size() || types.size() != names.size()) {
+    throw std::runtime_error("PCD header has mismatched FIELDS, SIZE, TYPE");
+  }
+  for (size_t field = 0; field < names.size(); ++field) {
+    const int key = types[field] * 16 + sizes[field];
+    FieldType type;
+    if (key == 'I' * 16 + 1) {
+      type = FieldType::kInt8;
+    } else if (key == 'U' * 16 + 1) {
+      type = FieldType::kUint8;
+    } else if (key == 'I' * 16 + 2) {
+      type = FieldType::kInt16;
+    } else if (key == 'U' * 16 + 2) {
+      type = FieldType::kUint16;
+    } else if (key == 'I' * 16 + 4) {
+      type = FieldType::kInt32;
+    } else if (key == 'U' * 16 + 4) {
+      type = FieldType::kUint32;
+    } else if (key == 'F' * 16 + 4) {
+      type = FieldType::kFloat32;
+    } else if (key == 'F' * 16 + 8) {
+      type = FieldType::kFloat64;
+    } else {
+      throw std::runtime_error("Unsupported PCD type of field " +
+          names[field]);
+    }
+    AddField(&layout, names[field], type, counts[field]);
+  }
+
+  layout.num_points = num_points >= 0 ? num_points : width * height;
+  layout.data_begin = pos;
+  layout.data_end = layout.encoding == Encoding::kAscii ? size :
+    pos + layout.num_points * layout.record_size;
+  return layout;
+}
+
+Layout ParseXyzHeader(const char* data, size_t size) {
+  Layout layout;
+  size_t pos = 0;
+  int num_columns = 0;
+  while (pos < size && num_columns == 0) {
+    const size_t line_begin = pos;
+    const std::string line = ReadLine(data, size, &pos);
+    if (line.find('#') == 0) {
+      continue;
+    }
+    const char* ptr = line.data();
+    double value;
+    while (ParseNumber(&ptr, line.data() + line.size(), &value)) {
+      ++num_columns;
+    }
+    // A single value is the point count of a .pts file.
+    if (num_columns == 1) {
+      num_columns = 0;
+    } else {
+      pos = line_begin;
+    }
+  }
+
+  const FieldType kFloat = FieldType::kFloat64;
+  const FieldType kColor = FieldType::kUint8;
+  AddField(&layout, "x", kFloat, 1);
+  AddField(&layout, "y", kFloat, 1);
+  AddField(&layout, "z", kFloat, 1);
+  if (num_columns == 4 || num_columns == 7) {
+    AddField(&layout, "intensity", kFloat, 1);
+  }
+  if (num_columns == 6 || num_columns == 7) {
+    AddField(&layout, "red", kColor, 1);
+    AddField(&layout, "green", kColor, 1);
+    AddField(&layout, "blue", kColor, 1);
+  }
+  layout.num_points = -1;
+  layout.data_begin = pos;
+  layout.data_end = size;
+  return layout;
+}
+
+// Converts points from the fields of a file to the arrays of a
+// PointCloudData.
+class PointDecoder {
+  public:
+    PointDecoder(const Layout& layout, const std::string& scalar_field,
+        PointCloudData* cloud);
+
+    // Resizes the arrays of the cloud for up to num_points points.
+    void Allocate(int64_t num_points);
+
+    // Decodes count binary records to the points starting at first, and
+    // returns the number of valid points.
+    int64_t DecodeBinary(const char* records, int64_t count,
+        int64_t first) const;
+
+    // Decodes the lines in [begin, end) to the points starting at first,
+    // and returns the number of valid points.
+    int64_t DecodeAscii(const char* begin, const char* end,
+        int64_t first) const;
+
+    // Moves count points from index from to index to, with to <= from.
+    void Move(int64_t from, int64_t to, int64_t count);
+
+    // Shrinks the arrays of the cloud to num_points points.
+    void Finish(int64_t num_points);
+
+  private:
+    // Writes a point from the values of its roles. Returns false if its
+    // position isn't valid.
+    bool Write(const double* values, int64_t point) const;
+
+    const Layout& layout_;
+    PointCloudData* cloud_;
+    const Field* sources_[kNumRoles];
+    bool has_alpha_;
+    int num_columns_;
+
+    float* vertices_;
+    float* normals_;
+    float* colors_;
+    float* scalars_;
+};
+
+PointDecoder::PointDecoder(const Layout& layout,
+    const std::string& scalar_field, PointCloudData* cloud) :
+  layout_(layout),
+  cloud_(cloud),
+  has_alpha_(false),
+  num_columns_(0),
+  vertices_(nullptr),
+  normals_(nullptr),
+  colors_(nullptr),
+  scalars_(nullptr) {
+  std::fill(sources_, sources_ + kNumRoles, nullptr);
+  const Field* other = nullptr;
+  for (const Field& field : layout.fields) {
+    const std::string& name = field.name;
+    int role = -1;
+    if (name == "x" || name == "y" || name == "z") {
+      role = kX + name[0] - 'x';
+    } else if (name == "nx" || name == "ny" || name == "nz") {
+      role = kNormalX + name[1] - 'x';
+    } else if (name == "normal_x" || name == "normal_y" ||
+        name == "normal_z") {
+      role = kNormalX + name[7] - 'x';
+    } else if (name == "red" || name == "r" || name == "diffuse_red") {
+      role = kRed;
+    } else if (name == "green" || name == "g" || name == "diffuse_green") {
+      role = kGreen;
+    } else if (name == "blue" || name == "b" || name == "diffuse_blue") {
+      role = kBlue;
+    } else if (name == "alpha" || name == "a") {
+      role = kAlpha;
+    } else if (name == "rgb" || name == "rgba") {
+      role = kPackedColor;
+      has_alpha_ = name == "rgba";
+    } else if (name != "_" && !other) {
+      other = &field;
+    }
+    if (role >= 0) {
+      sources_[role] = &field;
+    }
+    if (name == scalar_field ||
+        (scalar_field.empty() && name == "intensity")) {
+      sources_[kScalar] = &field;
+    }
+  }
+
+  if (!sources_[kX] || !sources_[kY] || !sources_[kZ]) {
+    throw std::runtime_error("Point cloud has no x, y and z fields");
+  }
+  if (!sources_[kNormalX] || !sources_[kNormalY] || !sources_[kNormalZ]) {
+    sources_[kNormalX] = sources_[kNormalY] = sources_[kNormalZ] = nullptr;
+  }
+  if (!sources_[kRed] || !sources_[kGreen] || !sources_[kBlue]) {
+    sources_[kRed] = sources_[kGreen] = sources_[kBlue] = nullptr;
+    sources_[kAlpha] = nullptr;
+  }
+  if (!sources_[kScalar]) {
+    if (!scalar_field.empty()) {
+      throw std::runtime_error("Point cloud has no field " + scalar_field);
+    }
+    sources_[kScalar] = other;
+  }
+  cloud_->scalar_field = sources_[kScalar] ? sources_[kScalar]->name : "";
+
+  for (const Field* source : sources_) {
+    if (source) {
+      num_columns_ = std::max(num_columns_, source->column + 1);
+    }
+  }
+}
+
+void PointDecoder::Allocate(int64_t num_points) {
+  cloud_->vertices.resize(3 * num_points);
+  vertices_ = cloud_->vertices.data();
+  if (sources_[kNormalX]) {
+    cloud_->normals.resize(3 * num_points);
+    normals_ = cloud_->normals.data();
+  }
+  if (sources_[kRed] || sources_[kPackedColor]) {
+    cloud_->colors.resize(4 * num_points);
+    colors_ = cloud_->colors.data();
+  }
+  if (sources_[kScalar]) {
+    cloud_->scalars.resize(num_points);
+    scalars_ = cloud_->scalars.data();
+  }
+}
+
+int64_t PointDecoder::DecodeBinary(const char* records, int64_t count,
+    int64_t first) const {
+  const bool swap = layout_.encoding == Encoding::kBinaryBigEndian;
+  const Field* packed = sources_[kPackedColor];
+  double values[kNumRoles];
+  int64_t num_valid = 0;
+  for (int64_t ind = 0; ind < count; ++ind) {
+    const char* record = records + ind * layout_.record_size;
+    for (int role = 0; role < kNumRoles; ++role) {
+      const Field* source = sources_[role];
+      if (source && role != kPackedColor) {
+        values[role] = LoadValue(record + source->offset, source->type,
+            swap);
+      }
+    }
+    if (packed) {
+      values[kPackedColor] =
+        LoadRaw<uint32_t>(record + packed->offset, swap);
+    }
+    num_valid += Write(values, first + num_valid);
+  }
+  return num_valid;
+}
+
+int64_t PointDecoder::DecodeAscii(const char* begin, const char* end,
+    int64_t first) const {
+  const Field* packed = sources_[kPackedColor];
+  std::vector<double> columns(num_columns_);
+  double values[kNumRoles];
+  int64_t num_valid = 0;
+  const char* line = begin;
+  while (line < end) {
+    const char* line_begin = line;
+    const char* ptr = line;
+    int num_parsed = 0;
+    while (ptr < end && (*ptr == ' ' || *ptr == '\t')) {
+      ++ptr;
+    }
+    if (ptr == end || *ptr != '#') {
+      while (num_parsed < num_columns_ &&
+          ParseNumber(&ptr, end, &columns[num_parsed])) {
+        ++num_parsed;
+      }
+    }
+    const void* newline = std::memchr(ptr, '\n', end - ptr);
+    line = newline ? static_cast<const char*>(newline) + 1 : end;
+    if (num_parsed == 0) {
+      continue;
+    } else if (num_parsed < num_columns_) {
+      throw std::runtime_error("Point with too few values: " +
+          std::string(line_begin, ptr));
+    }
+
+    for (int role = 0; role < kNumRoles; ++role) {
+      const Field* source = sources_[role];
+      if (source) {
+        values[role] = columns[source->column];
+      }
+    }
+    // Packed colors are written as the float with the same bits, or as an
+    // integer.
+    if (packed && packed->type == FieldType::kFloat32) {
+      const float value = values[kPackedColor];
+      uint32_t bits;
+      std::memcpy(&bits, &value, sizeof(bits));
+      values[kPackedColor] = bits;
+    }
+    num_valid += Write(values, first + num_valid);
+  }
+  return num_valid;
+}
+
+bool PointDecoder::Write(const double* values, int64_t point) const {
+  if (!std::isfinite(values[kX]) || !std::isfinite(values[kY]) ||
+      !std::isfinite(values[kZ])) {
+    return false;
+  }
+  float* vertex = vertices_ + 3 * point;
+  vertex[0] = values[kX];
+  vertex[1] = values[kY];
+  vertex[2] = values[kZ];
+  if (normals_) {
+    float* normal = normals_ + 3 * point;
+    normal[0] = values[kNormalX];
+    normal[1] = values[kNormalY];
+    normal[2] = values[kNormalZ];
+  }
+  if (colors_) {
+    float* color = colors_ + 4 * point;
+    if (sources_[kRed]) {
+      for (int component = 0; component < 3; ++component) {
+        color[component] = NormalizeColor(values[kRed + component],
+            sources_[kRed + component]->type);
+      }
+      color[3] = sources_[kAlpha] ?
+        NormalizeColor(values[kAlpha], sources_[kAlpha]->type) : 1;
+    } else {
+      const uint32_t bits = values[kPackedColor];
+      color[0] = ((bits >> 16) & 0xFF) / 255.0f;
+      color[1] = ((bits >> 8) & 0xFF) / 255.0f;
+      color[2] = (bits & 0xFF) / 255.0f;
+      color[3] = has_alpha_ ? (bits >> 24) / 255.0f : 1;
+    }
+  }
+  if (scalars_) {
+    scalars_[point] = values[kScalar];
+  }
+  return true;
+}
+
+void PointDecoder::Move(int64_t from, int64_t to, int64_t count) {
+  if (from == to || count == 0) {
+    return;
+  }
+  std::memmove(vertices_ + 3 * to, vertices_ + 3 * from,
+      3 * count * sizeof(float));
+  if (normals_) {
+    std::memmove(normals_ + 3 * to, normals_ + 3 * from,
+        3 * count * sizeof(float));
+  }
+  if (colors_) {
+    std::memmove(colors_ + 4 * to, colors_ + 4 * from,
+        4 * count * sizeof(float));
+  }
+  if (scalars_) {
+    std::memmove(scalars_ + to, scalars_ + from, count * sizeof(float));
+  }
+}
+
+void PointDecoder::Finish(int64_t num_points) {
+  cloud_->vertices.resize(3 * num_points);
+  if (normals_) {
+    cloud_->normals.resize(3 * num_points);
+  }
+  if (colors_) {
+    cloud_->colors.resize(4 * num_points);
+  }
+  if (scalars_) {
+    cloud_->scalars.resize(num_points);
+  }
+}
+
+// A chunk of the points of a file, and where its points are written.
+struct Chunk {
+  size_t begin;
+  size_t end;
+  int64_t first_point;
+  int64_t num_points;
+  int64_t num_valid;
+};
+
+void ReadPoints(const char* data, const Layout& layout,
+    const std::string& scalar_field, PointCloudData* cloud) {
+  PointDecoder decoder(layout, scalar_field, cloud);
+  std::vector<Chunk> chunks;
+  const size_t num_bytes = layout.data_end - layout.data_begin;
+
+  if (layout.encoding == Encoding::kAscii) {
+    // Chunks end at line endings. Each chunk has room for as many points
+    // as it has lines.
+    const int num_chunks = num_bytes / kChunkBytes + 1;
+    size_t begin = layout.data_begin;
+    for (int chunk = 1; chunk <= num_chunks && begin < layout.data_end;
+        ++chunk) {
+      size_t end = layout.data_begin + num_bytes * chunk / num_chunks;
+      end = std::max(end, begin);
+      end = end < layout.data_end ?
+        SkipLine(data, layout.data_end, end) : layout.data_end;
+      chunks.push_back(Chunk { begin, end, 0, 0, 0 });
+      begin = end;
+    }
+    ThreadPool::Default()->ParallelFor(chunks.size(), [&](int chunk_ind) {
+      Chunk& chunk = chunks[chunk_ind];
+      chunk.num_points = std::count(data + chunk.begin, data + chunk.end,
+          '\n') + 1;
+    });
+  } else {
+    const int64_t points_per_chunk =
+      std::max<int64_t>(kChunkBytes / layout.record_size, 1);
+    for (int64_t first = 0; first < layout.num_points;
+        first += points_per_chunk) {
+      const int64_t count =
+        std::min(points_per_chunk, layout.num_points - first);
+      const size_t begin = layout.data_begin + first * layout.record_size;
+      chunks.push_back(Chunk { begin, begin + count * layout.record_size,
+          0, count, 0 });
+    }
+  }
+
+  int64_t num_points = 0;
+  for (Chunk& chunk : chunks) {
+    chunk.first_point = num_points;
+    num_points += chunk.num_points;
+  }
+  decoder.Allocate(num_points);
+  ThreadPool::Default()->ParallelFor(chunks.size(), [&](int chunk_ind) {
+    Chunk& chunk = chunks[chunk_ind];
+    if (layout.encoding == Encoding::kAscii) {
+      chunk.num_valid = decoder.DecodeAscii(data + chunk.begin,
+          data + chunk.end, chunk.first_point);
+    } else {
+      chunk.num_valid = decoder.DecodeBinary(data + chunk.begin,
+          chunk.num_points, chunk.first_point);
+    }
+  });
+
+  // Close the gaps left by blank lines and invalid points.
+  int64_t num_valid = 0;
+  for (const Chunk& chunk : chunks) {
+    decoder.Move(chunk.first_point, num_valid, chunk.num_valid);
+    num_valid += chunk.num_valid;
+  }
+  decoder.Finish(num_valid);
+  dbg("Read %d of %d points\n", static_cast<int>(num_valid),
+      static_cast<int>(num_points));
+}
+
+}  // namespace
+
+GeometryDataView PointCloudData::View() const {
+  GeometryDataView view;
+  const int num_points = NumPoints();
+  view.vertices = StridedSpan(vertices.data(), num_points);
+  if (!normals.empty()) {
+    view.normals = StridedSpan(normals.data(), num_points);
+  }
+  if (!colors.empty()) {
+    view.diffuse = StridedSpan(colors.data(), num_points);
+  }
+  if (!scalars.empty()) {
+    view.scalars = StridedSpan(scalars.data(), num_points);
+  }
+  view.gl_mode = GL_POINTS;
+  return view;
+}
+
+bool ReadPointCloudFile(const QString& fname, PointCloudData* cloud,
+    const std::string& scalar_field) {
+  const QString suffix = QFileInfo(fname).suffix().toLower();
+  if (suffix != "ply" && suffix != "pcd" && suffix != "xyz" &&
+      suffix != "pts") {
+    return false;
+  }
+
+  QFile file(fname);
+  if (!file.open(QIODevice::ReadOnly)) {
+    qDebug("Error opening file %s\n", fname.toStdString().c_str());
+    return false;
+  }
+
+  // Files that can't be mapped, e.g., compressed Qt resources, are read
+  // instead.
+  size_t size = file.size();
+  uchar* mapped = size > 0 ? file.map(0, size) : nullptr;
+  QByteArray contents;
+  const char* data = reinterpret_cast<const char*>(mapped);
+  if (!mapped) {
+    contents = file.readAll();
+    data = contents.constData();
+    size = contents.size();
+  }
+  std::unique_ptr<uchar, std::function<void(uchar*)>> unmap(mapped,
+      [&file](uchar* ptr) { file.unmap(ptr); });
+
+  Layout layout;
+  if (suffix == "ply") {
+    layout = ParsePlyHeader(data, size);
+  } else if (suffix == "pcd") {
+    layout = ParsePcdHeader(data, size);
+  } else {
+    layout = ParseXyzHeader(data, size);
+  }
+  if (layout.data_end > size || layout.data_begin > layout.data_end) {
+    throw std::runtime_error(fname.toStdString() + " is truncated");
+  }
+
+  *cloud = PointCloudData();
+  ReadPoints(data, layout, scalar_field, cloud);
+  return true;
+}
+
+}  // namespace sv
@@ -0,0 +1,96 @@
+// Copyright [2015] Albert Huang
+
+#ifndef SCENEVIEW_POINT_CLOUD_READER_HPP__
+#define SCENEVIEW_POINT_CLOUD_READER_HPP__
+
+#include <string>
+#include <vector>
+
+#include <QString>
+
+#include <sceneview/geometry_resource.hpp>
+
+namespace sv {
+
+/**
+ * Points read from a point cloud file, in system memory.
+ *
+ * Each attribute is a tightly packed float array, ready to be uploaded to
+ * graphics memory without conversion via View():
+ * @code
+ * PointCloudData cloud;
+ * if (ReadPointCloudFile("scan.ply", &cloud)) {
+ *   GeometryResource::Ptr geometry = resources->MakeGeometry();
+ *   geometry->Load(cloud.View());
+ * }
+ * @endcode
+ *
+ * @ingroup sv_resources
+ * @headerfile sceneview/point_cloud_reader.hpp
+ */
+struct PointCloudData {
+  /// XYZ of each point.
+  std::vector<float> vertices;
+
+  /// XYZ normal of each point, or empty if the file has no normals.
+  std::vector<float> normals;
+
+  /// RGBA color of each point, from 0 to 1, or empty if the file has no
+  /// colors.
+  std::vector<float> colors;
+
+  /// Scalar value of each point, or empty if the file has no scalar field.
+  std::vector<float> scalars;
+
+  /// Name of the field that scalars were read from.
+  std::string scalar_field;
+
+  int NumPoints() const { return vertices.size() / 3; }
+
+  /**
+   * Retrieve a view of the points, to be drawn as GL_POINTS. Scalars are
+   * viewed as GeometryDataView::scalars, for the colormap stock shaders.
+   *
+   * The view refers to the arrays of this object, and is invalidated when
+   * they change.
+   */
+  GeometryDataView View() const;
+};
+
+/**
+ * Reads a point cloud file into system memory.
+ *
+ * The following file formats are supported, by file name extension:
+ * - .ply: ASCII and binary PLY. Only the vertex element is read, so meshes
+ *   are read as their vertices.
+ * - .pcd: ASCII and binary PCD. Compressed binary PCD is not supported.
+ * - .xyz and .pts: one point per line, with 3 (XYZ), 4 (XYZ and scalar),
+ *   6 (XYZ and RGB) or 7 (XYZ, scalar and RGB) values. Other columns are
+ *   ignored. A first line with a single value is taken to be a point count
+ *   and skipped.
+ *
+ * Positions, normals (nx, ny, nz or normal_x, ...), colors (red, green,
+ * blue, alpha, or packed rgb and rgba) and one scalar field are read. The
+ * file is memory-mapped, and split into chunks that are parsed in parallel
+ * on the ThreadPool::Default() threads and the calling thread. Points with
+ * non-finite positions, e.g., the invalid points of organized PCD files,
+ * are dropped.
+ *
+ * Doesn't use OpenGL, and can be called from any thread, including the
+ * ThreadPool::Default() threads.
+ *
+ * @param scalar_field the name of the field to read as scalars. If empty,
+ *        the "intensity" field is read if there is one, and otherwise the
+ *        first field that isn't a position, normal or color.
+ *
+ * @return false if the file couldn't be opened, or its extension isn't
+ * supported.
+ * @throw std::runtime_error if the file can't be parsed, or doesn't have
+ * @p scalar_field.
+ */
+bool ReadPointCloudFile(const QString& fname, PointCloudData* cloud,
+    const std::string& scalar_field = std::string());
+
+}  // namespace sv
+
+#endif  // SCENEVIEW_POINT_CLOUD_READER_HPP__
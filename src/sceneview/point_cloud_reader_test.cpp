@@ -0,0 +1,254 @@
+// Copyright [2015] Albert Huang
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "sceneview/point_cloud_reader.hpp"
+
+using sv::PointCloudData;
+using sv::ReadPointCloudFile;
+
+static void WriteFile(const char* filename, const std::string& contents) {
+  FILE* file = fopen(filename, "wb");
+  ASSERT_TRUE(file != nullptr);
+  fwrite(contents.data(), 1, contents.size(), file);
+  fclose(file);
+}
+
+template <typename T>
+static void Append(std::string* contents, T value, bool big_endian = false) {
+  char bytes[sizeof(T)];
+  std::memcpy(bytes, &value, sizeof(T));
+  for (size_t ind = 0; ind < sizeof(T); ++ind) {
+    contents->push_back(bytes[big_endian ? sizeof(T) - 1 - ind : ind]);
+  }
+}
+
+TEST(PointCloudReader, AsciiPly) {
+  const char* kFilename = "point_cloud_reader_test.ply";
+  WriteFile(kFilename,
+      "ply\n"
+      "format ascii 1.0\n"
+      "comment made by hand\n"
+      "element vertex 3\n"
+      "property float x\n"
+      "property float y\n"
+      "property float z\n"
+      "property uchar red\n"
+      "property uchar green\n"
+      "property uchar blue\n"
+      "property float intensity\n"
+      "element face 1\n"
+      "property list uchar int vertex_indices\n"
+      "end_header\n"
+      "0 0 0 255 0 0 0.5\n"
+      "1.5 -2 3e2 0 255 0 0.25\r\n"
+      "-0.125 1e-3 7 0 0 51 1\n"
+      "3 0 1 2\n");
+
+  PointCloudData cloud;
+  ASSERT_TRUE(ReadPointCloudFile(kFilename, &cloud));
+  ASSERT_EQ(3, cloud.NumPoints());
+  EXPECT_TRUE(cloud.normals.empty());
+  EXPECT_EQ("intensity", cloud.scalar_field);
+  const std::vector<float> vertices = { 0, 0, 0, 1.5, -2, 300,
+    -0.125, 0.001f, 7 };
+  EXPECT_EQ(vertices, cloud.vertices);
+  const std::vector<float> colors = { 1, 0, 0, 1, 0, 1, 0, 1, 0, 0, 0.2f,
+    1 };
+  EXPECT_EQ(colors, cloud.colors);
+  const std::vector<float> scalars = { 0.5, 0.25, 1 };
+  EXPECT_EQ(scalars, cloud.scalars);
+  EXPECT_EQ(3, cloud.View().vertices.count);
+  remove(kFilename);
+}
+
+TEST(PointCloudReader, BinaryPly) {
+  // Enough points for several chunks, in both byte orders.
+  const int kNumPoints = 500000;
+  for (bool big_endian : { false, true }) {
+    const char* kFilename = "point_cloud_reader_test.ply";
+    std::string contents = std::string("ply\n") +
+      (big_endian ? "format binary_big_endian 1.0\n" :
+       "format binary_little_endian 1.0\n") +
+      "element camera 1\n"
+      "property int id\n"
+      "element vertex " + std::to_string(kNumPoints) + "\n"
+      "property double x\n"
+      "property float y\n"
+      "property float z\n"
+      "property float nx\n"
+      "property float ny\n"
+      "property float nz\n"
+      "property ushort range\n"
+      "end_header\n";
+    Append<int32_t>(&contents, 7, big_endian);
+    for (int ind = 0; ind < kNumPoints; ++ind) {
+      Append<double>(&contents, ind, big_endian);
+      Append<float>(&contents, -ind, big_endian);
+      Append<float>(&contents, 0.5f * ind, big_endian);
+      Append<float>(&contents, 0, big_endian);
+      Append<float>(&contents, 0, big_endian);
+      Append<float>(&contents, 1, big_endian);
+      Append<uint16_t>(&contents, ind % 1000, big_endian);
+    }
+    WriteFile(kFilename, contents);
+
+    PointCloudData cloud;
+    ASSERT_TRUE(ReadPointCloudFile(kFilename, &cloud));
+    ASSERT_EQ(kNumPoints, cloud.NumPoints());
+    EXPECT_TRUE(cloud.colors.empty());
+    EXPECT_EQ("range", cloud.scalar_field);
+    ASSERT_EQ(3u * kNumPoints, cloud.normals.size());
+    ASSERT_EQ(static_cast<size_t>(kNumPoints), cloud.scalars.size());
+    for (int ind = 0; ind < kNumPoints; ind += 997) {
+      EXPECT_FLOAT_EQ(ind, cloud.vertices[3 * ind]);
+      EXPECT_FLOAT_EQ(-ind, cloud.vertices[3 * ind + 1]);
+      EXPECT_FLOAT_EQ(0.5f * ind, cloud.vertices[3 * ind + 2]);
+      EXPECT_FLOAT_EQ(1, cloud.normals[3 * ind + 2]);
+      EXPECT_FLOAT_EQ(ind % 1000, cloud.scalars[ind]);
+    }
+    remove(kFilename);
+  }
+}
+
+TEST(PointCloudReader, Pcd) {
+  const char* kFilename = "point_cloud_reader_test.pcd";
+  float packed_red;
+  const uint32_t red_bits = 0xFF0000;
+  std::memcpy(&packed_red, &red_bits, sizeof(packed_red));
+  char packed_red_text[64];
+  snprintf(packed_red_text, sizeof(packed_red_text), "%.9g", packed_red);
+
+  // An organized ASCII cloud with an invalid point.
+  WriteFile(kFilename,
+      "# .PCD v0.7 - Point Cloud Data file format\n"
+      "VERSION 0.7\n"
+      "FIELDS x y z rgb\n"
+      "SIZE 4 4 4 4\n"
+      "TYPE F F F F\n"
+      "COUNT 1 1 1 1\n"
+      "WIDTH 2\n"
+      "HEIGHT 2\n"
+      "VIEWPOINT 0 0 0 1 0 0 0\n"
+      "POINTS 4\n"
+      "DATA ascii\n"
+      "1 2 3 " + std::string(packed_red_text) + "\n"
+      "nan nan nan 0\n"
+      "4 5 6 " + std::string(packed_red_text) + "\n"
+      "7 8 9 " + std::string(packed_red_text) + "\n");
+  PointCloudData cloud;
+  ASSERT_TRUE(ReadPointCloudFile(kFilename, &cloud));
+  ASSERT_EQ(3, cloud.NumPoints());
+  const std::vector<float> vertices = { 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+  EXPECT_EQ(vertices, cloud.vertices);
+  ASSERT_EQ(12u, cloud.colors.size());
+  for (int ind = 0; ind < 3; ++ind) {
+    EXPECT_FLOAT_EQ(1, cloud.colors[4 * ind]);
+    EXPECT_FLOAT_EQ(0, cloud.colors[4 * ind + 1]);
+    EXPECT_FLOAT_EQ(1, cloud.colors[4 * ind + 3]);
+  }
+  EXPECT_TRUE(cloud.scalars.empty());
+
+  // A binary cloud with padding, a field with several values, and packed
+  // colors with alpha.
+  std::string contents =
+      "VERSION 0.7\n"
+      "FIELDS x y z _ rgba histogram label\n"
+      "SIZE 4 4 4 1 4 4 2\n"
+      "TYPE F F F U U F U\n"
+      "COUNT 1 1 1 4 1 3 1\n"
+      "WIDTH 2\n"
+      "HEIGHT 1\n"
+      "DATA binary\n";
+  for (int ind = 0; ind < 2; ++ind) {
+    Append<float>(&contents, ind);
+    Append<float>(&contents, 2 * ind);
+    Append<float>(&contents, 3 * ind);
+    Append<uint32_t>(&contents, 0);
+    Append<uint32_t>(&contents, 0x8000FF00);
+    for (int bin = 0; bin < 3; ++bin) {
+      Append<float>(&contents, bin);
+    }
+    Append<uint16_t>(&contents, 10 + ind);
+  }
+  WriteFile(kFilename, contents);
+  ASSERT_TRUE(ReadPointCloudFile(kFilename, &cloud, "label"));
+  ASSERT_EQ(2, cloud.NumPoints());
+  EXPECT_FLOAT_EQ(3, cloud.vertices[5]);
+  EXPECT_FLOAT_EQ(1, cloud.colors[5]);
+  EXPECT_NEAR(0.5, cloud.colors[7], 0.01);
+  const std::vector<float> labels = { 10, 11 };
+  EXPECT_EQ(labels, cloud.scalars);
+  EXPECT_THROW(ReadPointCloudFile(kFilename, &cloud, "intensity"),
+      std::runtime_error);
+  remove(kFilename);
+}
+
+TEST(PointCloudReader, Xyz) {
+  const char* kFilename = "point_cloud_reader_test.xyz";
+  // Many lines, so that the chunks are parsed in parallel.
+  const int kNumPoints = 300000;
+  std::string contents = "# x y z intensity r g b\n";
+  for (int ind = 0; ind < kNumPoints; ++ind) {
+    contents += std::to_string(ind) + ".25 " + std::to_string(-ind) +
+      " 1e-2 " + std::to_string(ind % 7) + " 255 0 255\n";
+    if (ind % 1000 == 0) {
+      contents += "\n";
+    }
+  }
+  WriteFile(kFilename, contents);
+
+  PointCloudData cloud;
+  ASSERT_TRUE(ReadPointCloudFile(kFilename, &cloud));
+  ASSERT_EQ(kNumPoints, cloud.NumPoints());
+  EXPECT_EQ("intensity", cloud.scalar_field);
+  for (int ind = 0; ind < kNumPoints; ind += 991) {
+    EXPECT_FLOAT_EQ(ind + 0.25f, cloud.vertices[3 * ind]);
+    EXPECT_FLOAT_EQ(-ind, cloud.vertices[3 * ind + 1]);
+    EXPECT_FLOAT_EQ(0.01f, cloud.vertices[3 * ind + 2]);
+    EXPECT_FLOAT_EQ(ind % 7, cloud.scalars[ind]);
+    EXPECT_FLOAT_EQ(1, cloud.colors[4 * ind + 2]);
+  }
+
+  WriteFile(kFilename, "1 2 3\n4 5 six\n");
+  EXPECT_THROW(ReadPointCloudFile(kFilename, &cloud), std::runtime_error);
+  remove(kFilename);
+}
+
+TEST(PointCloudReader, Numbers) {
+  // Numbers are converted as strtod() would, including the ones it has to
+  // handle.
+  const char* kFilename = "point_cloud_reader_test.xyz";
+  const std::vector<std::string> numbers = {
+    "0.1", "-7.3e-5", "123456.789012345678", "1e30", "-0", "+2.5E+3",
+    "0.000000000000000000000000001", "3.14159265358979323846", "inf"
+  };
+  std::string contents;
+  for (const std::string& number : numbers) {
+    contents += number + " " + number + " " + number + "\n";
+  }
+  WriteFile(kFilename, contents);
+
+  PointCloudData cloud;
+  ASSERT_TRUE(ReadPointCloudFile(kFilename, &cloud));
+  ASSERT_EQ(static_cast<int>(numbers.size()) - 1, cloud.NumPoints());
+  for (int ind = 0; ind < cloud.NumPoints(); ++ind) {
+    const float expected = std::strtod(numbers[ind].c_str(), nullptr);
+    EXPECT_EQ(expected, cloud.vertices[3 * ind]) << numbers[ind];
+  }
+  remove(kFilename);
+}
+
+TEST(PointCloudReader, Unsupported) {
+  PointCloudData cloud;
+  EXPECT_FALSE(ReadPointCloudFile("point_cloud_reader_test.obj", &cloud));
+  EXPECT_FALSE(ReadPointCloudFile("point_cloud_reader_missing.ply", &cloud));
+}
@@ -0,0 +1,276 @@
+// Copyright [2015] Albert Huang
+
+#include "sceneview/internal_gl.hpp"
+
+#include "sceneview/point_cloud_resource.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <queue>
+#include <stdexcept>
+#include <utility>
+
+#include <QElapsedTimer>
+#include <QMatrix4x4>
+
+#include "sceneview/camera_node.hpp"
+#include "sceneview/draw_node.hpp"
+#include "sceneview/group_node.hpp"
+#include "sceneview/resource_manager.hpp"
+#include "sceneview/thread_pool.hpp"
+#include "sceneview/view_frustum.hpp"
+
+#if 0
+#define dbg(fmt, ...) printf(fmt, __VA_ARGS__)
+#else
+#define dbg(...)
+#endif
+
+namespace sv {
+
+// Limits the number of node loads queued at a time, so that nodes that are
+// no longer needed don't tie up the worker threads.
+static const int kMaxPendingLoadsPerThread = 2;
+
+PointCloudResource::PointCloudResource(const QString& name) :
+  name_(name),
+  group_node_(nullptr),
+  point_budget_(2000000),
+  cache_budget_(4000000),
+  max_screen_error_(1),
+  upload_time_budget_(4),
+  num_visible_points_(0),
+  num_loaded_points_(0) {}
+
+PointCloudResource::~PointCloudResource() {
+  // Destroying the group node also destroys the DrawNodes of loaded nodes.
+  if (scene_ && scene_->ContainsNode(group_node_)) {
+    scene_->DestroyNode(group_node_);
+  }
+}
+
+void PointCloudResource::Open(const QString& filename) {
+  PointCloudOctree::Ptr octree = std::make_shared<PointCloudOctree>(filename);
+  Clear();
+  octree_ = octree;
+  nodes_.resize(octree_->Nodes().size());
+}
+
+GroupNode* PointCloudResource::MakeSceneNode(
+    const std::shared_ptr<ResourceManager>& resources,
+    const Scene::Ptr& scene, GroupNode* parent,
+    const MaterialResource::Ptr& material) {
+  if (group_node_) {
+    throw std::logic_error("Point cloud " + name_.toStdString() +
+        " is already attached to a scene");
+  }
+  resources_ = resources;
+  scene_ = scene;
+  material_ = material;
+  group_node_ = scene_->MakeGroup(parent);
+  return group_node_;
+}
+
+void PointCloudResource::Update(CameraNode* camera) {
+  if (!octree_ || !group_node_ || octree_->Nodes().empty()) {
+    return;
+  }
+
+  SelectNodes(camera);
+
+  UploadNodes();
+
+  // Show the selected nodes that are loaded, and queue loads for the rest.
+  for (int node_ind : lru_) {
+    nodes_[node_ind].draw_node->SetVisible(false);
+  }
+  num_visible_points_ = 0;
+  const int max_pending =
+    kMaxPendingLoadsPerThread * ThreadPool::Default()->NumThreads();
+  for (auto iter = selected_.rbegin(); iter != selected_.rend(); ++iter) {
+    const int node_ind = *iter;
+    NodeState& state = nodes_[node_ind];
+    if (state.loaded) {
+      state.draw_node->SetVisible(true);
+      lru_.splice(lru_.begin(), lru_, state.lru_iter);
+      num_visible_points_ += octree_->Nodes()[node_ind].num_points;
+    }
+  }
+  for (int node_ind : selected_) {
+    NodeState& state = nodes_[node_ind];
+    if (static_cast<int>(loading_.size()) >= max_pending) {
+      break;
+    }
+    if (state.loaded || state.loading) {
+      continue;
+    }
+    PointCloudOctree::Ptr octree = octree_;
+    state.pending = ThreadPool::Default()->Submit([octree, node_ind]() {
+      return LoadNode(octree, node_ind);
+    });
+    state.loading = true;
+    loading_.push_back(node_ind);
+  }
+
+  // Evict the least recently used nodes that aren't visible.
+  while (num_loaded_points_ > cache_budget_ && !lru_.empty() &&
+      !nodes_[lru_.back()].draw_node->Visible()) {
+    Evict(lru_.back());
+  }
+}
+
+PointCloudResource::NodeData PointCloudResource::LoadNode(
+    const PointCloudOctree::Ptr& octree, int node_ind) {
+  const int num_points = octree->Nodes()[node_ind].num_points;
+  const PointRecord* points = octree->NodePoints(node_ind);
+  NodeData data;
+  data.vertices.resize(num_points * 3);
+  data.diffuse.resize(num_points * 4);
+  float* vertex = data.vertices.data();
+  float* diffuse = data.diffuse.data();
+  for (int point_ind = 0; point_ind < num_points; ++point_ind) {
+    const PointRecord& point = points[point_ind];
+    *vertex++ = point.x;
+    *vertex++ = point.y;
+    *vertex++ = point.z;
+    *diffuse++ = point.r / 255.0f;
+    *diffuse++ = point.g / 255.0f;
+    *diffuse++ = point.b / 255.0f;
+    *diffuse++ = point.a / 255.0f;
+  }
+  return data;
+}
+
+void PointCloudResource::SelectNodes(CameraNode* camera) {
+  selected_.clear();
+
+  const std::vector<PointCloudOctree::Node>& nodes = octree_->Nodes();
+  const QMatrix4x4 model_view = camera->GetViewMatrix() *
+    group_node_->WorldTransform();
+  const QMatrix4x4 proj_mat = camera->GetProjectionMatrix();
+  const ViewFrustum frustum(proj_mat * model_view);
+  const bool perspective = proj_mat(3, 3) == 0;
+  const float scale = model_view.column(0).toVector3D().length();
+  const float pixels_per_unit =
+    proj_mat(1, 1) * camera->GetViewportSize().height() / 2;
+
+  // Computes the projected size of the spacing between the points of a
+  // node, in pixels.
+  auto screen_error = [&](int node_ind) {
+    const PointCloudOctree::Node& node = nodes[node_ind];
+    float error = node.spacing * scale * pixels_per_unit;
+    if (perspective) {
+      const QVector3D center = model_view.map(
+          (node.bounds.Min() + node.bounds.Max()) / 2);
+      const float radius =
+        (node.bounds.Max() - node.bounds.Min()).length() / 2 * scale;
+      error /= std::max(center.length() - radius, 1e-3f);
+    }
+    return error;
+  };
+
+  auto visible = [&](int node_ind) {
+    const AxisAlignedBox& bounds = nodes[node_ind].bounds;
+    return bounds.Valid() && frustum.Intersects(bounds);
+  };
+
+  // Refine the octree, largest error first, until the point budget is used
+  // up.
+  std::priority_queue<std::pair<float, int>> to_visit;
+  if (visible(0)) {
+    to_visit.push(std::make_pair(screen_error(0), 0));
+  }
+  int64_t num_points = 0;
+  while (!to_visit.empty()) {
+    const float error = to_visit.top().first;
+    const int node_ind = to_visit.top().second;
+    to_visit.pop();
+
+    const PointCloudOctree::Node& node = nodes[node_ind];
+    if (num_points + node.num_points > point_budget_) {
+      break;
+    }
+    num_points += node.num_points;
+    if (node.num_points > 0) {
+      selected_.push_back(node_ind);
+    }
+
+    if (error <= max_screen_error_) {
+      continue;
+    }
+    for (int child : node.children) {
+      if (child >= 0 && visible(child)) {
+        to_visit.push(std::make_pair(screen_error(child), child));
+      }
+    }
+  }
+}
+
+void PointCloudResource::UploadNodes() {
+  QElapsedTimer timer;
+  timer.start();
+  bool uploaded = false;
+  for (auto iter = loading_.begin(); iter != loading_.end();) {
+    if (uploaded && timer.nsecsElapsed() > upload_time_budget_ * 1e6) {
+      break;
+    }
+    NodeState& state = nodes_[*iter];
+    if (state.pending.wait_for(std::chrono::seconds(0)) !=
+        std::future_status::ready) {
+      ++iter;
+      continue;
+    }
+    const NodeData data = state.pending.get();
+    state.loading = false;
+    Upload(*iter, data);
+    uploaded = true;
+    iter = loading_.erase(iter);
+  }
+}
+
+void PointCloudResource::Upload(int node_ind, const NodeData& data) {
+  const int num_points = octree_->Nodes()[node_ind].num_points;
+  GeometryDataView view;
+  view.gl_mode = GL_POINTS;
+  view.vertices = StridedSpan(data.vertices.data(), num_points);
+  view.diffuse = StridedSpan(data.diffuse.data(), num_points);
+
+  NodeState& state = nodes_[node_ind];
+  state.geometry = resources_->MakeGeometry();
+  state.geometry->Load(view);
+  state.draw_node = scene_->MakeDrawNode(group_node_, state.geometry,
+      material_);
+  state.draw_node->SetSelectionMask(group_node_->GetSelectionMask());
+  state.draw_node->SetVisible(false);
+  state.loaded = true;
+  lru_.push_front(node_ind);
+  state.lru_iter = lru_.begin();
+  num_loaded_points_ += num_points;
+  dbg("Uploaded node %d (%d points)\n", node_ind, num_points);
+}
+
+void PointCloudResource::Evict(int node_ind) {
+  NodeState& state = nodes_[node_ind];
+  scene_->DestroyNode(state.draw_node);
+  state.draw_node = nullptr;
+  state.geometry.reset();
+  state.loaded = false;
+  lru_.erase(state.lru_iter);
+  num_loaded_points_ -= octree_->Nodes()[node_ind].num_points;
+  dbg("Evicted node %d\n", node_ind);
+}
+
+void PointCloudResource::Clear() {
+  while (!lru_.empty()) {
+    Evict(lru_.back());
+  }
+  // Loads that are still running finish in the background, and their
+  // results are dropped.
+  loading_.clear();
+  selected_.clear();
+  nodes_.clear();
+  num_visible_points_ = 0;
+  num_loaded_points_ = 0;
+}
+
+}  // namespace sv
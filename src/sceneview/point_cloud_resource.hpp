@@ -0,0 +1,229 @@
+// Copyright [2015] Albert Huang
+
+#ifndef SCENEVIEW_POINT_CLOUD_RESOURCE_HPP__
+#define SCENEVIEW_POINT_CLOUD_RESOURCE_HPP__
+
+#include <cstdint>
+#include <future>
+#include <list>
+#include <memory>
+#include <vector>
+
+#include <QString>
+
+#include <sceneview/geometry_resource.hpp>
+#include <sceneview/material_resource.hpp>
+#include <sceneview/point_cloud_octree.hpp>
+#include <sceneview/scene.hpp>
+
+namespace sv {
+
+class CameraNode;
+class DrawNode;
+class GroupNode;
+class ResourceManager;
+
+/**
+ * Point cloud that is too large to fit in graphics memory, streamed from an
+ * octree file on disk.
+ *
+ * The octree is built with PointCloudOctreeBuilder. Each frame, Update()
+ * selects the octree nodes to draw, highest screen-space error first, until
+ * a point budget is reached. The screen-space error of a node is the
+ * projected size, in pixels, of the spacing between its points. Nodes that
+ * are outside of the view frustum, or whose parent's points are already
+ * dense enough on screen, are skipped.
+ *
+ * Selected nodes that aren't in graphics memory are read from disk on
+ * worker threads, and uploaded on the rendering thread subject to a time
+ * budget per frame, so that loading doesn't cause frame rate hitches. Nodes
+ * that are no longer selected stay in graphics memory until a cache budget
+ * is exceeded, and are then evicted in least recently used order.
+ *
+ * Each loaded octree node is drawn by its own DrawNode, placed below the
+ * GroupNode returned by MakeSceneNode(). The usual view frustum culling,
+ * draw groups and selection queries therefore work on a per octree node
+ * basis. DrawNodes are created with the selection mask of the GroupNode.
+ *
+ * Typical usage:
+ * @code
+ * PointCloudResource::Ptr cloud = resources->MakePointCloud();
+ * cloud->Open("map.svpc");
+ * cloud->MakeSceneNode(resources, scene, scene->Root(), material);
+ *
+ * // In Renderer::RenderBegin(), or elsewhere with the OpenGL context
+ * // current, once per frame:
+ * cloud->Update(camera);
+ * @endcode
+ *
+ * The material should use a shader that reads per-vertex colors, e.g.,
+ * StockResources::kPerVertexColorNoLighting, or
+ * StockResources::kSplatPerVertexColor to cover surfaces with a lower point
+ * budget.
+ *
+ * PointCloudResource objects cannot be directly instantiated. Instead, use
+ * ResourceManager.
+ *
+ * @ingroup sv_resources
+ * @headerfile sceneview/point_cloud_resource.hpp
+ */
+class PointCloudResource {
+  public:
+    typedef std::shared_ptr<PointCloudResource> Ptr;
+
+    ~PointCloudResource();
+
+    const QString& Name() const { return name_; }
+
+    /**
+     * Opens an octree file written by PointCloudOctreeBuilder.
+     *
+     * Any previously loaded data is discarded.
+     *
+     * @throw std::runtime_error if the file can't be read.
+     */
+    void Open(const QString& filename);
+
+    /**
+     * Creates the scene node that draws the point cloud.
+     *
+     * The returned node is owned by @p scene. Don't add children to it, as
+     * they are managed by the PointCloudResource. The point cloud can only
+     * be attached to a single scene at a time.
+     *
+     * @param resources used to create geometry for the loaded nodes.
+     * @param scene the scene to add the node to.
+     * @param parent the parent of the new node.
+     * @param material the material used to draw the points.
+     *
+     * @throw std::logic_error if the point cloud is already attached to a
+     * scene.
+     */
+    GroupNode* MakeSceneNode(const std::shared_ptr<ResourceManager>& resources,
+        const Scene::Ptr& scene, GroupNode* parent,
+        const MaterialResource::Ptr& material);
+
+    /**
+     * Selects the octree nodes to draw from the specified camera, queues
+     * loads, uploads loaded nodes, and evicts unused nodes.
+     *
+     * Must be called with the OpenGL context current, typically once per
+     * frame before drawing.
+     */
+    void Update(CameraNode* camera);
+
+    /**
+     * Sets the maximum number of points to draw. The default is two
+     * million.
+     */
+    void SetPointBudget(int64_t num_points) { point_budget_ = num_points; }
+
+    int64_t PointBudget() const { return point_budget_; }
+
+    /**
+     * Sets the maximum number of points to keep in graphics memory,
+     * including points that aren't drawn. The default is four million.
+     */
+    void SetCacheBudget(int64_t num_points) { cache_budget_ = num_points; }
+
+    int64_t CacheBudget() const { return cache_budget_; }
+
+    /**
+     * Sets the screen-space error, in pixels, below which octree nodes are
+     * not refined. The default is 1.
+     */
+    void SetMaxScreenSpaceError(float pixels) { max_screen_error_ = pixels; }
+
+    /**
+     * Sets the maximum time, in milliseconds, spent uploading loaded nodes
+     * to graphics memory in each call to Update(). At least one node is
+     * uploaded per call if any are ready. The default is 4 ms.
+     */
+    void SetUploadTimeBudget(double milliseconds) {
+      upload_time_budget_ = milliseconds;
+    }
+
+    /**
+     * Retrieve the opened octree, or nullptr.
+     */
+    const PointCloudOctree::Ptr& Octree() const { return octree_; }
+
+    /**
+     * Retrieve the number of points selected by the last call to Update()
+     * that are in graphics memory.
+     */
+    int64_t NumVisiblePoints() const { return num_visible_points_; }
+
+    /**
+     * Retrieve the number of points in graphics memory.
+     */
+    int64_t NumLoadedPoints() const { return num_loaded_points_; }
+
+  private:
+    friend class ResourceManager;
+
+    // Vertex data of an octree node, prepared on a worker thread.
+    struct NodeData {
+      std::vector<float> vertices;
+      std::vector<float> diffuse;
+    };
+
+    struct NodeState {
+      NodeState() : draw_node(nullptr), loading(false), loaded(false) {}
+
+      DrawNode* draw_node;
+      GeometryResource::Ptr geometry;
+
+      bool loading;
+      std::future<NodeData> pending;
+
+      bool loaded;
+      std::list<int>::iterator lru_iter;
+    };
+
+    explicit PointCloudResource(const QString& name);
+
+    static NodeData LoadNode(const PointCloudOctree::Ptr& octree,
+        int node_ind);
+
+    void SelectNodes(CameraNode* camera);
+
+    void UploadNodes();
+
+    void Upload(int node_ind, const NodeData& data);
+
+    void Evict(int node_ind);
+
+    void Clear();
+
+    QString name_;
+
+    PointCloudOctree::Ptr octree_;
+    std::vector<NodeState> nodes_;
+
+    std::shared_ptr<ResourceManager> resources_;
+    Scene::Ptr scene_;
+    GroupNode* group_node_;
+    MaterialResource::Ptr material_;
+
+    int64_t point_budget_;
+    int64_t cache_budget_;
+    float max_screen_error_;
+    double upload_time_budget_;
+
+    // Nodes selected by the last call to Update(), in priority order.
+    std::vector<int> selected_;
+
+    // Nodes being loaded, in the order that loads were queued.
+    std::list<int> loading_;
+
+    // Loaded nodes, most recently used first.
+    std::list<int> lru_;
+
+    int64_t num_visible_points_;
+    int64_t num_loaded_points_;
+};
+
+}  // namespace sv
+
+#endif  // SCENEVIEW_POINT_CLOUD_RESOURCE_HPP__
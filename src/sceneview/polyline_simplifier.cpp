@@ -0,0 +1,98 @@
+// Copyright [2015] Albert Huang
+
+#include "sceneview/polyline_simplifier.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+
+namespace sv {
+
+// Distance from a point to the segment between a and b.
+static float SegmentDistance(const QVector3D& point, const QVector3D& a,
+    const QVector3D& b) {
+  const QVector3D ab = b - a;
+  const float length_sq = QVector3D::dotProduct(ab, ab);
+  float t = 0;
+  if (length_sq > 0) {
+    t = QVector3D::dotProduct(point - a, ab) / length_sq;
+    t = std::min(std::max(t, 0.0f), 1.0f);
+  }
+  return (point - (a + t * ab)).length();
+}
+
+std::vector<float> PolylineImportance(const std::vector<QVector3D>& points) {
+  const float infinity = std::numeric_limits<float>::infinity();
+  std::vector<float> importance(points.size(), 0);
+  if (points.empty()) {
+    return importance;
+  }
+  importance.front() = infinity;
+  importance.back() = infinity;
+
+  struct Segment {
+    int first;
+    int last;
+    float max_importance;
+  };
+  std::vector<Segment> stack;
+  stack.push_back(Segment { 0, static_cast<int>(points.size()) - 1,
+      infinity });
+  while (!stack.empty()) {
+    const Segment segment = stack.back();
+    stack.pop_back();
+    if (segment.last - segment.first < 2) {
+      continue;
+    }
+
+    int split = segment.first + 1;
+    float max_distance = -1;
+    for (int ind = segment.first + 1; ind < segment.last; ++ind) {
+      const float distance = SegmentDistance(points[ind],
+          points[segment.first], points[segment.last]);
+      if (distance > max_distance) {
+        max_distance = distance;
+        split = ind;
+      }
+    }
+    importance[split] = std::min(max_distance, segment.max_importance);
+    stack.push_back(Segment { segment.first, split, importance[split] });
+    stack.push_back(Segment { split, segment.last, importance[split] });
+  }
+  return importance;
+}
+
+std::vector<PolylineLod> GeneratePolylineLodChain(
+    const std::vector<float>& importance, double reduction) {
+  std::vector<PolylineLod> levels;
+  const int num_points = importance.size();
+  if (!num_points) {
+    return levels;
+  }
+
+  levels.emplace_back();
+  levels.back().error = 0;
+  for (int ind = 0; ind < num_points; ++ind) {
+    levels.back().indices.push_back(ind);
+  }
+
+  std::vector<float> sorted(importance);
+  std::sort(sorted.begin(), sorted.end(), std::greater<float>());
+  while (levels.back().indices.size() > 2) {
+    // Keep the points more important than the first one left out.
+    const int target = std::max(2,
+        static_cast<int>(levels.back().indices.size() * reduction));
+    const float threshold = sorted[target];
+    PolylineLod level;
+    level.error = threshold;
+    for (int ind = 0; ind < num_points; ++ind) {
+      if (importance[ind] > threshold) {
+        level.indices.push_back(ind);
+      }
+    }
+    levels.push_back(level);
+  }
+  return levels;
+}
+
+}  // namespace sv
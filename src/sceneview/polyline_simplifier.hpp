@@ -0,0 +1,72 @@
+// Copyright [2015] Albert Huang
+
+#ifndef SCENEVIEW_POLYLINE_SIMPLIFIER_HPP__
+#define SCENEVIEW_POLYLINE_SIMPLIFIER_HPP__
+
+#include <cstdint>
+#include <vector>
+
+#include <QVector3D>
+
+namespace sv {
+
+/**
+ * Ranks the points of a polyline for Douglas-Peucker simplification.
+ *
+ * Douglas-Peucker simplification with tolerance t keeps the point farthest
+ * from the segment between the ends of the polyline if it's farther than t,
+ * and recurses on both halves. This computes, for each point, the largest
+ * tolerance at which the point is still kept, so that the polyline can be
+ * simplified at any tolerance without running the algorithm again: the
+ * points kept at tolerance t are exactly those whose importance is greater
+ * than t. A point's importance is never greater than that of the point that
+ * split the segment it lies on.
+ *
+ * The recursion is done with an explicit stack, so very long polylines are
+ * fine.
+ *
+ * @return the importance of each point. The first and last points have an
+ * infinite importance.
+ *
+ * @ingroup sv_resources
+ * @headerfile sceneview/polyline_simplifier.hpp
+ */
+std::vector<float> PolylineImportance(const std::vector<QVector3D>& points);
+
+/**
+ * A simplified version of a polyline.
+ *
+ * @ingroup sv_resources
+ * @headerfile sceneview/polyline_simplifier.hpp
+ */
+struct PolylineLod {
+  /**
+   * Indices of the points that are kept, in increasing order.
+   */
+  std::vector<uint32_t> indices;
+
+  /**
+   * Largest distance from a removed point to the simplified polyline.
+   */
+  float error;
+};
+
+/**
+ * Generates a chain of successively simplified polylines.
+ *
+ * The first level keeps every point and has no error. Each next level keeps
+ * at most @p reduction times as many points as the previous one, until a
+ * level with only the first and last points.
+ *
+ * @param importance the importance of each point, as computed by
+ *        PolylineImportance().
+ *
+ * @ingroup sv_resources
+ * @headerfile sceneview/polyline_simplifier.hpp
+ */
+std::vector<PolylineLod> GeneratePolylineLodChain(
+    const std::vector<float>& importance, double reduction = 0.5);
+
+}  // namespace sv
+
+#endif  // SCENEVIEW_POLYLINE_SIMPLIFIER_HPP__
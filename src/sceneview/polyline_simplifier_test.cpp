@@ -0,0 +1,61 @@
+// Copyright [2015] Albert Huang
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <vector>
+
+#include "sceneview/polyline_simplifier.hpp"
+
+using sv::GeneratePolylineLodChain;
+using sv::PolylineImportance;
+using sv::PolylineLod;
+
+TEST(PolylineSimplifier, Importance) {
+  // A square wave: the corners matter, the points along the edges don't.
+  const std::vector<QVector3D> points = {
+    { 0, 0, 0 }, { 1, 0, 0 }, { 2, 0, 0 }, { 2, 1, 0 }, { 3, 1, 0 },
+    { 4, 1, 0 }, { 4, 0, 0 }
+  };
+  const std::vector<float> importance = PolylineImportance(points);
+  ASSERT_EQ(points.size(), importance.size());
+  EXPECT_TRUE(std::isinf(importance.front()));
+  EXPECT_TRUE(std::isinf(importance.back()));
+  EXPECT_FLOAT_EQ(0, importance[1]);
+  EXPECT_FLOAT_EQ(0, importance[4]);
+  EXPECT_GT(importance[2], 0.5);
+  EXPECT_GT(importance[3], 0.5);
+  EXPECT_GT(importance[5], 0.5);
+}
+
+TEST(PolylineSimplifier, Monotonic) {
+  // Along a spiral, no point is more important than the point that split
+  // its segment, so thresholds give nested subsets.
+  std::vector<QVector3D> points;
+  for (int ind = 0; ind < 500; ++ind) {
+    const double angle = ind * 0.05;
+    points.emplace_back(angle * cos(angle), angle * sin(angle), 0.01 * ind);
+  }
+  const std::vector<float> importance = PolylineImportance(points);
+  const std::vector<PolylineLod> levels = GeneratePolylineLodChain(importance);
+  ASSERT_GT(levels.size(), 3u);
+  EXPECT_EQ(points.size(), levels.front().indices.size());
+  EXPECT_FLOAT_EQ(0, levels.front().error);
+  EXPECT_EQ(2u, levels.back().indices.size());
+  for (size_t level = 1; level < levels.size(); ++level) {
+    EXPECT_LE(levels[level].indices.size(),
+        levels[level - 1].indices.size() / 2 + 1);
+    EXPECT_GE(levels[level].error, levels[level - 1].error);
+    EXPECT_EQ(0u, levels[level].indices.front());
+    EXPECT_EQ(points.size() - 1, levels[level].indices.back());
+  }
+}
+
+TEST(PolylineSimplifier, Degenerate) {
+  EXPECT_TRUE(PolylineImportance({}).empty());
+  EXPECT_TRUE(GeneratePolylineLodChain({}).empty());
+
+  const std::vector<float> importance = PolylineImportance({ { 1, 2, 3 } });
+  ASSERT_EQ(1u, importance.size());
+  EXPECT_EQ(1u, GeneratePolylineLodChain(importance).size());
+}
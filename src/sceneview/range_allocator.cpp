@@ -0,0 +1,96 @@
+// Copyright [2015] Albert Huang
+
+#include "sceneview/range_allocator.hpp"
+
+#include <iterator>
+#include <stdexcept>
+#include <utility>
+
+namespace sv {
+
+RangeAllocator::RangeAllocator(int capacity) :
+  capacity_(0),
+  num_allocated_(0) {
+  Grow(capacity);
+}
+
+int RangeAllocator::Allocate(int size) {
+  if (size <= 0) {
+    throw std::invalid_argument("Invalid allocation size");
+  }
+  auto fit = by_size_.lower_bound(std::make_pair(size, -1));
+  if (fit == by_size_.end()) {
+    return -1;
+  }
+  const int offset = fit->second;
+  const int free_size = fit->first;
+  RemoveFreeRange(by_offset_.find(offset));
+  if (free_size > size) {
+    AddFreeRange(offset + size, free_size - size);
+  }
+  num_allocated_ += size;
+  return offset;
+}
+
+void RangeAllocator::Free(int offset, int size) {
+  if (size <= 0 || offset < 0 || offset + size > capacity_) {
+    throw std::invalid_argument("Invalid range");
+  }
+  num_allocated_ -= size;
+
+  // Merge with the free ranges on either side.
+  auto next = by_offset_.lower_bound(offset);
+  if (next != by_offset_.end() && next->first == offset + size) {
+    size += next->second;
+    auto merged = next++;
+    RemoveFreeRange(merged);
+  }
+  if (next != by_offset_.begin()) {
+    auto prev = std::prev(next);
+    if (prev->first + prev->second == offset) {
+      offset = prev->first;
+      size += prev->second;
+      RemoveFreeRange(prev);
+    }
+  }
+  AddFreeRange(offset, size);
+}
+
+void RangeAllocator::Grow(int capacity) {
+  if (capacity <= capacity_) {
+    return;
+  }
+  const int old_capacity = capacity_;
+  capacity_ = capacity;
+  num_allocated_ += capacity - old_capacity;
+  Free(old_capacity, capacity - old_capacity);
+}
+
+void RangeAllocator::Clear() {
+  by_offset_.clear();
+  by_size_.clear();
+  num_allocated_ = 0;
+  if (capacity_ > 0) {
+    AddFreeRange(0, capacity_);
+  }
+}
+
+int RangeAllocator::End() const {
+  if (by_offset_.empty()) {
+    return capacity_;
+  }
+  auto last = std::prev(by_offset_.end());
+  return last->first + last->second == capacity_ ? last->first : capacity_;
+}
+
+void RangeAllocator::AddFreeRange(int offset, int size) {
+  by_offset_[offset] = size;
+  by_size_.insert(std::make_pair(size, offset));
+}
+
+void RangeAllocator::RemoveFreeRange(std::map<int, int>::iterator iter) {
+  by_size_.erase(std::make_pair(iter->second, iter->first));
+  by_offset_.erase(iter);
+}
+
+}  // namespace sv
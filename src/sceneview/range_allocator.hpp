@@ -0,0 +1,84 @@
+// Copyright [2015] Albert Huang
+
+#ifndef SCENEVIEW_RANGE_ALLOCATOR_HPP__
+#define SCENEVIEW_RANGE_ALLOCATOR_HPP__
+
+#include <map>
+#include <set>
+#include <utility>
+
+namespace sv {
+
+/**
+ * Allocates contiguous ranges of a fixed-size pool, such as a region of a
+ * vertex or index buffer.
+ *
+ * Allocation is best fit, and freed ranges are merged with adjacent free
+ * ranges. Both allocating and freeing take logarithmic time in the number of
+ * free ranges. The allocator only does bookkeeping, and never touches the
+ * pool itself.
+ *
+ * @ingroup sv_resources
+ * @headerfile sceneview/range_allocator.hpp
+ */
+class RangeAllocator {
+  public:
+    /**
+     * Creates an allocator for a pool of @p capacity units, all free.
+     */
+    explicit RangeAllocator(int capacity = 0);
+
+    /**
+     * Allocates @p size contiguous units.
+     *
+     * @return the offset of the allocated range, or -1 if there isn't a
+     * large enough free range.
+     */
+    int Allocate(int size);
+
+    /**
+     * Frees a range returned by Allocate().
+     */
+    void Free(int offset, int size);
+
+    /**
+     * Enlarges the pool. The new units are free.
+     */
+    void Grow(int capacity);
+
+    /**
+     * Frees all ranges.
+     */
+    void Clear();
+
+    int Capacity() const { return capacity_; }
+
+    /**
+     * Retrieve the number of allocated units.
+     */
+    int NumAllocated() const { return num_allocated_; }
+
+    /**
+     * Retrieve the end of the highest allocated range, or 0 if nothing is
+     * allocated.
+     */
+    int End() const;
+
+  private:
+    void AddFreeRange(int offset, int size);
+
+    void RemoveFreeRange(std::map<int, int>::iterator iter);
+
+    int capacity_;
+    int num_allocated_;
+
+    // Free ranges, keyed by offset, with their sizes.
+    std::map<int, int> by_offset_;
+
+    // Free ranges, as (size, offset) pairs.
+    std::set<std::pair<int, int>> by_size_;
+};
+
+}  // namespace sv
+
+#endif  // SCENEVIEW_RANGE_ALLOCATOR_HPP__
@@ -0,0 +1,125 @@
+// Copyright [2015] Albert Huang
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "sceneview/range_allocator.hpp"
+
+using sv::RangeAllocator;
+
+TEST(RangeAllocator, AllocateAndFree) {
+  RangeAllocator allocator(100);
+  EXPECT_EQ(100, allocator.Capacity());
+  EXPECT_EQ(0, allocator.NumAllocated());
+  EXPECT_EQ(0, allocator.End());
+
+  const int a = allocator.Allocate(30);
+  const int b = allocator.Allocate(30);
+  const int c = allocator.Allocate(30);
+  EXPECT_EQ(0, a);
+  EXPECT_EQ(30, b);
+  EXPECT_EQ(60, c);
+  EXPECT_EQ(90, allocator.NumAllocated());
+  EXPECT_EQ(90, allocator.End());
+  EXPECT_EQ(-1, allocator.Allocate(11));
+
+  // Freeing the middle range leaves a hole that is reused.
+  allocator.Free(b, 30);
+  EXPECT_EQ(90, allocator.End());
+  EXPECT_EQ(30, allocator.Allocate(20));
+  EXPECT_EQ(50, allocator.Allocate(10));
+  EXPECT_EQ(90, allocator.Allocate(10));
+  EXPECT_EQ(100, allocator.End());
+}
+
+TEST(RangeAllocator, BestFit) {
+  RangeAllocator allocator(100);
+  std::vector<int> offsets;
+  for (int i = 0; i < 10; ++i) {
+    offsets.push_back(allocator.Allocate(10));
+  }
+  // Free ranges of 10 and 20 units.
+  allocator.Free(offsets[1], 10);
+  allocator.Free(offsets[5], 10);
+  allocator.Free(offsets[6], 10);
+
+  // The smallest range that fits is used.
+  EXPECT_EQ(offsets[1], allocator.Allocate(10));
+  EXPECT_EQ(offsets[5], allocator.Allocate(15));
+  EXPECT_EQ(-1, allocator.Allocate(6));
+  EXPECT_EQ(offsets[5] + 15, allocator.Allocate(5));
+}
+
+TEST(RangeAllocator, MergesFreeRanges) {
+  RangeAllocator allocator(40);
+  const int a = allocator.Allocate(10);
+  const int b = allocator.Allocate(10);
+  const int c = allocator.Allocate(10);
+  const int d = allocator.Allocate(10);
+  allocator.Free(a, 10);
+  allocator.Free(c, 10);
+  allocator.Free(b, 10);
+  EXPECT_EQ(0, allocator.Allocate(30));
+  allocator.Free(d, 10);
+  allocator.Free(0, 30);
+  EXPECT_EQ(0, allocator.NumAllocated());
+  EXPECT_EQ(0, allocator.End());
+  EXPECT_EQ(0, allocator.Allocate(40));
+}
+
+TEST(RangeAllocator, Grow) {
+  RangeAllocator allocator;
+  EXPECT_EQ(-1, allocator.Allocate(1));
+  allocator.Grow(10);
+  EXPECT_EQ(0, allocator.Allocate(8));
+  EXPECT_EQ(-1, allocator.Allocate(4));
+
+  // The new space is merged with the free space at the end.
+  allocator.Grow(20);
+  EXPECT_EQ(8, allocator.Allocate(12));
+  EXPECT_EQ(20, allocator.NumAllocated());
+
+  allocator.Clear();
+  EXPECT_EQ(0, allocator.NumAllocated());
+  EXPECT_EQ(0, allocator.Allocate(20));
+}
+
+TEST(RangeAllocator, RandomOperations) {
+  // Allocated ranges never overlap, and everything can be reallocated once
+  // freed.
+  const int capacity = 1000;
+  RangeAllocator allocator(capacity);
+  std::mt19937 rng(1);
+  std::vector<std::pair<int, int>> allocated;
+  std::vector<int> owner(capacity, -1);
+  for (int iter = 0; iter < 2000; ++iter) {
+    if (allocated.empty() || rng() % 2) {
+      const int size = 1 + rng() % 50;
+      const int offset = allocator.Allocate(size);
+      if (offset < 0) {
+        continue;
+      }
+      for (int ind = offset; ind < offset + size; ++ind) {
+        ASSERT_EQ(-1, owner[ind]);
+        owner[ind] = iter;
+      }
+      allocated.push_back(std::make_pair(offset, size));
+    } else {
+      const int which = rng() % allocated.size();
+      const std::pair<int, int> range = allocated[which];
+      allocated.erase(allocated.begin() + which);
+      allocator.Free(range.first, range.second);
+      for (int ind = range.first; ind < range.first + range.second; ++ind) {
+        owner[ind] = -1;
+      }
+    }
+  }
+  for (const std::pair<int, int>& range : allocated) {
+    allocator.Free(range.first, range.second);
+  }
+  EXPECT_EQ(0, allocator.NumAllocated());
+  EXPECT_EQ(0, allocator.Allocate(capacity));
+}
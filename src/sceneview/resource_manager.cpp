@@ -48,6 +48,69 @@ GeometryResource::Ptr ResourceManager::MakeGeometry(const QString& name) {
   return result;
 }
 
+StreamingGeometryResource::Ptr ResourceManager::MakeStreamingGeometry(
+    const QString& name) {
+  QString actual_name = PickName(name);
+  StreamingGeometryResource::Ptr result(
+      new StreamingGeometryResource(actual_name));
+  geometries_[actual_name] = result;
+  dbg("MakeStreamingGeometry: -> %s (total: %d)\n",
+      actual_name.c_str(), static_cast<int>(geometries_.size()));
+  return result;
+}
+
+GrowingGeometryResource::Ptr ResourceManager::MakeGrowingGeometry(
+    const QString& name) {
+  QString actual_name = PickName(name);
+  GrowingGeometryResource::Ptr result(
+      new GrowingGeometryResource(actual_name));
+  geometries_[actual_name] = result;
+  dbg("MakeGrowingGeometry: -> %s (total: %d)\n",
+      actual_name.c_str(), static_cast<int>(geometries_.size()));
+  return result;
+}
+
+RingBufferGeometryResource::Ptr ResourceManager::MakeRingBufferGeometry(
+    const QString& name) {
+  QString actual_name = PickName(name);
+  RingBufferGeometryResource::Ptr result(
+      new RingBufferGeometryResource(actual_name));
+  geometries_[actual_name] = result;
+  dbg("MakeRingBufferGeometry: -> %s (total: %d)\n",
+      actual_name.c_str(), static_cast<int>(geometries_.size()));
+  return result;
+}
+
+ChunkedMeshResource::Ptr ResourceManager::MakeChunkedMesh(
+    const QString& name) {
+  QString actual_name = PickName(name);
+  ChunkedMeshResource::Ptr result(new ChunkedMeshResource(actual_name));
+  geometries_[actual_name] = result;
+  dbg("MakeChunkedMesh: -> %s (total: %d)\n",
+      actual_name.c_str(), static_cast<int>(geometries_.size()));
+  return result;
+}
+
+PointCloudResource::Ptr ResourceManager::MakePointCloud(const QString& name) {
+  QString actual_name = PickName(name);
+  PointCloudResource::Ptr result(new PointCloudResource(actual_name));
+  point_clouds_[actual_name] = result;
+  dbg("MakePointCloud: -> %s (total: %d)\n",
+      actual_name.c_str(), static_cast<int>(point_clouds_.size()));
+  return result;
+}
+
+StreamingTextureResource::Ptr ResourceManager::MakeStreamingTexture(
+    const QString& name) {
+  QString actual_name = PickName(name);
+  StreamingTextureResource::Ptr result(
+      new StreamingTextureResource(actual_name));
+  textures_[actual_name] = result;
+  dbg("MakeStreamingTexture: -> %s (total: %d)\n",
+      actual_name.c_str(), static_cast<int>(textures_.size()));
+  return result;
+}
+
 Scene::Ptr ResourceManager::MakeScene(const QString& name) {
   QString actual_name = PickName(name);
   Scene::Ptr result(new Scene(actual_name));
@@ -110,6 +173,8 @@ void ResourceManager::Cleanup() {
   ClearExpired(&materials_);
   ClearExpired(&shaders_);
   ClearExpired(&geometries_);
+  ClearExpired(&point_clouds_);
+  ClearExpired(&textures_);
   ClearExpired(&scenes_);
 }
 
@@ -143,6 +208,8 @@ static bool InMap(const MapType& map, const QString& key) {
 bool ResourceManager::NameExists(const QString& name) {
   return InMap(materials_, name) ||
     InMap(geometries_, name) ||
+    InMap(point_clouds_, name) ||
+    InMap(textures_, name) ||
     InMap(scenes_, name);
 }
 
@@ -151,6 +218,8 @@ void ResourceManager::PrintStats() {
   printf("materials: %d\n", static_cast<int>(materials_.size()));
   printf("shaders: %d\n", static_cast<int>(shaders_.size()));
   printf("geometries: %d\n", static_cast<int>(geometries_.size()));
+  printf("point clouds: %d\n", static_cast<int>(point_clouds_.size()));
+  printf("textures: %d\n", static_cast<int>(textures_.size()));
   printf("scenes: %d\n", static_cast<int>(scenes_.size()));
 }
 
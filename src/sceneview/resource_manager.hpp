@@ -5,12 +5,19 @@
 
 #include <cstdint>
 #include <map>
+#include <memory>
 
+#include <sceneview/chunked_mesh_resource.hpp>
 #include <sceneview/font_resource.hpp>
 #include <sceneview/geometry_resource.hpp>
+#include <sceneview/growing_geometry_resource.hpp>
 #include <sceneview/material_resource.hpp>
+#include <sceneview/point_cloud_resource.hpp>
+#include <sceneview/ring_buffer_geometry_resource.hpp>
 #include <sceneview/shader_resource.hpp>
 #include <sceneview/scene.hpp>
+#include <sceneview/streaming_geometry_resource.hpp>
+#include <sceneview/streaming_texture_resource.hpp>
 
 namespace sv {
 
@@ -69,6 +76,87 @@ class ResourceManager {
      */
     GeometryResource::Ptr MakeGeometry(const QString& name = kAutoName);
 
+    /**
+     * Create a new geometry of a custom GeometryResource subclass, e.g., one
+     * that overrides how its draw ranges or instances are set up.
+     *
+     * @p GeometryType must have a constructor that takes the resource name,
+     * and that ResourceManager can access. The returned geometry can be
+     * retrieved with GetGeometry().
+     *
+     * @throw std::invalid_argument If a resource with the same name already
+     * exists.
+     */
+    template <typename GeometryType>
+    std::shared_ptr<GeometryType> MakeCustomGeometry(
+        const QString& name = kAutoName) {
+      const QString actual_name = PickName(name);
+      std::shared_ptr<GeometryType> result(new GeometryType(actual_name));
+      geometries_[actual_name] = result;
+      return result;
+    }
+
+    /**
+     * Create a new geometry for vertex data that changes every frame.
+     *
+     * The returned geometry can be retrieved with GetGeometry().
+     *
+     * @throw std::invalid_argument If a resource with the same name already
+     * exists.
+     */
+    StreamingGeometryResource::Ptr MakeStreamingGeometry(
+        const QString& name = kAutoName);
+
+    /**
+     * Create a new geometry that is only ever appended to.
+     *
+     * The returned geometry can be retrieved with GetGeometry().
+     *
+     * @throw std::invalid_argument If a resource with the same name already
+     * exists.
+     */
+    GrowingGeometryResource::Ptr MakeGrowingGeometry(
+        const QString& name = kAutoName);
+
+    /**
+     * Create a new fixed-capacity geometry that holds the most recent scans
+     * of a live sensor.
+     *
+     * The returned geometry can be retrieved with GetGeometry().
+     *
+     * @throw std::invalid_argument If a resource with the same name already
+     * exists.
+     */
+    RingBufferGeometryResource::Ptr MakeRingBufferGeometry(
+        const QString& name = kAutoName);
+
+    /**
+     * Create a new mesh made of independently replaceable blocks.
+     *
+     * The returned geometry can be retrieved with GetGeometry().
+     *
+     * @throw std::invalid_argument If a resource with the same name already
+     * exists.
+     */
+    ChunkedMeshResource::Ptr MakeChunkedMesh(const QString& name = kAutoName);
+
+    /**
+     * Create a new out-of-core point cloud.
+     *
+     * @throw std::invalid_argument If a resource with the same name already
+     * exists.
+     */
+    PointCloudResource::Ptr MakePointCloud(const QString& name = kAutoName);
+
+    /**
+     * Create a new texture whose contents are replaced every frame.
+     *
+     * @throw std::invalid_argument If a resource with the same name already
+     * exists.
+     */
+    StreamingTextureResource::Ptr MakeStreamingTexture(
+        const QString& name = kAutoName);
+
     /**
      * Create a new scene graph.
      *
@@ -112,6 +200,9 @@ class ResourceManager {
     typedef std::weak_ptr<MaterialResource> MaterialResourceWeakPtr;
     typedef std::weak_ptr<ShaderResource> ShaderResourceWeakPtr;
     typedef std::weak_ptr<GeometryResource> GeometryResourceWeakPtr;
+    typedef std::weak_ptr<PointCloudResource> PointCloudResourceWeakPtr;
+    typedef std::weak_ptr<StreamingTextureResource>
+      StreamingTextureResourceWeakPtr;
     typedef std::weak_ptr<Scene> SceneWeakPtr;
     typedef std::weak_ptr<FontResource> FontResourceWeakPtr;
 
@@ -126,6 +217,8 @@ class ResourceManager {
     std::map<QString, MaterialResourceWeakPtr> materials_;
     std::map<QString, ShaderResourceWeakPtr> shaders_;
     std::map<QString, GeometryResourceWeakPtr> geometries_;
+    std::map<QString, PointCloudResourceWeakPtr> point_clouds_;
+    std::map<QString, StreamingTextureResourceWeakPtr> textures_;
     std::map<QString, SceneWeakPtr> scenes_;
     std::map<QString, FontResourceWeakPtr> fonts_;
 
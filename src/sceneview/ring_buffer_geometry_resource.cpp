@@ -0,0 +1,211 @@
+// Copyright [2015] Albert Huang
+
+#include "sceneview/internal_gl.hpp"
+
+#include "sceneview/ring_buffer_geometry_resource.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+#if 0
+#define dbg(fmt, ...) printf(fmt, __VA_ARGS__)
+#else
+#define dbg(...)
+#endif
+
+namespace sv {
+
+RingBufferGeometryResource::RingBufferGeometryResource(const QString& name) :
+  GeometryResource(name, true),
+  upper_end_(0),
+  time_window_(10),
+  time_origin_(0),
+  have_time_origin_(false) {}
+
+RingBufferGeometryResource::~RingBufferGeometryResource() {}
+
+void RingBufferGeometryResource::Initialize(GLenum gl_mode, int capacity,
+    const std::vector<VertexAttribute>& attributes) {
+  if (std::find(attributes.begin(), attributes.end(),
+        VertexAttribute::kVertices) == attributes.end()) {
+    throw std::invalid_argument("Ring buffer geometry must have vertices");
+  }
+  if (capacity <= 0) {
+    throw std::invalid_argument("Invalid ring buffer capacity");
+  }
+
+  for (int attr_ind = 0; attr_ind < kNumVertexAttributes; ++attr_ind) {
+    present_[attr_ind] = false;
+    counts_[attr_ind] = 0;
+  }
+  for (VertexAttribute attribute : attributes) {
+    present_[static_cast<int>(attribute)] = true;
+  }
+  present_[static_cast<int>(VertexAttribute::kTimestamps)] = true;
+
+  gl_mode_ = gl_mode;
+  num_indices_ = 0;
+  primitive_restart_ = false;
+  bounding_box_ = AxisAlignedBox();
+  scans_.clear();
+  upper_end_ = 0;
+  have_time_origin_ = false;
+  timestamps_.reserve(capacity);
+
+  vbo_.setUsagePattern(QOpenGLBuffer::DynamicDraw);
+  AllocateVBO(capacity, false);
+  vbo_.release();
+
+  NotifyBoundingBoxChanged();
+}
+
+void RingBufferGeometryResource::AddScan(const GeometryDataView& data,
+    double timestamp) {
+  if (!created_vbo_) {
+    throw std::logic_error("Initialize() must be called before AddScan()");
+  }
+
+  // Check inputs. The timestamps are filled in from the scan timestamp.
+  const StridedSpan* spans[kNumVertexAttributes];
+  GetSpans(data, spans);
+  const int num_vertices = data.vertices.count;
+  const int timestamps_ind = static_cast<int>(VertexAttribute::kTimestamps);
+  CheckSpans(spans, num_vertices,
+      "Scan data doesn't match the geometry attributes",
+      { VertexAttribute::kTimestamps });
+  if (num_vertices > capacity_) {
+    throw std::invalid_argument("Scan is larger than the ring buffer");
+  }
+
+  if (!have_time_origin_) {
+    time_origin_ = timestamp;
+    have_time_origin_ = true;
+  }
+
+  ExpireScans(timestamp);
+
+  if (num_vertices) {
+    // Place the scan after the newest one, or wrap around to the start of
+    // the buffer if it doesn't fit. Scans in the way are dropped, oldest
+    // first.
+    int first = scans_.empty() ? 0 :
+      scans_.back().first + scans_.back().count;
+    if (first + num_vertices > capacity_) {
+      while (!scans_.empty() && scans_.front().first >= first) {
+        scans_.pop_front();
+      }
+      upper_end_ = first;
+      first = 0;
+    }
+    while (!scans_.empty() && scans_.front().first >= first &&
+        scans_.front().first < first + num_vertices) {
+      scans_.pop_front();
+    }
+
+    timestamps_.assign(num_vertices,
+        static_cast<float>(timestamp - time_origin_));
+    vbo_.bind();
+    for (int attr_ind = 0; attr_ind < kNumVertexAttributes; ++attr_ind) {
+      if (!present_[attr_ind]) {
+        continue;
+      }
+      const VertexAttribute attribute = static_cast<VertexAttribute>(attr_ind);
+      if (attr_ind == timestamps_ind) {
+        WriteSpan(attribute, first,
+            StridedSpan(timestamps_.data(), num_vertices));
+      } else {
+        WriteSpan(attribute, first, *spans[attr_ind]);
+      }
+      counts_[attr_ind] = std::max(counts_[attr_ind], first + num_vertices);
+    }
+    vbo_.release();
+
+    Scan scan;
+    scan.first = first;
+    scan.count = num_vertices;
+    scan.timestamp = timestamp;
+    scan.box = AxisAlignedBox::FromPoints(data.vertices.data, num_vertices,
+        data.vertices.stride);
+    scans_.push_back(scan);
+    dbg("%s: scan at %d (%d vertices), %d scans\n",
+        name_.toStdString().c_str(), first, num_vertices, NumScans());
+  }
+
+  UpdateBoundingBox();
+}
+
+void RingBufferGeometryResource::Expire(double now) {
+  if (ExpireScans(now)) {
+    UpdateBoundingBox();
+  }
+}
+
+void RingBufferGeometryResource::Clear() {
+  scans_.clear();
+  UpdateBoundingBox();
+}
+
+int RingBufferGeometryResource::NumScanVertices() const {
+  int num_vertices = 0;
+  for (const Scan& scan : scans_) {
+    num_vertices += scan.count;
+  }
+  return num_vertices;
+}
+
+int RingBufferGeometryResource::NumDrawRanges() const {
+  if (scans_.empty()) {
+    return 0;
+  }
+  return Wrapped() ? 2 : 1;
+}
+
+void RingBufferGeometryResource::DrawRange(int range, int* first,
+    int* count) const {
+  const Scan& oldest = scans_.front();
+  const Scan& newest = scans_.back();
+  const int newest_end = newest.first + newest.count;
+  if (!Wrapped()) {
+    *first = oldest.first;
+    *count = newest_end - oldest.first;
+  } else if (range == 0) {
+    *first = oldest.first;
+    *count = upper_end_ - oldest.first;
+  } else {
+    *first = 0;
+    *count = newest_end;
+  }
+}
+
+bool RingBufferGeometryResource::Wrapped() const {
+  return !scans_.empty() && scans_.back().first < scans_.front().first;
+}
+
+bool RingBufferGeometryResource::ExpireScans(double now) {
+  const double oldest_time = now - time_window_;
+  bool expired = false;
+  while (!scans_.empty() && scans_.front().timestamp < oldest_time) {
+    scans_.pop_front();
+    expired = true;
+  }
+  return expired;
+}
+
+void RingBufferGeometryResource::UpdateBoundingBox() {
+  AxisAlignedBox box;
+  for (const Scan& scan : scans_) {
+    if (scan.box.Valid()) {
+      box.IncludeBox(scan.box);
+    }
+  }
+  const bool changed = box.Valid() != bounding_box_.Valid() ||
+    (box.Valid() && (box.Min() != bounding_box_.Min() ||
+                     box.Max() != bounding_box_.Max()));
+  if (changed) {
+    bounding_box_ = box;
+    NotifyBoundingBoxChanged();
+  }
+}
+
+}  // namespace sv
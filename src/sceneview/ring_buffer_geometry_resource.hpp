@@ -0,0 +1,176 @@
+// Copyright [2015] Albert Huang
+
+#ifndef SCENEVIEW_RING_BUFFER_GEOMETRY_RESOURCE_HPP__
+#define SCENEVIEW_RING_BUFFER_GEOMETRY_RESOURCE_HPP__
+
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include <sceneview/axis_aligned_box.hpp>
+#include <sceneview/geometry_resource.hpp>
+
+namespace sv {
+
+/**
+ * Fixed-capacity geometry that holds the most recent scans of a live sensor,
+ * such as a lidar.
+ *
+ * Each scan is written into graphics memory after the previous one, wrapping
+ * around to the start of the vertex buffer when the end is reached. Scans
+ * older than a time window, and scans that would be overwritten by a new
+ * scan, are dropped. No memory is allocated after Initialize():
+ *
+ * @code
+ * geom->Initialize(GL_POINTS, 1000000,
+ *     { VertexAttribute::kVertices, VertexAttribute::kDiffuse });
+ * geom->SetTimeWindow(5);
+ *
+ * // For each new scan:
+ * GeometryDataView scan;
+ * scan.vertices = StridedSpan(&points[0].x, num_points, sizeof(Point));
+ * scan.diffuse = StridedSpan(&points[0].r, num_points, sizeof(Point));
+ * geom->AddScan(scan, scan_time);
+ * @endcode
+ *
+ * Every vertex is given a VertexAttribute::kTimestamps value, the time of
+ * its scan in seconds relative to TimeOrigin(). Shaders can read it as the
+ * sv_timestamp attribute, e.g., to fade out older scans.
+ *
+ * The scans are drawn with at most two calls to glDrawArrays(), one for each
+ * contiguous range of the vertex buffer. For strip and loop primitive types,
+ * the last vertex of a scan is connected to the first vertex of the next
+ * one, so GL_POINTS, GL_LINES and GL_TRIANGLES are usually the most useful.
+ * Indices are not supported.
+ *
+ * Since the buffer is filled scan by scan, Load(), LoadAndKeep(), Reserve(),
+ * Update(), SetLods() and GenerateLods() aren't supported, and throw
+ * std::logic_error.
+ *
+ * RingBufferGeometryResource objects cannot be directly instantiated.
+ * Instead, use ResourceManager.
+ *
+ * @ingroup sv_resources
+ * @headerfile sceneview/ring_buffer_geometry_resource.hpp
+ */
+class RingBufferGeometryResource : public GeometryResource {
+  public:
+    typedef std::shared_ptr<RingBufferGeometryResource> Ptr;
+
+    ~RingBufferGeometryResource();
+
+    /**
+     * Discards any existing scans, and allocates graphics memory.
+     *
+     * Must be called with a current OpenGL context, before any call to
+     * AddScan().
+     *
+     * @param gl_mode the primitive type (GL_POINTS, GL_LINES, ...)
+     * @param capacity the total number of vertices that can be held.
+     * @param attributes the vertex attributes that scans provide.
+     *        VertexAttribute::kVertices must be included.
+     *        VertexAttribute::kTimestamps is always added.
+     *
+     * @throw std::invalid_argument if the attributes don't include vertices,
+     * or the capacity isn't positive.
+     */
+    void Initialize(GLenum gl_mode, int capacity,
+        const std::vector<VertexAttribute>& attributes);
+
+    /**
+     * Sets how long scans are kept, in seconds. The default is 10 seconds.
+     */
+    void SetTimeWindow(double seconds) { time_window_ = seconds; }
+
+    double TimeWindow() const { return time_window_; }
+
+    /**
+     * Adds a scan, dropping expired scans and the oldest scans that it
+     * overwrites.
+     *
+     * Each attribute passed to Initialize() must have a span with as many
+     * values as @p data.vertices. Spans of other attributes, including
+     * @p data.timestamps, must be empty. @p data.gl_mode and indices are
+     * ignored.
+     *
+     * @param data the scan data.
+     * @param timestamp the time of the scan, in seconds. Scans must be added
+     *        in chronological order.
+     *
+     * @throw std::invalid_argument if the spans don't match the attributes
+     * passed to Initialize(), or the scan has more vertices than the
+     * capacity.
+     */
+    void AddScan(const GeometryDataView& data, double timestamp);
+
+    /**
+     * Drops scans that are older than the time window.
+     *
+     * Useful to clear out old scans when no new scans arrive.
+     *
+     * @param now the current time, in seconds.
+     */
+    void Expire(double now);
+
+    /**
+     * Drops all scans.
+     */
+    void Clear();
+
+    /**
+     * Retrieve the time that per-vertex timestamps are relative to. This is
+     * the timestamp of the first scan added after Initialize().
+     */
+    double TimeOrigin() const { return time_origin_; }
+
+    /**
+     * Retrieve the number of scans held.
+     */
+    int NumScans() const { return scans_.size(); }
+
+    /**
+     * Retrieve the number of vertices in the held scans.
+     */
+    int NumScanVertices() const;
+
+    int NumDrawRanges() const override;
+
+    void DrawRange(int range, int* first, int* count) const override;
+
+  private:
+    friend class ResourceManager;
+
+    struct Scan {
+      int first;
+      int count;
+      double timestamp;
+      AxisAlignedBox box;
+    };
+
+    explicit RingBufferGeometryResource(const QString& name);
+
+    // Returns true if the oldest scan is in the upper part of the vertex
+    // buffer, and newer scans have wrapped around to the start.
+    bool Wrapped() const;
+
+    // Returns true if any scans were dropped.
+    bool ExpireScans(double now);
+
+    void UpdateBoundingBox();
+
+    std::deque<Scan> scans_;
+
+    // When wrapped, the end of the last scan in the upper part of the buffer.
+    int upper_end_;
+
+    double time_window_;
+    double time_origin_;
+    bool have_time_origin_;
+
+    // Reused to upload the timestamps of each scan.
+    std::vector<float> timestamps_;
+};
+
+}  // namespace sv
+
+#endif  // SCENEVIEW_RING_BUFFER_GEOMETRY_RESOURCE_HPP__
@@ -1,6 +1,9 @@
 // Copyright [2015] Albert Huang
 
 #include "sceneview/scene_node.hpp"
+
+#include <QVector4D>
+
 #include "sceneview/group_node.hpp"
 
 namespace sv {
@@ -11,20 +14,50 @@ SceneNode::SceneNode(const QString& node_name) :
 const QMatrix4x4& SceneNode::WorldTransform() {
   if (to_world_dirty_) {
     if (parent_node_) {
+      // The translation is rotated and scaled by the parent in single
+      // precision, and added to the parent's origin in double precision.
       to_world_ = parent_node_->WorldTransform();
+      const Vector3d& parent_origin = parent_node_->WorldOrigin();
+      const Vector3d& t = precise_translation_;
+      world_origin_ = Vector3d(
+          parent_origin.x + to_world_(0, 0) * t.x + to_world_(0, 1) * t.y +
+          to_world_(0, 2) * t.z,
+          parent_origin.y + to_world_(1, 0) * t.x + to_world_(1, 1) * t.y +
+          to_world_(1, 2) * t.z,
+          parent_origin.z + to_world_(2, 0) * t.x + to_world_(2, 1) * t.y +
+          to_world_(2, 2) * t.z);
     } else {
       to_world_.setToIdentity();
+      world_origin_ = precise_translation_;
     }
-    to_world_.translate(translation_);
     to_world_.rotate(rotation_);
     to_world_.scale(scale_);
+    to_world_.setColumn(3, QVector4D(world_origin_.ToVector3D(), 1));
     to_world_dirty_ = false;
   }
   return to_world_;
 }
 
+const Vector3d& SceneNode::WorldOrigin() {
+  WorldTransform();
+  return world_origin_;
+}
+
+QMatrix4x4 SceneNode::RelativeTransform(const Vector3d& origin) {
+  QMatrix4x4 result = WorldTransform();
+  result.setColumn(3, QVector4D((world_origin_ - origin).ToVector3D(), 1));
+  return result;
+}
+
 void SceneNode::SetTranslation(const QVector3D& vec) {
   translation_ = vec;
+  precise_translation_ = Vector3d(vec);
+  TransformChanged();
+}
+
+void SceneNode::SetPreciseTranslation(const Vector3d& vec) {
+  translation_ = vec.ToVector3D();
+  precise_translation_ = vec;
   TransformChanged();
 }
 
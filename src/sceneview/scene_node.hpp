@@ -8,6 +8,7 @@
 #include <QMatrix4x4>
 
 #include <sceneview/axis_aligned_box.hpp>
+#include <sceneview/vector3d.hpp>
 
 namespace sv {
 
@@ -31,6 +32,8 @@ class GroupNode;
  * The SceneNode class maintains state common to all scene graph nodes:
  * - Node transform.
  *   - Represented as Translation * Rotation * Scale.
+ *   - The translation is kept in double precision, and so is the world
+ *     position of the node's origin, for scenes far from the origin.
  * - Node name.
  * - Node visibility.
  * - Parent node.
@@ -61,6 +64,14 @@ class SceneNode {
      */
     const QVector3D& Translation() const { return translation_; }
 
+    /**
+     * Retrieve the translation component of the node to parent transform,
+     * in double precision.
+     */
+    const Vector3d& PreciseTranslation() const {
+      return precise_translation_;
+    }
+
     /**
      * Retrieve the rotation component of the node to parent transform.
      */
@@ -79,6 +90,28 @@ class SceneNode {
      */
     const QMatrix4x4& WorldTransform();
 
+    /**
+     * Retrieve the world position of the node's origin, in double
+     * precision.
+     *
+     * The translations of the nodes from this node to the root are chained
+     * in double precision. Their rotations and scales are applied in single
+     * precision, so large translations should be on nodes whose ancestors
+     * are not rotated or scaled, e.g., the children of the root.
+     */
+    const Vector3d& WorldOrigin();
+
+    /**
+     * Retrieve the transform from node coordinates to world coordinates
+     * shifted so that @p origin is at zero.
+     *
+     * The shift is done in double precision, so if @p origin is near the
+     * node, e.g., the position of the camera, the result is accurate even
+     * when the node is far from the world origin. DrawContext draws with
+     * these camera-relative transforms.
+     */
+    QMatrix4x4 RelativeTransform(const Vector3d& origin);
+
     /**
      * Check if the node is visible or not.
      */
@@ -93,9 +126,15 @@ class SceneNode {
      * Sets the translation component of the node transform.
      */
     void SetTranslation(double x, double y, double z) {
-      SetTranslation(QVector3D(x, y, z));
+      SetPreciseTranslation(Vector3d(x, y, z));
     }
 
+    /**
+     * Sets the translation component of the node transform, in double
+     * precision.
+     */
+    void SetPreciseTranslation(const Vector3d& vec);
+
     /**
      * Sets the rotation component of the node to parent transform.
      */
@@ -181,10 +220,12 @@ class SceneNode {
     const QString node_name_;
 
     QVector3D translation_;
+    Vector3d precise_translation_;
     QQuaternion rotation_;
     QVector3D scale_{1, 1, 1};
 
     QMatrix4x4 to_world_;
+    Vector3d world_origin_;
     bool to_world_dirty_ = true;
 
     GroupNode* parent_node_ = nullptr;
@@ -11,35 +11,65 @@
 // to select exactly the right subset, so you can just include this one for
 // convenience.
 
+#include <sceneview/anchor_set.hpp>
 #include <sceneview/asset_importer.hpp>
 #include <sceneview/axis_aligned_box.hpp>
+#include <sceneview/camera_image.hpp>
 #include <sceneview/camera_node.hpp>
+#include <sceneview/chunked_mesh_resource.hpp>
+#include <sceneview/clip_volume.hpp>
+#include <sceneview/colormap.hpp>
+#include <sceneview/depth_cloud.hpp>
 #include <sceneview/draw_group.hpp>
 #include <sceneview/expander_widget.hpp>
 #include <sceneview/font_resource.hpp>
 #include <sceneview/geometry_resource.hpp>
 #include <sceneview/grid_renderer.hpp>
 #include <sceneview/group_node.hpp>
+#include <sceneview/growing_geometry_resource.hpp>
+#include <sceneview/heightfield.hpp>
+#include <sceneview/heightfield_clipmap.hpp>
+#include <sceneview/imported_asset.hpp>
 #include <sceneview/input_handler.hpp>
 #include <sceneview/input_handler_widget_stack.hpp>
 #include <sceneview/light_node.hpp>
 #include <sceneview/material_resource.hpp>
+#include <sceneview/mesh_optimizer.hpp>
+#include <sceneview/mesh_simplifier.hpp>
 #include <sceneview/draw_node.hpp>
+#include <sceneview/paged_tile_set.hpp>
 #include <sceneview/param_widget.hpp>
+#include <sceneview/point_cloud_octree.hpp>
+#include <sceneview/point_cloud_reader.hpp>
+#include <sceneview/point_cloud_resource.hpp>
+#include <sceneview/polyline_simplifier.hpp>
+#include <sceneview/range_allocator.hpp>
 #include <sceneview/renderer.hpp>
 #include <sceneview/renderer_widget_stack.hpp>
 #include <sceneview/resource_manager.hpp>
+#include <sceneview/ring_buffer_geometry_resource.hpp>
 #include <sceneview/scene.hpp>
 #include <sceneview/scene_node.hpp>
 #include <sceneview/sceneview.hpp>
 #include <sceneview/selection_query.hpp>
 #include <sceneview/shader_resource.hpp>
 #include <sceneview/shader_uniform.hpp>
+#include <sceneview/splat_hole_fill_renderer.hpp>
 #include <sceneview/stock_resources.hpp>
+#include <sceneview/streaming_geometry_resource.hpp>
+#include <sceneview/streaming_texture_resource.hpp>
 #include <sceneview/text_billboard.hpp>
+#include <sceneview/thread_pool.hpp>
+#include <sceneview/trajectory.hpp>
+#include <sceneview/vector3d.hpp>
 #include <sceneview/viewer.hpp>
 #include <sceneview/view_handler_horizontal.hpp>
+#include <sceneview/view_frustum.hpp>
 #include <sceneview/viewport.hpp>
+#include <sceneview/virtual_texture_layer.hpp>
+#include <sceneview/virtual_texture_page_table.hpp>
+#include <sceneview/voxel_map.hpp>
+#include <sceneview/voxel_mesher.hpp>
 
 /**
  * @defgroup sv_resources Resource System
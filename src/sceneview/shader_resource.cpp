@@ -30,7 +30,7 @@ void ShaderResource::LoadFromFiles(const QString& prefix,
   const std::string cprefix = prefix.toStdString();
 
   if (vshader_file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-    const QString vshader_src = preamble +
+    const QString vshader_src = "#define SV_VERTEX_SHADER\n" + preamble +
       QTextStream(&vshader_file).readAll();
 
     if (!program_->addShaderFromSourceCode(
@@ -41,7 +41,7 @@ void ShaderResource::LoadFromFiles(const QString& prefix,
   }
 
   if (fshader_file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-    const QString fshader_src = preamble +
+    const QString fshader_src = "#define SV_FRAGMENT_SHADER\n" + preamble +
       QTextStream(&fshader_file).readAll();
     if (!program_->addShaderFromSourceCode(
           QOpenGLShader::Fragment, fshader_src)) {
@@ -75,6 +75,8 @@ void ShaderResource::LoadLocations() {
   locations_.sv_mv_mat = program_->uniformLocation("sv_mv_mat");
   locations_.sv_model_normal_mat =
     program_->uniformLocation("sv_model_normal_mat");
+  locations_.sv_viewport_size = program_->uniformLocation("sv_viewport_size");
+  locations_.sv_clip_planes = program_->uniformLocation("sv_clip_planes");
 
   locations_.sv_lights.resize(kShaderMaxLights);
 
@@ -98,6 +100,10 @@ void ShaderResource::LoadLocations() {
   locations_.sv_specular = program_->attributeLocation("sv_specular");
   locations_.sv_shininess = program_->attributeLocation("sv_shininess");
   locations_.sv_tex_coords_0 = program_->attributeLocation("sv_tex_coords_0");
+  locations_.sv_timestamp = program_->attributeLocation("sv_timestamp");
+  locations_.sv_anchor = program_->attributeLocation("sv_anchor");
+  locations_.sv_scalar = program_->attributeLocation("sv_scalar");
+  locations_.sv_label = program_->attributeLocation("sv_label");
 }
 
 }  // namespace sv
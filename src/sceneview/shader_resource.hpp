@@ -86,6 +86,19 @@ struct ShaderStandardVariables {
    */
   int sv_model_normal_mat;
 
+  /**
+   * Size of the viewport, in pixels.
+   * Type: vec2
+   */
+  int sv_viewport_size;
+
+  /**
+   * Clip planes of the draw group, in world space, for shaders that write
+   * gl_ClipDistance. Planes that aren't used are zero.
+   * Type: vec4[8]
+   */
+  int sv_clip_planes;
+
   // Lights
   std::vector<ShaderLightLocation> sv_lights;
 
@@ -126,6 +139,26 @@ struct ShaderStandardVariables {
    * Texture coordinates set 0
    */
   int sv_tex_coords_0;
+
+  /**
+   * Per-vertex timestamp.
+   */
+  int sv_timestamp;
+
+  /**
+   * Per-vertex anchor index.
+   */
+  int sv_anchor;
+
+  /**
+   * Per-vertex scalar value.
+   */
+  int sv_scalar;
+
+  /**
+   * Per-vertex label.
+   */
+  int sv_label;
 };
 
 /**
@@ -160,7 +193,9 @@ class ShaderResource {
      *        added to the fragment shader filename.
      * @param preamble text to prepend to both the vertex and fragment shaders
      *        before compiling. You can use this to define preprocessor
-     *        constants, etc.
+     *        constants, etc. SV_VERTEX_SHADER or SV_FRAGMENT_SHADER is
+     *        defined before the preamble, so that it can hold code for only
+     *        one of the stages.
      */
     void LoadFromFiles(const QString& prefix, const QString& preamble);
 
@@ -0,0 +1,166 @@
+// Copyright [2015] Albert Huang
+
+#include "sceneview/internal_gl.hpp"
+
+#include "sceneview/splat_hole_fill_renderer.hpp"
+
+#include <QOpenGLShaderProgram>
+#include <QVector2D>
+#include <QVector3D>
+
+#include "sceneview/camera_node.hpp"
+#include "sceneview/viewport.hpp"
+
+namespace sv {
+
+SplatHoleFillRenderer::SplatHoleFillRenderer(const QString& name,
+    QObject* parent) :
+  Renderer(name, parent),
+  depth_threshold_(0.05),
+  framebuffer_(0),
+  color_texture_(0),
+  depth_texture_(0),
+  width_(0),
+  height_(0) {}
+
+void SplatHoleFillRenderer::InitializeGL() {
+  shader_ = GetResources()->MakeShader();
+  shader_->LoadFromFiles(":sceneview/stock_shaders/hole_fill");
+
+  // A quad covering the viewport, in normalized device coordinates.
+  GeometryData gdata;
+  gdata.gl_mode = GL_TRIANGLE_STRIP;
+  gdata.vertices = {
+    QVector3D(-1, -1, 0),
+    QVector3D(1, -1, 0),
+    QVector3D(-1, 1, 0),
+    QVector3D(1, 1, 0),
+  };
+  quad_ = GetResources()->MakeGeometry();
+  quad_->Load(gdata);
+}
+
+void SplatHoleFillRenderer::RenderEnd() {
+#ifdef GL_READ_FRAMEBUFFER
+  GLint viewport[4];
+  glGetIntegerv(GL_VIEWPORT, viewport);
+  if (viewport[2] <= 0 || viewport[3] <= 0) {
+    return;
+  }
+  ResizeTargets(viewport[2], viewport[3]);
+
+  // Copy the frame, resolving multisampling.
+  GLint scene_framebuffer = 0;
+  glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &scene_framebuffer);
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, scene_framebuffer);
+  glBindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffer_);
+  glBlitFramebuffer(viewport[0], viewport[1], viewport[0] + width_,
+      viewport[1] + height_, 0, 0, width_, height_,
+      GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+  glBindFramebuffer(GL_FRAMEBUFFER, scene_framebuffer);
+
+  const QMatrix4x4 proj_mat = GetViewport()->GetCamera()->GetProjectionMatrix();
+  const bool perspective = proj_mat(3, 3) == 0;
+
+  QOpenGLShaderProgram* program = shader_->Program();
+  program->bind();
+  program->setUniformValue("color_texture", 0);
+  program->setUniformValue("depth_texture", 1);
+  program->setUniformValue("texel_size",
+      QVector2D(1.0 / width_, 1.0 / height_));
+  program->setUniformValue("viewport_offset",
+      QVector2D(viewport[0], viewport[1]));
+  program->setUniformValue("depth_params",
+      QVector3D(proj_mat(2, 2), proj_mat(2, 3), perspective ? 1 : 0));
+  program->setUniformValue("depth_threshold", depth_threshold_);
+
+  glActiveTexture(GL_TEXTURE1);
+  glBindTexture(GL_TEXTURE_2D, depth_texture_);
+  glActiveTexture(GL_TEXTURE0);
+  glBindTexture(GL_TEXTURE_2D, color_texture_);
+
+  // Only holes are written, so the depth test is turned off rather than
+  // the depth buffer cleared.
+  glPushAttrib(GL_DEPTH_BUFFER_BIT | GL_ENABLE_BIT);
+  glEnable(GL_DEPTH_TEST);
+  glDepthFunc(GL_ALWAYS);
+  glDepthMask(GL_TRUE);
+  glDisable(GL_BLEND);
+  glDisable(GL_CULL_FACE);
+  const int pos_loc = shader_->StandardVariables().sv_vert_pos;
+  quad_->VBO()->bind();
+  program->enableAttributeArray(pos_loc);
+  program->setAttributeBuffer(pos_loc, GL_FLOAT, quad_->VertexOffset(), 3);
+  glDrawArrays(quad_->GLMode(), 0, quad_->NumVertices());
+  program->disableAttributeArray(pos_loc);
+  quad_->VBO()->release();
+  glPopAttrib();
+
+  glActiveTexture(GL_TEXTURE1);
+  glBindTexture(GL_TEXTURE_2D, 0);
+  glActiveTexture(GL_TEXTURE0);
+  glBindTexture(GL_TEXTURE_2D, 0);
+  program->release();
+#endif
+}
+
+void SplatHoleFillRenderer::ShutdownGL() {
+#ifdef GL_READ_FRAMEBUFFER
+  if (framebuffer_) {
+    glDeleteFramebuffers(1, &framebuffer_);
+    glDeleteTextures(1, &color_texture_);
+    glDeleteTextures(1, &depth_texture_);
+    framebuffer_ = 0;
+    color_texture_ = 0;
+    depth_texture_ = 0;
+  }
+#endif
+  shader_.reset();
+  quad_.reset();
+}
+
+void SplatHoleFillRenderer::ResizeTargets(int width, int height) {
+#ifdef GL_READ_FRAMEBUFFER
+  if (framebuffer_ && width == width_ && height == height_) {
+    return;
+  }
+  width_ = width;
+  height_ = height;
+
+  if (!framebuffer_) {
+    glGenFramebuffers(1, &framebuffer_);
+    glGenTextures(1, &color_texture_);
+    glGenTextures(1, &depth_texture_);
+  }
+
+  glBindTexture(GL_TEXTURE_2D, color_texture_);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA,
+      GL_UNSIGNED_BYTE, nullptr);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+  // Blitting depth needs the same format as the frame, which
+  // QOpenGLWidget creates with a packed depth and stencil buffer.
+  glBindTexture(GL_TEXTURE_2D, depth_texture_);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH24_STENCIL8, width, height, 0,
+      GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, nullptr);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glBindTexture(GL_TEXTURE_2D, 0);
+
+  GLint scene_framebuffer = 0;
+  glGetIntegerv(GL_FRAMEBUFFER_BINDING, &scene_framebuffer);
+  glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_);
+  glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
+      color_texture_, 0);
+  glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT,
+      GL_TEXTURE_2D, depth_texture_, 0);
+  glBindFramebuffer(GL_FRAMEBUFFER, scene_framebuffer);
+#endif
+}
+
+}  // namespace sv
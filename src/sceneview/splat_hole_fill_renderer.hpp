@@ -0,0 +1,66 @@
+// Copyright [2015] Albert Huang
+
+#ifndef SCENEVIEW_SPLAT_HOLE_FILL_RENDERER_HPP__
+#define SCENEVIEW_SPLAT_HOLE_FILL_RENDERER_HPP__
+
+#include <sceneview/geometry_resource.hpp>
+#include <sceneview/renderer.hpp>
+#include <sceneview/shader_resource.hpp>
+
+namespace sv {
+
+/**
+ * Fills the holes between point splats in a full screen pass after the
+ * scene is drawn.
+ *
+ * With splats sized by StockResources::kSplatPerVertexColor, sparse parts of
+ * a point cloud can still leave gaps of a few pixels, through which the
+ * background or hidden surfaces show. This renderer copies the color and
+ * depth of the frame, and fills each pixel that has nearer pixels on both
+ * sides in most directions with their average color and depth. The search
+ * is depth-aware, so silhouettes aren't grown and thin lines aren't
+ * thickened.
+ *
+ * Add it to the viewer after the renderers whose points it should fill, and
+ * disable it like any other renderer. It needs framebuffer objects and
+ * framebuffer blits (OpenGL 3.0).
+ *
+ * @ingroup sv_gui
+ * @headerfile sceneview/splat_hole_fill_renderer.hpp
+ */
+class SplatHoleFillRenderer : public Renderer {
+  Q_OBJECT
+
+  public:
+    explicit SplatHoleFillRenderer(const QString& name, QObject* parent = 0);
+
+    /**
+     * Sets the fraction of its distance to the camera by which a pixel
+     * must be nearer than a hole to fill it. The default is 0.05.
+     */
+    void SetDepthThreshold(float fraction) { depth_threshold_ = fraction; }
+
+    void InitializeGL() override;
+
+    void RenderEnd() override;
+
+    void ShutdownGL() override;
+
+  private:
+    void ResizeTargets(int width, int height);
+
+    ShaderResource::Ptr shader_;
+    GeometryResource::Ptr quad_;
+
+    float depth_threshold_;
+
+    unsigned int framebuffer_;
+    unsigned int color_texture_;
+    unsigned int depth_texture_;
+    int width_;
+    int height_;
+};
+
+}  // namespace sv
+
+#endif  // SCENEVIEW_SPLAT_HOLE_FILL_RENDERER_HPP__
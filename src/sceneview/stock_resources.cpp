@@ -2,12 +2,15 @@
 
 #include "sceneview/stock_resources.hpp"
 
+#include <algorithm>
 #include <cassert>
 #include <cmath>
+#include <limits>
 #include <map>
 #include <utility>
 #include <vector>
 
+#include <QOpenGLTexture>
 #include <QVector4D>
 
 namespace sv {
@@ -32,8 +35,54 @@ static GeometryResource::Ptr GetOrMakeGeometry(const QString& name,
   return geom;
 }
 
+// Loads several tessellations of the same shape into a single geometry
+// resource, with the first one as the full resolution geometry and the rest
+// as coarser levels of detail. The vertices of all tessellations are stored
+// back to back in one vertex buffer.
+static GeometryResource::Ptr GetOrMakeLodGeometry(const QString& name,
+    std::function<GeometryData(int)> data_function,
+    const std::vector<int>& tessellations,
+    const ResourceManager::Ptr& res) {
+  GeometryResource::Ptr geom = res->GetGeometry(name);
+  if (geom) {
+    return geom;
+  }
+
+  GeometryData merged;
+  std::vector<std::vector<uint32_t>> lod_indices;
+  for (int tessellation : tessellations) {
+    const GeometryData level = data_function(tessellation);
+    const uint32_t first_vertex = merged.vertices.size();
+    merged.gl_mode = level.gl_mode;
+    merged.vertices.insert(merged.vertices.end(), level.vertices.begin(),
+        level.vertices.end());
+    merged.normals.insert(merged.normals.end(), level.normals.begin(),
+        level.normals.end());
+
+    std::vector<uint32_t> indices(level.indices);
+    for (uint32_t& index : indices) {
+      index += first_vertex;
+    }
+    if (merged.indices.empty()) {
+      merged.indices.swap(indices);
+    } else {
+      lod_indices.push_back(indices);
+    }
+  }
+
+  geom = res->MakeGeometry(name);
+  geom->Load(merged);
+  geom->SetLods(lod_indices);
+  return geom;
+}
+
+// Tessellation levels for the stock shapes, from finest to coarsest.
+static const std::vector<int> kSphereSubdivisions = { 3, 2, 1 };
+static const std::vector<int> kNumSlices = { 32, 16, 8 };
+
 GeometryResource::Ptr StockResources::Cone() {
-  return GetOrMakeGeometry("geom:sv_cone", ConeData, resources_);
+  return GetOrMakeLodGeometry("geom:sv_cone", ConeData, kNumSlices,
+      resources_);
 }
 
 GeometryResource::Ptr StockResources::Cube() {
@@ -41,11 +90,13 @@ GeometryResource::Ptr StockResources::Cube() {
 }
 
 GeometryResource::Ptr StockResources::Cylinder() {
-  return GetOrMakeGeometry("geom:sv_cylinder", CylinderData, resources_);
+  return GetOrMakeLodGeometry("geom:sv_cylinder", CylinderData, kNumSlices,
+      resources_);
 }
 
 GeometryResource::Ptr StockResources::Sphere() {
-  return GetOrMakeGeometry("geom:sv_sphere", SphereData, resources_);
+  return GetOrMakeLodGeometry("geom:sv_sphere", SphereData,
+      kSphereSubdivisions, resources_);
 }
 
 Drawable::Ptr StockResources::UnitAxes() {
@@ -67,6 +118,26 @@ struct StockShaderData {
   QString preamble;
 };
 
+// Prepended to every stock shader, after its defines. Clip() clips a vertex
+// against the clip planes of the draw group. Shaders compiled as GLSL 1.30 or
+// later write gl_ClipDistance for the world space planes, and older ones
+// write gl_ClipVertex for the eye space planes set up by DrawContext.
+static const char* kStockPreamble =
+  "#ifdef SV_VERTEX_SHADER\n"
+  "uniform mat4 sv_view_mat;\n"
+  "#if __VERSION__ >= 130\n"
+  "uniform vec4 sv_clip_planes[8];\n"
+  "#endif\n"
+  "void Clip(vec4 world_pos) {\n"
+  "#if __VERSION__ >= 130\n"
+  "  for (int ind = 0; ind < 8; ++ind)\n"
+  "    gl_ClipDistance[ind] = dot(sv_clip_planes[ind], world_pos);\n"
+  "#else\n"
+  "  gl_ClipVertex = sv_view_mat * world_pos;\n"
+  "#endif\n"
+  "}\n"
+  "#endif\n";
+
 static std::vector<StockShaderData> g_stock_shader_data = {
   { StockResources::kUniformColorNoLighting, "no_lighting",
     "#define COLOR_UNIFORM\n" },
@@ -83,7 +154,43 @@ static std::vector<StockShaderData> g_stock_shader_data = {
   { StockResources::kBillboardTextured, "billboard",
     "#define USE_TEXTURE0\n" },
   { StockResources::kBillboardUniformColor, "billboard",
-    "#define COLOR_UNIFORM\n" }
+    "#define COLOR_UNIFORM\n" },
+  { StockResources::kVirtualTextureUniformColorNoLighting, "no_lighting",
+    "#define COLOR_UNIFORM\n#define VIRTUAL_TEXTURE\n" },
+  { StockResources::kHeightfieldLighting, "lighting",
+    "#define COLOR_PER_VERTEX\n#define HEIGHTFIELD\n" },
+  { StockResources::kInstancedPosePerVertexColorNoLighting, "no_lighting",
+    "#define COLOR_PER_VERTEX\n#define INSTANCED_POSE\n" },
+  { StockResources::kAnchoredPerVertexColorNoLighting, "no_lighting",
+    "#define COLOR_PER_VERTEX\n#define ANCHORED\n" },
+  { StockResources::kAnchoredPerVertexColorLighting, "lighting",
+    "#define COLOR_PER_VERTEX\n#define ANCHORED\n" },
+  { StockResources::kScalarColormapNoLighting, "no_lighting",
+    "#define SCALAR_COLORMAP\n#define RANGE_FILTER\n" },
+  { StockResources::kLabelPaletteNoLighting, "no_lighting",
+    "#define LABEL_PALETTE\n#define RANGE_FILTER\n" },
+  { StockResources::kRangeFilterPerVertexColorNoLighting, "no_lighting",
+    "#define COLOR_PER_VERTEX\n#define RANGE_FILTER\n" },
+  { StockResources::kSplatPerVertexColor, "splat",
+    "#define COLOR_PER_VERTEX\n" },
+  { StockResources::kSplatUniformColor, "splat",
+    "#define COLOR_UNIFORM\n" },
+  { StockResources::kOrientedSplatPerVertexColor, "splat",
+    "#define COLOR_PER_VERTEX\n#define ORIENTED\n" },
+  { StockResources::kMonoImageNoLighting, "no_lighting",
+    "#define COLOR_UNIFORM\n#define CAMERA_IMAGE\n#define MONO_IMAGE\n" },
+  { StockResources::kNV12ImageNoLighting, "no_lighting",
+    "#define COLOR_UNIFORM\n#define CAMERA_IMAGE\n#define NV12_IMAGE\n" },
+  { StockResources::kYUYVImageNoLighting, "no_lighting",
+    "#define COLOR_UNIFORM\n#define CAMERA_IMAGE\n#define YUYV_IMAGE\n" },
+  { StockResources::kBayerImageNoLighting, "no_lighting",
+    "#define COLOR_UNIFORM\n#define CAMERA_IMAGE\n#define BAYER_IMAGE\n" },
+  { StockResources::kDepthImageNoLighting, "no_lighting",
+    "#define COLOR_UNIFORM\n#define CAMERA_IMAGE\n#define DEPTH_IMAGE\n" },
+  { StockResources::kDepthCloudColormap, "depth_cloud",
+    "#define DEPTH_COLORMAP\n" },
+  { StockResources::kDepthCloudColorImage, "depth_cloud",
+    "#define COLOR_IMAGE\n" }
 };
 
 static const StockShaderData& GetStockShaderData(
@@ -104,7 +211,7 @@ ShaderResource::Ptr StockResources::Shader(StockShaderId id) {
   if (!shader) {
     shader = resources_->MakeShader(shader_name);
     shader->LoadFromFiles(":sceneview/stock_shaders/" + sdata.fname_stem,
-        sdata.preamble);
+        sdata.preamble + kStockPreamble);
     if (!shader) {
       shader.reset();
     }
@@ -113,7 +220,74 @@ ShaderResource::Ptr StockResources::Shader(StockShaderId id) {
 }
 
 MaterialResource::Ptr StockResources::NewMaterial(StockShaderId id) {
-  return resources_->MakeMaterial(Shader(id));
+  MaterialResource::Ptr material = resources_->MakeMaterial(Shader(id));
+  switch (id) {
+    case kScalarColormapNoLighting:
+      material->SetParam("scalar_source", 1.0f, 0.0f, 0.0f);
+      material->SetParam("scalar_range", 0.0f, 1.0f);
+      // Fall through
+    case kLabelPaletteNoLighting:
+    case kRangeFilterPerVertexColorNoLighting:
+      material->SetParam("filter_min", std::vector<float>(4,
+            -std::numeric_limits<float>::max()));
+      material->SetParam("filter_max", std::vector<float>(4,
+            std::numeric_limits<float>::max()));
+      break;
+    case kSplatPerVertexColor:
+    case kSplatUniformColor:
+    case kOrientedSplatPerVertexColor:
+      material->SetProgramPointSize(true);
+      material->SetParam("splat_radius", 0.01f);
+      material->SetParam("splat_size_range", 1.0f, 64.0f);
+      break;
+    case kDepthCloudColormap:
+      material->SetParam("depth_range", 0.0f, 10.0f);
+      // Fall through
+    case kDepthCloudColorImage:
+      material->SetParam("depth_scale", 0.001f);
+      material->SetParam("depth_max", 10.0f);
+      material->SetParam("depth_edge_ratio", 0.0f);
+      break;
+    case kDepthImageNoLighting:
+      material->SetParam("depth_scale", 0.001f);
+      material->SetParam("depth_range", 0.0f, 10.0f);
+      // Fall through
+    case kMonoImageNoLighting:
+    case kNV12ImageNoLighting:
+    case kYUYVImageNoLighting:
+    case kBayerImageNoLighting:
+      material->SetParam(kColor, 1.0f, 1.0f, 1.0f, 1.0f);
+      break;
+    default:
+      break;
+  }
+  return material;
+}
+
+// Makes a single row RGBA texture.
+static std::shared_ptr<QOpenGLTexture> MakeRowTexture(
+    const std::vector<uint8_t>& rgba, QOpenGLTexture::Filter filter) {
+  std::shared_ptr<QOpenGLTexture> texture(
+      new QOpenGLTexture(QOpenGLTexture::Target2D));
+  texture->setSize(rgba.size() / 4, 1);
+  texture->setFormat(QOpenGLTexture::RGBA8_UNorm);
+  texture->allocateStorage();
+  texture->setData(QOpenGLTexture::RGBA, QOpenGLTexture::UInt8, rgba.data());
+  texture->setMinificationFilter(filter);
+  texture->setMagnificationFilter(filter);
+  texture->setWrapMode(QOpenGLTexture::ClampToEdge);
+  return texture;
+}
+
+std::shared_ptr<QOpenGLTexture> StockResources::ColormapTexture(
+    Colormap colormap) {
+  return MakeRowTexture(ColormapRgba(colormap), QOpenGLTexture::Linear);
+}
+
+std::shared_ptr<QOpenGLTexture> StockResources::LabelPaletteTexture(
+    int num_labels) {
+  return MakeRowTexture(LabelPaletteRgba(std::max(num_labels, 1)),
+      QOpenGLTexture::Nearest);
 }
 
 GeometryData StockResources::CubeData() {
@@ -245,7 +419,7 @@ struct SphereSubdivider {
   GeometryData output;
 };
 
-GeometryData StockResources::SphereData() {
+GeometryData StockResources::SphereData(int num_subdivisions) {
   GeometryData result;
   result.gl_mode = GL_TRIANGLES;
   result.vertices = {
@@ -268,7 +442,6 @@ GeometryData StockResources::SphereData() {
     1, 6, 2, 2, 7, 3, 3, 8, 4, 4, 9, 5, 5, 10, 1,
     11, 6, 10, 11, 7, 6, 11, 8, 7, 11, 9, 8, 11, 10, 9
   };
-  const int num_subdivisions = 2;
   for (int i = 0; i < num_subdivisions; ++i) {
     result = SphereSubdivider(result).output;
   }
@@ -279,13 +452,12 @@ GeometryData StockResources::SphereData() {
   return result;
 }
 
-GeometryData StockResources::ConeData() {
+GeometryData StockResources::ConeData(int num_slices) {
   GeometryData result;
 
   const double radius = 0.5;
   const double height = 1.0;
   const double half_height = height / 2;
-  const int num_slices = 16;
 
   const double dtheta = 2 * M_PI / num_slices;
   const double half_dtheta = dtheta / 2;
@@ -331,13 +503,12 @@ GeometryData StockResources::ConeData() {
   return result;
 }
 
-GeometryData StockResources::CylinderData() {
+GeometryData StockResources::CylinderData(int num_slices) {
   GeometryData result;
   result.gl_mode = GL_TRIANGLES;
 
   const double radius = 0.5;
   const double half_height = 0.5;
-  const int num_slices = 16;
 
   std::vector<float> x_pts(num_slices);
   std::vector<float> y_pts(num_slices);
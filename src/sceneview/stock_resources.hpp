@@ -4,10 +4,13 @@
 #define SCENEVIEW_STOCK_RESOURCES_HPP_
 
 #include <memory>
+#include <sceneview/colormap.hpp>
 #include <sceneview/geometry_resource.hpp>
 #include <sceneview/resource_manager.hpp>
 #include <sceneview/drawable.hpp>
 
+class QOpenGLTexture;
+
 namespace sv {
 
 /**
@@ -226,7 +229,187 @@ class StockResources {
        */
       kTextureUniformColorLighting,
       kBillboardTextured,
-      kBillboardUniformColor
+      kBillboardUniformColor,
+      /**
+       * Like kTextureUniformColorNoLighting, but the texture is a virtual
+       * texture drawn by VirtualTextureLayer, which sets the textures and
+       * parameters it needs.
+       */
+      kVirtualTextureUniformColorNoLighting,
+      /**
+       * Like kPerVertexColorLighting, but vertices are displaced by a height
+       * texture and colored by height. Used by Heightfield, which sets the
+       * texture and parameters it needs.
+       */
+      kHeightfieldLighting,
+      /**
+       * Like kPerVertexColorNoLighting, but each vertex is scaled by the
+       * float uniform instance_scale, rotated by the per-instance quaternion
+       * attribute sv_instance_rot (x, y, z, w), and translated by the
+       * per-instance attribute sv_instance_pos. Used by Trajectory to draw
+       * coordinate axes with instancing.
+       */
+      kInstancedPosePerVertexColorNoLighting,
+      /**
+       * Like kPerVertexColorNoLighting, but each vertex is relative to the
+       * pose of its anchor in an AnchorSet. Set up the material with
+       * AnchorSet::ApplyTo().
+       */
+      kAnchoredPerVertexColorNoLighting,
+      /**
+       * Like kPerVertexColorLighting, but each vertex is relative to the
+       * pose of its anchor in an AnchorSet. Set up the material with
+       * AnchorSet::ApplyTo().
+       */
+      kAnchoredPerVertexColorLighting,
+      /**
+       * No lighting, with each vertex colored by mapping a scalar through a
+       * colormap texture. Recoloring only changes uniforms, so nothing is
+       * uploaded again.
+       *
+       * The value mapped is a weighted sum of the GeometryData::scalars
+       * attribute, the GeometryData::timestamps attribute and the model
+       * space height, with the weights set by the vec3 parameter
+       * scalar_source. Values from scalar_range[0] to scalar_range[1] are
+       * mapped to the colormap, and values outside it are clamped.
+       *
+       * Also discards vertices outside a range, like
+       * kRangeFilterPerVertexColorNoLighting.
+       *
+       * NewMaterial() maps the scalars attribute from 0 to 1 and passes all
+       * vertices. Set the colormap texture with ColormapTexture().
+       *
+       * @code
+       * StockResources stock(resources);
+       * MaterialResource::Ptr material =
+       *     stock.NewMaterial(StockResources::kScalarColormapNoLighting);
+       * material->AddTexture("colormap",
+       *     StockResources::ColormapTexture(Colormap::kViridis));
+       *
+       * // Color by height, from 0 to 3 meters.
+       * material->SetParam("scalar_source", 0.0, 0.0, 1.0);
+       * material->SetParam("scalar_range", 0.0, 3.0);
+       * @endcode
+       */
+      kScalarColormapNoLighting,
+      /**
+       * No lighting, with each vertex colored by looking up its label, from
+       * the GeometryData::labels attribute, in a palette texture. Labels
+       * wrap around the float parameter label_palette_size, which must be
+       * the width of the texture.
+       *
+       * Also discards vertices outside a range, like
+       * kRangeFilterPerVertexColorNoLighting.
+       *
+       * @code
+       * StockResources stock(resources);
+       * MaterialResource::Ptr material =
+       *     stock.NewMaterial(StockResources::kLabelPaletteNoLighting);
+       * material->AddTexture("label_palette",
+       *     StockResources::LabelPaletteTexture(num_classes));
+       * material->SetParam("label_palette_size",
+       *     static_cast<float>(num_classes));
+       * @endcode
+       */
+      kLabelPaletteNoLighting,
+      /**
+       * Like kPerVertexColorNoLighting, but discards vertices whose scalar,
+       * timestamp, model space height or label is outside a range. The
+       * bounds are set by the vec4 parameters filter_min and filter_max, in
+       * that order, and NewMaterial() sets them to pass all vertices.
+       *
+       * @code
+       * // Hide points with an intensity below 10, or older than 30 s.
+       * material->SetParam("filter_min", 10.0, now - 30, -1e30, -1e30);
+       * @endcode
+       */
+      kRangeFilterPerVertexColorNoLighting,
+      /**
+       * Draws GL_POINTS as round splats with per-vertex colors. The size of
+       * each splat on screen is computed in the vertex shader from the
+       * float parameter splat_radius, in model space, so near points are
+       * drawn larger than far ones and surfaces are covered with fewer
+       * points than with a fixed point size. The vec2 parameter
+       * splat_size_range clamps the diameter, in pixels.
+       *
+       * NewMaterial() enables MaterialResource::SetProgramPointSize(), sets
+       * a radius of 0.01 and limits the diameter to 1 to 64 pixels.
+       *
+       * @code
+       * StockResources stock(resources);
+       * MaterialResource::Ptr material =
+       *     stock.NewMaterial(StockResources::kSplatPerVertexColor);
+       * // About the spacing between points.
+       * material->SetParam("splat_radius", 0.05f);
+       * @endcode
+       *
+       * SplatHoleFillRenderer can fill the gaps that remain.
+       */
+      kSplatPerVertexColor,
+      /**
+       * Like kSplatPerVertexColor, but with a uniform color set by
+       * sv::kColor.
+       */
+      kSplatUniformColor,
+      /**
+       * Like kSplatPerVertexColor, but each splat is a disc perpendicular to
+       * its vertex normal, seen as an ellipse, so that splats follow the
+       * surface they sample instead of facing the camera.
+       */
+      kOrientedSplatPerVertexColor,
+      /**
+       * Like kTextureUniformColorNoLighting, but the texture is a single
+       * channel image drawn in gray. Used by CameraImage, which sets the
+       * textures and parameters that this and the following image shaders
+       * need.
+       */
+      kMonoImageNoLighting,
+      /**
+       * Like kTextureUniformColorNoLighting, but the texture is an NV12
+       * image, converted from BT.601 video range YUV to RGB.
+       */
+      kNV12ImageNoLighting,
+      /**
+       * Like kNV12ImageNoLighting, but the texture is a packed YUYV image.
+       */
+      kYUYVImageNoLighting,
+      /**
+       * Like kTextureUniformColorNoLighting, but the texture is an 8-bit
+       * Bayer mosaic, demosaiced with bilinear interpolation.
+       */
+      kBayerImageNoLighting,
+      /**
+       * Like kTextureUniformColorNoLighting, but the texture is a 16-bit
+       * depth image, colored by mapping each depth through a colormap
+       * texture. Raw depths are multiplied by the float parameter
+       * depth_scale, and depths from depth_range[0] to depth_range[1] are
+       * mapped to the colormap. Pixels with a raw depth of 0 are
+       * discarded.
+       *
+       * NewMaterial() sets a scale of 0.001, for depths in millimeters, and
+       * a range of 0 to 10 meters.
+       *
+       * @code
+       * MaterialResource::Ptr material =
+       *     stock.NewMaterial(StockResources::kDepthImageNoLighting);
+       * depth_image->ApplyTo(material);
+       * material->AddTexture("colormap",
+       *     StockResources::ColormapTexture(Colormap::kJet));
+       * @endcode
+       */
+      kDepthImageNoLighting,
+      /**
+       * Back-projects a grid of depth image pixels in the vertex shader, and
+       * colors each point by its depth through a colormap texture, as with
+       * kDepthImageNoLighting. Used by DepthCloud, which sets the textures
+       * and parameters it needs.
+       */
+      kDepthCloudColormap,
+      /**
+       * Like kDepthCloudColormap, but each point is colored by a color
+       * image registered to the depth image, bound as sv::kTexture0.
+       */
+      kDepthCloudColorImage
     };
 
   public:
@@ -241,6 +424,8 @@ class StockResources {
      * - Tip is at Z = +0.5
      * - Base is at Z = -0.5
      * - The cone fits in a unit cube centered on the origin.
+     *
+     * The geometry has several levels of detail, with 32, 16 and 8 slices.
      */
     GeometryResource::Ptr Cone();
 
@@ -258,6 +443,8 @@ class StockResources {
      * - Diameter 1 and length 1.
      * - The axis of revolution is the Z axis.
      * - Centered on the origin.
+     *
+     * The geometry has several levels of detail, with 32, 16 and 8 slices.
      */
     GeometryResource::Ptr Cylinder();
 
@@ -266,6 +453,9 @@ class StockResources {
      *
      * - Diameter 1
      * - Centered on the origin.
+     *
+     * The geometry has several levels of detail, made by subdividing an
+     * icosahedron 3, 2 and 1 times.
      */
     GeometryResource::Ptr Sphere();
 
@@ -306,14 +496,34 @@ class StockResources {
      */
     MaterialResource::Ptr NewMaterial(StockShaderId id);
 
+    /**
+     * Makes a 256 by 1 texture holding a colormap, for the colormap
+     * parameter of kScalarColormapNoLighting.
+     *
+     * Must be called with the OpenGL context current.
+     */
+    static std::shared_ptr<QOpenGLTexture> ColormapTexture(
+        Colormap colormap);
+
+    /**
+     * Makes a @p num_labels by 1 texture holding a palette of distinct
+     * colors, for the label_palette parameter of kLabelPaletteNoLighting.
+     *
+     * Must be called with the OpenGL context current.
+     */
+    static std::shared_ptr<QOpenGLTexture> LabelPaletteTexture(
+        int num_labels);
+
     /**
      * Generate geometry data for a cone.
      *
      * - Tip is at Z = +0.5
      * - Base is at Z = -0.5
      * - The cone fits in a unit cube centered on the origin.
+     *
+     * @param num_slices the number of segments around the base.
      */
-    static GeometryData ConeData();
+    static GeometryData ConeData(int num_slices = 16);
 
     /**
      * Generate geometry data for a unit cube.
@@ -330,14 +540,19 @@ class StockResources {
      * - Diameter 1 and length 1.
      * - The axis of revolution is the Z axis.
      * - Centered on the origin.
+     *
+     * @param num_slices the number of segments around the axis.
      */
-    static GeometryData CylinderData();
+    static GeometryData CylinderData(int num_slices = 16);
 
     /**
      * Generate geometry data for a sphere of diameter 1 centered at the
      * origin.
+     *
+     * @param num_subdivisions the number of times to subdivide an icosahedron.
+     * Each subdivision quadruples the number of triangles.
      */
-    static GeometryData SphereData();
+    static GeometryData SphereData(int num_subdivisions = 2);
 
     /**
      * Generate geometry data for a set of unit axes.
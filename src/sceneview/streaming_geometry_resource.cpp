@@ -0,0 +1,259 @@
+// Copyright [2015] Albert Huang
+
+#include "sceneview/internal_gl.hpp"
+
+#include "sceneview/streaming_geometry_resource.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+#include <QOpenGLContext>
+
+#if 0
+#define dbg(fmt, ...) printf(fmt, __VA_ARGS__)
+#else
+#define dbg(...)
+#endif
+
+namespace sv {
+
+// Returns true if the current context can create persistently mapped
+// buffers.
+static bool SupportsBufferStorage() {
+#ifdef GL_MAP_PERSISTENT_BIT
+  QOpenGLContext* context = QOpenGLContext::currentContext();
+  if (!context || context->isOpenGLES()) {
+    return false;
+  }
+  return context->format().version() >= qMakePair(4, 4) ||
+    context->hasExtension("GL_ARB_buffer_storage");
+#else
+  return false;
+#endif
+}
+
+StreamingGeometryResource::StreamingGeometryResource(const QString& name) :
+  GeometryResource(name, true),
+  segment_size_(0),
+  mapped_(nullptr),
+  staging_(),
+  write_segment_(0),
+  committed_segment_(0),
+  writing_(false) {
+  for (int attr_ind = 0; attr_ind < kNumVertexAttributes; ++attr_ind) {
+    block_offsets_[attr_ind] = 0;
+  }
+  for (int segment = 0; segment < kNumSegments; ++segment) {
+    fences_[segment] = nullptr;
+  }
+}
+
+StreamingGeometryResource::~StreamingGeometryResource() {
+  dbg("destroying streaming geometry resource %s\n",
+      name_.toStdString().c_str());
+  Release();
+}
+
+void StreamingGeometryResource::Release() {
+#ifdef GL_MAP_PERSISTENT_BIT
+  for (int segment = 0; segment < kNumSegments; ++segment) {
+    if (fences_[segment]) {
+      glDeleteSync(static_cast<GLsync>(fences_[segment]));
+      fences_[segment] = nullptr;
+    }
+  }
+#endif
+
+  // Buffers created with glBufferStorage() are immutable, so a new buffer is
+  // needed each time the geometry is initialized. Deleting the buffer also
+  // unmaps it.
+  if (created_vbo_) {
+    vbo_.destroy();
+    created_vbo_ = false;
+  }
+  mapped_ = nullptr;
+  staging_.clear();
+  cpu_data_.reset();
+}
+
+void StreamingGeometryResource::Initialize(GLenum gl_mode, int max_vertices,
+    const std::vector<VertexAttribute>& attributes) {
+  if (max_vertices <= 0) {
+    throw std::invalid_argument("Invalid maximum number of vertices");
+  }
+  if (std::find(attributes.begin(), attributes.end(),
+        VertexAttribute::kVertices) == attributes.end()) {
+    throw std::invalid_argument("Streaming geometry must have vertices");
+  }
+
+  Release();
+
+  for (int attr_ind = 0; attr_ind < kNumVertexAttributes; ++attr_ind) {
+    present_[attr_ind] = false;
+    counts_[attr_ind] = 0;
+    offsets_[attr_ind] = 0;
+    block_offsets_[attr_ind] = 0;
+  }
+  for (VertexAttribute attribute : attributes) {
+    present_[static_cast<int>(attribute)] = true;
+  }
+
+  // Lay out one segment. Each attribute is a contiguous block, just like
+  // geometry loaded with Load().
+  qint64 segment_size = 0;
+  for (int attr_ind = 0; attr_ind < kNumVertexAttributes; ++attr_ind) {
+    if (present_[attr_ind]) {
+      block_offsets_[attr_ind] = segment_size;
+      segment_size += static_cast<qint64>(max_vertices) *
+        NumComponents(static_cast<VertexAttribute>(attr_ind)) *
+        sizeof(GLfloat);
+    }
+  }
+  segment_size_ = BufferSize(segment_size);
+
+  gl_mode_ = gl_mode;
+  num_indices_ = 0;
+  primitive_restart_ = false;
+  capacity_ = max_vertices;
+  write_segment_ = 0;
+  committed_segment_ = 0;
+  writing_ = false;
+  bounding_box_ = AxisAlignedBox();
+
+  vbo_.create();
+  created_vbo_ = true;
+  vbo_.bind();
+
+#ifdef GL_MAP_PERSISTENT_BIT
+  if (SupportsBufferStorage()) {
+    const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT |
+      GL_MAP_COHERENT_BIT;
+    const GLsizeiptr buffer_size = BufferSize(segment_size_ * kNumSegments);
+    glBufferStorage(GL_ARRAY_BUFFER, buffer_size, nullptr, flags);
+    mapped_ = static_cast<char*>(
+        glMapBufferRange(GL_ARRAY_BUFFER, 0, buffer_size, flags));
+    if (!mapped_) {
+      // Mapping failed. Start over with a mutable buffer.
+      dbg("persistent mapping failed: %s\n", glErrorString(glGetError()));
+      vbo_.release();
+      vbo_.destroy();
+      vbo_.create();
+      vbo_.bind();
+    }
+  }
+#endif
+
+  if (!mapped_) {
+    staging_.resize(segment_size_);
+    vbo_.setUsagePattern(QOpenGLBuffer::StreamDraw);
+    BufferData(&vbo_, segment_size_);
+  }
+  vbo_.release();
+
+  NotifyBoundingBoxChanged();
+}
+
+void StreamingGeometryResource::WaitForSegment(int segment) {
+#ifdef GL_MAP_PERSISTENT_BIT
+  GLsync fence = static_cast<GLsync>(fences_[segment]);
+  if (!fence) {
+    return;
+  }
+  const GLuint64 kTimeoutNs = 1000000;
+  GLenum status = glClientWaitSync(fence, 0, 0);
+  while (status == GL_TIMEOUT_EXPIRED) {
+    status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, kTimeoutNs);
+  }
+  glDeleteSync(fence);
+  fences_[segment] = nullptr;
+#endif
+}
+
+void StreamingGeometryResource::BeginWrite() {
+  if (!created_vbo_) {
+    throw std::runtime_error("StreamingGeometryResource not initialized");
+  }
+  writing_ = true;
+  if (!mapped_) {
+    return;
+  }
+
+#ifdef GL_MAP_PERSISTENT_BIT
+  // All draw commands that read from the committed segment have been issued
+  // by now, so fence them. If the segment was already fenced (i.e., it was
+  // drawn again since the last BeginWrite()), the new fence supersedes the
+  // old one.
+  if (fences_[committed_segment_]) {
+    glDeleteSync(static_cast<GLsync>(fences_[committed_segment_]));
+  }
+  fences_[committed_segment_] =
+    glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+#endif
+
+  write_segment_ = (committed_segment_ + 1) % kNumSegments;
+  WaitForSegment(write_segment_);
+}
+
+GLfloat* StreamingGeometryResource::Data(VertexAttribute attribute) {
+  const int attr_ind = static_cast<int>(attribute);
+  if (!present_[attr_ind]) {
+    throw std::invalid_argument("Attribute not allocated");
+  }
+  if (!writing_) {
+    throw std::runtime_error("Data() called outside of BeginWrite()/Commit()");
+  }
+  if (mapped_) {
+    return reinterpret_cast<GLfloat*>(mapped_ +
+        write_segment_ * segment_size_ + block_offsets_[attr_ind]);
+  }
+  return reinterpret_cast<GLfloat*>(staging_.data() +
+      block_offsets_[attr_ind]);
+}
+
+void StreamingGeometryResource::Commit(int num_vertices,
+    const AxisAlignedBox& bounding_box) {
+  if (num_vertices < 0 || num_vertices > capacity_) {
+    throw std::invalid_argument("Invalid number of vertices");
+  }
+  if (!writing_) {
+    throw std::runtime_error("Commit() called without BeginWrite()");
+  }
+  writing_ = false;
+
+  qint64 segment_offset = 0;
+  if (mapped_) {
+    // The mapping is coherent, so the data is visible to the GPU without
+    // an explicit flush.
+    segment_offset = write_segment_ * segment_size_;
+    committed_segment_ = write_segment_;
+  } else {
+    // Orphan the old storage, so that the driver can hand out fresh memory
+    // instead of waiting for the GPU to finish with the previous frame.
+    vbo_.bind();
+    BufferData(&vbo_, segment_size_);
+    for (int attr_ind = 0; attr_ind < kNumVertexAttributes; ++attr_ind) {
+      if (!present_[attr_ind]) {
+        continue;
+      }
+      const qint64 size = static_cast<qint64>(num_vertices) *
+        NumComponents(static_cast<VertexAttribute>(attr_ind)) *
+        sizeof(GLfloat);
+      BufferSubData(&vbo_, block_offsets_[attr_ind],
+          staging_.data() + block_offsets_[attr_ind], size);
+    }
+    vbo_.release();
+  }
+
+  for (int attr_ind = 0; attr_ind < kNumVertexAttributes; ++attr_ind) {
+    if (present_[attr_ind]) {
+      offsets_[attr_ind] = segment_offset + block_offsets_[attr_ind];
+      counts_[attr_ind] = num_vertices;
+    }
+  }
+
+  bounding_box_ = bounding_box;
+  NotifyBoundingBoxChanged();
+}
+
+}  // namespace sv
@@ -0,0 +1,146 @@
+// Copyright [2015] Albert Huang
+
+#ifndef SCENEVIEW_STREAMING_GEOMETRY_RESOURCE_HPP__
+#define SCENEVIEW_STREAMING_GEOMETRY_RESOURCE_HPP__
+
+#include <memory>
+#include <vector>
+
+#include <sceneview/geometry_resource.hpp>
+
+namespace sv {
+
+/**
+ * Geometry that is completely rewritten every frame.
+ *
+ * StreamingGeometryResource is intended for geometry such as animated
+ * polylines or live sensor data, where the vertex data changes every frame.
+ * Instead of building a GeometryData object and calling Load() (which
+ * reallocates graphics memory, and can stall while the GPU is still reading
+ * the previous frame's data), vertex data is written directly into graphics
+ * memory:
+ *
+ * @code
+ * geom->BeginWrite();
+ * GLfloat* vertices = geom->Data(VertexAttribute::kVertices);
+ * GLfloat* diffuse = geom->Data(VertexAttribute::kDiffuse);
+ * // ... fill in up to Capacity() vertices ...
+ * geom->Commit(num_vertices, bounding_box);
+ * @endcode
+ *
+ * When the OpenGL context supports it (OpenGL 4.4 or ARB_buffer_storage),
+ * the vertex buffer is a persistently mapped ring of three segments. Each
+ * frame writes to a different segment, and fences make sure that a segment
+ * is not overwritten while the GPU may still be reading from it. Otherwise,
+ * the data is staged in system memory and uploaded on Commit(), orphaning
+ * the previous buffer storage so that the driver doesn't have to wait for
+ * the GPU.
+ *
+ * The vertex data is rewritten every frame, so Load(), LoadAndKeep(),
+ * Reserve(), Update(), SetLods() and GenerateLods() aren't supported, and
+ * throw std::logic_error.
+ *
+ * StreamingGeometryResource objects cannot be directly instantiated. Instead,
+ * use ResourceManager.
+ *
+ * @ingroup sv_resources
+ * @headerfile sceneview/streaming_geometry_resource.hpp
+ */
+class StreamingGeometryResource : public GeometryResource {
+  public:
+    typedef std::shared_ptr<StreamingGeometryResource> Ptr;
+
+    ~StreamingGeometryResource();
+
+    /**
+     * Allocates graphics memory for the geometry.
+     *
+     * Must be called with a current OpenGL context, before any call to
+     * BeginWrite().
+     *
+     * @param gl_mode the primitive type (GL_POINTS, GL_LINE_STRIP, ...)
+     * @param max_vertices the maximum number of vertices that can be written
+     *        in a single frame.
+     * @param attributes the vertex attributes to allocate.
+     *        VertexAttribute::kVertices must be included.
+     *
+     * @throw std::invalid_argument if @p max_vertices is not positive, if the
+     * attributes don't include vertices, or if the vertex buffer would be
+     * too large to allocate.
+     */
+    void Initialize(GLenum gl_mode, int max_vertices,
+        const std::vector<VertexAttribute>& attributes);
+
+    /**
+     * Starts writing the next frame's vertex data.
+     *
+     * If persistent mapping is used, this may block until the GPU has finished
+     * reading from the segment that is about to be written.
+     */
+    void BeginWrite();
+
+    /**
+     * Retrieve a pointer to write an attribute's data to.
+     *
+     * Only valid between BeginWrite() and Commit(). Values are tightly packed,
+     * with GeometryResource::NumComponents() floats per vertex. The memory may
+     * be write-combined graphics memory, so it should be written sequentially
+     * and never read back.
+     *
+     * @throw std::invalid_argument if the attribute wasn't passed to
+     * Initialize().
+     */
+    GLfloat* Data(VertexAttribute attribute);
+
+    /**
+     * Finishes writing the vertex data, and makes it the data that gets drawn.
+     *
+     * @param num_vertices the number of vertices written for each attribute.
+     * @param bounding_box bounding box of the written vertices. Since the
+     * vertex data may live in graphics memory, it is up to the caller to
+     * compute this.
+     *
+     * @throw std::invalid_argument if @p num_vertices exceeds Capacity().
+     */
+    void Commit(int num_vertices, const AxisAlignedBox& bounding_box);
+
+    /**
+     * Returns true if the vertex buffer is persistently mapped.
+     */
+    bool IsPersistentlyMapped() const { return mapped_ != nullptr; }
+
+  private:
+    friend class ResourceManager;
+
+    static constexpr int kNumSegments = 3;
+
+    explicit StreamingGeometryResource(const QString& name);
+
+    void Release();
+
+    void WaitForSegment(int segment);
+
+    // Offset of each attribute block within a segment.
+    qint64 block_offsets_[kNumVertexAttributes];
+
+    // Size of one segment, in bytes.
+    qint64 segment_size_;
+
+    // Start of the persistently mapped buffer, or nullptr if the orphaning
+    // fallback is used.
+    char* mapped_;
+
+    // System memory staging area for the orphaning fallback.
+    std::vector<char> staging_;
+
+    // GLsync objects guarding each segment.
+    void* fences_[kNumSegments];
+
+    int write_segment_;
+    int committed_segment_;
+    bool writing_;
+};
+
+}  // namespace sv
+
+#endif  // SCENEVIEW_STREAMING_GEOMETRY_RESOURCE_HPP__
@@ -0,0 +1,266 @@
+// Copyright [2015] Albert Huang
+
+#include "sceneview/internal_gl.hpp"
+
+#include "sceneview/streaming_texture_resource.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include <QOpenGLContext>
+#include <QOpenGLTexture>
+
+#include "sceneview/thread_pool.hpp"
+
+#if 0
+#define dbg(fmt, ...) printf(fmt, __VA_ARGS__)
+#else
+#define dbg(...)
+#endif
+
+namespace sv {
+
+namespace {
+
+struct FormatInfo {
+  QOpenGLTexture::TextureFormat texture_format;
+  GLenum format;
+  GLenum type;
+  int bytes_per_pixel;
+};
+
+FormatInfo GetFormatInfo(StreamingTextureResource::PixelFormat format) {
+  typedef StreamingTextureResource::PixelFormat PixelFormat;
+  switch (format) {
+    case PixelFormat::kR8:
+      return { QOpenGLTexture::R8_UNorm, GL_RED, GL_UNSIGNED_BYTE, 1 };
+    case PixelFormat::kRGB8:
+      return { QOpenGLTexture::RGB8_UNorm, GL_RGB, GL_UNSIGNED_BYTE, 3 };
+    case PixelFormat::kRGBA8:
+      return { QOpenGLTexture::RGBA8_UNorm, GL_RGBA, GL_UNSIGNED_BYTE, 4 };
+    case PixelFormat::kBGRA8:
+      return { QOpenGLTexture::RGBA8_UNorm, GL_BGRA, GL_UNSIGNED_BYTE, 4 };
+    case PixelFormat::kRG8:
+      return { QOpenGLTexture::RG8_UNorm, GL_RG, GL_UNSIGNED_BYTE, 2 };
+    case PixelFormat::kR16:
+      return { QOpenGLTexture::R16_UNorm, GL_RED, GL_UNSIGNED_SHORT, 2 };
+    case PixelFormat::kR16UI:
+      return { QOpenGLTexture::R16U, GL_RED_INTEGER, GL_UNSIGNED_SHORT, 2 };
+  }
+  throw std::invalid_argument("Invalid pixel format");
+}
+
+// Returns true if the current context can map pixel buffer objects.
+bool SupportsPixelBuffers() {
+#ifdef GL_PIXEL_UNPACK_BUFFER
+  QOpenGLContext* context = QOpenGLContext::currentContext();
+  if (!context || context->isOpenGLES()) {
+    return false;
+  }
+  return context->format().version() >= qMakePair(3, 0);
+#else
+  return false;
+#endif
+}
+
+// Images smaller than this are copied on the calling thread only.
+const int kParallelCopyBytes = 1 << 20;
+
+// Copies rows of pixels, dropping the padding at the end of each source
+// row.
+void CopyRows(const uint8_t* src, int src_stride, uint8_t* dst,
+    int row_size, int num_rows) {
+  if (src_stride == row_size) {
+    std::memcpy(dst, src, static_cast<size_t>(row_size) * num_rows);
+    return;
+  }
+  for (int row = 0; row < num_rows; ++row) {
+    std::memcpy(dst + static_cast<size_t>(row) * row_size,
+        src + static_cast<size_t>(row) * src_stride, row_size);
+  }
+}
+
+}  // namespace
+
+StreamingTextureResource::StreamingTextureResource(const QString& name) :
+  name_(name),
+  width_(0),
+  height_(0),
+  format_(PixelFormat::kRGBA8),
+  mipmaps_(false),
+  texture_(),
+  pbos_(),
+  next_pbo_(0) {}
+
+StreamingTextureResource::~StreamingTextureResource() {
+  dbg("destroying streaming texture resource %s\n",
+      name_.toStdString().c_str());
+  Release();
+}
+
+int StreamingTextureResource::BytesPerPixel(PixelFormat format) {
+  return GetFormatInfo(format).bytes_per_pixel;
+}
+
+void StreamingTextureResource::Release() {
+  for (QOpenGLBuffer& pbo : pbos_) {
+    pbo.destroy();
+  }
+  pbos_.clear();
+  next_pbo_ = 0;
+  texture_.reset();
+}
+
+void StreamingTextureResource::Initialize(int width, int height,
+    PixelFormat format, bool mipmaps, int num_buffers) {
+  if (width <= 0 || height <= 0) {
+    throw std::invalid_argument("Invalid texture size");
+  }
+  if (num_buffers <= 0) {
+    throw std::invalid_argument("Invalid number of pixel buffers");
+  }
+  const FormatInfo info = GetFormatInfo(format);
+  const bool integer = info.format == GL_RED_INTEGER;
+  if (integer && mipmaps) {
+    throw std::invalid_argument("Integer textures can't have mipmaps");
+  }
+
+  Release();
+  width_ = width;
+  height_ = height;
+  format_ = format;
+  mipmaps_ = mipmaps;
+
+  // Allocate immutable storage once. Uploads only ever replace its
+  // contents.
+  texture_.reset(new QOpenGLTexture(QOpenGLTexture::Target2D));
+  texture_->setSize(width, height);
+  texture_->setFormat(info.texture_format);
+  if (mipmaps) {
+    texture_->setMipLevels(texture_->maximumMipLevels());
+  }
+  texture_->allocateStorage();
+  if (integer) {
+    texture_->setMinificationFilter(QOpenGLTexture::Nearest);
+    texture_->setMagnificationFilter(QOpenGLTexture::Nearest);
+  } else {
+    texture_->setMinificationFilter(mipmaps ?
+        QOpenGLTexture::LinearMipMapLinear : QOpenGLTexture::Linear);
+    texture_->setMagnificationFilter(QOpenGLTexture::Linear);
+  }
+  texture_->setWrapMode(QOpenGLTexture::ClampToEdge);
+
+  if (SupportsPixelBuffers()) {
+    const int size = width * height * info.bytes_per_pixel;
+    for (int pbo_ind = 0; pbo_ind < num_buffers; ++pbo_ind) {
+      QOpenGLBuffer pbo(QOpenGLBuffer::PixelUnpackBuffer);
+      pbo.create();
+      pbo.setUsagePattern(QOpenGLBuffer::StreamDraw);
+      pbo.bind();
+      pbo.allocate(size);
+      pbo.release();
+      pbos_.push_back(pbo);
+    }
+  }
+  dbg("streaming texture %s: %dx%d, %d pixel buffers\n",
+      name_.toStdString().c_str(), width, height,
+      static_cast<int>(pbos_.size()));
+}
+
+void StreamingTextureResource::Upload(const void* pixels, int stride) {
+  if (!texture_) {
+    throw std::runtime_error("StreamingTextureResource not initialized");
+  }
+  const FormatInfo info = GetFormatInfo(format_);
+  const int row_size = width_ * info.bytes_per_pixel;
+  if (stride == 0) {
+    stride = row_size;
+  }
+  if (stride < row_size) {
+    throw std::invalid_argument("Row stride is smaller than a row");
+  }
+  const uint8_t* src = static_cast<const uint8_t*>(pixels);
+
+  texture_->bind();
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  if (!UploadFromBuffer(src, stride)) {
+    // Let the driver copy the pixels. It skips the row padding itself if
+    // the stride is a whole number of pixels.
+    if (stride % info.bytes_per_pixel == 0) {
+      glPixelStorei(GL_UNPACK_ROW_LENGTH, stride / info.bytes_per_pixel);
+      glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width_, height_, info.format,
+          info.type, src);
+      glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    } else {
+      for (int row = 0; row < height_; ++row) {
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, row, width_, 1, info.format,
+            info.type, src + static_cast<size_t>(row) * stride);
+      }
+    }
+  }
+  if (mipmaps_) {
+    texture_->generateMipMaps();
+  }
+  texture_->release();
+}
+
+bool StreamingTextureResource::UploadFromBuffer(const uint8_t* pixels,
+    int stride) {
+#ifdef GL_PIXEL_UNPACK_BUFFER
+  if (pbos_.empty()) {
+    return false;
+  }
+  const FormatInfo info = GetFormatInfo(format_);
+  const int row_size = width_ * info.bytes_per_pixel;
+  const int size = row_size * height_;
+
+  QOpenGLBuffer& pbo = pbos_[next_pbo_];
+  next_pbo_ = (next_pbo_ + 1) % pbos_.size();
+
+  // Invalidating the whole buffer orphans its storage, so that mapping it
+  // doesn't wait for the GPU to finish a transfer still reading from it.
+  pbo.bind();
+  uint8_t* mapped = static_cast<uint8_t*>(glMapBufferRange(
+        GL_PIXEL_UNPACK_BUFFER, 0, size,
+        GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+  if (!mapped) {
+    dbg("mapping pixel buffer failed: %s\n", glErrorString(glGetError()));
+    pbo.release();
+    return false;
+  }
+
+  // The mapping is usually write-combined memory, which a single thread
+  // can't fill at full bandwidth.
+  if (size < kParallelCopyBytes) {
+    CopyRows(pixels, stride, mapped, row_size, height_);
+  } else {
+    ThreadPool* pool = ThreadPool::Default();
+    const int num_bands = std::min(pool->NumThreads() + 1, height_);
+    pool->ParallelFor(num_bands, [&](int band) {
+      const int first_row = band * height_ / num_bands;
+      const int last_row = (band + 1) * height_ / num_bands;
+      CopyRows(pixels + static_cast<size_t>(first_row) * stride, stride,
+          mapped + static_cast<size_t>(first_row) * row_size, row_size,
+          last_row - first_row);
+    });
+  }
+
+  // If the buffer contents were lost while mapped (e.g., on a display mode
+  // change), the frame is garbage, but the next one replaces it.
+  glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+  // With a pixel unpack buffer bound, the pointer is an offset into the
+  // buffer, and the call returns without waiting for the transfer.
+  glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width_, height_, info.format,
+      info.type, nullptr);
+  pbo.release();
+  return true;
+#else
+  (void) pixels;
+  (void) stride;
+  return false;
+#endif
+}
+
+}  // namespace sv
@@ -0,0 +1,165 @@
+// Copyright [2015] Albert Huang
+
+#ifndef SCENEVIEW_STREAMING_TEXTURE_RESOURCE_HPP__
+#define SCENEVIEW_STREAMING_TEXTURE_RESOURCE_HPP__
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <QOpenGLBuffer>
+#include <QString>
+
+class QOpenGLTexture;
+
+namespace sv {
+
+/**
+ * A 2D texture whose contents are replaced every frame, e.g., by a live
+ * camera feed.
+ *
+ * Creating a new QOpenGLTexture from a QImage for each frame reallocates
+ * graphics memory and blocks until the pixels have been copied. Instead,
+ * StreamingTextureResource allocates the texture storage once, and each call
+ * to Upload() copies the pixels into one of a ring of pixel buffer objects,
+ * from which the GPU fills the texture asynchronously:
+ *
+ * @code
+ * texture = resources->MakeStreamingTexture();
+ * texture->Initialize(1920, 1080,
+ *     StreamingTextureResource::PixelFormat::kRGB8);
+ * material->AddTexture(kTexture0, texture->Texture());
+ * ...
+ * // For each frame, with the OpenGL context current:
+ * texture->Upload(frame.data, frame.stride);
+ * @endcode
+ *
+ * Since each pixel buffer is orphaned before being written, and consecutive
+ * uploads go to different buffers, Upload() doesn't wait for the GPU to
+ * finish with the previous frames. If the context doesn't support pixel
+ * buffer objects (OpenGL 3.0), the pixels are passed to glTexSubImage2D()
+ * directly.
+ *
+ * StreamingTextureResource objects cannot be directly instantiated. Instead,
+ * use ResourceManager.
+ *
+ * @ingroup sv_resources
+ * @headerfile sceneview/streaming_texture_resource.hpp
+ */
+class StreamingTextureResource {
+  public:
+    typedef std::shared_ptr<StreamingTextureResource> Ptr;
+
+    /**
+     * Layout of the pixels passed to Upload().
+     */
+    enum class PixelFormat {
+      /// One 8-bit channel, e.g., grayscale. Sampled as (r, 0, 0, 1).
+      kR8,
+      /// 8-bit red, green and blue.
+      kRGB8,
+      /// 8-bit red, green, blue and alpha.
+      kRGBA8,
+      /// 8-bit blue, green, red and alpha. Sampled as RGBA.
+      kBGRA8,
+      /// Two 8-bit channels, e.g., the interleaved chroma plane of an NV12
+      /// image. Sampled as (r, g, 0, 1).
+      kRG8,
+      /// One 16-bit unsigned channel, e.g., a depth image, sampled as a
+      /// float from 0 to 1.
+      kR16,
+      /// One 16-bit unsigned channel, sampled as an integer with a usampler2D.
+      /// Integer textures can't be filtered, so the texture always uses
+      /// nearest filtering and has no mipmaps.
+      kR16UI,
+    };
+
+    ~StreamingTextureResource();
+
+    const QString& Name() const { return name_; }
+
+    /**
+     * Allocates the texture storage.
+     *
+     * Must be called with a current OpenGL context, before any call to
+     * Upload(). Calling it again reallocates the texture, so the texture
+     * must be added to materials again.
+     *
+     * @param mipmaps if true, the texture has a full mipmap chain that is
+     *        regenerated after each upload, and is sampled with trilinear
+     *        filtering. Otherwise, the texture has a single level sampled
+     *        with bilinear filtering.
+     * @param num_buffers number of pixel buffer objects to cycle through.
+     *        Two or three are enough for the GPU to read one frame while
+     *        the next is written.
+     *
+     * @throw std::invalid_argument if the size or number of buffers is not
+     * positive, or if mipmaps are requested for an integer format.
+     */
+    void Initialize(int width, int height, PixelFormat format,
+        bool mipmaps = false, int num_buffers = 3);
+
+    /**
+     * Replaces the texture contents.
+     *
+     * Must be called with a current OpenGL context. The pixels are copied
+     * before this method returns, so they can be reused right away. Large
+     * images are copied in parallel on the ThreadPool::Default() threads.
+     *
+     * @param pixels the first row of the image, which is the bottom row of
+     *        the texture (texture coordinate v = 0).
+     * @param stride the number of bytes between the starts of consecutive
+     *        rows, or 0 if the rows are tightly packed.
+     *
+     * @throw std::runtime_error if Initialize() wasn't called.
+     * @throw std::invalid_argument if @p stride is smaller than a row.
+     */
+    void Upload(const void* pixels, int stride = 0);
+
+    /**
+     * Retrieve the texture, e.g., to pass to MaterialResource::AddTexture().
+     */
+    const std::shared_ptr<QOpenGLTexture>& Texture() const { return texture_; }
+
+    int Width() const { return width_; }
+
+    int Height() const { return height_; }
+
+    PixelFormat Format() const { return format_; }
+
+    /**
+     * Returns true if uploads go through pixel buffer objects.
+     */
+    bool UsesPixelBuffers() const { return !pbos_.empty(); }
+
+    /**
+     * Returns the number of bytes of a pixel in the specified format.
+     */
+    static int BytesPerPixel(PixelFormat format);
+
+  private:
+    friend class ResourceManager;
+
+    explicit StreamingTextureResource(const QString& name);
+
+    void Release();
+
+    bool UploadFromBuffer(const uint8_t* pixels, int stride);
+
+    QString name_;
+    int width_;
+    int height_;
+    PixelFormat format_;
+    bool mipmaps_;
+
+    std::shared_ptr<QOpenGLTexture> texture_;
+
+    // Pixel buffer objects, used in turn. Empty if the context doesn't
+    // support them.
+    std::vector<QOpenGLBuffer> pbos_;
+    int next_pbo_;
+};
+
+}  // namespace sv
+
+#endif  // SCENEVIEW_STREAMING_TEXTURE_RESOURCE_HPP__
@@ -0,0 +1,105 @@
+// Copyright [2015] Albert Huang
+
+#include "sceneview/thread_pool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <utility>
+
+namespace sv {
+
+ThreadPool::ThreadPool(int num_threads) :
+  stop_(false) {
+  for (int thread_ind = 0; thread_ind < std::max(num_threads, 1);
+      ++thread_ind) {
+    threads_.emplace_back(&ThreadPool::Run, this);
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+    tasks_.clear();
+  }
+  condition_.notify_all();
+  for (std::thread& thread : threads_) {
+    thread.join();
+  }
+}
+
+ThreadPool* ThreadPool::Default() {
+  static ThreadPool pool(
+      static_cast<int>(std::thread::hardware_concurrency()) - 1);
+  return &pool;
+}
+
+void ThreadPool::ParallelFor(int count,
+    const std::function<void(int)>& function) {
+  struct State {
+    std::atomic<int> next_index;
+    int count;
+    int num_done;
+    std::exception_ptr error;
+    std::mutex mutex;
+    std::condition_variable condition;
+    const std::function<void(int)>* function;
+  };
+  std::shared_ptr<State> state = std::make_shared<State>();
+  state->next_index = 0;
+  state->count = count;
+  state->num_done = 0;
+  state->function = &function;
+
+  // Tasks that start after all indices are taken return immediately, and
+  // don't touch the function, which may be gone by then.
+  auto work = [state]() {
+    int index;
+    while ((index = state->next_index++) < state->count) {
+      std::exception_ptr error;
+      try {
+        (*state->function)(index);
+      } catch (...) {
+        error = std::current_exception();
+      }
+      std::lock_guard<std::mutex> lock(state->mutex);
+      if (error && !state->error) {
+        state->error = error;
+      }
+      if (++state->num_done == state->count) {
+        state->condition.notify_all();
+      }
+    }
+  };
+  const int num_tasks = std::min(NumThreads(), count - 1);
+  for (int task = 0; task < num_tasks; ++task) {
+    Submit(work);
+  }
+  work();
+
+  std::unique_lock<std::mutex> lock(state->mutex);
+  state->condition.wait(lock,
+      [state]() { return state->num_done >= state->count; });
+  if (state->error) {
+    std::rethrow_exception(state->error);
+  }
+}
+
+void ThreadPool::Run() {
+  while (true) {
+    std::function<void()> task;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      condition_.wait(lock, [this]() { return stop_ || !tasks_.empty(); });
+      if (stop_) {
+        return;
+      }
+      task = std::move(tasks_.front());
+      tasks_.pop_front();
+    }
+    task();
+  }
+}
+
+}  // namespace sv
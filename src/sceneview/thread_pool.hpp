@@ -0,0 +1,104 @@
+// Copyright [2015] Albert Huang
+
+#ifndef SCENEVIEW_THREAD_POOL_HPP__
+#define SCENEVIEW_THREAD_POOL_HPP__
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace sv {
+
+/**
+ * Fixed size pool of worker threads for background work.
+ *
+ * Used for work that doesn't need an OpenGL context, such as generating
+ * mesh levels of detail or parsing files. Results are typically handed back
+ * to the rendering thread via the returned std::future, and uploaded to
+ * graphics memory from there.
+ *
+ * @ingroup sv_resources
+ * @headerfile sceneview/thread_pool.hpp
+ */
+class ThreadPool {
+  public:
+    /**
+     * Starts @p num_threads worker threads.
+     */
+    explicit ThreadPool(int num_threads);
+
+    /**
+     * Discards tasks that haven't started yet, and waits for running tasks
+     * to finish.
+     */
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * Retrieve a pool shared by all of sceneview, with one thread per core
+     * (minus one for the rendering thread).
+     */
+    static ThreadPool* Default();
+
+    /**
+     * Queues a function to be run on a worker thread.
+     *
+     * @return a future for the result of the function. If the task is
+     * discarded before it runs, the future reports a broken promise.
+     */
+    template <typename Function>
+    std::future<typename std::result_of<Function()>::type>
+    Submit(Function&& function) {
+      typedef typename std::result_of<Function()>::type ResultType;
+      auto task = std::make_shared<std::packaged_task<ResultType()>>(
+          std::forward<Function>(function));
+      std::future<ResultType> result = task->get_future();
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        tasks_.emplace_back([task]() { (*task)(); });
+      }
+      condition_.notify_one();
+      return result;
+    }
+
+    /**
+     * Runs function(index) for each index in [0, count), on the calling
+     * thread and the worker threads, and returns when all calls are done.
+     *
+     * Indices are handed out one at a time to whichever thread is free, and
+     * the calling thread only waits for calls that another thread is
+     * running. It never waits for a queued task to start, so this can be
+     * called from a task of the same pool.
+     *
+     * If calls throw, the other indices still run, and the first exception
+     * is rethrown.
+     */
+    void ParallelFor(int count, const std::function<void(int)>& function);
+
+    /**
+     * Retrieve the number of worker threads.
+     */
+    int NumThreads() const { return threads_.size(); }
+
+  private:
+    void Run();
+
+    std::mutex mutex_;
+    std::condition_variable condition_;
+    std::deque<std::function<void()>> tasks_;
+    std::vector<std::thread> threads_;
+    bool stop_;
+};
+
+}  // namespace sv
+
+#endif  // SCENEVIEW_THREAD_POOL_HPP__
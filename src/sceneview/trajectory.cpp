@@ -0,0 +1,421 @@
+// Copyright [2015] Albert Huang
+
+#include "sceneview/internal_gl.hpp"
+
+#include "sceneview/trajectory.hpp"
+
+#include <algorithm>
+
+#include <QMatrix4x4>
+#include <QOpenGLBuffer>
+#include <QOpenGLShaderProgram>
+
+#include "sceneview/camera_node.hpp"
+#include "sceneview/draw_node.hpp"
+#include "sceneview/geometry_resource.hpp"
+#include "sceneview/group_node.hpp"
+#include "sceneview/polyline_simplifier.hpp"
+#include "sceneview/stock_resources.hpp"
+#include "sceneview/view_frustum.hpp"
+#include "sceneview/viewport.hpp"
+
+#if 0
+#define dbg(fmt, ...) printf(fmt, __VA_ARGS__)
+#else
+#define dbg(...)
+#endif
+
+namespace sv {
+
+// Floats per instance of the axes: position, then orientation as x, y, z, w.
+static const int kInstanceSize = 7;
+
+/**
+ * Line strip of a chunk of the path, with every level of detail stored one
+ * after the other in the index buffer. Only the selected level is drawn.
+ */
+class TrajectoryChunkGeometry : public GeometryResource {
+  public:
+    void LoadLevels(const std::vector<QVector3D>& vertices,
+        const std::vector<PolylineLod>& lods) {
+      GeometryData gdata;
+      gdata.gl_mode = GL_LINE_STRIP;
+      gdata.vertices = vertices;
+      first_indices_.clear();
+      errors_.clear();
+      for (const PolylineLod& lod : lods) {
+        first_indices_.push_back(gdata.indices.size());
+        errors_.push_back(lod.error);
+        gdata.indices.insert(gdata.indices.end(), lod.indices.begin(),
+            lod.indices.end());
+      }
+      first_indices_.push_back(gdata.indices.size());
+      selected_ = 0;
+      Load(gdata);
+    }
+
+    int NumLevels() const { return errors_.size(); }
+
+    // Largest distance from a vertex to the path drawn at a level.
+    float Error(int level) const { return errors_[level]; }
+
+    int NumLevelVertices(int level) const {
+      return first_indices_[level + 1] - first_indices_[level];
+    }
+
+    void Select(int level) { selected_ = level; }
+
+    void DrawRange(int range, int* first, int* count) const override {
+      *first = first_indices_[selected_];
+      *count = NumLevelVertices(selected_);
+    }
+
+  private:
+    friend class ResourceManager;
+
+    explicit TrajectoryChunkGeometry(const QString& name) :
+      GeometryResource(name),
+      selected_(0) {}
+
+    std::vector<int> first_indices_;
+    std::vector<float> errors_;
+    int selected_;
+};
+
+/**
+ * Axes glyph, drawn once for each instance in a buffer of poses with a
+ * single instanced draw call.
+ */
+class TrajectoryAxesGeometry : public GeometryResource {
+  public:
+    ~TrajectoryAxesGeometry() {
+      if (instance_buffer_.isCreated()) {
+        instance_buffer_.destroy();
+      }
+    }
+
+    // Sets the position and orientation of each instance, kInstanceSize
+    // floats per instance. The vector must outlive the geometry.
+    void SetInstances(const std::vector<float>* instances) {
+      instances_ = instances;
+      num_instances_ = 0;
+    }
+
+    // Writes the instances from @p first to the end of the instance list
+    // to graphics memory.
+    void Upload(int first) {
+      const int num_instances = instances_->size() / kInstanceSize;
+      num_instances_ = num_instances;
+      if (!num_instances) {
+        return;
+      }
+      if (num_instances > instance_capacity_) {
+        instance_capacity_ = std::max(num_instances, 2 * instance_capacity_);
+        if (instance_buffer_.isCreated()) {
+          instance_buffer_.destroy();
+        }
+        instance_buffer_.create();
+        instance_buffer_.bind();
+        instance_buffer_.allocate(
+            instance_capacity_ * kInstanceSize * sizeof(float));
+        first = 0;
+      } else {
+        instance_buffer_.bind();
+      }
+      if (first < num_instances) {
+        instance_buffer_.write(first * kInstanceSize * sizeof(float),
+            instances_->data() + first * kInstanceSize,
+            (num_instances - first) * kInstanceSize * sizeof(float));
+      }
+      instance_buffer_.release();
+    }
+
+    // Replaces the bounding box of the glyph with one that covers every
+    // instance.
+    void SetBoundingBox(const AxisAlignedBox& box) {
+      if (box != bounding_box_) {
+        bounding_box_ = box;
+        NotifyBoundingBoxChanged();
+      }
+    }
+
+    int NumInstances() const override { return num_instances_; }
+
+    void EnableInstanceArrays(QOpenGLShaderProgram* program) override {
+#ifdef GL_VERTEX_ATTRIB_ARRAY_DIVISOR
+      const int pos_loc = program->attributeLocation("sv_instance_pos");
+      const int rot_loc = program->attributeLocation("sv_instance_rot");
+      const int stride = kInstanceSize * sizeof(float);
+      instance_buffer_.bind();
+      if (pos_loc >= 0) {
+        program->enableAttributeArray(pos_loc);
+        program->setAttributeBuffer(pos_loc, GL_FLOAT, 0, 3, stride);
+        glVertexAttribDivisor(pos_loc, 1);
+      }
+      if (rot_loc >= 0) {
+        program->enableAttributeArray(rot_loc);
+        program->setAttributeBuffer(rot_loc, GL_FLOAT, 3 * sizeof(float), 4,
+            stride);
+        glVertexAttribDivisor(rot_loc, 1);
+      }
+      instance_buffer_.release();
+#endif
+    }
+
+    void DisableInstanceArrays(QOpenGLShaderProgram* program) override {
+#ifdef GL_VERTEX_ATTRIB_ARRAY_DIVISOR
+      for (const char* name : { "sv_instance_pos", "sv_instance_rot" }) {
+        const int loc = program->attributeLocation(name);
+        if (loc >= 0) {
+          glVertexAttribDivisor(loc, 0);
+          program->disableAttributeArray(loc);
+        }
+      }
+#endif
+    }
+
+    void SetInstanceAttributes(QOpenGLShaderProgram* program,
+        int instance) override {
+      const float* data = instances_->data() + instance * kInstanceSize;
+      program->disableAttributeArray("sv_instance_pos");
+      program->disableAttributeArray("sv_instance_rot");
+      program->setAttributeValue("sv_instance_pos", data[0], data[1],
+          data[2]);
+      program->setAttributeValue("sv_instance_rot", data[3], data[4],
+          data[5], data[6]);
+    }
+
+  private:
+    friend class ResourceManager;
+
+    explicit TrajectoryAxesGeometry(const QString& name) :
+      GeometryResource(name),
+      instances_(nullptr),
+      instance_buffer_(QOpenGLBuffer::VertexBuffer),
+      num_instances_(0),
+      instance_capacity_(0) {}
+
+    const std::vector<float>* instances_;
+    QOpenGLBuffer instance_buffer_;
+    int num_instances_;
+    int instance_capacity_;
+};
+
+Trajectory::Ptr Trajectory::Create(Viewport* viewport, GroupNode* parent,
+    int chunk_size) {
+  return Ptr(new Trajectory(viewport, parent, chunk_size));
+}
+
+Trajectory::Trajectory(Viewport* viewport, GroupNode* parent,
+    int chunk_size) :
+  resources_(viewport->GetResources()),
+  scene_(viewport->GetScene()),
+  chunk_size_(std::max(chunk_size, 2)),
+  axes_spacing_(1),
+  axes_length_(0.2),
+  max_screen_error_(1),
+  num_drawn_vertices_(0),
+  distance_since_axes_(0),
+  num_uploaded_instances_(0),
+  axes_node_(nullptr),
+  axes_geometry_() {
+  StockResources stock(resources_);
+  material_ = stock.NewMaterial(StockResources::kUniformColorNoLighting);
+  material_->SetParam(kColor, 1.0f, 1.0f, 1.0f, 1.0f);
+  axes_material_ =
+    stock.NewMaterial(StockResources::kInstancedPosePerVertexColorNoLighting);
+  axes_material_->SetParam("instance_scale", axes_length_);
+  node_ = scene_->MakeGroup(parent);
+}
+
+Trajectory::~Trajectory() {
+  if (scene_->ContainsNode(node_)) {
+    scene_->DestroyNode(node_);
+  }
+}
+
+void Trajectory::AddPose(const QVector3D& position,
+    const QQuaternion& orientation) {
+  positions_.push_back(position);
+  orientations_.push_back(orientation);
+  const int num_poses = positions_.size();
+  if (num_poses >= 2) {
+    const int chunk_ind = (num_poses - 2) / chunk_size_;
+    if (chunk_ind >= static_cast<int>(chunks_.size())) {
+      chunks_.resize(chunk_ind + 1);
+    }
+    chunks_[chunk_ind].dirty = true;
+  }
+  SelectAxes(num_poses - 1);
+}
+
+void Trajectory::Clear() {
+  for (Chunk& chunk : chunks_) {
+    if (chunk.draw_node) {
+      scene_->DestroyNode(chunk.draw_node);
+    }
+  }
+  chunks_.clear();
+  positions_.clear();
+  orientations_.clear();
+  axes_poses_.clear();
+  instances_.clear();
+  distance_since_axes_ = 0;
+  num_uploaded_instances_ = -1;
+}
+
+void Trajectory::SetAxesSpacing(float distance) {
+  axes_spacing_ = distance;
+  axes_poses_.clear();
+  instances_.clear();
+  distance_since_axes_ = 0;
+  num_uploaded_instances_ = -1;
+  SelectAxes(0);
+}
+
+void Trajectory::SetAxesLength(float length) {
+  axes_length_ = length;
+  axes_material_->SetParam("instance_scale", axes_length_);
+}
+
+void Trajectory::SetColor(float red, float green, float blue) {
+  material_->SetParam(kColor, red, green, blue, 1.0f);
+}
+
+void Trajectory::Update(CameraNode* camera) {
+  if (!axes_geometry_) {
+    InitializeGL();
+  }
+
+  for (int chunk_ind = 0; chunk_ind < static_cast<int>(chunks_.size());
+      ++chunk_ind) {
+    if (chunks_[chunk_ind].dirty) {
+      UpdateChunk(chunk_ind);
+    }
+  }
+
+  const int num_instances = axes_poses_.size();
+  if (num_uploaded_instances_ != num_instances) {
+    axes_geometry_->Upload(std::max(num_uploaded_instances_, 0));
+    num_uploaded_instances_ = num_instances;
+    AxisAlignedBox box;
+    for (int pose : axes_poses_) {
+      box.IncludePoint(positions_[pose]);
+    }
+    if (box.Valid()) {
+      const QVector3D margin(axes_length_, axes_length_, axes_length_);
+      box = AxisAlignedBox(box.Min() - margin, box.Max() + margin);
+    }
+    axes_geometry_->SetBoundingBox(box);
+  }
+
+  SelectLods(camera);
+}
+
+void Trajectory::InitializeGL() {
+  // One line per axis, colored red, green and blue for x, y and z.
+  GeometryData gdata;
+  gdata.gl_mode = GL_LINES;
+  gdata.vertices = {
+    { 0, 0, 0 }, { 1, 0, 0 },
+    { 0, 0, 0 }, { 0, 1, 0 },
+    { 0, 0, 0 }, { 0, 0, 1 }
+  };
+  gdata.diffuse = {
+    { 1, 0, 0, 1 }, { 1, 0, 0, 1 },
+    { 0, 1, 0, 1 }, { 0, 1, 0, 1 },
+    { 0, 0, 1, 1 }, { 0, 0, 1, 1 }
+  };
+  axes_geometry_ = resources_->MakeCustomGeometry<TrajectoryAxesGeometry>();
+  axes_geometry_->Load(gdata);
+  axes_geometry_->SetInstances(&instances_);
+
+  axes_node_ = scene_->MakeDrawNode(node_);
+  axes_node_->SetSelectionMask(node_->GetSelectionMask());
+  axes_node_->Add(axes_geometry_, axes_material_);
+  num_uploaded_instances_ = -1;
+}
+
+void Trajectory::UpdateChunk(int chunk_ind) {
+  Chunk& chunk = chunks_[chunk_ind];
+  chunk.dirty = false;
+  const int first = chunk_ind * chunk_size_;
+  const int last = std::min(first + chunk_size_, NumPoses() - 1);
+
+  if (!chunk.geometry) {
+    chunk.geometry = resources_->MakeCustomGeometry<TrajectoryChunkGeometry>();
+    chunk.draw_node = scene_->MakeDrawNode(node_);
+    chunk.draw_node->SetSelectionMask(node_->GetSelectionMask());
+    chunk.draw_node->Add(chunk.geometry, material_);
+  }
+
+  const std::vector<QVector3D> vertices(positions_.begin() + first,
+      positions_.begin() + last + 1);
+  chunk.geometry->LoadLevels(vertices,
+      GeneratePolylineLodChain(PolylineImportance(vertices)));
+  dbg("Chunk %d: %d poses, %d levels\n", chunk_ind, last - first + 1,
+      chunk.geometry->NumLevels());
+}
+
+void Trajectory::SelectLods(CameraNode* camera) {
+  num_drawn_vertices_ = 0;
+  const QMatrix4x4 model_view = camera->GetViewMatrix() *
+    node_->WorldTransform();
+  const QMatrix4x4 proj_mat = camera->GetProjectionMatrix();
+  const ViewFrustum frustum(proj_mat * model_view);
+  const bool perspective = proj_mat(3, 3) == 0;
+  const float scale = model_view.column(0).toVector3D().length();
+  const float pixels_per_unit =
+    proj_mat(1, 1) * camera->GetViewportSize().height() / 2;
+
+  for (Chunk& chunk : chunks_) {
+    TrajectoryChunkGeometry* geometry = chunk.geometry.get();
+    if (!geometry) {
+      continue;
+    }
+    const AxisAlignedBox& box = geometry->BoundingBox();
+
+    // Chunks outside the view are drawn at the coarsest level, so that they
+    // are cheap if they come into view before the next update.
+    int level = geometry->NumLevels() - 1;
+    if (frustum.Intersects(box)) {
+      float pixels_per_error = scale * pixels_per_unit;
+      if (perspective) {
+        const QVector3D center = model_view.map((box.Min() + box.Max()) / 2);
+        const float radius = (box.Max() - box.Min()).length() / 2 * scale;
+        pixels_per_error /= std::max(center.length() - radius, 1e-3f);
+      }
+      while (level > 0 &&
+          geometry->Error(level) * pixels_per_error > max_screen_error_) {
+        --level;
+      }
+    }
+    geometry->Select(level);
+    num_drawn_vertices_ += geometry->NumLevelVertices(level);
+  }
+}
+
+void Trajectory::SelectAxes(int first_pose) {
+  if (axes_spacing_ <= 0) {
+    return;
+  }
+  for (int pose = first_pose; pose < NumPoses(); ++pose) {
+    if (pose > 0) {
+      distance_since_axes_ += (positions_[pose] - positions_[pose - 1])
+        .length();
+    }
+    if (pose > 0 && distance_since_axes_ < axes_spacing_) {
+      continue;
+    }
+    distance_since_axes_ = 0;
+    axes_poses_.push_back(pose);
+    const QVector3D& position = positions_[pose];
+    const QQuaternion& orientation = orientations_[pose];
+    instances_.insert(instances_.end(), {
+        position.x(), position.y(), position.z(),
+        orientation.x(), orientation.y(), orientation.z(),
+        orientation.scalar() });
+  }
+}
+
+}  // namespace sv
@@ -0,0 +1,198 @@
+// Copyright [2015] Albert Huang
+
+#ifndef SCENEVIEW_TRAJECTORY_HPP__
+#define SCENEVIEW_TRAJECTORY_HPP__
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <QQuaternion>
+#include <QVector3D>
+
+#include <sceneview/material_resource.hpp>
+#include <sceneview/resource_manager.hpp>
+#include <sceneview/scene.hpp>
+
+namespace sv {
+
+class CameraNode;
+class DrawNode;
+class GroupNode;
+class TrajectoryAxesGeometry;
+class TrajectoryChunkGeometry;
+class Viewport;
+
+/**
+ * Draws a long sequence of poses, such as the path of a robot or the
+ * keyframes of a SLAM system, as a polyline with coordinate axes at regular
+ * intervals along it.
+ *
+ * The path is split into chunks of consecutive poses, each drawn by its own
+ * DrawNode so that chunks outside the view are culled. Each chunk has a
+ * chain of Douglas-Peucker simplifications, computed once when the chunk
+ * changes, and Update() picks the coarsest one whose error is below a
+ * screen-space threshold. Distant parts of the path are therefore drawn with
+ * a few vertices, whatever the number of poses.
+ *
+ * The axes are drawn for a subset of the poses, spaced by SetAxesSpacing()
+ * along the path. They are drawn with a single instanced draw call, with one
+ * instance per pose holding its position and orientation, instead of a
+ * DrawNode per pose.
+ *
+ * Only the last chunk changes as poses are added, so adding poses costs the
+ * same however long the trajectory is.
+ *
+ * @code
+ * Trajectory::Ptr path = Trajectory::Create(viewport, scene->Root());
+ * for (const Pose& pose : poses) {
+ *   path->AddPose(pose.position, pose.orientation);
+ * }
+ *
+ * // In Renderer::RenderBegin(), or elsewhere with the OpenGL context
+ * // current, once per frame:
+ * path->Update(viewport->GetCamera());
+ * @endcode
+ *
+ * @ingroup sv_scenegraph
+ * @headerfile sceneview/trajectory.hpp
+ */
+class Trajectory {
+  public:
+    typedef std::shared_ptr<Trajectory> Ptr;
+
+    /**
+     * Creates an empty trajectory.
+     *
+     * @param viewport provides the scene and resources.
+     * @param parent the parent of Node().
+     * @param chunk_size the number of poses in each chunk of the path.
+     */
+    static Ptr Create(Viewport* viewport, GroupNode* parent,
+        int chunk_size = 2048);
+
+    ~Trajectory();
+
+    /**
+     * Appends a pose to the trajectory.
+     */
+    void AddPose(const QVector3D& position, const QQuaternion& orientation);
+
+    /**
+     * Removes all poses.
+     */
+    void Clear();
+
+    /**
+     * Retrieve the number of poses.
+     */
+    int NumPoses() const { return positions_.size(); }
+
+    const QVector3D& Position(int pose) const { return positions_[pose]; }
+
+    const QQuaternion& Orientation(int pose) const {
+      return orientations_[pose];
+    }
+
+    /**
+     * Sets the distance along the path between consecutive axes. Axes are
+     * drawn at the first pose, and then at the first pose at least this far
+     * along the path from the previous axes. Zero or less hides the axes.
+     * The default is 1.
+     */
+    void SetAxesSpacing(float distance);
+
+    /**
+     * Sets the length of each axis. The default is 0.2.
+     */
+    void SetAxesLength(float length);
+
+    /**
+     * Sets the color of the path. The default is white.
+     */
+    void SetColor(float red, float green, float blue);
+
+    /**
+     * Sets the distance, in screen pixels, by which the simplified path may
+     * stray from the full path. The default is 1.
+     */
+    void SetMaxScreenSpaceError(float pixels) { max_screen_error_ = pixels; }
+
+    /**
+     * Uploads poses added since the last call, and picks the level of
+     * detail of each chunk of the path for the camera.
+     *
+     * Must be called with the OpenGL context current, typically once per
+     * frame before drawing.
+     */
+    void Update(CameraNode* camera);
+
+    /**
+     * Retrieve the group node that the trajectory is drawn under.
+     */
+    GroupNode* Node() { return node_; }
+
+    /**
+     * Retrieve the number of poses that have axes.
+     */
+    int NumAxes() const { return axes_poses_.size(); }
+
+    /**
+     * Retrieve the number of path vertices drawn with the levels of detail
+     * picked by the last call to Update(), including chunks outside the
+     * view.
+     */
+    int64_t NumDrawnVertices() const { return num_drawn_vertices_; }
+
+  private:
+    struct Chunk {
+      Chunk() : draw_node(nullptr), dirty(true) {}
+
+      DrawNode* draw_node;
+      std::shared_ptr<TrajectoryChunkGeometry> geometry;
+      bool dirty;
+    };
+
+    Trajectory(Viewport* viewport, GroupNode* parent, int chunk_size);
+
+    void InitializeGL();
+
+    void UpdateChunk(int chunk_ind);
+
+    void SelectLods(CameraNode* camera);
+
+    void SelectAxes(int first_pose);
+
+    ResourceManager::Ptr resources_;
+    Scene::Ptr scene_;
+    GroupNode* node_;
+    MaterialResource::Ptr material_;
+    MaterialResource::Ptr axes_material_;
+
+    int chunk_size_;
+    float axes_spacing_;
+    float axes_length_;
+    float max_screen_error_;
+    int64_t num_drawn_vertices_;
+
+    std::vector<QVector3D> positions_;
+    std::vector<QQuaternion> orientations_;
+    std::vector<Chunk> chunks_;
+
+    // Poses that have axes, and the distance along the path since the last
+    // of them.
+    std::vector<int> axes_poses_;
+    float distance_since_axes_;
+
+    // Position and orientation of each instance of the axes, and the number
+    // of instances in graphics memory.
+    std::vector<float> instances_;
+    int num_uploaded_instances_;
+
+    DrawNode* axes_node_;
+    std::shared_ptr<TrajectoryAxesGeometry> axes_geometry_;
+};
+
+}  // namespace sv
+
+#endif  // SCENEVIEW_TRAJECTORY_HPP__
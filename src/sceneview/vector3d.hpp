@@ -0,0 +1,55 @@
+// Copyright [2015] Albert Huang
+
+#ifndef SCENEVIEW_VECTOR3D_HPP__
+#define SCENEVIEW_VECTOR3D_HPP__
+
+#include <QVector3D>
+
+namespace sv {
+
+/**
+ * A 3D vector with double-precision components.
+ *
+ * Used for world positions that are too far from the origin for the
+ * single-precision QVector3D, such as UTM coordinates. See
+ * SceneNode::WorldOrigin().
+ *
+ * @ingroup sv_scenegraph
+ * @headerfile sceneview/vector3d.hpp
+ */
+struct Vector3d {
+  Vector3d() : x(0), y(0), z(0) {}
+
+  Vector3d(double x_, double y_, double z_) : x(x_), y(y_), z(z_) {}
+
+  explicit Vector3d(const QVector3D& vec) :
+    x(vec.x()), y(vec.y()), z(vec.z()) {}
+
+  /**
+   * Converts to single precision. Only do this for small vectors, e.g., the
+   * difference of two nearby world positions.
+   */
+  QVector3D ToVector3D() const { return QVector3D(x, y, z); }
+
+  Vector3d operator+(const Vector3d& other) const {
+    return Vector3d(x + other.x, y + other.y, z + other.z);
+  }
+
+  Vector3d operator-(const Vector3d& other) const {
+    return Vector3d(x - other.x, y - other.y, z - other.z);
+  }
+
+  bool operator==(const Vector3d& other) const {
+    return x == other.x && y == other.y && z == other.z;
+  }
+
+  bool operator!=(const Vector3d& other) const { return !(*this == other); }
+
+  double x;
+  double y;
+  double z;
+};
+
+}  // namespace sv
+
+#endif  // SCENEVIEW_VECTOR3D_HPP__
@@ -0,0 +1,30 @@
+// Copyright [2015] Albert Huang
+
+#include "sceneview/view_frustum.hpp"
+
+namespace sv {
+
+ViewFrustum::ViewFrustum(const QMatrix4x4& model_view_projection) {
+  const QVector4D row3 = model_view_projection.row(3);
+  for (int row = 0; row < 3; ++row) {
+    planes_[row * 2] = row3 + model_view_projection.row(row);
+    planes_[row * 2 + 1] = row3 - model_view_projection.row(row);
+  }
+}
+
+bool ViewFrustum::Intersects(const AxisAlignedBox& box) const {
+  const QVector3D& bmin = box.Min();
+  const QVector3D& bmax = box.Max();
+  for (const QVector4D& plane : planes_) {
+    const float distance =
+      plane.x() * (plane.x() > 0 ? bmax.x() : bmin.x()) +
+      plane.y() * (plane.y() > 0 ? bmax.y() : bmin.y()) +
+      plane.z() * (plane.z() > 0 ? bmax.z() : bmin.z()) + plane.w();
+    if (distance < 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace sv
@@ -0,0 +1,43 @@
+// Copyright [2015] Albert Huang
+
+#ifndef SCENEVIEW_VIEW_FRUSTUM_HPP__
+#define SCENEVIEW_VIEW_FRUSTUM_HPP__
+
+#include <QMatrix4x4>
+#include <QVector4D>
+
+#include <sceneview/axis_aligned_box.hpp>
+
+namespace sv {
+
+/**
+ * View frustum planes extracted from a model-view-projection matrix.
+ *
+ * The planes are in the model coordinate frame of the matrix, so boxes in
+ * that frame can be tested without transforming them. Uses the method of
+ * Gribb and Hartmann, "Fast Extraction of Viewing Frustum Planes from the
+ * World-View-Projection Matrix".
+ *
+ * @headerfile sceneview/view_frustum.hpp
+ */
+class ViewFrustum {
+  public:
+    explicit ViewFrustum(const QMatrix4x4& model_view_projection);
+
+    /**
+     * Returns true if the box is at least partially inside the frustum.
+     *
+     * The test is conservative: some boxes that are outside the frustum near
+     * its corners are reported as intersecting.
+     */
+    bool Intersects(const AxisAlignedBox& box) const;
+
+  private:
+    // Left, right, bottom, top, near, far. Points inside the frustum have a
+    // non-negative dot product with every plane.
+    QVector4D planes_[6];
+};
+
+}  // namespace sv
+
+#endif  // SCENEVIEW_VIEW_FRUSTUM_HPP__
@@ -0,0 +1,44 @@
+// Copyright [2015] Albert Huang
+
+#include <gtest/gtest.h>
+
+#include <QMatrix4x4>
+
+#include "sceneview/view_frustum.hpp"
+
+using sv::AxisAlignedBox;
+using sv::ViewFrustum;
+
+static AxisAlignedBox Box(float x, float y, float z, float half_size) {
+  return AxisAlignedBox(QVector3D(x, y, z) - QVector3D(1, 1, 1) * half_size,
+      QVector3D(x, y, z) + QVector3D(1, 1, 1) * half_size);
+}
+
+TEST(ViewFrustum, Perspective) {
+  // Camera at the origin looking down the negative z axis.
+  QMatrix4x4 proj;
+  proj.perspective(90, 1, 1, 100);
+  const ViewFrustum frustum(proj);
+
+  EXPECT_TRUE(frustum.Intersects(Box(0, 0, -10, 1)));
+  EXPECT_TRUE(frustum.Intersects(Box(9, 9, -10, 1)));
+  EXPECT_TRUE(frustum.Intersects(Box(0, 0, -100, 1)));
+
+  // Behind the camera, beyond the far plane, and off to the sides.
+  EXPECT_FALSE(frustum.Intersects(Box(0, 0, 10, 1)));
+  EXPECT_FALSE(frustum.Intersects(Box(0, 0, -102, 1)));
+  EXPECT_FALSE(frustum.Intersects(Box(20, 0, -10, 1)));
+  EXPECT_FALSE(frustum.Intersects(Box(0, -20, -10, 1)));
+}
+
+TEST(ViewFrustum, ModelFrame) {
+  // Planes are in the model frame of the matrix.
+  QMatrix4x4 proj;
+  proj.ortho(-1, 1, -1, 1, -1, 1);
+  QMatrix4x4 model;
+  model.translate(10, 0, 0);
+  const ViewFrustum frustum(proj * model);
+
+  EXPECT_TRUE(frustum.Intersects(Box(-10, 0, 0, 0.5)));
+  EXPECT_FALSE(frustum.Intersects(Box(0, 0, 0, 0.5)));
+}
@@ -52,7 +52,7 @@ void ViewHandlerHorizontal::MousePressEvent(QMouseEvent *event) {
 
   movement_scale_ = vsize_per_pixel * mouse_speed_;
 
-  eye_start_ = camera_->Translation();
+  eye_start_ = camera_->PreciseTranslation();
   look_start_ = camera_->GetLookDir();
   up_start_ = camera_->GetUpDir();
 
@@ -74,10 +74,10 @@ void ViewHandlerHorizontal::MouseMoveEvent(QMouseEvent *event) {
     const double movement_left = screen_dx * movement_scale_;
     const double movement_forward = screen_dy * movement_scale_;
 
-    const QVector3D new_eye = eye_start_ +
-      movement_left * left +
-      movement_forward * forward;
-    const QVector3D new_look_at = new_eye + look_start_ * PivotDistance();
+    const Vector3d new_eye = eye_start_ + Vector3d(
+        movement_left * left + movement_forward * forward);
+    const Vector3d new_look_at =
+      new_eye + Vector3d(look_start_ * PivotDistance());
 
     camera_->LookAt(new_eye, new_look_at, up_start_);
     UpdateShapeTransform();
@@ -85,14 +85,14 @@ void ViewHandlerHorizontal::MouseMoveEvent(QMouseEvent *event) {
   } else if (buttons & Qt::MidButton) {
     // Raise / lower the camera
     const QVector3D motion = screen_dy * movement_scale_ * zenith_dir_;
-    const QVector3D new_eye = eye_start_ + motion;
-    camera_->LookAt(new_eye, new_eye + look_start_ * PivotDistance(),
-        up_start_);
+    const Vector3d new_eye = eye_start_ + Vector3d(motion);
+    camera_->LookAt(new_eye,
+        new_eye + Vector3d(look_start_ * PivotDistance()), up_start_);
     UpdateShapeTransform();
     viewport_->ScheduleRedraw();
   } else if (buttons & Qt::RightButton && allow_azimuth_elevation_control_) {
     // Rotate about the pivot
-    const QVector3D look_at = camera_->GetLookAt();
+    const Vector3d look_at = camera_->GetPreciseLookAt();
     const QVector3D left = QVector3D::crossProduct(
         up_start_, look_start_).normalized();
     const double init_elevation = M_PI / 2 -
@@ -117,7 +117,7 @@ void ViewHandlerHorizontal::MouseMoveEvent(QMouseEvent *event) {
         look_start_);
     const QVector3D new_left = azimuth_rot.rotatedVector(left);
 
-    const QVector3D new_eye = look_at - new_look * PivotDistance();
+    const Vector3d new_eye = look_at - Vector3d(new_look * PivotDistance());
     const QVector3D new_up = QVector3D::crossProduct(new_look, new_left);
 
     camera_->LookAt(new_eye, look_at, new_up);
@@ -142,9 +142,10 @@ void ViewHandlerHorizontal::WheelEvent(QWheelEvent* event) {
   }
   const double new_distance = event->delta() * PivotDistance() * .001;
 
-  const QVector3D new_eye = camera_->Translation() + camera_->GetLookDir() * new_distance;
+  const Vector3d new_eye = camera_->PreciseTranslation() +
+    Vector3d(camera_->GetLookDir() * new_distance);
 
-  camera_->LookAt(new_eye, camera_->GetLookAt(), camera_->GetUpDir());
+  camera_->LookAt(new_eye, camera_->GetPreciseLookAt(), camera_->GetUpDir());
   UpdateShapeTransform();
   UpdateNearFarPlanes();
   viewport_->ScheduleRedraw();
@@ -165,8 +166,8 @@ void ViewHandlerHorizontal::KeyPressEvent(QKeyEvent* event) {
   const double vsize_at_pivot = PivotDistance() * tan(vfov / 2);
   const double vsize_per_pixel = vsize_at_pivot / cy;
   const QVector3D motion = vsize_per_pixel * zenith_dir_ * direction * 10;
-  const QVector3D new_eye = camera_->Translation() + motion;
-  const QVector3D new_look_at = camera_->GetLookAt() + motion;
+  const Vector3d new_eye = camera_->PreciseTranslation() + Vector3d(motion);
+  const Vector3d new_look_at = camera_->GetPreciseLookAt() + Vector3d(motion);
   camera_->LookAt(new_eye, new_look_at, camera_->GetUpDir());
   UpdateShapeTransform();
   viewport_->ScheduleRedraw();
@@ -221,7 +222,8 @@ void ViewHandlerHorizontal::SetAllowAzimuthElevationControl(bool val) {
 }
 
 double ViewHandlerHorizontal::PivotDistance() const {
-  return (camera_->Translation() - camera_->GetLookAt()).length();
+  return (camera_->PreciseTranslation() - camera_->GetPreciseLookAt())
+    .ToVector3D().length();
 }
 
 void ViewHandlerHorizontal::MakeShape() {
@@ -266,7 +268,7 @@ void ViewHandlerHorizontal::UpdateShapeTransform() {
 
   const double dscale = PivotDistance() * 0.05;
   look_at_shape_->SetScale(dscale, dscale, 0.2 * dscale);
-  look_at_shape_->SetTranslation(camera_->GetLookAt());
+  look_at_shape_->SetPreciseTranslation(camera_->GetPreciseLookAt());
 
   if (hide_shape_timer_->isActive()) {
     hide_shape_timer_->stop();
@@ -6,6 +6,7 @@
 #include <QVector3D>
 
 #include <sceneview/input_handler.hpp>
+#include <sceneview/vector3d.hpp>
 
 class QComboBox;
 class QMouseEvent;
@@ -148,7 +149,7 @@ class ViewHandlerHorizontal : public QObject, public InputHandler {
     int first_mouse_y_;
 
     double movement_scale_;
-    QVector3D eye_start_;
+    Vector3d eye_start_;
     QVector3D look_start_;
     QVector3D up_start_;
 
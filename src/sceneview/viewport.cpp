@@ -122,6 +122,10 @@ void Viewport::SetBackgroundColor(const QColor& color) {
   draw_->SetClearColor(color);
 }
 
+void Viewport::SetLodHysteresis(float hysteresis) {
+  draw_->SetLodHysteresis(hysteresis);
+}
+
 void Viewport::SetDrawGroups(const std::vector<DrawGroup*>& groups) {
   draw_->SetDrawGroups(groups);
 }
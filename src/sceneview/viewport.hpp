@@ -64,6 +64,18 @@ class Viewport : public QOpenGLWidget {
 
     void SetBackgroundColor(const QColor& color);
 
+    /**
+     * Sets the hysteresis used when switching between geometry levels of
+     * detail, as a fraction of the switching screen size.
+     *
+     * For example, with a hysteresis of 0.1, a drawable switches to a finer
+     * level once its projected size is 10% larger than the switching size,
+     * and back to the coarser level once it is 10% smaller. This avoids
+     * flickering between levels when the size hovers around the threshold.
+     * The default is 0.1.
+     */
+    void SetLodHysteresis(float hysteresis);
+
     void SetDrawGroups(const std::vector<DrawGroup*>& groups);
 
     InputHandler* GetActiveInputHandler() { return input_handler_; }
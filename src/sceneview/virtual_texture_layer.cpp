@@ -0,0 +1,405 @@
+// Copyright [2015] Albert Huang
+
+#include "sceneview/internal_gl.hpp"
+
+#include "sceneview/virtual_texture_layer.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <queue>
+#include <utility>
+
+#include <QElapsedTimer>
+#include <QMatrix4x4>
+#include <QOpenGLTexture>
+
+#include "sceneview/camera_node.hpp"
+#include "sceneview/draw_node.hpp"
+#include "sceneview/group_node.hpp"
+#include "sceneview/stock_resources.hpp"
+#include "sceneview/thread_pool.hpp"
+#include "sceneview/view_frustum.hpp"
+#include "sceneview/viewport.hpp"
+
+#if 0
+#define dbg(fmt, ...) printf(fmt, __VA_ARGS__)
+#else
+#define dbg(...)
+#endif
+
+namespace sv {
+
+// Limits the number of page requests queued at a time, so that pages that
+// are no longer needed don't tie up the worker threads.
+static const int kMaxPendingRequestsPerThread = 4;
+
+static std::shared_ptr<QOpenGLTexture> MakeTexture(int width, int height,
+    QOpenGLTexture::Filter filter) {
+  std::shared_ptr<QOpenGLTexture> texture(
+      new QOpenGLTexture(QOpenGLTexture::Target2D));
+  texture->setSize(width, height);
+  texture->setFormat(QOpenGLTexture::RGBA8_UNorm);
+  texture->allocateStorage();
+  texture->setMinificationFilter(filter);
+  texture->setMagnificationFilter(filter);
+  texture->setWrapMode(QOpenGLTexture::ClampToEdge);
+  return texture;
+}
+
+// Writes RGBA pixels to a rectangle of a texture.
+static void WriteTexture(QOpenGLTexture* texture, int x, int y,
+    int width, int height, const uint8_t* pixels) {
+  texture->bind();
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height, GL_RGBA,
+      GL_UNSIGNED_BYTE, pixels);
+  texture->release();
+}
+
+VirtualTextureLayer::Ptr VirtualTextureLayer::Create(Viewport* viewport,
+    GroupNode* parent, int width, int height, float pixel_size,
+    const PageProvider& provider, int tile_size, int cache_size) {
+  return Ptr(new VirtualTextureLayer(viewport, parent, width, height,
+        pixel_size, provider, tile_size, cache_size));
+}
+
+VirtualTextureLayer::VirtualTextureLayer(Viewport* viewport,
+    GroupNode* parent, int width, int height, float pixel_size,
+    const PageProvider& provider, int tile_size, int cache_size) :
+  resources_(viewport->GetResources()),
+  scene_(viewport->GetScene()),
+  draw_node_(nullptr),
+  provider_(provider),
+  pixel_size_(pixel_size),
+  // Slot coordinates are stored in a byte of the indirection table.
+  slots_x_(std::min(std::max(cache_size / (tile_size + 2), 1), 256)),
+  slots_y_(std::min(std::max(cache_size / (tile_size + 2), 1), 256)),
+  page_table_(width, height, tile_size, slots_x_ * slots_y_),
+  max_screen_error_(1),
+  upload_time_budget_(4),
+  frame_(0) {
+  StockResources stock(resources_);
+  material_ =
+    stock.NewMaterial(StockResources::kVirtualTextureUniformColorNoLighting);
+  material_->SetParam(kColor, 1.0f, 1.0f, 1.0f, 1.0f);
+  material_->SetTwoSided(true);
+  node_ = scene_->MakeGroup(parent);
+}
+
+VirtualTextureLayer::~VirtualTextureLayer() {
+  // Requests that are still running finish in the background, and the
+  // results are dropped.
+  if (scene_->ContainsNode(node_)) {
+    scene_->DestroyNode(node_);
+  }
+}
+
+void VirtualTextureLayer::Invalidate(int x, int y, int width, int height) {
+  const int x_end = std::min(x + width, page_table_.Width());
+  const int y_end = std::min(y + height, page_table_.Height());
+  x = std::max(x, 0);
+  y = std::max(y, 0);
+  if (x >= x_end || y >= y_end) {
+    return;
+  }
+  for (int level = 0; level < page_table_.NumLevels(); ++level) {
+    const int page_size = page_table_.TileSize() << level;
+    for (int page_y = y / page_size; page_y <= (y_end - 1) / page_size;
+        ++page_y) {
+      for (int page_x = x / page_size; page_x <= (x_end - 1) / page_size;
+          ++page_x) {
+        const Page page { level, page_x, page_y };
+        if (page_table_.Slot(page) >= 0) {
+          dirty_.insert(page);
+        }
+        auto iter = requests_.find(page);
+        if (iter != requests_.end()) {
+          iter->second.stale = true;
+        }
+      }
+    }
+  }
+}
+
+void VirtualTextureLayer::Update(CameraNode* camera) {
+  if (!cache_texture_) {
+    InitializeGL();
+  }
+  ++frame_;
+
+  SelectPages(camera);
+
+  // Building the indirection table marks the pages it uses, so that they
+  // aren't evicted by pages received in this frame.
+  UpdateIndirection();
+
+  ReceivePages();
+
+  RequestPages();
+}
+
+std::vector<uint8_t> VirtualTextureLayer::LoadPage(
+    const PageProvider& provider, const Page& page, int tile_size) {
+  const int slot_size = tile_size + 2;
+  std::vector<uint8_t> pixels(4 * slot_size * slot_size, 0);
+  QImage image = provider(page.level, page.x, page.y);
+  if (image.isNull()) {
+    return pixels;
+  }
+  if (image.width() != tile_size || image.height() != tile_size) {
+    image = image.scaled(tile_size, tile_size);
+  }
+  image = image.convertToFormat(QImage::Format_RGBA8888);
+
+  // The border repeats the edge pixels of the page.
+  const int row_bytes = 4 * tile_size;
+  for (int row = 0; row < slot_size; ++row) {
+    const int image_row = std::min(std::max(row - 1, 0), tile_size - 1);
+    const uint8_t* src = image.constScanLine(image_row);
+    uint8_t* dst = pixels.data() + 4 * slot_size * row;
+    std::copy(src, src + 4, dst);
+    std::copy(src, src + row_bytes, dst + 4);
+    std::copy(src + row_bytes - 4, src + row_bytes, dst + 4 + row_bytes);
+  }
+  return pixels;
+}
+
+void VirtualTextureLayer::InitializeGL() {
+  const int tile_size = page_table_.TileSize();
+  const int slot_size = tile_size + 2;
+  const int table_width = page_table_.LevelPagesX(0);
+  const int table_height = page_table_.LevelPagesY(0);
+  cache_texture_ = MakeTexture(slots_x_ * slot_size, slots_y_ * slot_size,
+      QOpenGLTexture::Linear);
+  indirection_texture_ = MakeTexture(table_width, table_height,
+      QOpenGLTexture::Nearest);
+  indirection_.assign(4 * table_width * table_height, 0);
+  WriteTexture(indirection_texture_.get(), 0, 0, table_width, table_height,
+      indirection_.data());
+
+  material_->AddTexture("vt_cache", cache_texture_);
+  material_->AddTexture("vt_indirection", indirection_texture_);
+  material_->SetParam("vt_pages",
+      static_cast<float>(page_table_.Width()) / tile_size,
+      static_cast<float>(page_table_.Height()) / tile_size);
+  material_->SetParam("vt_table_size", static_cast<float>(table_width),
+      static_cast<float>(table_height));
+  material_->SetParam("vt_tile_size", static_cast<float>(tile_size));
+  material_->SetParam("vt_slot_size", static_cast<float>(slot_size));
+  material_->SetParam("vt_cache_size",
+      static_cast<float>(slots_x_ * slot_size),
+      static_cast<float>(slots_y_ * slot_size));
+
+  const float width = pixel_size_ * page_table_.Width();
+  const float height = pixel_size_ * page_table_.Height();
+  GeometryData gdata;
+  gdata.gl_mode = GL_TRIANGLES;
+  gdata.vertices = {
+    { 0, 0, 0 },
+    { width, 0, 0 },
+    { width, height, 0 },
+    { 0, height, 0 }
+  };
+  gdata.tex_coords_0 = {
+    { 0, 0 },
+    { 1, 0 },
+    { 1, 1 },
+    { 0, 1 }
+  };
+  gdata.indices = { 0, 1, 2, 0, 2, 3 };
+  geometry_ = resources_->MakeGeometry();
+  geometry_->Load(gdata);
+  draw_node_ = scene_->MakeDrawNode(node_, geometry_, material_);
+  draw_node_->SetSelectionMask(node_->GetSelectionMask());
+}
+
+void VirtualTextureLayer::SelectPages(CameraNode* camera) {
+  selected_.clear();
+
+  const QMatrix4x4 model_view = camera->GetViewMatrix() *
+    node_->WorldTransform();
+  const QMatrix4x4 proj_mat = camera->GetProjectionMatrix();
+  const ViewFrustum frustum(proj_mat * model_view);
+  const bool perspective = proj_mat(3, 3) == 0;
+  const float scale = model_view.column(0).toVector3D().length();
+  const float pixels_per_unit =
+    proj_mat(1, 1) * camera->GetViewportSize().height() / 2;
+  const float max_x = pixel_size_ * page_table_.Width();
+  const float max_y = pixel_size_ * page_table_.Height();
+
+  auto page_box = [&](const Page& page) {
+    const float extent =
+      std::ldexp(pixel_size_ * page_table_.TileSize(), page.level);
+    return AxisAlignedBox(QVector3D(page.x * extent, page.y * extent, 0),
+        QVector3D(std::min((page.x + 1) * extent, max_x),
+          std::min((page.y + 1) * extent, max_y), 0));
+  };
+
+  // Computes the projected size of a pixel of a page, in screen pixels.
+  auto screen_error = [&](const Page& page, const AxisAlignedBox& box) {
+    float error =
+      std::ldexp(pixel_size_, page.level) * scale * pixels_per_unit;
+    if (perspective) {
+      const QVector3D center = model_view.map((box.Min() + box.Max()) / 2);
+      const float radius = (box.Max() - box.Min()).length() / 2 * scale;
+      error /= std::max(center.length() - radius, 1e-3f);
+    }
+    return error;
+  };
+
+  // Refine the page quadtree, largest error first, until pages are sharp
+  // enough or the selection would take up more than half of the cache. The
+  // rest of the cache holds the coarser pages drawn while finer pages are
+  // requested.
+  const int max_selected = std::max(page_table_.NumSlots() / 2, 1);
+  const Page root { page_table_.NumLevels() - 1, 0, 0 };
+  const AxisAlignedBox root_box = page_box(root);
+  if (!frustum.Intersects(root_box)) {
+    return;
+  }
+  std::priority_queue<std::pair<float, Page>> to_refine;
+  to_refine.push(std::make_pair(screen_error(root, root_box), root));
+  int num_selected = 1;
+  std::vector<std::pair<float, Page>> children;
+  while (!to_refine.empty()) {
+    const float error = to_refine.top().first;
+    const Page page = to_refine.top().second;
+    if (error <= max_screen_error_) {
+      break;
+    }
+    to_refine.pop();
+    if (page.level == 0) {
+      selected_.push_back(page);
+      continue;
+    }
+
+    children.clear();
+    for (int child_ind = 0; child_ind < 4; ++child_ind) {
+      const Page child { page.level - 1, page.x * 2 + child_ind % 2,
+        page.y * 2 + child_ind / 2 };
+      if (child.x >= page_table_.LevelPagesX(child.level) ||
+          child.y >= page_table_.LevelPagesY(child.level)) {
+        continue;
+      }
+      const AxisAlignedBox child_box = page_box(child);
+      if (frustum.Intersects(child_box)) {
+        children.push_back(
+            std::make_pair(screen_error(child, child_box), child));
+      }
+    }
+    if (num_selected - 1 + static_cast<int>(children.size()) >
+        max_selected) {
+      selected_.push_back(page);
+      break;
+    }
+    num_selected += children.size() - 1;
+    for (const std::pair<float, Page>& child : children) {
+      to_refine.push(child);
+    }
+  }
+  for (; !to_refine.empty(); to_refine.pop()) {
+    selected_.push_back(to_refine.top().second);
+  }
+}
+
+void VirtualTextureLayer::ReceivePages() {
+  const int slot_size = page_table_.TileSize() + 2;
+  QElapsedTimer timer;
+  timer.start();
+  bool written = false;
+  for (auto iter = requests_.begin(); iter != requests_.end();) {
+    if (written && timer.nsecsElapsed() > upload_time_budget_ * 1e6) {
+      break;
+    }
+    Request& request = iter->second;
+    if (request.pending.wait_for(std::chrono::seconds(0)) !=
+        std::future_status::ready) {
+      ++iter;
+      continue;
+    }
+    const Page page = iter->first;
+    const bool stale = request.stale;
+    const std::vector<uint8_t> pixels = request.pending.get();
+    iter = requests_.erase(iter);
+    if (stale) {
+      // Requested again if it's still needed.
+      continue;
+    }
+
+    bool evicted = false;
+    Page evicted_page { 0, 0, 0 };
+    const int slot = page_table_.Map(page, frame_, &evicted, &evicted_page);
+    if (slot < 0) {
+      continue;
+    }
+    if (evicted) {
+      dirty_.erase(evicted_page);
+    }
+    WriteTexture(cache_texture_.get(), (slot % slots_x_) * slot_size,
+        (slot / slots_x_) * slot_size, slot_size, slot_size, pixels.data());
+    written = true;
+    dbg("Wrote page (%d, %d, %d) to slot %d\n", page.level, page.x, page.y,
+        slot);
+  }
+  if (written) {
+    UpdateIndirection();
+  }
+}
+
+void VirtualTextureLayer::RequestPages() {
+  // Coarser pages are requested first, since they stand in for the finer
+  // pages until those arrive.
+  std::vector<Page> wanted(selected_);
+  wanted.push_back(Page { page_table_.NumLevels() - 1, 0, 0 });
+  std::sort(wanted.begin(), wanted.end(),
+      [](const Page& page_a, const Page& page_b) {
+        return page_a.level > page_b.level;
+      });
+
+  const int max_pending =
+    kMaxPendingRequestsPerThread * ThreadPool::Default()->NumThreads();
+  auto request = [this](const Page& page) {
+    const PageProvider provider = provider_;
+    const int tile_size = page_table_.TileSize();
+    requests_[page].pending = ThreadPool::Default()->Submit(
+        [provider, page, tile_size]() {
+          return LoadPage(provider, page, tile_size);
+        });
+  };
+  for (const Page& page : wanted) {
+    if (static_cast<int>(requests_.size()) >= max_pending) {
+      return;
+    }
+    if (page_table_.Slot(page) < 0 && !requests_.count(page)) {
+      request(page);
+    }
+  }
+
+  // Pages in the cache that were invalidated are requested again, and
+  // rewritten in place when they arrive.
+  for (auto iter = dirty_.begin(); iter != dirty_.end();) {
+    if (static_cast<int>(requests_.size()) >= max_pending) {
+      return;
+    }
+    if (requests_.count(*iter)) {
+      ++iter;
+      continue;
+    }
+    request(*iter);
+    iter = dirty_.erase(iter);
+  }
+}
+
+void VirtualTextureLayer::UpdateIndirection() {
+  std::vector<uint8_t> indirection;
+  page_table_.BuildIndirection(selected_, slots_x_, frame_, &indirection);
+  if (indirection == indirection_) {
+    return;
+  }
+  indirection_.swap(indirection);
+  WriteTexture(indirection_texture_.get(), 0, 0, page_table_.LevelPagesX(0),
+      page_table_.LevelPagesY(0), indirection_.data());
+}
+
+}  // namespace sv
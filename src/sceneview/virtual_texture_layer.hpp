@@ -0,0 +1,237 @@
+// Copyright [2015] Albert Huang
+
+#ifndef SCENEVIEW_VIRTUAL_TEXTURE_LAYER_HPP__
+#define SCENEVIEW_VIRTUAL_TEXTURE_LAYER_HPP__
+
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <set>
+#include <vector>
+
+#include <QImage>
+
+#include <sceneview/geometry_resource.hpp>
+#include <sceneview/material_resource.hpp>
+#include <sceneview/resource_manager.hpp>
+#include <sceneview/scene.hpp>
+#include <sceneview/virtual_texture_page_table.hpp>
+
+class QOpenGLTexture;
+
+namespace sv {
+
+class CameraNode;
+class DrawNode;
+class GroupNode;
+class Viewport;
+
+/**
+ * Draws a 2D image that is too large for a single texture, such as an
+ * occupancy grid or an orthomosaic of a large site, on a rectangle.
+ *
+ * The image is a virtual texture: it is split into pages of tile_size
+ * pixels, with a mip chain of coarser levels. Only the pages needed to draw
+ * the current view are kept in graphics memory, in the slots of a fixed-size
+ * cache texture. An indirection table texture maps each part of the image to
+ * the cache slot of the page that covers it, and is used by the
+ * StockResources::kVirtualTextureUniformColorNoLighting shader.
+ *
+ * Each frame, Update() computes which pages are visible and at which level,
+ * from the camera and the projected size of the image's pixels. Pages that
+ * aren't in the cache are requested from a page provider on worker threads,
+ * coarsest first, and written into the cache with glTexSubImage2D() subject
+ * to a time budget. Until a page is available, the nearest coarser page in
+ * the cache is drawn in its place. When the cache is full, the least
+ * recently used pages are evicted.
+ *
+ * When part of the image changes, Invalidate() marks the pages that cover
+ * it as dirty. Dirty pages are requested again and rewritten in place, so
+ * the cost of an update depends on the size of the changed region and not
+ * on the size of the image.
+ *
+ * Pixel (x, y) of the image covers the square from (x, y) * pixel_size to
+ * (x + 1, y + 1) * pixel_size on the z = 0 plane of Node(). Row 0 of the
+ * image, and of each page, is at the lowest y.
+ *
+ * @code
+ * auto provider = [&map](int level, int x, int y) {
+ *   return map.RenderPage(level, x, y);
+ * };
+ * VirtualTextureLayer::Ptr layer = VirtualTextureLayer::Create(viewport,
+ *     scene->Root(), 40000, 40000, 0.025, provider);
+ *
+ * // When the robot updates part of the map:
+ * layer->Invalidate(x, y, width, height);
+ *
+ * // In Renderer::RenderBegin(), or elsewhere with the OpenGL context
+ * // current, once per frame:
+ * layer->Update(viewport->GetCamera());
+ * @endcode
+ *
+ * @ingroup sv_scenegraph
+ * @headerfile sceneview/virtual_texture_layer.hpp
+ */
+class VirtualTextureLayer {
+  public:
+    typedef std::shared_ptr<VirtualTextureLayer> Ptr;
+
+    /**
+     * Produces the pixels of a page.
+     *
+     * Called with the level and the coordinates of the page, and must return
+     * a tile_size x tile_size image of the page. Pages of coarser levels
+     * must be downsampled by the provider. Pages that extend past the edge
+     * of the image may have anything in the part outside the image. Images
+     * of the wrong size are scaled, and null images are drawn transparent.
+     *
+     * The provider is called on worker threads, possibly several at a time.
+     */
+    typedef std::function<QImage(int level, int x, int y)> PageProvider;
+
+    /**
+     * Creates a virtual texture layer.
+     *
+     * @param viewport provides the scene and resources.
+     * @param parent the parent of Node().
+     * @param width the width of the image, in pixels.
+     * @param height the height of the image, in pixels.
+     * @param pixel_size the size of a pixel, in the units of Node().
+     * @param provider produces the pixels of pages.
+     * @param tile_size the width and height of a page, in pixels. A cache
+     *        slot is two pixels larger, for a border that allows bilinear
+     *        filtering.
+     * @param cache_size the width and height of the cache texture, in
+     *        pixels.
+     */
+    static Ptr Create(Viewport* viewport, GroupNode* parent,
+        int width, int height, float pixel_size,
+        const PageProvider& provider,
+        int tile_size = 254, int cache_size = 4096);
+
+    ~VirtualTextureLayer();
+
+    /**
+     * Marks the pages that cover a rectangle of the image as dirty, so that
+     * they are requested from the provider again.
+     *
+     * The provider must already return the new pixels when this is called.
+     */
+    void Invalidate(int x, int y, int width, int height);
+
+    /**
+     * Selects the pages to draw, queues page requests, writes received
+     * pages into the cache, and updates the indirection table.
+     *
+     * Must be called with the OpenGL context current, typically once per
+     * frame before drawing.
+     */
+    void Update(CameraNode* camera);
+
+    /**
+     * Sets the projected size, in screen pixels, of an image pixel above
+     * which a finer level is drawn. The default is 1.
+     */
+    void SetMaxScreenSpaceError(float pixels) { max_screen_error_ = pixels; }
+
+    /**
+     * Sets the maximum time, in milliseconds, spent writing pages to the
+     * cache in each call to Update(). At least one page is written per call
+     * if any are ready. The default is 4 ms.
+     */
+    void SetUploadTimeBudget(double milliseconds) {
+      upload_time_budget_ = milliseconds;
+    }
+
+    /**
+     * Retrieve the group node that the layer is drawn under.
+     */
+    GroupNode* Node() { return node_; }
+
+    /**
+     * Retrieve the material used to draw the layer. Its color parameter
+     * sv::kColor multiplies the image, and defaults to opaque white.
+     */
+    const MaterialResource::Ptr& Material() const { return material_; }
+
+    /**
+     * Retrieve the page table.
+     */
+    const VirtualTexturePageTable& PageTable() const { return page_table_; }
+
+    /**
+     * Retrieve the number of pages selected by the last call to Update().
+     */
+    int NumSelectedPages() const { return selected_.size(); }
+
+    /**
+     * Returns true if some pages are being requested or haven't been
+     * written to the cache yet.
+     */
+    bool UpdatePending() const { return !requests_.empty(); }
+
+  private:
+    typedef VirtualTexturePageTable::Page Page;
+
+    struct Request {
+      Request() : stale(false) {}
+
+      std::future<std::vector<uint8_t>> pending;
+
+      // The page was invalidated after the request was made.
+      bool stale;
+    };
+
+    VirtualTextureLayer(Viewport* viewport, GroupNode* parent,
+        int width, int height, float pixel_size,
+        const PageProvider& provider, int tile_size, int cache_size);
+
+    // Produces the pixels of a cache slot, with a border.
+    static std::vector<uint8_t> LoadPage(const PageProvider& provider,
+        const Page& page, int tile_size);
+
+    void InitializeGL();
+
+    void SelectPages(CameraNode* camera);
+
+    void ReceivePages();
+
+    void RequestPages();
+
+    void UpdateIndirection();
+
+    ResourceManager::Ptr resources_;
+    Scene::Ptr scene_;
+    GroupNode* node_;
+    DrawNode* draw_node_;
+    GeometryResource::Ptr geometry_;
+    MaterialResource::Ptr material_;
+
+    PageProvider provider_;
+    float pixel_size_;
+    int slots_x_;
+    int slots_y_;
+
+    VirtualTexturePageTable page_table_;
+    std::shared_ptr<QOpenGLTexture> cache_texture_;
+    std::shared_ptr<QOpenGLTexture> indirection_texture_;
+    std::vector<uint8_t> indirection_;
+
+    float max_screen_error_;
+    double upload_time_budget_;
+    int64_t frame_;
+
+    // Pages selected by the last call to Update().
+    std::vector<Page> selected_;
+
+    std::map<Page, Request> requests_;
+
+    // Pages in the cache that were invalidated.
+    std::set<Page> dirty_;
+};
+
+}  // namespace sv
+
+#endif  // SCENEVIEW_VIRTUAL_TEXTURE_LAYER_HPP__
@@ -0,0 +1,165 @@
+// Copyright [2015] Albert Huang
+
+#include "sceneview/virtual_texture_page_table.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <tuple>
+
+namespace sv {
+
+bool VirtualTexturePageTable::Page::operator<(const Page& other) const {
+  return std::tie(level, x, y) < std::tie(other.level, other.x, other.y);
+}
+
+bool VirtualTexturePageTable::Page::operator==(const Page& other) const {
+  return level == other.level && x == other.x && y == other.y;
+}
+
+VirtualTexturePageTable::Page VirtualTexturePageTable::Page::Parent() const {
+  return Page { level + 1, x / 2, y / 2 };
+}
+
+VirtualTexturePageTable::VirtualTexturePageTable(int width, int height,
+    int tile_size, int num_slots) :
+  width_(width),
+  height_(height),
+  tile_size_(tile_size),
+  num_levels_(1),
+  slot_pages_(std::max(num_slots, 0)),
+  slot_frames_(std::max(num_slots, 0)) {
+  if (width <= 0 || height <= 0 || tile_size <= 0 || num_slots <= 0) {
+    throw std::invalid_argument("Invalid virtual texture size");
+  }
+  while (LevelPagesX(num_levels_ - 1) > 1 ||
+      LevelPagesY(num_levels_ - 1) > 1) {
+    ++num_levels_;
+  }
+  Clear();
+}
+
+int VirtualTexturePageTable::LevelPagesX(int level) const {
+  const int64_t page_size = static_cast<int64_t>(tile_size_) << level;
+  return (width_ + page_size - 1) / page_size;
+}
+
+int VirtualTexturePageTable::LevelPagesY(int level) const {
+  const int64_t page_size = static_cast<int64_t>(tile_size_) << level;
+  return (height_ + page_size - 1) / page_size;
+}
+
+int VirtualTexturePageTable::Slot(const Page& page) const {
+  auto iter = pages_.find(page);
+  return iter == pages_.end() ? -1 : iter->second;
+}
+
+int VirtualTexturePageTable::Map(const Page& page, int64_t frame,
+    bool* evicted, Page* evicted_page) {
+  if (evicted) {
+    *evicted = false;
+  }
+  const int existing = Slot(page);
+  if (existing >= 0) {
+    slot_frames_[existing] = frame;
+    return existing;
+  }
+
+  int slot;
+  if (!free_slots_.empty()) {
+    slot = free_slots_.back();
+    free_slots_.pop_back();
+  } else {
+    slot = std::min_element(slot_frames_.begin(), slot_frames_.end()) -
+      slot_frames_.begin();
+    if (slot_frames_[slot] >= frame) {
+      return -1;
+    }
+    if (evicted) {
+      *evicted = true;
+    }
+    if (evicted_page) {
+      *evicted_page = slot_pages_[slot];
+    }
+    pages_.erase(slot_pages_[slot]);
+  }
+  pages_[page] = slot;
+  slot_pages_[slot] = page;
+  slot_frames_[slot] = frame;
+  return slot;
+}
+
+void VirtualTexturePageTable::Unmap(const Page& page) {
+  auto iter = pages_.find(page);
+  if (iter == pages_.end()) {
+    return;
+  }
+  free_slots_.push_back(iter->second);
+  pages_.erase(iter);
+}
+
+void VirtualTexturePageTable::Clear() {
+  pages_.clear();
+  free_slots_.clear();
+  // Slots are handed out in increasing order.
+  for (int slot = NumSlots() - 1; slot >= 0; --slot) {
+    free_slots_.push_back(slot);
+  }
+}
+
+void VirtualTexturePageTable::BuildIndirection(
+    const std::vector<Page>& pages, int slots_x, int64_t frame,
+    std::vector<uint8_t>* table) {
+  table->assign(4 * LevelPagesX(0) * LevelPagesY(0), 0);
+
+  Page mapped;
+  int slot;
+  const Page root { num_levels_ - 1, 0, 0 };
+  if (FindMapped(root, &mapped, &slot)) {
+    FillEntries(root, mapped, slot, slots_x, table);
+    slot_frames_[slot] = frame;
+  }
+  for (const Page& page : pages) {
+    if (FindMapped(page, &mapped, &slot)) {
+      FillEntries(page, mapped, slot, slots_x, table);
+      slot_frames_[slot] = frame;
+    }
+  }
+}
+
+bool VirtualTexturePageTable::FindMapped(Page page, Page* mapped,
+    int* slot) const {
+  for (; page.level < num_levels_; page = page.Parent()) {
+    const int page_slot = Slot(page);
+    if (page_slot >= 0) {
+      *mapped = page;
+      *slot = page_slot;
+      return true;
+    }
+  }
+  return false;
+}
+
+void VirtualTexturePageTable::FillEntries(const Page& page,
+    const Page& mapped, int slot, int slots_x,
+    std::vector<uint8_t>* table) const {
+  const int table_width = LevelPagesX(0);
+  const int table_height = LevelPagesY(0);
+  const int x_begin = page.x << page.level;
+  const int y_begin = page.y << page.level;
+  const int x_end = std::min((page.x + 1) << page.level, table_width);
+  const int y_end = std::min((page.y + 1) << page.level, table_height);
+  const uint8_t entry[4] = {
+    static_cast<uint8_t>(slot % slots_x),
+    static_cast<uint8_t>(slot / slots_x),
+    static_cast<uint8_t>(mapped.level),
+    255
+  };
+  for (int y = y_begin; y < y_end; ++y) {
+    uint8_t* row = table->data() + 4 * y * table_width;
+    for (int x = x_begin; x < x_end; ++x) {
+      std::copy(entry, entry + 4, row + 4 * x);
+    }
+  }
+}
+
+}  // namespace sv
@@ -0,0 +1,168 @@
+// Copyright [2015] Albert Huang
+
+#ifndef SCENEVIEW_VIRTUAL_TEXTURE_PAGE_TABLE_HPP__
+#define SCENEVIEW_VIRTUAL_TEXTURE_PAGE_TABLE_HPP__
+
+#include <cstdint>
+#include <map>
+#include <vector>
+
+namespace sv {
+
+/**
+ * Bookkeeping for a virtual texture: which pages of the virtual image are
+ * stored in which slots of a physical cache texture.
+ *
+ * The virtual image is split into square pages of tile_size pixels, and has
+ * a mip chain of levels that halve the resolution until the whole image fits
+ * in one page. Page (level, x, y) covers the level 0 pixels from
+ * (x, y) * (tile_size << level) to (x + 1, y + 1) * (tile_size << level).
+ *
+ * The cache has a fixed number of slots. When it is full, mapping a page
+ * evicts the least recently used page that wasn't used in the current
+ * frame.
+ *
+ * The page table only does bookkeeping, and never touches graphics memory.
+ *
+ * @ingroup sv_resources
+ * @headerfile sceneview/virtual_texture_page_table.hpp
+ */
+class VirtualTexturePageTable {
+  public:
+    /**
+     * Identifies a page of the virtual image.
+     */
+    struct Page {
+      int level;
+      int x;
+      int y;
+
+      bool operator<(const Page& other) const;
+      bool operator==(const Page& other) const;
+
+      /**
+       * Retrieve the page of the next coarser level that contains this one.
+       */
+      Page Parent() const;
+    };
+
+    /**
+     * Constructor.
+     *
+     * @param width the width of the virtual image, in pixels.
+     * @param height the height of the virtual image, in pixels.
+     * @param tile_size the width and height of a page, in pixels.
+     * @param num_slots the number of pages that the cache can hold.
+     *
+     * @throw std::invalid_argument if a size is not positive.
+     */
+    VirtualTexturePageTable(int width, int height, int tile_size,
+        int num_slots);
+
+    int Width() const { return width_; }
+
+    int Height() const { return height_; }
+
+    int TileSize() const { return tile_size_; }
+
+    int NumSlots() const { return slot_pages_.size(); }
+
+    /**
+     * Retrieve the number of mip levels. The coarsest level is a single
+     * page.
+     */
+    int NumLevels() const { return num_levels_; }
+
+    /**
+     * Retrieve the number of pages along the x axis of a level.
+     */
+    int LevelPagesX(int level) const;
+
+    /**
+     * Retrieve the number of pages along the y axis of a level.
+     */
+    int LevelPagesY(int level) const;
+
+    /**
+     * Retrieve the slot that holds a page, or -1 if the page isn't mapped.
+     */
+    int Slot(const Page& page) const;
+
+    /**
+     * Assigns a slot to a page, evicting the least recently used page if
+     * the cache is full. The page is marked as used in @p frame.
+     *
+     * Does nothing if the page is already mapped.
+     *
+     * @param evicted if not null, set to whether a page was evicted.
+     * @param evicted_page if not null, receives the evicted page, if any.
+     *
+     * @return the slot of the page, or -1 if every slot is used by a page
+     * that was used in @p frame.
+     */
+    int Map(const Page& page, int64_t frame, bool* evicted = nullptr,
+        Page* evicted_page = nullptr);
+
+    /**
+     * Frees the slot of a page. Does nothing if the page isn't mapped.
+     */
+    void Unmap(const Page& page);
+
+    /**
+     * Frees all slots.
+     */
+    void Clear();
+
+    /**
+     * Retrieve the number of mapped pages.
+     */
+    int NumMapped() const { return pages_.size(); }
+
+    /**
+     * Builds the indirection table for drawing a set of pages.
+     *
+     * The table has one entry per page of level 0, in row major order, each
+     * made of 4 bytes: the x and y coordinates of a cache slot (in a grid of
+     * @p slots_x slots per row), the level of the page in that slot, and 255.
+     * The entries covered by each requested page refer to the requested page
+     * if it's mapped, or else to its nearest mapped ancestor. Entries that
+     * aren't covered by a requested page refer to the coarsest page if it's
+     * mapped. Entries without any mapped page are all zeros.
+     *
+     * Every page referred to by the table is marked as used in @p frame.
+     *
+     * @param pages pages that should be drawn. They should not overlap.
+     * @param slots_x the number of cache slots in each row of the cache
+     *        texture. At most 256.
+     * @param frame the current frame number.
+     * @param table receives the table, resized to 4 * LevelPagesX(0) *
+     *        LevelPagesY(0) bytes.
+     */
+    void BuildIndirection(const std::vector<Page>& pages, int slots_x,
+        int64_t frame, std::vector<uint8_t>* table);
+
+  private:
+    // Finds the nearest mapped page among a page and its ancestors, or
+    // returns false if there is none.
+    bool FindMapped(Page page, Page* mapped, int* slot) const;
+
+    void FillEntries(const Page& page, const Page& mapped, int slot,
+        int slots_x, std::vector<uint8_t>* table) const;
+
+    int width_;
+    int height_;
+    int tile_size_;
+    int num_levels_;
+
+    // Page to slot.
+    std::map<Page, int> pages_;
+
+    // For each slot, its page and the last frame it was used in.
+    std::vector<Page> slot_pages_;
+    std::vector<int64_t> slot_frames_;
+    std::vector<int> free_slots_;
+};
+
+}  // namespace sv
+
+#endif  // SCENEVIEW_VIRTUAL_TEXTURE_PAGE_TABLE_HPP__
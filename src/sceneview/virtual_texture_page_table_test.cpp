@@ -0,0 +1,105 @@
+// Copyright [2015] Albert Huang
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "sceneview/virtual_texture_page_table.hpp"
+
+using sv::VirtualTexturePageTable;
+
+typedef VirtualTexturePageTable::Page Page;
+
+TEST(VirtualTexturePageTable, Levels) {
+  VirtualTexturePageTable table(1000, 300, 128, 16);
+  EXPECT_EQ(8, table.LevelPagesX(0));
+  EXPECT_EQ(3, table.LevelPagesY(0));
+  EXPECT_EQ(4, table.LevelPagesX(1));
+  EXPECT_EQ(2, table.LevelPagesY(1));
+  EXPECT_EQ(4, table.NumLevels());
+  EXPECT_EQ(1, table.LevelPagesX(3));
+  EXPECT_EQ(1, table.LevelPagesY(3));
+
+  VirtualTexturePageTable single(100, 100, 128, 1);
+  EXPECT_EQ(1, single.NumLevels());
+}
+
+TEST(VirtualTexturePageTable, MapAndEvict) {
+  VirtualTexturePageTable table(1024, 1024, 256, 2);
+  const Page a { 0, 0, 0 };
+  const Page b { 0, 1, 0 };
+  const Page c { 0, 2, 0 };
+
+  EXPECT_EQ(0, table.Map(a, 1));
+  EXPECT_EQ(1, table.Map(b, 2));
+  EXPECT_EQ(0, table.Map(a, 2));
+  EXPECT_EQ(2, table.NumMapped());
+
+  // Every slot was used in frame 2, so nothing can be evicted.
+  EXPECT_EQ(-1, table.Map(c, 2));
+
+  // In the next frame, the least recently used page is evicted.
+  table.Map(b, 3);
+  bool evicted = false;
+  Page evicted_page { -1, -1, -1 };
+  EXPECT_EQ(0, table.Map(c, 4, &evicted, &evicted_page));
+  EXPECT_TRUE(evicted);
+  EXPECT_EQ(a, evicted_page);
+  EXPECT_EQ(-1, table.Slot(a));
+  EXPECT_EQ(0, table.Slot(c));
+
+  table.Unmap(b);
+  EXPECT_EQ(1, table.NumMapped());
+  EXPECT_EQ(1, table.Map(a, 4, &evicted));
+  EXPECT_FALSE(evicted);
+}
+
+TEST(VirtualTexturePageTable, Indirection) {
+  // 4x4 pages at level 0, 3 levels.
+  VirtualTexturePageTable table(1024, 1024, 256, 4);
+  ASSERT_EQ(3, table.NumLevels());
+  const Page root { 2, 0, 0 };
+  const Page fine { 0, 3, 2 };
+  const Page missing { 0, 0, 0 };
+  table.Map(root, 1);
+  table.Map(Page { 1, 1, 1 }, 1);
+  table.Map(fine, 1);
+
+  std::vector<uint8_t> entries;
+  const int slots_x = 2;
+  table.BuildIndirection({ fine, missing }, slots_x, 2, &entries);
+  ASSERT_EQ(4u * 16, entries.size());
+  auto entry = [&](int x, int y) {
+    const uint8_t* e = &entries[4 * (y * 4 + x)];
+    return std::vector<int>({ e[0], e[1], e[2], e[3] });
+  };
+
+  // The requested page is drawn from its own slot.
+  EXPECT_EQ(std::vector<int>({ 0, 1, 0, 255 }), entry(3, 2));
+
+  // A requested page that isn't mapped is drawn from its nearest mapped
+  // ancestor, and the rest from the coarsest page.
+  EXPECT_EQ(std::vector<int>({ 0, 0, 2, 255 }), entry(0, 0));
+  EXPECT_EQ(std::vector<int>({ 0, 0, 2, 255 }), entry(2, 2));
+
+  // Pages used by the table can't be evicted in the same frame, but the
+  // unused level 1 page can.
+  bool evicted = false;
+  Page evicted_page;
+  table.Map(Page { 0, 1, 1 }, 2);
+  EXPECT_EQ(1, table.Map(Page { 0, 2, 2 }, 2, &evicted, &evicted_page));
+  EXPECT_TRUE(evicted);
+  EXPECT_EQ((Page { 1, 1, 1 }), evicted_page);
+  EXPECT_EQ(-1, table.Map(Page { 0, 3, 3 }, 2));
+}
+
+TEST(VirtualTexturePageTable, EmptyIndirection) {
+  VirtualTexturePageTable table(512, 256, 256, 4);
+  std::vector<uint8_t> entries;
+  table.BuildIndirection({ Page { 0, 1, 0 } }, 2, 1, &entries);
+  ASSERT_EQ(4u * 2, entries.size());
+  for (uint8_t value : entries) {
+    EXPECT_EQ(0, value);
+  }
+}
@@ -0,0 +1,248 @@
+// Copyright [2015] Albert Huang
+
+#include "sceneview/internal_gl.hpp"
+
+#include "sceneview/voxel_map.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <tuple>
+#include <utility>
+
+#include "sceneview/draw_node.hpp"
+#include "sceneview/group_node.hpp"
+#include "sceneview/stock_resources.hpp"
+#include "sceneview/thread_pool.hpp"
+#include "sceneview/viewport.hpp"
+#include "sceneview/voxel_mesher.hpp"
+
+#if 0
+#define dbg(fmt, ...) printf(fmt, __VA_ARGS__)
+#else
+#define dbg(...)
+#endif
+
+namespace sv {
+
+// Division that rounds towards negative infinity.
+static int FloorDiv(int value, int divisor) {
+  const int quotient = value / divisor;
+  return (value % divisor < 0) ? quotient - 1 : quotient;
+}
+
+bool VoxelMap::ChunkKey::operator<(const ChunkKey& other) const {
+  return std::tie(x, y, z) < std::tie(other.x, other.y, other.z);
+}
+
+VoxelMap::Ptr VoxelMap::Create(Viewport* viewport, GroupNode* parent,
+    float voxel_size, int chunk_size) {
+  return Ptr(new VoxelMap(viewport, parent, voxel_size, chunk_size));
+}
+
+VoxelMap::VoxelMap(Viewport* viewport, GroupNode* parent, float voxel_size,
+    int chunk_size) :
+  resources_(viewport->GetResources()),
+  scene_(viewport->GetScene()),
+  voxel_size_(voxel_size),
+  chunk_size_(chunk_size) {
+  StockResources stock(resources_);
+  material_ = stock.NewMaterial(StockResources::kPerVertexColorLighting);
+  node_ = scene_->MakeGroup(parent);
+}
+
+VoxelMap::~VoxelMap() {
+  // Destroying the group node also destroys the DrawNodes of the chunks.
+  if (scene_->ContainsNode(node_)) {
+    scene_->DestroyNode(node_);
+  }
+}
+
+void VoxelMap::SetVoxel(int x, int y, int z, const QColor& color) {
+  SetPacked(x, y, z, color.alpha() ? color.rgba() : 0);
+}
+
+void VoxelMap::ClearVoxel(int x, int y, int z) {
+  SetPacked(x, y, z, 0);
+}
+
+bool VoxelMap::Occupied(int x, int y, int z) const {
+  return GetPacked(x, y, z) != 0;
+}
+
+void VoxelMap::Clear() {
+  for (auto& item : chunks_) {
+    DestroyChunkNode(&item.second);
+  }
+  // Meshing that is still running finishes in the background, and the
+  // results are dropped.
+  chunks_.clear();
+  dirty_.clear();
+  meshing_.clear();
+}
+
+void VoxelMap::Update() {
+  // Upload chunks that have finished meshing.
+  for (auto iter = meshing_.begin(); iter != meshing_.end();) {
+    Chunk& chunk = chunks_[*iter];
+    if (chunk.pending.wait_for(std::chrono::seconds(0)) !=
+        std::future_status::ready) {
+      ++iter;
+      continue;
+    }
+    const GeometryData mesh = chunk.pending.get();
+    chunk.meshing = false;
+    Upload(*iter, mesh);
+    iter = meshing_.erase(iter);
+  }
+
+  // Queue meshing of modified chunks. Chunks that are modified while being
+  // meshed are meshed again once the first result is in.
+  for (auto iter = dirty_.begin(); iter != dirty_.end();) {
+    const ChunkKey key = *iter;
+    Chunk& chunk = chunks_[key];
+    if (chunk.meshing) {
+      ++iter;
+      continue;
+    }
+    const std::vector<uint32_t> voxels = PaddedVoxels(key, chunk);
+    const int size = chunk_size_;
+    const float voxel_size = voxel_size_;
+    const QVector3D origin = QVector3D(key.x, key.y, key.z) * size *
+      voxel_size;
+    chunk.pending = ThreadPool::Default()->Submit(
+        [voxels, size, origin, voxel_size]() {
+          GeometryData mesh;
+          GreedyMeshVoxels(voxels.data(), size, origin, voxel_size, &mesh);
+          // The stock lighting shader also reads per-vertex specular
+          // colors and shininess.
+          mesh.specular.resize(mesh.vertices.size(), QVector4D(0, 0, 0, 1));
+          mesh.shininess.resize(mesh.vertices.size(), 1);
+          return mesh;
+        });
+    chunk.meshing = true;
+    meshing_.push_back(key);
+    iter = dirty_.erase(iter);
+  }
+}
+
+void VoxelMap::SetPacked(int x, int y, int z, uint32_t color) {
+  const ChunkKey key = { FloorDiv(x, chunk_size_), FloorDiv(y, chunk_size_),
+    FloorDiv(z, chunk_size_) };
+  auto iter = chunks_.find(key);
+  if (iter == chunks_.end()) {
+    if (!color) {
+      return;
+    }
+    iter = chunks_.insert(std::make_pair(key, Chunk())).first;
+    iter->second.voxels.resize(chunk_size_ * chunk_size_ * chunk_size_, 0);
+  }
+  Chunk& chunk = iter->second;
+
+  const int local[3] = {
+    x - key.x * chunk_size_,
+    y - key.y * chunk_size_,
+    z - key.z * chunk_size_
+  };
+  uint32_t& voxel = chunk.voxels[local[0] + chunk_size_ *
+    (local[1] + chunk_size_ * local[2])];
+  if (voxel == color) {
+    return;
+  }
+  chunk.num_occupied += (color != 0) - (voxel != 0);
+  voxel = color;
+  dirty_.insert(key);
+
+  // Faces of neighboring chunks may be hidden or revealed by voxels on the
+  // boundary.
+  for (int axis = 0; axis < 3; ++axis) {
+    int offset = 0;
+    if (local[axis] == 0) {
+      offset = -1;
+    } else if (local[axis] == chunk_size_ - 1) {
+      offset = 1;
+    } else {
+      continue;
+    }
+    ChunkKey neighbor = key;
+    (axis == 0 ? neighbor.x : axis == 1 ? neighbor.y : neighbor.z) += offset;
+    if (chunks_.count(neighbor)) {
+      dirty_.insert(neighbor);
+    }
+  }
+}
+
+uint32_t VoxelMap::GetPacked(int x, int y, int z) const {
+  const ChunkKey key = { FloorDiv(x, chunk_size_), FloorDiv(y, chunk_size_),
+    FloorDiv(z, chunk_size_) };
+  auto iter = chunks_.find(key);
+  if (iter == chunks_.end()) {
+    return 0;
+  }
+  const int local_x = x - key.x * chunk_size_;
+  const int local_y = y - key.y * chunk_size_;
+  const int local_z = z - key.z * chunk_size_;
+  return iter->second.voxels[local_x + chunk_size_ *
+    (local_y + chunk_size_ * local_z)];
+}
+
+std::vector<uint32_t> VoxelMap::PaddedVoxels(const ChunkKey& key,
+    const Chunk& chunk) const {
+  const int size = chunk_size_;
+  const int padded = size + 2;
+  std::vector<uint32_t> result(padded * padded * padded);
+  const int base_x = key.x * size;
+  const int base_y = key.y * size;
+  const int base_z = key.z * size;
+  for (int z = -1; z <= size; ++z) {
+    for (int y = -1; y <= size; ++y) {
+      uint32_t* row = &result[(y + 1) * padded + (z + 1) * padded * padded];
+      const bool border_row = y < 0 || y == size || z < 0 || z == size;
+      if (border_row) {
+        for (int x = -1; x <= size; ++x) {
+          row[x + 1] = GetPacked(base_x + x, base_y + y, base_z + z);
+        }
+        continue;
+      }
+      // Rows inside the chunk only need their first and last voxels from
+      // the neighbors.
+      row[0] = GetPacked(base_x - 1, base_y + y, base_z + z);
+      std::copy(&chunk.voxels[size * (y + size * z)],
+          &chunk.voxels[size * (y + size * z)] + size, row + 1);
+      row[size + 1] = GetPacked(base_x + size, base_y + y, base_z + z);
+    }
+  }
+  return result;
+}
+
+void VoxelMap::Upload(const ChunkKey& key, const GeometryData& mesh) {
+  auto iter = chunks_.find(key);
+  Chunk& chunk = iter->second;
+  if (mesh.indices.empty()) {
+    DestroyChunkNode(&chunk);
+    if (chunk.num_occupied == 0 && !dirty_.count(key)) {
+      chunks_.erase(iter);
+    }
+    return;
+  }
+
+  if (!chunk.geometry) {
+    chunk.geometry = resources_->MakeGeometry();
+  }
+  chunk.geometry->Load(mesh);
+  if (!chunk.draw_node) {
+    chunk.draw_node = scene_->MakeDrawNode(node_, chunk.geometry, material_);
+    chunk.draw_node->SetSelectionMask(node_->GetSelectionMask());
+  }
+  dbg("Uploaded voxel chunk (%d, %d, %d): %d triangles\n", key.x, key.y,
+      key.z, static_cast<int>(mesh.indices.size() / 3));
+}
+
+void VoxelMap::DestroyChunkNode(Chunk* chunk) {
+  if (chunk->draw_node) {
+    scene_->DestroyNode(chunk->draw_node);
+    chunk->draw_node = nullptr;
+  }
+  chunk->geometry.reset();
+}
+
+}  // namespace sv
@@ -0,0 +1,184 @@
+// Copyright [2015] Albert Huang
+
+#ifndef SCENEVIEW_VOXEL_MAP_HPP__
+#define SCENEVIEW_VOXEL_MAP_HPP__
+
+#include <cstdint>
+#include <future>
+#include <map>
+#include <memory>
+#include <set>
+#include <vector>
+
+#include <QColor>
+
+#include <sceneview/geometry_resource.hpp>
+#include <sceneview/material_resource.hpp>
+#include <sceneview/resource_manager.hpp>
+#include <sceneview/scene.hpp>
+
+namespace sv {
+
+class DrawNode;
+class GroupNode;
+class Viewport;
+
+/**
+ * Draws a large number of colored voxels, such as an occupancy map.
+ *
+ * Space is partitioned into cubic chunks of voxels. The surface of each
+ * chunk is built with GreedyMeshVoxels() on worker threads, and drawn by its
+ * own DrawNode below Node(), so view frustum culling works on a per chunk
+ * basis. When voxels change, only the chunks that contain them (and
+ * neighboring chunks, for voxels on a chunk boundary) are re-meshed.
+ *
+ * Voxels are addressed by integer coordinates. The voxel at (x, y, z)
+ * occupies the cube from (x, y, z) * voxel_size to (x + 1, y + 1, z + 1) *
+ * voxel_size in the coordinate frame of Node().
+ *
+ * @code
+ * VoxelMap::Ptr voxels = VoxelMap::Create(viewport, scene->Root(), 0.1);
+ * voxels->SetVoxel(10, 20, 3, Qt::red);
+ *
+ * // In Renderer::RenderBegin(), or elsewhere with the OpenGL context
+ * // current, once per frame:
+ * voxels->Update();
+ * @endcode
+ *
+ * @ingroup sv_scenegraph
+ * @headerfile sceneview/voxel_map.hpp
+ */
+class VoxelMap {
+  public:
+    typedef std::shared_ptr<VoxelMap> Ptr;
+
+    /**
+     * Creates an empty voxel map.
+     *
+     * @param viewport provides the scene and resources.
+     * @param parent the parent of Node().
+     * @param voxel_size the edge length of a voxel.
+     * @param chunk_size the number of voxels along each axis of a chunk.
+     */
+    static Ptr Create(Viewport* viewport, GroupNode* parent,
+        float voxel_size, int chunk_size = 16);
+
+    ~VoxelMap();
+
+    /**
+     * Sets the color of a voxel, marking it as occupied.
+     *
+     * Colors with an alpha of zero are treated like ClearVoxel(). Other
+     * colors are drawn opaque.
+     */
+    void SetVoxel(int x, int y, int z, const QColor& color);
+
+    /**
+     * Marks a voxel as empty.
+     */
+    void ClearVoxel(int x, int y, int z);
+
+    /**
+     * Returns true if a voxel is occupied.
+     */
+    bool Occupied(int x, int y, int z) const;
+
+    /**
+     * Removes all voxels.
+     */
+    void Clear();
+
+    /**
+     * Queues meshing of modified chunks, and uploads chunks that have
+     * finished meshing.
+     *
+     * Must be called with the OpenGL context current. Changes made with
+     * SetVoxel() and ClearVoxel() aren't visible until then.
+     */
+    void Update();
+
+    /**
+     * Retrieve the group node that all chunks are drawn under.
+     */
+    GroupNode* Node() { return node_; }
+
+    /**
+     * Retrieve the material used to draw the voxels. By default, this uses
+     * StockResources::kPerVertexColorLighting.
+     */
+    const MaterialResource::Ptr& Material() const { return material_; }
+
+    float VoxelSize() const { return voxel_size_; }
+
+    int ChunkSize() const { return chunk_size_; }
+
+    /**
+     * Retrieve the number of chunks that contain voxels.
+     */
+    int NumChunks() const { return chunks_.size(); }
+
+    /**
+     * Returns true if some changes haven't been uploaded yet, either because
+     * Update() hasn't been called or because chunks are still being meshed.
+     */
+    bool UpdatePending() const { return !dirty_.empty() || !meshing_.empty(); }
+
+  private:
+    struct ChunkKey {
+      int x;
+      int y;
+      int z;
+
+      bool operator<(const ChunkKey& other) const;
+    };
+
+    struct Chunk {
+      Chunk() : num_occupied(0), draw_node(nullptr), meshing(false) {}
+
+      // Voxel colors packed as 0xAARRGGBB, or 0 for empty voxels.
+      std::vector<uint32_t> voxels;
+      int num_occupied;
+
+      GeometryResource::Ptr geometry;
+      DrawNode* draw_node;
+
+      bool meshing;
+      std::future<GeometryData> pending;
+    };
+
+    VoxelMap(Viewport* viewport, GroupNode* parent, float voxel_size,
+        int chunk_size);
+
+    void SetPacked(int x, int y, int z, uint32_t color);
+
+    uint32_t GetPacked(int x, int y, int z) const;
+
+    // Copies the voxels of a chunk, with a one voxel border taken from the
+    // neighboring chunks.
+    std::vector<uint32_t> PaddedVoxels(const ChunkKey& key,
+        const Chunk& chunk) const;
+
+    void Upload(const ChunkKey& key, const GeometryData& mesh);
+
+    void DestroyChunkNode(Chunk* chunk);
+
+    ResourceManager::Ptr resources_;
+    Scene::Ptr scene_;
+    GroupNode* node_;
+    MaterialResource::Ptr material_;
+
+    float voxel_size_;
+    int chunk_size_;
+
+    std::map<ChunkKey, Chunk> chunks_;
+
+    // Chunks that have been modified since they were last meshed.
+    std::set<ChunkKey> dirty_;
+
+    // Chunks being meshed on worker threads.
+    std::vector<ChunkKey> meshing_;
+};
+
+}  // namespace sv
+
+#endif  // SCENEVIEW_VOXEL_MAP_HPP__
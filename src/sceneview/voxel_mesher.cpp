@@ -0,0 +1,128 @@
+// Copyright [2015] Albert Huang
+
+#include "sceneview/voxel_mesher.hpp"
+
+#include <vector>
+
+namespace sv {
+
+static QVector4D UnpackColor(uint32_t color) {
+  return QVector4D(((color >> 16) & 0xff) / 255.0f,
+      ((color >> 8) & 0xff) / 255.0f,
+      (color & 0xff) / 255.0f,
+      ((color >> 24) & 0xff) / 255.0f);
+}
+
+void GreedyMeshVoxels(const uint32_t* voxels, int size,
+    const QVector3D& origin, float voxel_size, GeometryData* mesh) {
+  *mesh = GeometryData();
+  mesh->gl_mode = GL_TRIANGLES;
+
+  const int padded = size + 2;
+  const int strides[3] = { 1, padded, padded * padded };
+  auto voxel_index = [&](const int pos[3]) {
+    return (pos[0] + 1) * strides[0] + (pos[1] + 1) * strides[1] +
+      (pos[2] + 1) * strides[2];
+  };
+
+  // Colors of the visible faces in the current slice, indexed by
+  // u + v * size.
+  std::vector<uint32_t> mask(size * size);
+
+  for (int axis = 0; axis < 3; ++axis) {
+    // (u, v, axis) is a right-handed coordinate frame, so quads listed
+    // counter-clockwise in (u, v) face the positive axis direction.
+    const int u = (axis + 1) % 3;
+    const int v = (axis + 2) % 3;
+
+    for (int sign = -1; sign <= 1; sign += 2) {
+      QVector3D normal;
+      normal[axis] = sign;
+
+      for (int slice = 0; slice < size; ++slice) {
+        // Find the faces of this slice that separate a solid voxel from an
+        // empty neighbor.
+        int pos[3];
+        pos[axis] = slice;
+        bool any_faces = false;
+        for (pos[v] = 0; pos[v] < size; ++pos[v]) {
+          for (pos[u] = 0; pos[u] < size; ++pos[u]) {
+            const int index = voxel_index(pos);
+            const uint32_t voxel = voxels[index];
+            const uint32_t neighbor = voxels[index + sign * strides[axis]];
+            const uint32_t face = neighbor ? 0 : voxel;
+            mask[pos[u] + pos[v] * size] = face;
+            any_faces = any_faces || face;
+          }
+        }
+        if (!any_faces) {
+          continue;
+        }
+
+        // Cover the faces with rectangles, greedily extending each one
+        // along u and then along v.
+        const float plane = sign > 0 ? slice + 1 : slice;
+        for (int j = 0; j < size; ++j) {
+          for (int i = 0; i < size;) {
+            const uint32_t color = mask[i + j * size];
+            if (!color) {
+              ++i;
+              continue;
+            }
+
+            int width = 1;
+            while (i + width < size && mask[i + width + j * size] == color) {
+              ++width;
+            }
+            int height = 1;
+            for (; j + height < size; ++height) {
+              bool row_matches = true;
+              for (int k = 0; k < width; ++k) {
+                if (mask[i + k + (j + height) * size] != color) {
+                  row_matches = false;
+                  break;
+                }
+              }
+              if (!row_matches) {
+                break;
+              }
+            }
+            for (int row = j; row < j + height; ++row) {
+              for (int k = 0; k < width; ++k) {
+                mask[i + k + row * size] = 0;
+              }
+            }
+
+            // Emit the rectangle as two triangles.
+            const uint32_t first_vertex = mesh->vertices.size();
+            const int corners[4][2] = {
+              { i, j }, { i + width, j }, { i + width, j + height },
+              { i, j + height }
+            };
+            const QVector4D diffuse = UnpackColor(color);
+            for (const int* corner : corners) {
+              QVector3D vertex;
+              vertex[axis] = plane;
+              vertex[u] = corner[0];
+              vertex[v] = corner[1];
+              mesh->vertices.push_back(origin + vertex * voxel_size);
+              mesh->normals.push_back(normal);
+              mesh->diffuse.push_back(diffuse);
+            }
+            const int order[2][6] = {
+              { 0, 2, 1, 0, 3, 2 },
+              { 0, 1, 2, 0, 2, 3 }
+            };
+            for (int corner_ind : order[sign > 0]) {
+              mesh->indices.push_back(first_vertex + corner_ind);
+            }
+
+            i += width;
+          }
+        }
+      }
+    }
+  }
+}
+
+}  // namespace sv
@@ -0,0 +1,45 @@
+// Copyright [2015] Albert Huang
+
+#ifndef SCENEVIEW_VOXEL_MESHER_HPP__
+#define SCENEVIEW_VOXEL_MESHER_HPP__
+
+#include <cstdint>
+
+#include <QVector3D>
+
+#include <sceneview/geometry_resource.hpp>
+
+namespace sv {
+
+/**
+ * Builds the surface of a cubic block of voxels with greedy meshing.
+ *
+ * Only faces between a solid voxel and an empty voxel are generated. Each
+ * slice of the block is then covered with as few rectangles as possible, by
+ * merging adjacent coplanar faces of the same color. This typically produces
+ * far fewer triangles than drawing a cube per voxel.
+ *
+ * Voxels are colors packed as 0xAARRGGBB (the same layout as QRgb), with 0
+ * meaning an empty voxel. All other voxels are treated as opaque when
+ * removing hidden faces.
+ *
+ * @param voxels the voxels of the block, with a one voxel border taken from
+ *        the neighboring blocks so that faces hidden across block boundaries
+ *        are removed. There are (@p size + 2)^3 values, with x varying
+ *        fastest, then y, then z. The voxel at (x, y, z) of the block is at
+ *        index (x + 1) + (y + 1) * (size + 2) + (z + 1) * (size + 2)^2.
+ * @param size the number of voxels along each axis of the block.
+ * @param origin the position of the minimum corner of the block.
+ * @param voxel_size the edge length of a voxel.
+ * @param mesh receives an indexed triangle list with vertices, normals and
+ *        diffuse colors. Any previous contents are replaced.
+ *
+ * @ingroup sv_resources
+ * @headerfile sceneview/voxel_mesher.hpp
+ */
+void GreedyMeshVoxels(const uint32_t* voxels, int size,
+    const QVector3D& origin, float voxel_size, GeometryData* mesh);
+
+}  // namespace sv
+
+#endif  // SCENEVIEW_VOXEL_MESHER_HPP__
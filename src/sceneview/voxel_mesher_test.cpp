@@ -0,0 +1,131 @@
+// Copyright [2015] Albert Huang
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "sceneview/voxel_mesher.hpp"
+
+using sv::GeometryData;
+using sv::GreedyMeshVoxels;
+
+static const uint32_t kRed = 0xffff0000;
+static const uint32_t kBlue = 0xff0000ff;
+
+// A block of voxels with a one voxel border, as taken by GreedyMeshVoxels().
+class Block {
+  public:
+    explicit Block(int size) :
+      size_(size),
+      voxels_((size + 2) * (size + 2) * (size + 2), 0) {}
+
+    // Coordinates range from -1 to size, to include the border.
+    uint32_t& At(int x, int y, int z) {
+      const int padded = size_ + 2;
+      return voxels_[(x + 1) + (y + 1) * padded + (z + 1) * padded * padded];
+    }
+
+    GeometryData Mesh(const QVector3D& origin = QVector3D(),
+        float voxel_size = 1) {
+      GeometryData mesh;
+      GreedyMeshVoxels(voxels_.data(), size_, origin, voxel_size, &mesh);
+      return mesh;
+    }
+
+  private:
+    int size_;
+    std::vector<uint32_t> voxels_;
+};
+
+static int NumQuads(const GeometryData& mesh) {
+  return mesh.indices.size() / 6;
+}
+
+// Checks that every triangle winds counter-clockwise around its normal.
+static void CheckWinding(const GeometryData& mesh) {
+  for (size_t ind = 0; ind < mesh.indices.size(); ind += 3) {
+    const QVector3D& v0 = mesh.vertices[mesh.indices[ind]];
+    const QVector3D& v1 = mesh.vertices[mesh.indices[ind + 1]];
+    const QVector3D& v2 = mesh.vertices[mesh.indices[ind + 2]];
+    const QVector3D cross = QVector3D::crossProduct(v1 - v0, v2 - v0);
+    EXPECT_GT(QVector3D::dotProduct(cross,
+          mesh.normals[mesh.indices[ind]]), 0);
+  }
+}
+
+TEST(VoxelMesher, Empty) {
+  Block block(4);
+  const GeometryData mesh = block.Mesh();
+  EXPECT_EQ(static_cast<GLenum>(GL_TRIANGLES), mesh.gl_mode);
+  EXPECT_TRUE(mesh.vertices.empty());
+  EXPECT_TRUE(mesh.indices.empty());
+}
+
+TEST(VoxelMesher, SingleVoxel) {
+  Block block(4);
+  block.At(1, 2, 3) = kRed;
+  const GeometryData mesh = block.Mesh(QVector3D(10, 20, 30), 0.5);
+  EXPECT_EQ(6, NumQuads(mesh));
+  EXPECT_EQ(24u, mesh.vertices.size());
+  EXPECT_EQ(mesh.vertices.size(), mesh.normals.size());
+  EXPECT_EQ(mesh.vertices.size(), mesh.diffuse.size());
+  for (const QVector3D& vertex : mesh.vertices) {
+    EXPECT_TRUE(vertex.x() == 10.5 || vertex.x() == 11);
+    EXPECT_TRUE(vertex.y() == 21 || vertex.y() == 21.5);
+    EXPECT_TRUE(vertex.z() == 31.5 || vertex.z() == 32);
+  }
+  for (const QVector4D& diffuse : mesh.diffuse) {
+    EXPECT_EQ(QVector4D(1, 0, 0, 1), diffuse);
+  }
+  CheckWinding(mesh);
+}
+
+TEST(VoxelMesher, MergesCoplanarFaces) {
+  // A solid 4x4x4 block has one quad per side.
+  Block block(4);
+  for (int z = 0; z < 4; ++z) {
+    for (int y = 0; y < 4; ++y) {
+      for (int x = 0; x < 4; ++x) {
+        block.At(x, y, z) = kRed;
+      }
+    }
+  }
+  GeometryData mesh = block.Mesh();
+  EXPECT_EQ(6, NumQuads(mesh));
+  CheckWinding(mesh);
+
+  // A differently colored voxel in a corner splits the three sides that it
+  // touches.
+  block.At(0, 0, 0) = kBlue;
+  mesh = block.Mesh();
+  EXPECT_EQ(3 + 3 * 3, NumQuads(mesh));
+  CheckWinding(mesh);
+}
+
+TEST(VoxelMesher, RemovesHiddenFaces) {
+  // Two adjacent voxels don't have faces between them.
+  Block block(4);
+  block.At(1, 1, 1) = kRed;
+  block.At(2, 1, 1) = kBlue;
+  GeometryData mesh = block.Mesh();
+  EXPECT_EQ(10, NumQuads(mesh));
+
+  // Faces hidden by voxels of neighboring blocks are removed.
+  Block edge(4);
+  edge.At(0, 0, 0) = kRed;
+  edge.At(-1, 0, 0) = kRed;
+  edge.At(0, -1, 0) = kRed;
+  edge.At(0, 0, -1) = kRed;
+  mesh = edge.Mesh();
+  EXPECT_EQ(3, NumQuads(mesh));
+  for (const QVector3D& normal : mesh.normals) {
+    EXPECT_GT(normal.x() + normal.y() + normal.z(), 0);
+  }
+
+  // Voxels in the border aren't meshed themselves.
+  Block border(4);
+  border.At(-1, 2, 2) = kRed;
+  border.At(4, 2, 2) = kRed;
+  EXPECT_TRUE(border.Mesh().indices.empty());
+}